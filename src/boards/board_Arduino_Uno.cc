@@ -392,6 +392,7 @@ void cboard_Arduino_Uno::Run_CPU(void) {
     unsigned char pi;
     const picpin* pins;
     unsigned int alm[100];
+    unsigned char plast[100];  // pin values before the batch
 
     // int JUMPSTEPS =
     // Window1.GetJUMPSTEPS
@@ -405,8 +406,7 @@ void cboard_Arduino_Uno::Run_CPU(void) {
                                                         // 100ms
     const float RNSTEP = 200.0 * pinc / NSTEP;
 
-    long long unsigned int cycle_start;
-    int twostep = 0;
+    unsigned int steps;
 
     // reset mean value
 
@@ -425,34 +425,35 @@ void cboard_Arduino_Uno::Run_CPU(void) {
     pi = 0;
     if (PICSimLab.GetMcuPwr())       // if
                                      // powered
-        for (i = 0; i < NSTEP; i++)  // repeat for
-                                     // number of
-                                     // steps in
-                                     // 100ms
+        for (i = 0; i < NSTEP; i += steps)  // repeat for
+                                            // number of
+                                            // cycles in
+                                            // 100ms
         {
             // verify if a
             // breakpoint is
             // reached if not
-            // run one
-            // instruction
+            // run until next
+            // timer or pin
+            // change
+            steps = 1;
             if (avr_debug_type || (!mplabxd_testbp())) {
-                if (twostep) {
-                    twostep = 0;  // NOP
-                } else {
-                    cycle_start = avr->cycle;
-                    avr_run(avr);
-                    if ((avr->cycle - cycle_start) > 1) {
-                        twostep = 1;
+                const unsigned int batch = GetBatchCycles(NSTEP - i);
+                if (batch > 1) {
+                    // the batch ends on a pin change, only its last cycle has the new values
+                    for (int p = 0; p < pinc; p++) {
+                        plast[p] = pins[p].value;
                     }
                 }
+                steps = MRunCycles(batch);
             }
 
-            InstCounterInc();
+            InstCounterAdd(steps);
             UpdateHardware();
 
             // avr->sleep_usec=0;
             if (use_oscope)
-                Oscilloscope.SetSample();
+                Oscilloscope.SetSample(steps);
             if (use_spare)
                 SpareParts.Process();
             ioupdated = 0;
@@ -460,10 +461,12 @@ void cboard_Arduino_Uno::Run_CPU(void) {
             // increment mean
             // value counter if
             // pin is high
-            alm[pi] += pins[pi].value;
-            pi++;
-            if (pi == pinc)
-                pi = 0;
+            for (unsigned int s = 0; s < steps; s++) {
+                alm[pi] += (s < (steps - 1)) ? plast[pi] : pins[pi].value;
+                pi++;
+                if (pi == pinc)
+                    pi = 0;
+            }
             /*
                 if (j >=
                JUMPSTEPS)//if
@@ -426,6 +426,7 @@ void cboard_Breadboard::Run_CPU(void) {
     unsigned char pi;
     const picpin* pins;
     unsigned int alm[100];
+    unsigned char plast[100];  // pin values before the batch (AVR)
 
     switch (ptype) {
         case _PIC: {
@@ -482,8 +483,8 @@ void cboard_Breadboard::Run_CPU(void) {
                     // reached if
                     // not run one
                     // instruction
-                    if (!mplabxd_testbp())
-                        pic_step(&pic);
+                    if (!DBGTestBP())
+                        PICStep();
                     ioupdated = pic.ioupdated;
                     InstCounterInc();
 
@@ -540,8 +541,7 @@ void cboard_Breadboard::Run_CPU(void) {
                                                                 // 100ms
             const float RNSTEP = 200.0 * pinc / NSTEP;
 
-            long long unsigned int cycle_start;
-            int twostep = 0;
+            unsigned int steps;
 
             // reset mean value
 
@@ -561,36 +561,37 @@ void cboard_Breadboard::Run_CPU(void) {
             pi = 0;
             if (PICSimLab.GetMcuPwr())       // if
                                              // powered
-                for (i = 0; i < NSTEP; i++)  // repeat
-                                             // for
-                                             // number
-                                             // of
-                                             // steps
-                                             // in
-                                             // 100ms
+                for (i = 0; i < NSTEP; i += steps)  // repeat
+                                                    // for
+                                                    // number
+                                                    // of
+                                                    // cycles
+                                                    // in
+                                                    // 100ms
                 {
                     // verify if a
                     // breakpoint is
                     // reached if
-                    // not run one
-                    // instruction
+                    // not run until
+                    // next timer or
+                    // pin change
+                    steps = 1;
                     if (avr_debug_type || (!mplabxd_testbp())) {
-                        if (twostep) {
-                            twostep = 0;  // NOP
-                        } else {
-                            cycle_start = avr->cycle;
-                            avr_run(avr);
-                            if ((avr->cycle - cycle_start) > 1) {
-                                twostep = 1;
+                        const unsigned int batch = GetBatchCycles(NSTEP - i);
+                        if (batch > 1) {
+                            // the batch ends on a pin change, only its last cycle has the new values
+                            for (int p = 0; p < pinc; p++) {
+                                plast[p] = pins[p].value;
                             }
                         }
+                        steps = MRunCycles(batch);
                     }
-                    InstCounterInc();
+                    InstCounterAdd(steps);
                     bsim_simavr::UpdateHardware();
 
                     // avr->sleep_usec=0;
                     if (use_oscope)
-                        Oscilloscope.SetSample();
+                        Oscilloscope.SetSample(steps);
                     if (use_spare)
                         SpareParts.Process();
                     ioupdated = 0;
@@ -599,10 +600,12 @@ void cboard_Breadboard::Run_CPU(void) {
                     // mean value
                     // counter if
                     // pin is high
-                    alm[pi] += pins[pi].value;
-                    pi++;
-                    if (pi == pinc)
-                        pi = 0;
+                    for (unsigned int s = 0; s < steps; s++) {
+                        alm[pi] += (s < (steps - 1)) ? plast[pi] : pins[pi].value;
+                        pi++;
+                        if (pi == pinc)
+                            pi = 0;
+                    }
                     /*
                     if (j >=
                     JUMPSTEPS)//if
@@ -705,6 +708,9 @@ int cboard_Breadboard::MInit(const char* processor, const char* fname, float fre
     else
         ptype = _AVR;
 
+    // only the picsim backend publishes RAM writes, simavr RAM watches are polled
+    RAMWatchHook = (ptype == _PIC);
+
     switch (ptype) {
         case _PIC:
             ret = bsim_picsim::MInit(processor, fname, freq);
@@ -954,6 +960,18 @@ void cboard_Breadboard::MReset(int flags) {
     }
 }
 
+int cboard_Breadboard::DBGIsSupported(void) {
+    switch (ptype) {
+        case _PIC:
+            return bsim_picsim::DBGIsSupported();
+            break;
+        case _AVR:
+            return bsim_simavr::DBGIsSupported();
+            break;
+    }
+    return 0;
+}
+
 unsigned short* cboard_Breadboard::DBGGetProcID_p(void) {
     switch (ptype) {
         case _PIC:
@@ -1182,6 +1200,7 @@ void cboard_Breadboard::SetScale(double scale) {
 
 void cboard_Breadboard::EndServers(void) {
     mplabxd_server_end();
+    gdbrsp_server_end();
 }
 
 board_init(BOARD_Breadboard_Name, cboard_Breadboard);
@@ -70,6 +70,7 @@ public:
     void MStep(void) override;
     void MStepResume(void) override;
     void MReset(int flags) override;
+    int DBGIsSupported(void) override;
     unsigned short* DBGGetProcID_p(void) override;
     unsigned int DBGGetPC(void) override;
     void DBGSetPC(unsigned int pc) override;
@@ -645,8 +645,8 @@ void cboard_Curiosity_HPC::Run_CPU(void) {
 
             // verify if a breakpoint is reached if not run one
             // instruction
-            if (!mplabxd_testbp())
-                pic_step(&pic);
+            if (!DBGTestBP())
+                PICStep();
             ioupdated = pic.ioupdated;
             InstCounterInc();
             if (use_oscope)
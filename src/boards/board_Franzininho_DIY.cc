@@ -369,13 +369,13 @@ void cboard_Franzininho_DIY::Run_CPU(void) {
     unsigned char pi;
     const picpin* pins;
     unsigned int alm[40];
+    unsigned char plast[40];  // pin values before the batch
 
     const int pinc = MGetPinCount();
     const long int NSTEP = 4.0 * PICSimLab.GetNSTEP();  // number of steps in 100ms
     const float RNSTEP = 200.0 * pinc / NSTEP;
 
-    long long unsigned int cycle_start;
-    int twostep = 0;
+    unsigned int steps;
 
     // reset mean value
 
@@ -390,40 +390,43 @@ void cboard_Franzininho_DIY::Run_CPU(void) {
 
     pi = 0;
     if (PICSimLab.GetMcuPwr())       // if powered
-        for (i = 0; i < NSTEP; i++)  // repeat for number of steps in 100ms
+        for (i = 0; i < NSTEP; i += steps)  // repeat for number of cycles in 100ms
         {
-            // verify if a breakpoint is reached if not run one instruction
+            // verify if a breakpoint is reached if not run until next timer or pin change
+            steps = 1;
             if (avr_debug_type || (!mplabxd_testbp())) {
-                if (twostep) {
-                    twostep = 0;  // NOP
-                } else {
-                    cycle_start = avr->cycle;
-                    avr_run(avr);
-                    if ((avr->cycle - cycle_start) > 1) {
-                        twostep = 1;
-                    }
-                    // TinyDebug support
-                    if (avr->data[TDDR]) {
-                        printf("%c", avr->data[TDDR]);
-                        serial_port_send(serialfd, avr->data[TDDR]);
-                        avr->data[TDDR] = 0;
+                // TinyDebug output is checked every instruction
+                const unsigned int batch = (avr->data[TDCR] & 0x01) ? 1 : GetBatchCycles(NSTEP - i);
+                if (batch > 1) {
+                    // the batch ends on a pin change, only its last cycle has the new values
+                    for (int p = 0; p < pinc; p++) {
+                        plast[p] = pins[p].value;
                     }
                 }
+                steps = MRunCycles(batch);
+                // TinyDebug support
+                if (avr->data[TDDR]) {
+                    printf("%c", avr->data[TDDR]);
+                    serial_port_send(serialfd, avr->data[TDDR]);
+                    avr->data[TDDR] = 0;
+                }
             }
-            InstCounterInc();
+            InstCounterAdd(steps);
             UpdateHardware();
 
             if (use_oscope)
-                Oscilloscope.SetSample();
+                Oscilloscope.SetSample(steps);
             if (use_spare)
                 SpareParts.Process();
             ioupdated = 0;
 
             // increment mean value counter if pin is high
-            alm[pi] += pins[pi].value;
-            pi++;
-            if (pi == pinc)
-                pi = 0;
+            for (unsigned int s = 0; s < steps; s++) {
+                alm[pi] += (s < (steps - 1)) ? plast[pi] : pins[pi].value;
+                pi++;
+                if (pi == pinc)
+                    pi = 0;
+            }
         }
 
     // calculate mean value
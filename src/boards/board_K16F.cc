@@ -177,10 +177,12 @@ void cboard_K16F::Draw(void) {
 
                 if (output[i].id == O_LCD) {
                     if (lcd.update) {
-                        PICSimLab.CanvasCmd(
-                            {.cmd = CC_RECTANGLE,
-                             .Rectangle{1, output[i].x1 - 1, output[i].y1 - 1, output[i].x2 - output[i].x1 + 2,
-                                        output[i].y2 - output[i].y1 + 3}});
+                        if (lcd.redraw) {
+                            PICSimLab.CanvasCmd(
+                                {.cmd = CC_RECTANGLE,
+                                 .Rectangle{1, output[i].x1 - 1, output[i].y1 - 1, output[i].x2 - output[i].x1 + 2,
+                                            output[i].y2 - output[i].y1 + 3}});
+                        }
                         lcd_draw(&lcd, PICSimLab.CanvasCmd, output[i].x1, output[i].y1, output[i].x2 - output[i].x1,
                                  output[i].y2 - output[i].y1, PICSimLab.GetMcuPwr());
                     }
@@ -352,8 +354,8 @@ void cboard_K16F::Run_CPU(void) {
                 pic_set_pin(&pic, 11, pic_get_pin(&pic, 16));
             }
 
-            if (!mplabxd_testbp())
-                pic_step(&pic);
+            if (!DBGTestBP())
+                PICStep();
             ioupdated = pic.ioupdated;
             InstCounterInc();
             if (use_oscope)
@@ -829,7 +831,7 @@ void cboard_K16F::EvKeyRelease(unsigned int key, unsigned int mask) {
 }
 
 void cboard_K16F::EvOnShow(void) {
-    lcd.update = 1;
+    lcd_redraw(&lcd);
     board::EvOnShow();
 }
 
@@ -440,8 +440,8 @@ void cboard_McLab1::Run_CPU(void) {
                 }
             }
 
-            if (!mplabxd_testbp())
-                pic_step(&pic);
+            if (!DBGTestBP())
+                PICStep();
             ioupdated = pic.ioupdated;
             InstCounterInc();
             if (use_oscope)
@@ -460,10 +460,12 @@ void cboard_McLab2::Draw(void) {
                     PICSimLab.CanvasCmd({.cmd = CC_CHANGESCALE, .ChangeScale{Scale, Scale}});
                 } else if (output[i].id == O_LCD) {
                     if (lcd.update) {
-                        PICSimLab.CanvasCmd(
-                            {.cmd = CC_RECTANGLE,
-                             .Rectangle{1, output[i].x1 - 1, output[i].y1 - 1, output[i].x2 - output[i].x1 + 2,
-                                        output[i].y2 - output[i].y1 + 3}});
+                        if (lcd.redraw) {
+                            PICSimLab.CanvasCmd(
+                                {.cmd = CC_RECTANGLE,
+                                 .Rectangle{1, output[i].x1 - 1, output[i].y1 - 1, output[i].x2 - output[i].x1 + 2,
+                                            output[i].y2 - output[i].y1 + 3}});
+                        }
                         lcd_draw(&lcd, PICSimLab.CanvasCmd, output[i].x1, output[i].y1, output[i].x2 - output[i].x1,
                                  output[i].y2 - output[i].y1, PICSimLab.GetMcuPwr());
                     }
@@ -682,8 +684,8 @@ void cboard_McLab2::Run_CPU(void) {
                 }
             }
 
-            if (!mplabxd_testbp())
-                pic_step(&pic);
+            if (!DBGTestBP())
+                PICStep();
             ioupdated = pic.ioupdated;
             InstCounterInc();
 
@@ -1174,7 +1176,7 @@ void cboard_McLab2::EvKeyRelease(unsigned int key, unsigned int mask) {
 }
 
 void cboard_McLab2::EvOnShow(void) {
-    lcd.update = 1;
+    lcd_redraw(&lcd);
     board::EvOnShow();
 }
 
@@ -659,21 +659,23 @@ void cboard_PICGenios::Draw(void) {
                     PICSimLab.CanvasCmd({.cmd = CC_CHANGESCALE, .ChangeScale{Scale, Scale}});
                 } else if (output[i].id == O_LCD) {
                     if (lcd.update) {
-                        PICSimLab.CanvasCmd({.cmd = CC_CHANGESCALE, .ChangeScale{1.0, 1.0}});
-                        if (lcd.lnum == 2) {
-                            PICSimLab.CanvasCmd(
-                                {.cmd = CC_PUTBITMAP,
-                                 .PutBitmap{lcdbmp[0], (output[i].x1 - 41) * Scale, (output[i].y1 - 58) * Scale}});
-                        } else {
+                        if (lcd.redraw) {
+                            PICSimLab.CanvasCmd({.cmd = CC_CHANGESCALE, .ChangeScale{1.0, 1.0}});
+                            if (lcd.lnum == 2) {
+                                PICSimLab.CanvasCmd(
+                                    {.cmd = CC_PUTBITMAP,
+                                     .PutBitmap{lcdbmp[0], (output[i].x1 - 41) * Scale, (output[i].y1 - 58) * Scale}});
+                            } else {
+                                PICSimLab.CanvasCmd(
+                                    {.cmd = CC_PUTBITMAP,
+                                     .PutBitmap{lcdbmp[1], (output[i].x1 - 41) * Scale, (output[i].y1 - 58) * Scale}});
+                            }
+                            PICSimLab.CanvasCmd({.cmd = CC_CHANGESCALE, .ChangeScale{Scale, Scale}});
                             PICSimLab.CanvasCmd(
-                                {.cmd = CC_PUTBITMAP,
-                                 .PutBitmap{lcdbmp[1], (output[i].x1 - 41) * Scale, (output[i].y1 - 58) * Scale}});
+                                {.cmd = CC_RECTANGLE,
+                                 .Rectangle{1, output[i].x1 - 1, output[i].y1 - 2, output[i].x2 - output[i].x1 + 2,
+                                            output[i].y2 - output[i].y1 + ((lcd.lnum == 2) ? 3 : 78)}});
                         }
-                        PICSimLab.CanvasCmd({.cmd = CC_CHANGESCALE, .ChangeScale{Scale, Scale}});
-                        PICSimLab.CanvasCmd(
-                            {.cmd = CC_RECTANGLE,
-                             .Rectangle{1, output[i].x1 - 1, output[i].y1 - 2, output[i].x2 - output[i].x1 + 2,
-                                        output[i].y2 - output[i].y1 + ((lcd.lnum == 2) ? 3 : 78)}});
                         if (dip[0]) {
                             lcd_draw(&lcd, PICSimLab.CanvasCmd, output[i].x1, output[i].y1, output[i].x2 - output[i].x1,
                                      output[i].y2 - output[i].y1, PICSimLab.GetMcuPwr());
@@ -1111,8 +1113,8 @@ void cboard_PICGenios::Run_CPU(void) {
                 }
             }
 
-            if (!mplabxd_testbp())
-                pic_step(&pic);
+            if (!DBGTestBP())
+                PICStep();
             ioupdated = pic.ioupdated;
             InstCounterInc();
             if (use_oscope)
@@ -1502,6 +1504,7 @@ void cboard_PICGenios::EvMouseButtonPress(unsigned int button, unsigned int x, u
                     output_ids[O_D01]->update = 1;
 
                     output_ids[O_LCD]->update = 1;
+                    lcd_redraw(&lcd);
                 } break;
                 case I_D02: {
                     dip[1] ^= 0x01;
@@ -2059,7 +2062,7 @@ void cboard_PICGenios::EvKeyRelease(unsigned int key, unsigned int mask) {
 }
 
 void cboard_PICGenios::EvOnShow(void) {
-    lcd.update = 1;
+    lcd_redraw(&lcd);
     board::EvOnShow();
 }
 
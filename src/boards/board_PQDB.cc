@@ -424,10 +424,12 @@ void cboard_PQDB::Draw(void) {
                     PICSimLab.CanvasCmd({.cmd = CC_CIRCLE, .Circle{1, output[i].cx + x, output[i].cy + y, 3}});
                 } else if (output[i].id == O_LCD) {  // draw lcd text
                                                      // strech lcd background
-                    PICSimLab.CanvasCmd(
-                        {.cmd = CC_RECTANGLE,
-                         .Rectangle{1, output[i].x1 - 15, output[i].y1 - 5, output[i].x2 - output[i].x1 + 32,
-                                    output[i].y2 - output[i].y1 + 13}});
+                    if (lcd.redraw) {
+                        PICSimLab.CanvasCmd(
+                            {.cmd = CC_RECTANGLE,
+                             .Rectangle{1, output[i].x1 - 15, output[i].y1 - 5, output[i].x2 - output[i].x1 + 32,
+                                        output[i].y2 - output[i].y1 + 13}});
+                    }
                     lcd_draw(&lcd, PICSimLab.CanvasCmd, output[i].x1, output[i].y1, output[i].x2 - output[i].x1,
                              output[i].y2 - output[i].y1, PICSimLab.GetMcuPwr());
                 } else if (output[i].id == O_MP) {
@@ -580,8 +582,8 @@ void cboard_PQDB::Run_CPU(void) {
                 }
             }
 
-            if (!mplabxd_testbp())
-                pic_step(&pic);
+            if (!DBGTestBP())
+                PICStep();
             ioupdated = pic.ioupdated;
             InstCounterInc();
 
@@ -1219,7 +1221,7 @@ void cboard_PQDB::EvKeyRelease(unsigned int key, unsigned int mask) {
 }
 
 void cboard_PQDB::EvOnShow(void) {
-    lcd.update = 1;
+    lcd_redraw(&lcd);
     board::EvOnShow();
 }
 
@@ -265,6 +265,8 @@ void cboard_RemoteTCP::WritePreferences(void) {
     PICSimLab.SavePrefs("RemoteTCP_proc", Proc);
     // write microcontroller clock to preferences
     PICSimLab.SavePrefs("RemoteTCP_clock", FloatStrFormat("%2.1f", PICSimLab.GetClock()));
+    // write local transport (tcp, unix or shm)
+    PICSimLab.SavePrefs("RemoteTCP_transport", TransportName(GetTransport()));
 }
 
 // Called whe configuration file load  preferences
@@ -278,6 +280,10 @@ void cboard_RemoteTCP::ReadPreferences(char* name, char* value) {
     if (!strcmp(name, "RemoteTCP_clock")) {
         PICSimLab.SetClock(atof(value));
     }
+    // read local transport
+    if (!strcmp(name, "RemoteTCP_transport")) {
+        SetTransport(TransportFromName(value));
+    }
 }
 
 // Event on the board
@@ -503,8 +503,8 @@ void cboard_Xpress::Run_CPU(void) {
             // breakpoint is reached
             // if not run one
             // instruction
-            if (!mplabxd_testbp())
-                pic_step(&pic);
+            if (!DBGTestBP())
+                PICStep();
             ioupdated = pic.ioupdated;
             InstCounterInc();
             if (use_oscope)
@@ -304,7 +304,8 @@ void cboard_gpboard::Run_CPU(void) {
              */
             // verify if a breakpoint is reached if not run
             // one instruction
-            MStep();
+            if (!gdbrsp_testbp())
+                MStep();
             InstCounterInc();
             // Oscilloscope window process
             if (use_oscope)
@@ -614,8 +614,8 @@ void cboard_x::Run_CPU(void) {
             // breakpoint is reached
             // if not run one
             // instruction
-            if (!mplabxd_testbp())
-                pic_step(&pic);
+            if (!DBGTestBP())
+                PICStep();
             ioupdated = pic.ioupdated;
             InstCounterInc();
             // Oscilloscope window
@@ -100,9 +100,13 @@ void bridge_gpsim_set_apin_value(int pin, float value) {
     iopins[pin]->set_nodeVoltage(value);
 }
 
-void bridge_gpsim_step(void) {
+// return 1 if the cycle ends an instruction (second cycles run in mExecute2ndHalf, sleep in mIdle)
+int bridge_gpsim_step(void) {
+    const ProcessorPhase* phase = gpic->mCurrentPhase;
     gpic->step_cycle();
     bp.clear_halt();
+    return ((phase == gpic->mExecute1Cycle) || (phase == gpic->mExecute2ndHalf)) &&
+           (gpic->mCurrentPhase != gpic->mExecute2ndHalf);
 }
 
 void bridge_gpsim_end(void) {
@@ -116,6 +120,50 @@ void bridge_gpsim_end(void) {
     }
 }
 
+unsigned int bridge_gpsim_get_pc(void) {
+    if (gpic) {
+        return gpic->pc->get_value();
+    }
+    return 0;
+}
+
+void bridge_gpsim_set_pc(unsigned int pc) {
+    if (gpic) {
+        gpic->pc->put_value(pc);
+    }
+}
+
+unsigned int bridge_gpsim_get_ram_size(void) {
+    if (gpic) {
+        return gpic->register_memory_size();
+    }
+    return 0;
+}
+
+void bridge_gpsim_read_ram(unsigned char* buff, unsigned int size) {
+    for (unsigned int i = 0; i < size; i++) {
+        // get_value don't have side effects in special registers
+        buff[i] = gpic->registers[i]->get_value();
+    }
+}
+
+unsigned int bridge_gpsim_get_rom_size(void) {
+    if (gpic) {
+        return gpic->program_memory_size() * 2;
+    }
+    return 0;
+}
+
+void bridge_gpsim_read_rom(unsigned char* buff, unsigned int size) {
+    unsigned short val;
+
+    for (unsigned int i = 0; i < size; i += 2) {
+        val = gpic->program_memory[i / 2]->get_opcode();
+        buff[i + 1] = (val & 0xFF00) >> 8;
+        buff[i] = (val & 0x00FF);
+    }
+}
+
 char* bridge_gpsim_get_processor_list(char* buff, unsigned int size) {
     std::list<ProcessorConstructor*>::iterator processor_iterator;
     ProcessorConstructorList* pl = ProcessorConstructor::GetList();
@@ -27,10 +27,16 @@ unsigned char bridge_gpsim_get_pin_dir(int pin);
 void bridge_gpsim_set_pin_value(int pin, unsigned char value);
 void bridge_gpsim_set_apin_value(int pin, float value);
 void bridge_gpsim_set_frequency(double freq);
-void bridge_gpsim_step(void);
+int bridge_gpsim_step(void);
 void bridge_gpsim_end(void);
 int bridge_gpsim_dump_memory(const char* fname);
 char* bridge_gpsim_get_processor_list(char* buff, unsigned int size);
+unsigned int bridge_gpsim_get_pc(void);
+void bridge_gpsim_set_pc(unsigned int pc);
+unsigned int bridge_gpsim_get_ram_size(void);
+void bridge_gpsim_read_ram(unsigned char* buff, unsigned int size);
+unsigned int bridge_gpsim_get_rom_size(void);
+void bridge_gpsim_read_rom(unsigned char* buff, unsigned int size);
 
 #ifdef __cplusplus
 }
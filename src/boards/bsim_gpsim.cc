@@ -27,6 +27,7 @@
 
 #include <algorithm>
 #include "../lib/picsimlab.h"
+#include "../lib/profiler.h"
 #include "bsim_gpsim.h"
 
 static const unsigned char GPSIM_PORTS[7] = {0, 1, 2, 3, 4, 5, 0xFF};
@@ -35,6 +36,8 @@ bsim_gpsim::bsim_gpsim(void) {
     char list[2000];
     supported_devices = bridge_gpsim_get_processor_list(list, 1999);
     PICSimLab.SetNeedReboot();
+    dbg_ram = NULL;
+    dbg_rom = NULL;
 }
 
 void bsim_gpsim::MSetSerial(const char* port) {
@@ -70,6 +73,15 @@ void bsim_gpsim::MSetSerial(const char* port) {
 
  void bsim_gpsim::MEnd(void) {
      // bridge_gpsim_end(); //Not needed when SetNeedReboot is used
+     gdbrsp_end();
+     if (dbg_ram) {
+         free(dbg_ram);
+         dbg_ram = NULL;
+     }
+     if (dbg_rom) {
+         free(dbg_rom);
+         dbg_rom = NULL;
+     }
  }
 
  int bsim_gpsim::MGetArchitecture(void) {
@@ -106,7 +118,9 @@ void bsim_gpsim::MSetSerial(const char* port) {
      return 1;
  }
 
- void bsim_gpsim::DebugLoop(void) {}
+ void bsim_gpsim::DebugLoop(void) {
+     gdbrsp_loop();
+ }
 
  std::string bsim_gpsim::MGetPinName(int pin) {
      std::string pinname = "error";
@@ -129,9 +143,16 @@ void bsim_gpsim::MSetSerial(const char* port) {
      return bridge_gpsim_dump_memory(fname);
  }
 
- int bsim_gpsim::DebugInit(int dtyppe)  // argument not used in picm only mplabx
+ int bsim_gpsim::DebugInit(int dtyppe)  // argument not used, gpsim only support gdb
  {
-     return 0;  //! mplabxd_init (this, Window1.Get_debug_port ()) - 1;
+     // memory pointers are snapshots of gpsim registers, gdb can't write on it
+     int ret = !gdbrsp_init(this, PICSimLab.GetDebugPort(), GDBRSP_MEMRO) - 1;
+
+     if (ret < 0) {
+         PICSimLab.RegisterError("Error starting GDB debugger support !");
+     }
+
+     return ret;
  }
 
  int bsim_gpsim::MGetPinCount(void) {
@@ -201,7 +222,9 @@ void bsim_gpsim::MSetSerial(const char* port) {
  }
 
  void bsim_gpsim::MStep(void) {
-     bridge_gpsim_step();
+     if (bridge_gpsim_step() && Profiler.IsRunning()) {
+         Profiler.Retire();
+     }
 
      for (int i = 0; i < MGetPinCount(); i++) {
          pins[i].value = bridge_gpsim_get_pin_value(i + 1);
@@ -212,3 +235,35 @@ void bsim_gpsim::MSetSerial(const char* port) {
  void bsim_gpsim::MStepResume(void) {
      // if (pic.s2 == 1)step ();
  }
+
+ unsigned int bsim_gpsim::DBGGetPC(void) {
+     return bridge_gpsim_get_pc();
+ }
+
+ void bsim_gpsim::DBGSetPC(unsigned int pc) {
+     bridge_gpsim_set_pc(pc);
+ }
+
+ unsigned char* bsim_gpsim::DBGGetRAM_p(void) {
+     dbg_ram = (unsigned char*)realloc(dbg_ram, DBGGetRAMSize() + 1);
+     bridge_gpsim_read_ram(dbg_ram, DBGGetRAMSize());
+     return dbg_ram;
+ }
+
+ unsigned char* bsim_gpsim::DBGGetROM_p(void) {
+     dbg_rom = (unsigned char*)realloc(dbg_rom, DBGGetROMSize() + 1);
+     bridge_gpsim_read_rom(dbg_rom, DBGGetROMSize());
+     return dbg_rom;
+ }
+
+ unsigned int bsim_gpsim::DBGGetRAMSize(void) {
+     return bridge_gpsim_get_ram_size();
+ }
+
+ unsigned int bsim_gpsim::DBGGetROMSize(void) {
+     return bridge_gpsim_get_rom_size();
+ }
+
+ void bsim_gpsim::EndServers(void) {
+     gdbrsp_server_end();
+ }
@@ -29,11 +29,13 @@
 #include "../lib/board.h"
 #include "../lib/serial_port.h"
 
+#include "../devices/gdbrsp.h"
+
 class bsim_gpsim : virtual public board {
 public:
     bsim_gpsim(void);
     int DebugInit(int dtyppe) override;
-    std::string GetDebugName(void) override { return "none"; };
+    std::string GetDebugName(void) override { return "GDB"; };
     void DebugLoop(void) override;
     int CpuInitialized(void) override;
     void MSetSerial(const char* port) override;
@@ -58,6 +60,15 @@ public:
     void MStepResume(void) override;
     void MReset(int flags) override;
     int GetDefaultClock(void) override { return 8; };
+    int DBGIsSupported(void) override { return 1; };
+    unsigned int DBGGetPC(void) override;
+    void DBGSetPC(unsigned int pc) override;
+    unsigned char* DBGGetRAM_p(void) override;
+    unsigned char* DBGGetROM_p(void) override;
+    unsigned int DBGGetRAMSize(void) override;
+    unsigned int DBGGetROMSize(void) override;
+    unsigned int DBGGetEEPROM_Size(void) override { return 0; };
+    void EndServers(void) override;
 
 protected:
     void pins_reset(void);
@@ -71,6 +82,8 @@ protected:
     int serialfd;
 #endif
     std::string supported_devices;
+    unsigned char* dbg_ram;  // snapshots of gpsim memory for debugger
+    unsigned char* dbg_rom;
 };
 
 #endif /* BOARD_GPSIM_H */
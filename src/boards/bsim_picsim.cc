@@ -29,6 +29,8 @@
 
 bsim_picsim::bsim_picsim(void) {
     pic.PINCOUNT = 0;
+    pic_debug_type = 0;
+    RAMWatchHook = 1;  // RAM writes published from pic.lram in PICStep
 }
 
 void bsim_picsim::MSetSerial(const char* port) {
@@ -66,6 +68,7 @@ void bsim_picsim::MEnd(void) {
     pic_end(&pic);
     // prog_end();
     mplabxd_end();
+    gdbrsp_end();
 }
 
 int bsim_picsim::MGetArchitecture(void) {
@@ -127,12 +130,25 @@ int bsim_picsim::MDumpMemory(const char* fname) {
     return 1;
 }
 
-int bsim_picsim::DebugInit(int dtyppe)  // argument not used in pic, it only use mplabx
-{
-    int ret = !mplabxd_init(this, PICSimLab.GetDebugPort()) - 1;
+int bsim_picsim::DebugInit(int dtyppe) {
+    int ret;
 
-    if (ret < 0) {
-        PICSimLab.RegisterError("Error starting MPLABX debugger support !");
+    pic_debug_type = dtyppe;
+
+    if (pic_debug_type) {
+        mplabxd_server_end();
+        ret = !gdbrsp_init(this, PICSimLab.GetDebugPort(), GDBRSP_WATCH) - 1;
+
+        if (ret < 0) {
+            PICSimLab.RegisterError("Error starting GDB debugger support !");
+        }
+    } else {
+        gdbrsp_server_end();
+        ret = !mplabxd_init(this, PICSimLab.GetDebugPort()) - 1;
+
+        if (ret < 0) {
+            PICSimLab.RegisterError("Error starting MPLABX debugger support !");
+        }
     }
 
     return ret;
@@ -141,7 +157,11 @@ int bsim_picsim::DebugInit(int dtyppe)  // argument not used in pic, it only use
 void bsim_picsim::DebugLoop(void) {
     if (PICSimLab.GetMcuPwr()) {
         // prog_loop(&pic);
-        mplabxd_loop();
+        if (pic_debug_type) {
+            gdbrsp_loop();
+        } else {
+            mplabxd_loop();
+        }
     }
 }
 
@@ -179,14 +199,16 @@ const picpin* bsim_picsim::MGetPinsValues(void) {
 }
 
 void bsim_picsim::MStep(void) {
-    pic_step(&pic);
-    if (pic.s2 == 1)
-        pic_step(&pic);
+    PICStep();
+    if (pic.s2 == 1) {
+        PICStep();
+    }
 }
 
 void bsim_picsim::MStepResume(void) {
-    if (pic.s2 == 1)
-        pic_step(&pic);
+    if (pic.s2 == 1) {
+        PICStep();
+    }
 }
 
 void bsim_picsim::MReset(int flags) {
@@ -261,6 +283,7 @@ unsigned int bsim_picsim::DBGGetRAMLARD(void) {
 
 void bsim_picsim::EndServers(void) {
     mplabxd_server_end();
+    gdbrsp_server_end();
 }
 
 int bsim_picsim::GetUARTRX(const int uart_num) {
@@ -27,15 +27,17 @@
 #define BOARD_PIC_H
 
 #include "../lib/board.h"
+#include "../lib/profiler.h"
 #include "../lib/serial_port.h"
 
+#include "../devices/gdbrsp.h"
 #include "../devices/mplabxd.h"
 
 class bsim_picsim : virtual public board {
 public:
     bsim_picsim(void);
     int DebugInit(int dtyppe) override;
-    std::string GetDebugName(void) override { return "MDB"; };
+    std::string GetDebugName(void) override { return pic_debug_type ? "GDB" : "MDB"; };
     void DebugLoop(void) override;
     int CpuInitialized(void) override;
     void MSetSerial(const char* port) override;
@@ -59,6 +61,7 @@ public:
     void MStep(void) override;
     void MStepResume(void) override;
     void MReset(int flags) override;
+    int DBGIsSupported(void) override { return 1; };
     unsigned short* DBGGetProcID_p(void) override;
     unsigned int DBGGetPC(void) override;
     void DBGSetPC(unsigned int pc) override;
@@ -80,7 +83,23 @@ public:
     int GetUARTTX(const int uart_num) override;
 
 protected:
+    /**
+     * @brief verify if a breakpoint is reached (call before each instruction)
+     */
+    int DBGTestBP(void) { return pic_debug_type ? gdbrsp_testbp() : mplabxd_testbp(); };
+    /**
+     * @brief run one instruction step and publish its RAM write to the RAM watches (use instead of pic_step)
+     */
+    void PICStep(void) {
+        pic_step(&pic);
+        RAMWatchWrite(pic.lram);
+        // s2 is set while a two cycle instruction has its second cycle to run
+        if (Profiler.IsRunning() && (!pic.s2) && (!pic.sleep)) {
+            Profiler.Retire();
+        }
+    };
     _pic pic;
+    int pic_debug_type;
 };
 
 #endif /* BOARD_PIC_H */
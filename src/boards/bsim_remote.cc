@@ -23,14 +23,21 @@
    For e-mail suggestions :  lcgamboa@yahoo.com
    ######################################################################## */
 
-#define _TCP_
-
 #ifndef _WIN_
 #include <arpa/inet.h>
+#include <fcntl.h>
 #include <netinet/in.h>
+#include <sys/mman.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <sys/un.h>
+#ifdef __linux__
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#endif
 #else
 #include <winsock2.h>
 #include <ws2tcpip.h>
@@ -56,6 +63,8 @@ void setblock(int sock_descriptor);
 void setnblock(int sock_descriptor);
 
 static int listenfd = -1;
+static int ulistenfd = -1;
+static rshm_t* rshm = NULL;
 
 static const int id[3] = {0, 1, 2};
 
@@ -68,9 +77,154 @@ static void picsimlab_uart_rx_event(bitbang_uart_t* bu, void* arg) {
     }
 }
 
+//===================== shared memory transport ================================
+#if defined(__linux__)
+#define RSHM_SPIN 4000  // busy wait iterations before sleep on futex
+
+static inline void rshm_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+static void rshm_wake(rshm_ring_t* ring) {
+    __atomic_add_fetch(&ring->seq, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&ring->waiters, __ATOMIC_SEQ_CST)) {
+        syscall(SYS_futex, &ring->seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+    }
+}
+
+// wait until *idx changes from last, return -1 if client detached
+static int rshm_wait(rshm_ring_t* ring, const uint32_t* idx, const uint32_t last) {
+    for (int i = 0; i < RSHM_SPIN; i++) {
+        if (__atomic_load_n(idx, __ATOMIC_ACQUIRE) != last)
+            return 0;
+        rshm_relax();
+    }
+
+    const struct timespec timeout = {0, 10000000L};  // 10ms
+    while (__atomic_load_n(idx, __ATOMIC_ACQUIRE) == last) {
+        if (!__atomic_load_n(&rshm->client, __ATOMIC_ACQUIRE))
+            return -1;
+        __atomic_add_fetch(&ring->waiters, 1, __ATOMIC_SEQ_CST);
+        uint32_t seq = __atomic_load_n(&ring->seq, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(idx, __ATOMIC_SEQ_CST) == last) {
+            syscall(SYS_futex, &ring->seq, FUTEX_WAIT, seq, &timeout, NULL, 0);
+        }
+        __atomic_sub_fetch(&ring->waiters, 1, __ATOMIC_SEQ_CST);
+    }
+    return 0;
+}
+
+static int32_t rshm_read(rshm_ring_t* ring, char* buff, const uint32_t size) {
+    uint32_t done = 0;
+    while (done < size) {
+        const uint32_t tail = ring->tail;
+        const uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        uint32_t n = head - tail;
+        if (!n) {
+            if (rshm_wait(ring, &ring->head, head) < 0)
+                return -1;
+            continue;
+        }
+        if (n > size - done)
+            n = size - done;
+        const uint32_t off = tail & (RSHM_RING_SIZE - 1);
+        const uint32_t first = (n < RSHM_RING_SIZE - off) ? n : RSHM_RING_SIZE - off;
+        memcpy(buff + done, ring->data + off, first);
+        memcpy(buff + done + first, ring->data, n - first);
+        __atomic_store_n(&ring->tail, tail + n, __ATOMIC_RELEASE);
+        rshm_wake(ring);
+        done += n;
+    }
+    return done;
+}
+
+static int32_t rshm_write(rshm_ring_t* ring, const char* buff, const uint32_t size) {
+    uint32_t done = 0;
+    while (done < size) {
+        const uint32_t head = ring->head;
+        const uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        uint32_t n = RSHM_RING_SIZE - (head - tail);
+        if (!n) {
+            if (rshm_wait(ring, &ring->tail, tail) < 0)
+                return -1;
+            continue;
+        }
+        if (n > size - done)
+            n = size - done;
+        const uint32_t off = head & (RSHM_RING_SIZE - 1);
+        const uint32_t first = (n < RSHM_RING_SIZE - off) ? n : RSHM_RING_SIZE - off;
+        memcpy(ring->data + off, buff + done, first);
+        memcpy(ring->data, buff + done + first, n - first);
+        __atomic_store_n(&ring->head, head + n, __ATOMIC_RELEASE);
+        rshm_wake(ring);
+        done += n;
+    }
+    return done;
+}
+
+static void rshm_rings_reset(void) {
+    for (int r = 0; r < 2; r++) {
+        rshm->ring[r].head = 0;
+        rshm->ring[r].tail = 0;
+        rshm_wake(&rshm->ring[r]);
+    }
+}
+
+static char rshm_name[64];
+
+static int rshm_open(void) {
+    struct stat st;
+
+    snprintf(rshm_name, sizeof(rshm_name), "%s.%u", RT_SHM_NAME, (unsigned int)geteuid());
+    int fd = shm_open(rshm_name, O_CREAT | O_RDWR | O_NOFOLLOW, 0600);
+    if (fd < 0) {
+        printf("picsimlab: shm open error : %s \n", strerror(errno));
+        return -1;
+    }
+    // a region left by other user (or with a wider mode) is not used
+    if (fstat(fd, &st) || (!S_ISREG(st.st_mode)) || (st.st_uid != geteuid()) || (st.st_mode & 0077)) {
+        printf("picsimlab: shm %s not owned by the user\n", rshm_name);
+        close(fd);
+        return -1;
+    }
+    if (ftruncate(fd, sizeof(rshm_t))) {
+        printf("picsimlab: shm truncate error : %s \n", strerror(errno));
+        close(fd);
+        return -1;
+    }
+    void* mem = mmap(NULL, sizeof(rshm_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mem == MAP_FAILED) {
+        printf("picsimlab: shm mmap error : %s \n", strerror(errno));
+        return -1;
+    }
+    rshm = (rshm_t*)mem;
+    memset(rshm, 0, sizeof(rshm_t));
+    rshm->version = RSHM_VERSION;
+    __atomic_store_n(&rshm->server, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&rshm->magic, RSHM_MAGIC, __ATOMIC_RELEASE);
+    return 0;
+}
+
+static void rshm_close(void) {
+    if (rshm) {
+        __atomic_store_n(&rshm->server, 0, __ATOMIC_RELEASE);
+        rshm_rings_reset();
+        munmap(rshm, sizeof(rshm_t));
+        shm_unlink(rshm_name);
+        rshm = NULL;
+    }
+}
+#endif
+//==============================================================================
+
 bsim_remote::bsim_remote(void) {
     connected = 0;
     sockfd = -1;
+    transport = RT_TCP;
+    ctransport = RT_TCP;
     fname_bak[0] = 0;
     fname_[0] = 0;
 
@@ -101,11 +255,7 @@ void bsim_remote::MSetSerial(const char* port) {
 }
 
 int bsim_remote::MInit(const char* processor, const char* fname, float freq) {
-#ifdef _TCP_
     struct sockaddr_in serv;
-#else
-    struct sockaddr_un serv;
-#endif
 
     std::string sproc = GetSupportedDevices();
     if (sproc.find(processor) == std::string::npos) {
@@ -123,7 +273,6 @@ int bsim_remote::MInit(const char* processor, const char* fname, float freq) {
     serialfd[3] = INVALID_SERIAL;
 
     if (listenfd < 0) {
-#ifdef _TCP_
         int reuse = 1;
         if ((listenfd = socket(PF_INET, SOCK_STREAM, 0)) < 0) {
             printf("picsimlab: socket error : %s \n", strerror(errno));
@@ -136,18 +285,7 @@ int bsim_remote::MInit(const char* processor, const char* fname, float freq) {
         memset(&serv, 0, sizeof(serv));
         serv.sin_family = AF_INET;
         serv.sin_addr.s_addr = htonl(INADDR_ANY);
-        serv.sin_port = htons(7890);
-#else
-        if ((listenfd = socket(PF_UNIX, SOCK_STREAM, 0)) < 0) {
-            printf("picsimlab: socket error : %s \n", strerror(errno));
-            exit(1);
-        }
-
-        memset(&serv, 0, sizeof(serv));
-        serv.sun_family = AF_UNIX;
-        serv.sun_path[0] = 0;
-        strncpy(serv.sun_path + 1, "picsimlab_qemu", sizeof(serv.sun_path) - 2);
-#endif
+        serv.sin_port = htons(RT_TCP_PORT);
 
         if (bind(listenfd, (sockaddr*)&serv, sizeof(serv))) {
             printf("picsimlab: remote bind error : %s \n", strerror(errno));
@@ -160,20 +298,89 @@ int bsim_remote::MInit(const char* processor, const char* fname, float freq) {
         }
     }
 
-    PICSimLab.ConfigMenuGUI(GMT_DISABLED);
-
     setnblock(listenfd);
 
+#ifndef _WIN_
+    if ((transport == RT_UNIX) && (ulistenfd < 0)) {
+        struct sockaddr_un userv;
+
+        memset(&userv, 0, sizeof(userv));
+        userv.sun_family = AF_UNIX;
+#ifdef __linux__
+        // abstract namespace
+        userv.sun_path[0] = 0;
+        strncpy(userv.sun_path + 1, RT_UNIX_NAME, sizeof(userv.sun_path) - 2);
+#else
+        snprintf(userv.sun_path, sizeof(userv.sun_path) - 1, "/tmp/%s", RT_UNIX_NAME);
+        unlink(userv.sun_path);
+#endif
+        if ((ulistenfd = socket(PF_UNIX, SOCK_STREAM, 0)) < 0) {
+            printf("picsimlab: unix socket error : %s \n", strerror(errno));
+        } else if (bind(ulistenfd, (sockaddr*)&userv, sizeof(userv)) || listen(ulistenfd, SOMAXCONN)) {
+            printf("picsimlab: unix bind/listen error : %s \n", strerror(errno));
+            close(ulistenfd);
+            ulistenfd = -1;
+        }
+
+        if (ulistenfd < 0) {
+            printf("picsimlab: remote falling back to TCP transport\n");
+        } else {
+            setnblock(ulistenfd);
+        }
+    }
+#endif
+
+#ifdef __linux__
+    if ((transport == RT_SHM) && (!rshm)) {
+        if (rshm_open() < 0) {
+            printf("picsimlab: remote falling back to TCP transport\n");
+        }
+    }
+#endif
+
+    PICSimLab.ConfigMenuGUI(GMT_DISABLED);
+
     return 0;  // ret;
 }
 
+void bsim_remote::SetTransport(const int tr) {
+    transport = RT_TCP;
+#ifndef _WIN_
+    if (tr == RT_UNIX)
+        transport = tr;
+#endif
+#ifdef __linux__
+    if (tr == RT_SHM)
+        transport = tr;
+#endif
+    if (transport != tr) {
+        printf("picsimlab: remote transport %s not supported, using TCP\n", TransportName(tr));
+    }
+}
+
+const char* bsim_remote::TransportName(const int tr) {
+    switch (tr) {
+        case RT_UNIX:
+            return "unix";
+        case RT_SHM:
+            return "shm";
+        default:
+            return "tcp";
+    }
+}
+
+int bsim_remote::TransportFromName(const char* name) {
+    for (int tr = 0; tr < RT_LAST; tr++) {
+        if (!strcmp(name, TransportName(tr))) {
+            return tr;
+        }
+    }
+    return RT_TCP;
+}
+
 const int bsim_remote::TestConnection(void) {
     if (!connected) {
-#ifdef _TCP_
         struct sockaddr_in cli;
-#else
-        struct sockaddr_un cli;
-#endif
 #ifdef _WIN_
         int clilen;
 #else
@@ -181,12 +388,27 @@ const int bsim_remote::TestConnection(void) {
 #endif
 
         clilen = sizeof(cli);
-        if ((sockfd = accept(listenfd, (sockaddr*)&cli, &clilen)) < 0) {
+        sockfd = accept(listenfd, (sockaddr*)&cli, &clilen);
+        ctransport = RT_TCP;
+#ifndef _WIN_
+        if ((sockfd < 0) && (ulistenfd >= 0)) {
+            struct sockaddr_un ucli;
+            clilen = sizeof(ucli);
+            sockfd = accept(ulistenfd, (sockaddr*)&ucli, &clilen);
+            ctransport = RT_UNIX;
+        }
+#endif
+        if (sockfd < 0) {
             sockfd = -1;
-            connected = 0;
+#ifdef __linux__
+            if (!(rshm && __atomic_load_n(&rshm->client, __ATOMIC_ACQUIRE)))
+                return 0;
+            ctransport = RT_SHM;
+#else
             return 0;
+#endif
         }
-        printf("picsimlab: Ripes connected to PICSimLab!\n");
+        printf("picsimlab: Ripes connected to PICSimLab (%s)!\n", TransportName(ctransport));
 
         connected = 1;
         StartThread();
@@ -198,6 +420,17 @@ const int bsim_remote::DataAvaliable(void) {
     if (!connected)
         return 0;
 
+#ifdef __linux__
+    if (ctransport == RT_SHM) {
+        const rshm_ring_t* ring = &rshm->ring[RSHM_C2S];
+        if (!__atomic_load_n(&rshm->client, __ATOMIC_ACQUIRE)) {
+            ConnectionError("shm");
+            return 0;
+        }
+        return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) != ring->tail;
+    }
+#endif
+
     char dp;
 #ifndef _WIN_
     int ret = recv(sockfd, &dp, 1, MSG_PEEK | MSG_DONTWAIT);
@@ -232,6 +465,12 @@ void bsim_remote::Disconnect(void) {
         if (sockfd >= 0)
             close(sockfd);
         sockfd = -1;
+#ifdef __linux__
+        if (ctransport == RT_SHM) {
+            __atomic_store_n(&rshm->client, 0, __ATOMIC_RELEASE);
+            rshm_rings_reset();
+        }
+#endif
         connected = 0;
         PICSimLab.SetMcuPwr(0);
     }
@@ -256,6 +495,14 @@ void bsim_remote::EndServers(void) {
         close(listenfd);
     listenfd = -1;
 
+    if (ulistenfd >= 0)
+        close(ulistenfd);
+    ulistenfd = -1;
+
+#ifdef __linux__
+    rshm_close();
+#endif
+
     if (sockfd >= 0)
         close(sockfd);
     sockfd = -1;
@@ -785,12 +1032,30 @@ int bsim_remote::GetUARTTX(const int uart_num) {
 
 //===================== Ripes protocol =========================================
 
+int32_t bsim_remote::tr_recv(char* buff, const uint32_t size) {
+#ifdef __linux__
+    if (ctransport == RT_SHM) {
+        return rshm_read(&rshm->ring[RSHM_C2S], buff, size);
+    }
+#endif
+    return recv(sockfd, buff, size, MSG_WAITALL);
+}
+
+int32_t bsim_remote::tr_send(const char* buff, const uint32_t size) {
+#ifdef __linux__
+    if (ctransport == RT_SHM) {
+        return rshm_write(&rshm->ring[RSHM_S2C], buff, size);
+    }
+#endif
+    return send(sockfd, buff, size, MSG_NOSIGNAL);
+}
+
 int32_t bsim_remote::recv_payload(char* buff, const uint32_t payload_size) {
     char* dp = buff;
     int ret = 0;
     uint32_t size = payload_size;
     do {
-        if ((ret = recv(sockfd, dp, size, MSG_WAITALL)) != (int)size) {
+        if ((ret = tr_recv(dp, size)) != (int)size) {
             printf("receive error : %s \n", strerror(errno));
             return -1;
         }
@@ -830,7 +1095,7 @@ int32_t bsim_remote::send_cmd(const uint32_t cmd, const char* payload, const uin
         dp = buffer;
     }
 
-    if ((ret = send(sockfd, dp, dsize, MSG_NOSIGNAL)) != dsize) {
+    if ((ret = tr_send(dp, dsize)) != dsize) {
         printf("send error : %s \n", strerror(errno));
         return -1;
     }
@@ -842,7 +1107,7 @@ int32_t bsim_remote::recv_cmd(cmd_header_t* cmd_header) {
     int ret = 0;
     int size = sizeof(cmd_header_t);
     do {
-        if ((ret = recv(sockfd, dp, size, MSG_WAITALL)) != size) {
+        if ((ret = tr_recv(dp, size)) != size) {
             printf("receive error : %s \n", strerror(errno));
             return -1;
         }
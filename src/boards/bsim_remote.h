@@ -42,6 +42,40 @@ typedef struct {
 enum { VB_PINFO = 1, VB_PWRITE, VB_PREAD, VB_PSTATUS, VB_QUIT, VB_SYNC, VB_LAST };
 //==============================================================================
 
+// remote transports (TCP is always listening, local transports are optional)
+enum { RT_TCP, RT_UNIX, RT_SHM, RT_LAST };
+
+#define RT_TCP_PORT 7890
+#define RT_UNIX_NAME "picsimlab_remote"
+#define RT_SHM_NAME "/picsimlab_remote"  // shm_open name, the user id is appended (/dev/shm/picsimlab_remote.UID)
+
+//===================== shared memory transport ================================
+// The same cmd_header_t messages (network byte order) are carried over two
+// single producer / single consumer byte rings. Indexes are free running and
+// the seq field is used as futex word to wake up a sleeping peer.
+#define RSHM_MAGIC 0x5053484D  // "PSHM"
+#define RSHM_VERSION 1
+#define RSHM_RING_SIZE 65536  // must be power of 2
+
+enum { RSHM_C2S, RSHM_S2C };  // client to PICSimLab, PICSimLab to client
+
+typedef struct {
+    uint32_t head;     ///< write index
+    uint32_t tail;     ///< read index
+    uint32_t seq;      ///< futex word, incremented on every index change
+    uint32_t waiters;  ///< number of peers sleeping on seq
+    char data[RSHM_RING_SIZE];
+} rshm_ring_t;
+
+typedef struct {
+    uint32_t magic;       ///< RSHM_MAGIC when the region is initialized
+    uint32_t version;     ///< RSHM_VERSION
+    uint32_t server;      ///< 1 while PICSimLab is listening
+    uint32_t client;      ///< set to 1 by client after attach and 0 on detach
+    rshm_ring_t ring[2];  ///< rings indexed by RSHM_C2S and RSHM_S2C
+} rshm_t;
+//==============================================================================
+
 #define TTIMEOUT (BASETIMER * 1000000L)
 
 class bsim_remote : virtual public board {
@@ -79,6 +113,10 @@ public:
     int GetUARTRX(const int uart_num) override;
     int GetUARTTX(const int uart_num) override;
     virtual std::string GetClkLabel(void) override { return "IO (Mhz)"; };
+    void SetTransport(const int tr);
+    int GetTransport(void) { return transport; };
+    static const char* TransportName(const int tr);
+    static int TransportFromName(const char* name);
 
 protected:
     const int TestConnection(void);
@@ -90,7 +128,9 @@ protected:
     int32_t recv_cmd(cmd_header_t* cmd_header);
     int32_t recv_payload(char* buff, const uint32_t payload_size);
     int32_t send_cmd(const uint32_t cmd, const char* payload = NULL, const uint32_t payload_size = 0);
-//==============================================================================
+    //==============================================================================
+    int32_t tr_recv(char* buff, const uint32_t size);
+    int32_t tr_send(const char* buff, const uint32_t size);
 #ifdef _WIN_
     HANDLE serialfd[4];
 #else
@@ -103,6 +143,8 @@ protected:
     float freq;
     int sockfd;
     int connected;
+    int transport;   ///< selected local transport (RT_TCP = only TCP)
+    int ctransport;  ///< transport of the active connection
     char fname_[300];
     char fname_bak[300];
     unsigned short ADCvalues[16];
@@ -28,6 +28,8 @@
 #include <string.h>
 
 #include "../lib/picsimlab.h"
+#include "../lib/profiler.h"
+#include "../lib/spareparts.h"
 #include "bsim_simavr.h"
 #include "simavr/avr_eeprom.h"
 #include "simavr/avr_extint.h"
@@ -1409,13 +1411,13 @@ static void uart_in_hook(struct avr_irq_t* irq, uint32_t value, void* param) {
 
 void bsim_simavr::UpdateHardware(void) {
     if (usart_count) {
-        static int cont = 0;
+        static avr_cycle_count_t cont = 0;
         static int aux = 1;
         unsigned char c;
-        cont++;
 
-        if (cont > 1000) {
-            cont = 0;
+        // poll every 1000 cycles
+        if ((avr->cycle - cont) > 1000) {
+            cont = avr->cycle;
 
             if (PICSimLab.GetUseDSRReset() && serial_port_get_dsr(serialfd)) {
                 if (aux) {
@@ -1526,8 +1528,58 @@ void bsim_simavr::UpdateHardware(void) {
     }
 }
 
-void bsim_simavr::MStep(void) {
+// run one avr_run, an instruction is executed only when the core is not sleeping
+static inline void avr_run_inst(avr_t* avr) {
+    const int inst = (avr->state == cpu_Running) || (avr->state == cpu_Step);
     avr_run(avr);
+    if (inst && Profiler.IsRunning()) {
+        Profiler.Retire();
+    }
+}
+
+void bsim_simavr::MStep(void) {
+    avr_run_inst(avr);
+}
+
+unsigned int bsim_simavr::GetBatchCycles(const unsigned int max_cycles) {
+    // debug, profiler and always update parts need board interaction every cycle
+    if (PICSimLab.GetDebugStatus() || Profiler.IsRunning() || (use_spare && SpareParts.GetAlwaysUpdateCount())) {
+        return 1;
+    }
+
+    const uint32_t next = TimerGetNext();
+    if (next < max_cycles) {
+        return next;
+    }
+    return max_cycles;
+}
+
+static avr_cycle_count_t batch_deadline_hook(avr_t* avr, avr_cycle_count_t when, void* param) {
+    return 0;
+}
+
+unsigned int bsim_simavr::MRunCycles(const unsigned int max_cycles) {
+    const avr_cycle_count_t start = avr->cycle;
+    const avr_cycle_count_t end = start + max_cycles;
+
+    if (max_cycles > 1) {
+        // limit the simavr sleep to the batch deadline
+        avr_cycle_timer_register(avr, max_cycles, batch_deadline_hook, this);
+    }
+
+    // pin changes arrive by out_hook/ddr_hook and finish the batch
+    do {
+        avr_run_inst(avr);
+    } while ((avr->cycle < end) && (!ioupdated) && ((avr->state == cpu_Running) || (avr->state == cpu_Sleeping)));
+
+    if (max_cycles > 1) {
+        avr_cycle_timer_cancel(avr, batch_deadline_hook, this);
+    }
+
+    if (avr->cycle > start) {
+        return avr->cycle - start;
+    }
+    return 1;
 }
 
 void bsim_simavr::MStepResume(void) {}
@@ -81,6 +81,7 @@ public:
     void MStep(void) override;
     void MStepResume(void) override;
     void MReset(int flags) override;
+    int DBGIsSupported(void) override { return 1; };
     unsigned short* DBGGetProcID_p(void) override;
     unsigned int DBGGetPC(void) override;
     void DBGSetPC(unsigned int pc) override;
@@ -100,6 +101,16 @@ public:
     int GetUARTTX(const int uart_num) override;
     virtual void UpdateHardware(void);
 
+    /**
+     * @brief Return the number of cycles that can run before board interaction (1 if needed every cycle)
+     */
+    unsigned int GetBatchCycles(const unsigned int max_cycles);
+
+    /**
+     * @brief Run until max_cycles elapsed or a pin changed, return the number of cycles executed
+     */
+    unsigned int MRunCycles(const unsigned int max_cycles);
+
     static void out_hook(struct avr_irq_t* irq, uint32_t value, void* param) {
         picpin* p = (picpin*)param;
         p->value = value;
@@ -0,0 +1,198 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2024-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#include "dbg_bpindex.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define dprintf \
+    if (1) {    \
+    } else      \
+        printf
+
+void bpindex_init(bpindex_t* bpi, const unsigned int rom_size, const unsigned int ram_size) {
+    memset(bpi, 0, sizeof(bpindex_t));
+    bpi->size[BP_CODE] = rom_size;
+    bpi->size[BP_DWRITE] = ram_size;
+    bpi->size[BP_DREAD] = ram_size;
+    for (int t = 0; t < BP_LAST; t++) {
+        bpi->map[t] = (uint32_t*)calloc((bpi->size[t] >> 5) + 1, sizeof(uint32_t));
+    }
+}
+
+void bpindex_end(bpindex_t* bpi) {
+    for (int t = 0; t < BP_LAST; t++) {
+        if (bpi->map[t]) {
+            free(bpi->map[t]);
+        }
+        bpi->map[t] = NULL;
+        bpi->size[t] = 0;
+    }
+    bpi->count = 0;
+}
+
+static void bpindex_update_count(bpindex_t* bpi) {
+    bpi->count = 0;
+    for (int t = 0; t < BP_LAST; t++) {
+        bpi->count += bpi->tcount[t];
+    }
+}
+
+void bpindex_clear(bpindex_t* bpi, const int type) {
+    if (bpi->map[type]) {
+        memset(bpi->map[type], 0, ((bpi->size[type] >> 5) + 1) * sizeof(uint32_t));
+    }
+    bpi->outc[type] = 0;
+    bpi->tcount[type] = 0;
+
+    unsigned int j = 0;
+    for (unsigned int i = 0; i < bpi->extc; i++) {
+        if (bpi->ext[i].type != type) {
+            bpi->ext[j++] = bpi->ext[i];
+        }
+    }
+    bpi->extc = j;
+
+    bpindex_update_count(bpi);
+}
+
+int bpindex_set(bpindex_t* bpi, const int type, const unsigned int addr) {
+    if (bpindex_bit(bpi, type, addr)) {
+        return 0;
+    }
+
+    if (addr < bpi->size[type]) {
+        bpi->map[type][addr >> 5] |= (1U << (addr & 31));
+    } else if (bpi->outc[type] < BP_MAX_EXT) {
+        bpi->out[type][bpi->outc[type]++] = addr;
+    } else {
+        return -1;
+    }
+    bpi->tcount[type]++;
+    bpindex_update_count(bpi);
+    dprintf("bpindex set type=%i addr=0x%04X\n", type, addr);
+    return 0;
+}
+
+// set the breakpoint with hit count and condition, hits is copied from ext (0 for a new breakpoint)
+int bpindex_set_ext(bpindex_t* bpi, const bpext_t* ext) {
+    bpext_t* entry = bpindex_find_ext(bpi, ext->type, ext->addr);
+
+    if ((!entry) && (bpi->extc >= BP_MAX_EXT)) {
+        return -1;
+    }
+    // nothing is stored if the breakpoint can't be indexed
+    if (bpindex_set(bpi, ext->type, ext->addr)) {
+        return -1;
+    }
+    if (!entry) {
+        entry = &bpi->ext[bpi->extc++];
+    }
+    *entry = *ext;
+    return 0;
+}
+
+bpext_t* bpindex_find_ext(bpindex_t* bpi, const int type, const unsigned int addr) {
+    for (unsigned int i = 0; i < bpi->extc; i++) {
+        if ((bpi->ext[i].type == type) && (bpi->ext[i].addr == addr)) {
+            return &bpi->ext[i];
+        }
+    }
+    return NULL;
+}
+
+void bpindex_remove(bpindex_t* bpi, const int type, const unsigned int addr) {
+    if (!bpindex_bit(bpi, type, addr)) {
+        return;
+    }
+
+    if (addr < bpi->size[type]) {
+        bpi->map[type][addr >> 5] &= ~(1U << (addr & 31));
+    } else {
+        for (unsigned int i = 0; i < bpi->outc[type]; i++) {
+            if (bpi->out[type][i] == addr) {
+                bpi->out[type][i] = bpi->out[type][--bpi->outc[type]];
+                break;
+            }
+        }
+    }
+
+    bpext_t* ext = bpindex_find_ext(bpi, type, addr);
+    if (ext) {
+        *ext = bpi->ext[--bpi->extc];
+    }
+
+    bpi->tcount[type]--;
+    bpindex_update_count(bpi);
+}
+
+// called only on a bitmap hit, return 1 if the break must happen
+static int bpindex_ext_check(bpindex_t* bpi, const int type, const unsigned int addr, board* pboard) {
+    bpext_t* ext = bpindex_find_ext(bpi, type, addr);
+    if (!ext) {
+        return 1;
+    }
+    if (ext->use_cond) {
+        if (ext->cond_addr >= pboard->DBGGetRAMSize()) {
+            return 0;
+        }
+        if ((pboard->DBGGetRAM_p()[ext->cond_addr] & ext->cond_mask) != ext->cond_value) {
+            return 0;
+        }
+    }
+    ext->hits++;
+    return ext->hits > ext->ignore;
+}
+
+int bpindex_check(bpindex_t* bpi, board* pboard) {
+    unsigned int addr;
+
+    if (bpi->tcount[BP_CODE]) {
+        addr = pboard->DBGGetPC();
+        if (bpindex_bit(bpi, BP_CODE, addr) && bpindex_ext_check(bpi, BP_CODE, addr, pboard)) {
+            bpi->last_type = BP_CODE;
+            bpi->last_addr = addr;
+            return 1;
+        }
+    }
+    if (bpi->tcount[BP_DWRITE]) {
+        addr = pboard->DBGGetRAMLAWR();
+        if (bpindex_bit(bpi, BP_DWRITE, addr) && bpindex_ext_check(bpi, BP_DWRITE, addr, pboard)) {
+            bpi->last_type = BP_DWRITE;
+            bpi->last_addr = addr;
+            return 1;
+        }
+    }
+    if (bpi->tcount[BP_DREAD]) {
+        addr = pboard->DBGGetRAMLARD();
+        if (bpindex_bit(bpi, BP_DREAD, addr) && bpindex_ext_check(bpi, BP_DREAD, addr, pboard)) {
+            bpi->last_type = BP_DREAD;
+            bpi->last_addr = addr;
+            return 1;
+        }
+    }
+    return 0;
+}
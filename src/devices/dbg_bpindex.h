@@ -0,0 +1,89 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2024-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#ifndef DBG_BPINDEX_H
+#define DBG_BPINDEX_H
+
+#include "../lib/board.h"
+
+// breakpoint types
+enum { BP_CODE, BP_DWRITE, BP_DREAD, BP_LAST };
+
+#define BP_MAX_EXT 64
+
+// extended breakpoint (hit count and condition), only checked when the bitmap bit is set
+typedef struct {
+    unsigned char type;
+    unsigned int addr;
+    unsigned int ignore;     // number of hits to ignore before break
+    unsigned int hits;       // hits counter
+    unsigned char use_cond;  // break only if (RAM[cond_addr] & cond_mask) == cond_value
+    unsigned int cond_addr;
+    unsigned char cond_mask;
+    unsigned char cond_value;
+} bpext_t;
+
+typedef struct {
+    unsigned int count;                     // total number of breakpoints (0 = fast path)
+    unsigned int tcount[BP_LAST];           // number of breakpoints by type
+    unsigned int size[BP_LAST];             // bitmap size in addresses
+    uint32_t* map[BP_LAST];                 // one bit per address
+    unsigned int outc[BP_LAST];             // breakpoints out of bitmap range count
+    unsigned int out[BP_LAST][BP_MAX_EXT];  // breakpoints out of bitmap range
+    unsigned int extc;                      // extended breakpoints count
+    bpext_t ext[BP_MAX_EXT];                // extended breakpoints
+    unsigned int last_addr;                 // address of the last breakpoint hit
+    unsigned char last_type;                // type of the last breakpoint hit
+} bpindex_t;
+
+void bpindex_init(bpindex_t* bpi, const unsigned int rom_size, const unsigned int ram_size);
+void bpindex_end(bpindex_t* bpi);
+void bpindex_clear(bpindex_t* bpi, const int type);
+int bpindex_set(bpindex_t* bpi, const int type, const unsigned int addr);
+int bpindex_set_ext(bpindex_t* bpi, const bpext_t* ext);
+bpext_t* bpindex_find_ext(bpindex_t* bpi, const int type, const unsigned int addr);
+void bpindex_remove(bpindex_t* bpi, const int type, const unsigned int addr);
+int bpindex_check(bpindex_t* bpi, board* pboard);
+
+static inline int bpindex_bit(const bpindex_t* bpi, const int type, const unsigned int addr) {
+    if (addr < bpi->size[type]) {
+        return (bpi->map[type][addr >> 5] >> (addr & 31)) & 1;
+    }
+    for (unsigned int i = 0; i < bpi->outc[type]; i++) {
+        if (bpi->out[type][i] == addr)
+            return 1;
+    }
+    return 0;
+}
+
+// return 1 if a breakpoint is reached
+static inline int bpindex_test(bpindex_t* bpi, board* pboard) {
+    if (!bpi->count) {
+        return 0;
+    }
+    return bpindex_check(bpi, pboard);
+}
+
+#endif  // DBG_BPINDEX_H
@@ -0,0 +1,899 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#include "gdbrsp.h"
+#include "dbg_bpindex.h"
+
+// #define _DEBUG_
+#define dprint \
+    if (1) {   \
+    } else     \
+        printf
+
+#ifndef _POSIX_SOURCE
+#define _POSIX_SOURCE
+#endif
+
+#ifndef _WIN_
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <fcntl.h>
+#include <sys/unistd.h>
+#else
+#include <winsock.h>
+#define MSG_NOSIGNAL 0
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#ifndef _NOTHREAD
+#include <thread>
+#endif
+
+#include "../lib/picsimlab.h"
+
+#define GDB_SIGINT 2
+#define GDB_SIGTRAP 5
+
+#define GDBRSP_BUFFSIZE 4096
+#define GDBRSP_REQ_TIMEOUT 1000  // ms
+
+// requests from the server thread to the simulation thread
+enum { REQ_NONE, REQ_HALT, REQ_STEP, REQ_CONT, REQ_RESET, REQ_DETACH };
+
+static int sockfd = -1;
+static int listenfd = -1;
+static int server_started = 0;
+#ifndef _NOTHREAD
+static std::thread* server_thread = NULL;
+#endif
+static std::atomic<int> server_run(0);
+
+static std::mutex dbg_lock;  // protects dbg_board and bpi against gdbrsp_end
+static board* dbg_board = NULL;
+static int dbg_flags = 0;
+static bpindex_t bpi;
+static int bpi_started = 0;
+
+static std::atomic<int> request(REQ_NONE);
+static std::atomic<int> stop_signal(0);  // signal of the last stop, 0 while running
+static int running = 0;                  // target running under gdb control (server thread)
+static int skipbp = 0;                   // don't test breakpoints in the first instruction after continue
+static unsigned int stop_addr = 0;
+static unsigned char stop_type = BP_LAST;
+static bpext_t cond_list[BP_MAX_EXT];  // set by monitor cond, applied when gdb inserts the breakpoint
+static unsigned int cond_count = 0;
+
+static char inbuff[GDBRSP_BUFFSIZE];
+static int inlen = 0;
+static char pkt[GDBRSP_BUFFSIZE];
+static char reply[GDBRSP_BUFFSIZE];
+
+static const char hexchars[] = "0123456789abcdef";
+
+// register file seen by the gdb client: only the program counter, as register 0
+static const char target_xml[] =
+    "<?xml version=\"1.0\"?>"
+    "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">"
+    "<target version=\"1.0\">"
+    "<feature name=\"org.picsimlab.core\">"
+    "<reg name=\"pc\" bitsize=\"32\" type=\"code_ptr\" regnum=\"0\"/>"
+    "</feature>"
+    "</target>";
+
+void setnblock(int sock_descriptor);
+void setblock(int sock_descriptor);
+
+#ifndef _NOTHREAD
+static void gdbrsp_server(void);
+#else
+static void gdbrsp_poll(const int timeout_ms);
+static void gdbrsp_disconnect(void);
+#endif
+
+int gdbrsp_init(board* mboard, unsigned short tcpport, const int flags) {
+    struct sockaddr_in serv;
+
+    dbg_lock.lock();
+    dbg_board = mboard;
+    dbg_flags = flags;
+    if (!bpi_started) {
+        bpindex_init(&bpi, dbg_board->DBGGetROMSize(), dbg_board->DBGGetRAMSize());
+        bpi_started = 1;
+    }
+    dbg_lock.unlock();
+
+    if (!server_started) {
+        dprint("gdbrsp_init\n");
+
+        if ((listenfd = socket(PF_INET, SOCK_STREAM, 0)) < 0) {
+            printf("gdbrsp: socket error : %s \n", strerror(errno));
+            return 1;
+        };
+
+        int reuse = 1;
+        if (setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse)) < 0)
+            perror("gdbrsp: setsockopt(SO_REUSEADDR) failed");
+
+        memset(&serv, 0, sizeof(serv));
+        serv.sin_family = AF_INET;
+        serv.sin_addr.s_addr = htonl(INADDR_ANY);
+        serv.sin_port = htons(tcpport);
+
+        if (bind(listenfd, (sockaddr*)&serv, sizeof(serv))) {
+            printf("gdbrsp: bind error : %s \n", strerror(errno));
+            char stemp[100];
+            snprintf(stemp, 100, "Can't open gdb TCP port %i\n It is already in use by another application!",
+                     tcpport);
+            PICSimLab.RegisterError(stemp);
+            close(listenfd);
+            listenfd = -1;
+            return 1;
+        }
+
+        if (listen(listenfd, SOMAXCONN)) {
+            printf("gdbrsp: listen error : %s \n", strerror(errno));
+            close(listenfd);
+            listenfd = -1;
+            return 1;
+        }
+        setnblock(listenfd);
+        server_started = 1;
+        server_run = 1;
+#ifndef _NOTHREAD
+        server_thread = new std::thread(gdbrsp_server);
+#endif
+    }
+    return 0;
+}
+
+void gdbrsp_end(void) {
+    dbg_lock.lock();
+    dbg_board = NULL;
+    if (bpi_started) {
+        bpindex_end(&bpi);
+        bpi_started = 0;
+    }
+    request = REQ_NONE;
+    dbg_lock.unlock();
+}
+
+void gdbrsp_server_end(void) {
+    if (server_started) {
+        dprint("gdbrsp: server end\n");
+        server_run = 0;
+#ifndef _NOTHREAD
+        server_thread->join();
+        delete server_thread;
+        server_thread = NULL;
+#else
+        gdbrsp_disconnect();
+#endif
+        shutdown(listenfd, SHUT_RDWR);
+        close(listenfd);
+    }
+    listenfd = -1;
+    server_started = 0;
+}
+
+// simulation thread side
+
+static void gdbrsp_service(void) {
+    switch (request.load()) {
+        case REQ_HALT:
+            PICSimLab.Set_mcudbg(1);
+            dbg_board->MStepResume();
+            PICSimLab.SetCpuState(CPU_HALTED);
+            stop_type = BP_LAST;
+            stop_signal = GDB_SIGINT;
+            break;
+        case REQ_STEP:
+            dbg_board->MStep();
+            PICSimLab.SetCpuState(CPU_STEPPING);
+            stop_type = BP_LAST;
+            stop_signal = GDB_SIGTRAP;
+            break;
+        case REQ_CONT:
+            skipbp = 1;
+            PICSimLab.Set_mcudbg(0);
+            PICSimLab.SetCpuState(CPU_RUNNING);
+            break;
+        case REQ_RESET:
+            PICSimLab.Set_mcudbg(1);
+            dbg_board->MStepResume();
+            dbg_board->MReset(1);
+            stop_type = BP_LAST;
+            stop_signal = GDB_SIGTRAP;
+            break;
+        case REQ_DETACH:
+            for (int t = 0; t < BP_LAST; t++) {
+                bpindex_clear(&bpi, t);
+            }
+            PICSimLab.Set_mcudbg(0);
+            PICSimLab.SetCpuState(CPU_RUNNING);
+            break;
+    }
+    request = REQ_NONE;
+}
+
+int gdbrsp_testbp(void) {
+    if (request.load(std::memory_order_relaxed)) {
+        gdbrsp_service();
+    }
+
+    if (!PICSimLab.GetMcuDbg()) {
+        if (skipbp) {
+            skipbp = 0;
+        } else if (bpindex_test(&bpi, dbg_board)) {
+            dprint("gdbrsp: breakpoint type %i 0x%04X\n", bpi.last_type, bpi.last_addr);
+            PICSimLab.SetCpuState(CPU_BREAKPOINT);
+            PICSimLab.Set_mcudbg(1);
+            stop_type = bpi.last_type;
+            stop_addr = bpi.last_addr;
+            stop_signal = GDB_SIGTRAP;
+        }
+    }
+    return PICSimLab.GetMcuDbg();
+}
+
+int gdbrsp_loop(void) {
+    if (request.load(std::memory_order_relaxed)) {
+        gdbrsp_service();
+    }
+#ifdef _NOTHREAD
+    // without threads the packets are handled here
+    if (server_run) {
+        gdbrsp_poll(0);
+    }
+#endif
+    return 0;
+}
+
+// server thread side
+
+// post a request to the simulation thread and wait it be processed
+static int gdbrsp_request(const int req) {
+    request = req;
+#ifdef _NOTHREAD
+    // same thread of simulation, service the request now
+    gdbrsp_service();
+#else
+    for (int i = 0; i < GDBRSP_REQ_TIMEOUT; i++) {
+        if (request.load() == REQ_NONE) {
+            return 0;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    int expected = req;
+    if (request.compare_exchange_strong(expected, REQ_NONE)) {
+        // simulation is not running (power off), the cpu is already stopped
+        dprint("gdbrsp: request %i timeout\n", req);
+        if (req == REQ_HALT) {
+            stop_signal = GDB_SIGINT;
+        }
+        return 1;
+    }
+#endif
+    return 0;
+}
+
+static int gdbrsp_wait(const int fd, const int timeout_ms) {
+    fd_set rfds;
+    struct timeval tv;
+
+    FD_ZERO(&rfds);
+    FD_SET(fd, &rfds);
+    tv.tv_sec = 0;
+    tv.tv_usec = timeout_ms * 1000;
+    return select(fd + 1, &rfds, NULL, NULL, &tv);
+}
+
+static void gdbrsp_disconnect(void) {
+    dprint("gdbrsp: disconnected\n");
+    if (sockfd >= 0) {
+        shutdown(sockfd, SHUT_RDWR);
+        close(sockfd);
+    }
+    sockfd = -1;
+    inlen = 0;
+    running = 0;
+}
+
+static int gdbrsp_send(const char* data, const int len) {
+    if (send(sockfd, data, len, MSG_NOSIGNAL) != len) {
+        printf("gdbrsp: send error : %s \n", strerror(errno));
+        return 1;
+    }
+    return 0;
+}
+
+static int gdbrsp_send_packet(const char* data) {
+    char buff[GDBRSP_BUFFSIZE + 4];
+    unsigned char sum = 0;
+    int len = 0;
+
+    buff[len++] = '$';
+    while (*data && (len < GDBRSP_BUFFSIZE)) {
+        sum += *data;
+        buff[len++] = *data++;
+    }
+    buff[len++] = '#';
+    buff[len++] = hexchars[sum >> 4];
+    buff[len++] = hexchars[sum & 0x0F];
+    dprint("gdbrsp: -> %.*s\n", len, buff);
+    return gdbrsp_send(buff, len);
+}
+
+static int hexval(const char c) {
+    if ((c >= '0') && (c <= '9'))
+        return c - '0';
+    if ((c >= 'a') && (c <= 'f'))
+        return c - 'a' + 10;
+    if ((c >= 'A') && (c <= 'F'))
+        return c - 'A' + 10;
+    return -1;
+}
+
+static char* tohex(char* out, const unsigned char* data, const unsigned int len) {
+    for (unsigned int i = 0; i < len; i++) {
+        *out++ = hexchars[data[i] >> 4];
+        *out++ = hexchars[data[i] & 0x0F];
+    }
+    *out = 0;
+    return out;
+}
+
+// extract the next packet from the input buffer, return 1 for a packet, 2 for an interrupt, 3 for a
+// packet with bad checksum and 0 if none
+static int gdbrsp_next_packet(void) {
+    int start;
+    int i;
+
+    for (start = 0; start < inlen; start++) {
+        if (inbuff[start] == 0x03) {
+            memmove(inbuff, inbuff + start + 1, inlen - start - 1);
+            inlen -= start + 1;
+            return 2;
+        }
+        if (inbuff[start] == '$')
+            break;
+    }
+
+    if (start == inlen) {
+        inlen = 0;  // only acks
+        return 0;
+    }
+
+    for (i = start + 1; i < inlen; i++) {
+        if (inbuff[i] == '#')
+            break;
+    }
+    if ((i + 2) >= inlen) {
+        // incomplete packet
+        if (start) {
+            memmove(inbuff, inbuff + start, inlen - start);
+            inlen -= start;
+        }
+        if (inlen == GDBRSP_BUFFSIZE) {
+            inlen = 0;  // too big, drop
+        }
+        return 0;
+    }
+
+    unsigned char sum = 0;
+    int len = i - start - 1;
+    for (int j = 0; j < len; j++) {
+        sum += inbuff[start + 1 + j];
+        pkt[j] = inbuff[start + 1 + j];
+    }
+    pkt[len] = 0;
+
+    int ok = ((hexval(inbuff[i + 1]) << 4) | hexval(inbuff[i + 2])) == sum;
+
+    memmove(inbuff, inbuff + i + 3, inlen - i - 3);
+    inlen -= i + 3;
+
+    gdbrsp_send(ok ? "+" : "-", 1);
+    dprint("gdbrsp: <- %s\n", pkt);
+    return ok ? 1 : 3;
+}
+
+static void gdbrsp_stop_reply(char* out) {
+    switch (stop_type) {
+        case BP_DWRITE:
+            sprintf(out, "T%02xwatch:%x;", stop_signal.load(), stop_addr + GDBRSP_RAM_OFFSET);
+            break;
+        case BP_DREAD:
+            sprintf(out, "T%02xrwatch:%x;", stop_signal.load(), stop_addr + GDBRSP_RAM_OFFSET);
+            break;
+        default:
+            sprintf(out, "S%02x", stop_signal.load() ? stop_signal.load() : GDB_SIGTRAP);
+            break;
+    }
+}
+
+// return a pointer to the memory region that contains addr and adjust addr to the region offset
+static unsigned char* gdbrsp_mem(unsigned int* addr, const unsigned int len) {
+    unsigned char* mem;
+    unsigned int size;
+
+    if (*addr >= GDBRSP_EEPROM_OFFSET) {
+        *addr -= GDBRSP_EEPROM_OFFSET;
+        size = dbg_board->DBGGetEEPROM_Size();
+        mem = size ? dbg_board->DBGGetEEPROM_p() : NULL;
+    } else if (*addr >= GDBRSP_RAM_OFFSET) {
+        *addr -= GDBRSP_RAM_OFFSET;
+        size = dbg_board->DBGGetRAMSize();
+        mem = dbg_board->DBGGetRAM_p();
+    } else {
+        size = dbg_board->DBGGetROMSize();
+        mem = dbg_board->DBGGetROM_p();
+    }
+
+    if ((!mem) || (*addr >= size) || (len > (size - *addr))) {
+        return NULL;
+    }
+    return mem;
+}
+
+static bpext_t* gdbrsp_find_cond(const int type, const unsigned int addr) {
+    for (unsigned int i = 0; i < cond_count; i++) {
+        if ((cond_list[i].type == type) && (cond_list[i].addr == addr)) {
+            return &cond_list[i];
+        }
+    }
+    return NULL;
+}
+
+static int gdbrsp_bp_insert(const int type, const unsigned int addr) {
+    const bpext_t* cond = gdbrsp_find_cond(type, addr);
+    return cond ? bpindex_set_ext(&bpi, cond) : bpindex_set(&bpi, type, addr);
+}
+
+// gdb removes the breakpoints on each stop, the hit count is kept in cond_list
+static void gdbrsp_bp_remove(const int type, const unsigned int addr) {
+    const bpext_t* ext = bpindex_find_ext(&bpi, type, addr);
+    bpext_t* cond = gdbrsp_find_cond(type, addr);
+    if (ext && cond) {
+        cond->hits = ext->hits;
+    }
+    bpindex_remove(&bpi, type, addr);
+}
+
+static void gdbrsp_bp(const char* cmd) {
+    unsigned int type, addr, kind;
+    int ret = 0;
+
+    if (sscanf(cmd + 1, "%x,%x,%x", &type, &addr, &kind) != 3) {
+        strcpy(reply, "E01");
+        return;
+    }
+
+    switch (type) {
+        case 0:  // software breakpoint
+        case 1:  // hardware breakpoint
+            if (cmd[0] == 'Z') {
+                ret = gdbrsp_bp_insert(BP_CODE, addr);
+            } else {
+                gdbrsp_bp_remove(BP_CODE, addr);
+            }
+            break;
+        case 2:  // write watchpoint
+        case 3:  // read watchpoint
+        case 4:  // access watchpoint
+            if ((!(dbg_flags & GDBRSP_WATCH)) || (addr < GDBRSP_RAM_OFFSET) || (addr >= GDBRSP_EEPROM_OFFSET)) {
+                // let gdb use software watchpoints
+                reply[0] = 0;
+                return;
+            }
+            addr -= GDBRSP_RAM_OFFSET;
+            for (unsigned int i = 0; i < kind; i++) {
+                if (type != 3) {
+                    if (cmd[0] == 'Z') {
+                        ret |= gdbrsp_bp_insert(BP_DWRITE, addr + i);
+                    } else {
+                        gdbrsp_bp_remove(BP_DWRITE, addr + i);
+                    }
+                }
+                if (type != 2) {
+                    if (cmd[0] == 'Z') {
+                        ret |= gdbrsp_bp_insert(BP_DREAD, addr + i);
+                    } else {
+                        gdbrsp_bp_remove(BP_DREAD, addr + i);
+                    }
+                }
+            }
+            break;
+        default:
+            reply[0] = 0;
+            return;
+    }
+    strcpy(reply, ret ? "E0E" : "OK");
+}
+
+static void gdbrsp_read_mem(const char* cmd) {
+    unsigned int addr, len;
+    unsigned char* mem;
+
+    if ((sscanf(cmd + 1, "%x,%x", &addr, &len) != 2) || ((len * 2) >= GDBRSP_BUFFSIZE)) {
+        strcpy(reply, "E01");
+        return;
+    }
+    if (!(mem = gdbrsp_mem(&addr, len))) {
+        strcpy(reply, "E01");
+        return;
+    }
+    tohex(reply, mem + addr, len);
+}
+
+static void gdbrsp_write_mem(const char* cmd) {
+    unsigned int addr, len;
+    unsigned char* mem;
+    const char* data = strchr(cmd, ':');
+
+    if ((!data) || (sscanf(cmd + 1, "%x,%x", &addr, &len) != 2)) {
+        strcpy(reply, "E01");
+        return;
+    }
+    if ((dbg_flags & GDBRSP_MEMRO) || (!(mem = gdbrsp_mem(&addr, len))) || (strlen(data + 1) < (len * 2))) {
+        strcpy(reply, "E01");
+        return;
+    }
+    data++;
+    for (unsigned int i = 0; i < len; i++) {
+        mem[addr + i] = (hexval(data[2 * i]) << 4) | hexval(data[2 * i + 1]);
+    }
+    strcpy(reply, "OK");
+}
+
+static void gdbrsp_set_pc(const char* hex) {
+    unsigned char v[4];
+    unsigned int pc = 0;
+
+    for (int i = 0; i < 4; i++) {
+        v[i] = (hexval(hex[2 * i]) << 4) | hexval(hex[2 * i + 1]);
+        pc |= v[i] << (8 * i);
+    }
+    dbg_board->DBGSetPC(pc);
+}
+
+// qXfer:features:read:annex:offset,length
+static void gdbrsp_read_features(const char* args) {
+    unsigned int offset, length;
+    const unsigned int size = strlen(target_xml);
+
+    if (strncmp(args, "target.xml:", 11) || (sscanf(args + 11, "%x,%x", &offset, &length) != 2)) {
+        strcpy(reply, "E00");
+        return;
+    }
+    if (offset >= size) {
+        strcpy(reply, "l");
+        return;
+    }
+    if (length > (GDBRSP_BUFFSIZE - 8)) {
+        length = GDBRSP_BUFFSIZE - 8;
+    }
+    unsigned int n = size - offset;
+    if (n > length) {
+        n = length;
+    }
+    reply[0] = ((offset + n) < size) ? 'm' : 'l';
+    memcpy(reply + 1, target_xml + offset, n);
+    reply[n + 1] = 0;
+}
+
+// monitor cond code|write|read addr ignore [ram_addr mask value]
+// break after ignore hits and only when (RAM[ram_addr] & mask) == value, addresses as seen by gdb
+static void gdbrsp_cond(const char* args) {
+    char tname[8];
+    unsigned int addr, ignore, cond_addr, mask, value;
+    bpext_t ext;
+
+    if (!strcmp(args, "clear")) {
+        cond_count = 0;
+        strcpy(reply, "OK");
+        return;
+    }
+
+    const int n = sscanf(args, "%7s %i %i %i %i %i", tname, &addr, &ignore, &cond_addr, &mask, &value);
+    if ((n != 3) && (n != 6)) {
+        strcpy(reply, "E01");
+        return;
+    }
+
+    memset(&ext, 0, sizeof(ext));
+    if (!strcmp(tname, "code")) {
+        ext.type = BP_CODE;
+    } else if (!strcmp(tname, "write") || !strcmp(tname, "read")) {
+        if ((addr < GDBRSP_RAM_OFFSET) || (addr >= GDBRSP_EEPROM_OFFSET)) {
+            strcpy(reply, "E01");
+            return;
+        }
+        addr -= GDBRSP_RAM_OFFSET;
+        ext.type = (tname[0] == 'w') ? BP_DWRITE : BP_DREAD;
+    } else {
+        strcpy(reply, "E01");
+        return;
+    }
+    ext.addr = addr;
+    ext.ignore = ignore;
+    if (n == 6) {
+        if ((cond_addr >= GDBRSP_RAM_OFFSET) && (cond_addr < GDBRSP_EEPROM_OFFSET)) {
+            cond_addr -= GDBRSP_RAM_OFFSET;
+        }
+        ext.use_cond = 1;
+        ext.cond_addr = cond_addr;
+        ext.cond_mask = mask;
+        ext.cond_value = value;
+    }
+
+    bpext_t* cond = gdbrsp_find_cond(ext.type, ext.addr);
+    if (!cond) {
+        if (cond_count >= BP_MAX_EXT) {
+            strcpy(reply, "E0E");
+            return;
+        }
+        cond = &cond_list[cond_count++];
+    }
+    *cond = ext;
+
+    // already inserted by gdb
+    if (bpindex_bit(&bpi, ext.type, ext.addr) && bpindex_set_ext(&bpi, cond)) {
+        strcpy(reply, "E0E");
+        return;
+    }
+    strcpy(reply, "OK");
+}
+
+// monitor commands
+static void gdbrsp_monitor(const char* hex) {
+    char cmd[64];
+    unsigned int i;
+
+    for (i = 0; (i < (sizeof(cmd) - 1)) && hex[2 * i] && hex[2 * i + 1]; i++) {
+        cmd[i] = (hexval(hex[2 * i]) << 4) | hexval(hex[2 * i + 1]);
+    }
+    cmd[i] = 0;
+
+    if (!strcmp(cmd, "reset")) {
+        gdbrsp_request(REQ_RESET);
+        strcpy(reply, "OK");
+    } else if (!strncmp(cmd, "cond ", 5)) {
+        gdbrsp_cond(cmd + 5);
+    } else {
+        reply[0] = 0;
+    }
+}
+
+// handle one packet, return 1 to close connection
+static int gdbrsp_handle(void) {
+    unsigned int addr;
+    unsigned char pc[4];
+
+    reply[0] = 0;
+
+    switch (pkt[0]) {
+        case '?':
+            gdbrsp_stop_reply(reply);
+            break;
+        case 'g':
+            addr = dbg_board->DBGGetPC();
+            for (int i = 0; i < 4; i++) {
+                pc[i] = addr >> (8 * i);
+            }
+            tohex(reply, pc, 4);
+            break;
+        case 'G':
+            if (strlen(pkt + 1) >= 8) {
+                gdbrsp_set_pc(pkt + 1);
+                strcpy(reply, "OK");
+            } else {
+                strcpy(reply, "E01");
+            }
+            break;
+        case 'p':
+            if (strtoul(pkt + 1, NULL, 16) == 0) {
+                addr = dbg_board->DBGGetPC();
+                for (int i = 0; i < 4; i++) {
+                    pc[i] = addr >> (8 * i);
+                }
+                tohex(reply, pc, 4);
+            } else {
+                strcpy(reply, "E01");
+            }
+            break;
+        case 'P':
+            if ((strtoul(pkt + 1, NULL, 16) == 0) && strchr(pkt, '=') && (strlen(strchr(pkt, '=') + 1) >= 8)) {
+                gdbrsp_set_pc(strchr(pkt, '=') + 1);
+                strcpy(reply, "OK");
+            } else {
+                strcpy(reply, "E01");
+            }
+            break;
+        case 'm':
+            gdbrsp_read_mem(pkt);
+            break;
+        case 'M':
+            gdbrsp_write_mem(pkt);
+            break;
+        case 'Z':
+        case 'z':
+            gdbrsp_bp(pkt);
+            break;
+        case 's':
+        case 'c':
+            if (pkt[1]) {
+                dbg_board->DBGSetPC(strtoul(pkt + 1, NULL, 16));
+            }
+            stop_signal = 0;
+            if (pkt[0] == 's') {
+                gdbrsp_request(REQ_STEP);
+                gdbrsp_stop_reply(reply);
+            } else {
+                gdbrsp_request(REQ_CONT);
+                running = 1;
+                return 0;  // reply is sent when the target stops
+            }
+            break;
+        case 'H':
+        case 'T':
+            strcpy(reply, "OK");
+            break;
+        case 'D':
+            gdbrsp_send_packet("OK");
+            gdbrsp_request(REQ_DETACH);
+            return 1;
+        case 'k':
+            gdbrsp_request(REQ_DETACH);
+            return 1;
+        case 'q':
+            if (!strncmp(pkt, "qSupported", 10)) {
+                sprintf(reply, "PacketSize=%x;hwbreak+;qXfer:features:read+", GDBRSP_BUFFSIZE);
+            } else if (!strcmp(pkt, "qAttached")) {
+                strcpy(reply, "1");
+            } else if (!strcmp(pkt, "qC")) {
+                strcpy(reply, "QC1");
+            } else if (!strcmp(pkt, "qfThreadInfo")) {
+                strcpy(reply, "m1");
+            } else if (!strcmp(pkt, "qsThreadInfo")) {
+                strcpy(reply, "l");
+            } else if (!strcmp(pkt, "qOffsets")) {
+                strcpy(reply, "Text=0;Data=0;Bss=0");
+            } else if (!strncmp(pkt, "qSymbol", 7)) {
+                strcpy(reply, "OK");
+            } else if (!strncmp(pkt, "qXfer:features:read:", 20)) {
+                gdbrsp_read_features(pkt + 20);
+            } else if (!strncmp(pkt, "qRcmd,", 6)) {
+                gdbrsp_monitor(pkt + 6);
+            }
+            break;
+    }
+
+    return gdbrsp_send_packet(reply);
+}
+
+static int gdbrsp_accept(const int timeout_ms) {
+    struct sockaddr_in cli;
+#ifndef _WIN_
+    unsigned int clilen;
+#else
+    int clilen;
+#endif
+    clilen = sizeof(cli);
+
+    if (gdbrsp_wait(listenfd, timeout_ms) <= 0) {
+        return 1;
+    }
+
+    if ((sockfd = accept(listenfd, (sockaddr*)&cli, &clilen)) < 0) {
+        return 1;
+    }
+
+    setblock(sockfd);
+    dprint("gdbrsp: connected\n");
+
+    // gdb expects a stopped target on connection
+    inlen = 0;
+    cond_count = 0;
+    running = 0;
+    stop_type = BP_LAST;
+    gdbrsp_request(REQ_HALT);
+    return 0;
+}
+
+// handle a new connection or the received packets, waiting up to timeout_ms
+static void gdbrsp_poll(const int timeout_ms) {
+    int n;
+
+    if (sockfd < 0) {
+        if (dbg_board) {
+            gdbrsp_accept(timeout_ms);
+        }
+        return;
+    }
+
+    n = gdbrsp_wait(sockfd, timeout_ms);
+
+    std::lock_guard<std::mutex> lock(dbg_lock);
+
+    if (!dbg_board) {
+        gdbrsp_disconnect();
+        return;
+    }
+
+    if (n > 0) {
+        n = recv(sockfd, inbuff + inlen, GDBRSP_BUFFSIZE - inlen, 0);
+        if (n <= 0) {
+            gdbrsp_request(REQ_DETACH);
+            gdbrsp_disconnect();
+            return;
+        }
+        inlen += n;
+
+        while ((n = gdbrsp_next_packet())) {
+            if (n == 2) {
+                // interrupt (ctrl-c)
+                if (running) {
+                    gdbrsp_request(REQ_HALT);
+                }
+            } else if ((n == 1) && (!running)) {
+                if (gdbrsp_handle()) {
+                    gdbrsp_disconnect();
+                    return;
+                }
+            }
+        }
+    }
+
+    if (running && stop_signal.load()) {
+        running = 0;
+        gdbrsp_stop_reply(reply);
+        if (gdbrsp_send_packet(reply)) {
+            gdbrsp_disconnect();
+        }
+    }
+}
+
+#ifndef _NOTHREAD
+static void gdbrsp_server(void) {
+    while (server_run) {
+        if ((sockfd < 0) && (!dbg_board)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+        gdbrsp_poll(running ? 10 : 100);
+    }
+    gdbrsp_disconnect();
+}
+#endif
@@ -0,0 +1,49 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#ifndef GDBRSP_H
+#define GDBRSP_H
+
+#include "../lib/board.h"
+
+// gdbrsp_init flags
+#define GDBRSP_WATCH 0x01  // board supports DBGGetRAMLAWR/DBGGetRAMLARD (data watchpoints)
+#define GDBRSP_MEMRO 0x02  // board memory pointers are read only snapshots
+
+// memory map seen by the gdb client (same offsets used by simavr)
+#define GDBRSP_RAM_OFFSET 0x800000
+#define GDBRSP_EEPROM_OFFSET 0x810000
+
+// gdb remote serial protocol server over the board DBG* API
+// the packets are handled in a dedicated thread, the simulation thread only
+// runs gdbrsp_testbp each instruction and gdbrsp_loop each board cycle
+// (without threads, _NOTHREAD, the packets are handled by gdbrsp_loop)
+int gdbrsp_init(board* mboard, unsigned short tcpport, const int flags);
+int gdbrsp_loop(void);
+void gdbrsp_end(void);
+int gdbrsp_testbp(void);
+void gdbrsp_server_end(void);
+
+#endif /* GDBRSP_H */
@@ -0,0 +1,105 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#include "lcd_dirty.h"
+
+static void lcd_dirty_clear(lcd_dirty_t* dirty) {
+    for (int i = 0; i < dirty->lines; i++) {
+        dirty->cmin[i] = dirty->columns;
+        dirty->cmax[i] = -1;
+    }
+    dirty->first = -1;
+    dirty->last = -1;
+}
+
+void lcd_dirty_init(lcd_dirty_t* dirty, const unsigned short columns, const unsigned short lines) {
+    dirty->columns = columns;
+    dirty->lines = (lines > LCD_DIRTY_MAX) ? LCD_DIRTY_MAX : lines;
+    dirty->lock.clear();
+    lcd_dirty_clear(dirty);
+}
+
+void lcd_dirty_all(lcd_dirty_t* dirty) {
+    lcd_dirty_lock(dirty);
+    for (int i = 0; i < dirty->lines; i++) {
+        dirty->cmin[i] = 0;
+        dirty->cmax[i] = dirty->columns - 1;
+    }
+    dirty->first = 0;
+    dirty->last = dirty->lines - 1;
+    lcd_dirty_unlock(dirty);
+}
+
+static int lcd_dirty_band(lcd_dirty_t* dirty, Rect_t* area) {
+    int line = dirty->first;
+
+    if (line < 0)
+        return 0;
+
+    while ((line <= dirty->last) && (dirty->cmax[line] < 0)) {
+        line++;
+    }
+
+    if (line > dirty->last) {
+        dirty->first = -1;
+        dirty->last = -1;
+        return 0;
+    }
+
+    int cmin = dirty->cmin[line];
+    int cmax = dirty->cmax[line];
+    int end = line;
+
+    do {
+        if (dirty->cmin[end] < cmin)
+            cmin = dirty->cmin[end];
+        if (dirty->cmax[end] > cmax)
+            cmax = dirty->cmax[end];
+        dirty->cmin[end] = dirty->columns;
+        dirty->cmax[end] = -1;
+        end++;
+    } while ((end <= dirty->last) && (dirty->cmax[end] >= cmin) && (dirty->cmin[end] <= cmax));
+
+    area->x = cmin;
+    area->y = line;
+    area->width = cmax - cmin + 1;
+    area->height = end - line;
+
+    if (end > dirty->last) {
+        dirty->first = -1;
+        dirty->last = -1;
+    } else {
+        dirty->first = end;
+    }
+    return 1;
+}
+
+// returns in area the next band of consecutive dirty lines with overlapping spans, and marks it clean
+int lcd_dirty_next(lcd_dirty_t* dirty, Rect_t* area) {
+    lcd_dirty_lock(dirty);
+    const int ret = lcd_dirty_band(dirty, area);
+    lcd_dirty_unlock(dirty);
+    return ret;
+}
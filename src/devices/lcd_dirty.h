@@ -0,0 +1,71 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#ifndef LCD_DIRTY
+#define LCD_DIRTY
+
+#include <atomic>
+#include "../lib/draw.h"
+
+#define LCD_DIRTY_MAX 320
+
+// changed column span of each line (or page) of a display ram
+typedef struct {
+    std::atomic_flag lock;  // marked by the simulation thread, drawn by the GUI thread
+    unsigned short columns;
+    unsigned short lines;
+    short first;  // first dirty line, -1 when clean
+    short last;   // last dirty line
+    short cmin[LCD_DIRTY_MAX];
+    short cmax[LCD_DIRTY_MAX];
+} lcd_dirty_t;
+
+void lcd_dirty_init(lcd_dirty_t* dirty, const unsigned short columns, const unsigned short lines);
+void lcd_dirty_all(lcd_dirty_t* dirty);
+int lcd_dirty_next(lcd_dirty_t* dirty, Rect_t* area);
+
+static inline void lcd_dirty_lock(lcd_dirty_t* dirty) {
+    while (dirty->lock.test_and_set(std::memory_order_acquire)) {
+    }
+}
+
+static inline void lcd_dirty_unlock(lcd_dirty_t* dirty) {
+    lcd_dirty_unlock(dirty);
+}
+
+static inline void lcd_dirty_mark(lcd_dirty_t* dirty, const int column, const int line) {
+    lcd_dirty_lock(dirty);
+    if (dirty->cmin[line] > column)
+        dirty->cmin[line] = column;
+    if (dirty->cmax[line] < column)
+        dirty->cmax[line] = column;
+    if ((dirty->first < 0) || (dirty->first > line))
+        dirty->first = line;
+    if (dirty->last < line)
+        dirty->last = line;
+    lcd_dirty_unlock(dirty);
+}
+
+#endif  // LCD_DIRTY
@@ -428,6 +428,7 @@ void lcd_data(lcd_t* lcd, char data) {
                 lcd->cgram[lcd->addr_counter >> 3][j] &= ~(0x01 << (lcd->addr_counter & 0x07));
             }
         }
+        lcd->cgram_dirty.fetch_or(0x01 << (lcd->addr_counter >> 3));
         if (lcd->flags & L_DID) {
             lcd->addr_counter++;
             if (lcd->addr_counter >= 64)
@@ -529,6 +530,8 @@ void lcd_rst(lcd_t* lcd) {
     lcd->addr_counter = 0;
     lcd->addr_mode = LCD_ADDR_DDRAM;
     lcd->update = 1;
+    lcd->redraw = 1;
+    lcd->cgram_dirty = 0xFF;
     lcd->bc = 0;
 
     lcd->blink = 0;
@@ -561,6 +564,7 @@ void lcd_init(lcd_t* lcd, unsigned char cnum, unsigned char lnum, board* pboard_
     else
         lcd->lnum = 2;
     lcd->update = 1;
+    lcd->cgram_valid = 0;
 
     lcd_rst(lcd);
 
@@ -578,66 +582,75 @@ void lcd_on(lcd_t* lcd, int onoff) {
     lcd_rst(lcd);
 }
 
+void lcd_redraw(lcd_t* lcd) {
+    lcd->update = 1;
+    lcd->redraw = 1;
+}
+
+// pre-rendered 5x8 glyphs of the ROM font, for each power level
+static unsigned int lcd_glyph[2][224][40];
+static unsigned char lcd_glyph_init = 0;
+
+static void lcd_glyph_render(unsigned int* glyph, const char* font, const int pwr) {
+    const unsigned int on = 35 << 8;
+    const unsigned int off = (90 * pwr + 35) << 8;
+
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 5; x++) {
+            glyph[(y * 5) + x] = (font[x] & (0x01 << y)) ? on : off;
+        }
+    }
+}
+
+static const unsigned int* lcd_get_glyph(lcd_t* lcd, const int fp, const int pwr) {
+    if (fp >= 0x20) {
+        if (!(lcd_glyph_init & (0x01 << pwr))) {
+            for (int i = 0; i < 224; i++) {
+                lcd_glyph_render(lcd_glyph[pwr][i], (const char*)LCDfont[i], pwr);
+            }
+            lcd_glyph_init |= 0x01 << pwr;
+        }
+        return lcd_glyph[pwr][fp - 0x20];
+    }
+
+    const int n = fp & 0x07;
+    if (!(lcd->cgram_valid & (0x01 << ((pwr * 8) + n)))) {
+        lcd_glyph_render(lcd->cgram_glyph[pwr][n], lcd->cgram[n], pwr);
+        lcd->cgram_valid |= 0x01 << ((pwr * 8) + n);
+    }
+    return lcd->cgram_glyph[pwr][n];
+}
+
 void lcd_draw(lcd_t* lcd, CanvasCmd_ft CanvasCmd, float x1, float y1, float w1, float h1, int picpwr) {
-    int l, c, x, y;
+    int l, c;
     int loff = 0;
-    float w;
+    int pwr = (picpwr != 0);
+    int cl = -1;  // cursor line
+    int cc = -1;  // cursor column
+    int cursor = 0;
 
-    if (lcd->cnum == 16)
-        w = w1;
-    else
-        w = (int)(w1 * 1.25);
+    // characters written after this point stay dirty for the next draw
+    const unsigned char dirty = lcd->cgram_dirty.exchange(0);
+    lcd->cgram_valid &= ~(dirty | (dirty << 8));
+
+    if (lcd->redraw) {
+        float w;
+
+        if (lcd->cnum == 16)
+            w = w1;
+        else
+            w = (int)(w1 * 1.25);
 
-    if (lcd->lnum == 2)
-        (*CanvasCmd)({.cmd = CC_RECTANGLE, .Rectangle{1, x1, y1, w, h1}});
-    else
         (*CanvasCmd)({.cmd = CC_RECTANGLE, .Rectangle{1, x1, y1, w, h1}});
-    lcd->update = 0;
 
-    for (l = 0; l < lcd->lnum; l++) {
-        switch (l) {
-            case 0:
-                loff = 0;
-                break;
-            case 1:
-                loff = 40;
-                break;
-            case 2:
-                loff = lcd->cnum;
-                break;
-            case 3:
-                loff = 40 + lcd->cnum;
-                break;
-        }
-        for (c = 0; c < lcd->cnum; c++) {
-            for (x = 0; x < 5; x++) {
-                for (y = 0; y < 8; y++) {
-                    int cs = c - lcd->shift;
-                    if (cs < 0)
-                        cs = 40 + (cs % 40);
-                    if (cs >= 40)
-                        cs = cs % 40;
-                    char ram;
-                    int fp = ((unsigned char)lcd->ddram_char[(cs + loff) % DDRMAX]);
-
-                    if (fp >= 0x20) {
-                        ram = LCDfont[fp - 0x20][x];
-                    } else {
-                        ram = lcd->cgram[fp & 0x07][x];
-                    }
-                    if ((ram & (0x01 << y)) && (lcd->flags & L_DON)) {
-                        (*CanvasCmd)({.cmd = CC_SETFGCOLOR, .SetFgColor{0, 35, 0}});
-                        (*CanvasCmd)({.cmd = CC_SETCOLOR, .SetColor{0, 35, 0}});
-                    } else {
-                        (*CanvasCmd)({.cmd = CC_SETFGCOLOR, .SetFgColor{0, (unsigned int)(90 * picpwr + 35), 0}});
-                        (*CanvasCmd)({.cmd = CC_SETCOLOR, .SetColor{0, (unsigned int)(90 * picpwr + 35), 0}});
-                    }
-                    (*CanvasCmd)({.cmd = CC_RECTANGLE,
-                                  .Rectangle{1, x1 + 2 + (x * 4) + (c * 23), y1 + 10 + (y * 4) + (l * 35), 4, 4}});
-                }
+        for (l = 0; l < 4; l++) {
+            for (c = 0; c < 40; c++) {
+                lcd->cell[l][c] = -1;
             }
         }
+        lcd->redraw = 0;
     }
+    lcd->update = 0;
 
     // cursor
     if ((lcd->flags & L_DON) && (lcd->flags & L_CON)) {
@@ -656,13 +669,60 @@ void lcd_draw(lcd_t* lcd, CanvasCmd_ft CanvasCmd, float x1, float y1, float w1,
 
         if ((c >= 0) && (c < lcd->cnum))  // draw only visible columns
         {
-            (*CanvasCmd)({.cmd = CC_SETFGCOLOR, .SetFgColor{0, 35, 0}});
-            (*CanvasCmd)({.cmd = CC_SETCOLOR, .SetColor{0, 35, 0}});
+            cl = l;
+            cc = c;
+            cursor = lcd->blink ? 2 : 1;
+        }
+    }
 
-            if (lcd->blink)
-                (*CanvasCmd)({.cmd = CC_RECTANGLE, .Rectangle{1, x1 + 2 + (c * 23), y1 + 10 + (l * 35), 20, 32}});
-            else
-                (*CanvasCmd)({.cmd = CC_RECTANGLE, .Rectangle{1, x1 + 2 + (c * 23), y1 + 38 + (l * 35), 20, 4}});
+    for (l = 0; l < lcd->lnum; l++) {
+        switch (l) {
+            case 0:
+                loff = 0;
+                break;
+            case 1:
+                loff = 40;
+                break;
+            case 2:
+                loff = lcd->cnum;
+                break;
+            case 3:
+                loff = 40 + lcd->cnum;
+                break;
+        }
+        for (c = 0; c < lcd->cnum; c++) {
+            int cs = c - lcd->shift;
+            if (cs < 0)
+                cs = 40 + (cs % 40);
+            if (cs >= 40)
+                cs = cs % 40;
+            int fp = ((unsigned char)lcd->ddram_char[(cs + loff) % DDRMAX]);
+
+            if (!(lcd->flags & L_DON))
+                fp = ' ';
+
+            // only cells with a different glyph, power level or cursor are drawn
+            short key = fp | (pwr << 8);
+            if ((l == cl) && (c == cc))
+                key |= cursor << 9;
+
+            if ((key == lcd->cell[l][c]) && ((fp >= 0x20) || !(dirty & (0x01 << (fp & 0x07)))))
+                continue;
+            lcd->cell[l][c] = key;
+
+            (*CanvasCmd)({.cmd = CC_PUTPIXELS,
+                          .PutPixels{lcd_get_glyph(lcd, fp, pwr), 5, 8, 1, 5, {0, 0, 5, 8}, x1 + 2 + (c * 23),
+                                     y1 + 10 + (l * 35), 0, 4.0}});
+
+            if ((l == cl) && (c == cc)) {
+                (*CanvasCmd)({.cmd = CC_SETFGCOLOR, .SetFgColor{0, 35, 0}});
+                (*CanvasCmd)({.cmd = CC_SETCOLOR, .SetColor{0, 35, 0}});
+
+                if (lcd->blink)
+                    (*CanvasCmd)({.cmd = CC_RECTANGLE, .Rectangle{1, x1 + 2 + (c * 23), y1 + 10 + (l * 35), 20, 32}});
+                else
+                    (*CanvasCmd)({.cmd = CC_RECTANGLE, .Rectangle{1, x1 + 2 + (c * 23), y1 + 38 + (l * 35), 20, 4}});
+            }
         }
     }
-}
\ No newline at end of file
+}
@@ -28,6 +28,7 @@
 
 class board;
 
+#include <atomic>
 #include "../lib/draw.h"
 
 #define DDRMAX 80
@@ -69,6 +70,7 @@ typedef struct {
     unsigned char addr_counter;
     unsigned char addr_mode;
     unsigned char update;     // redraw
+    unsigned char redraw;     // repaint of all display area needed
     unsigned char blink;      // cursor state
     char shift;               // display shift
     char ddram_char[DDRMAX];  // ddram
@@ -80,8 +82,14 @@ typedef struct {
     unsigned char lnum;  // number of lines 1,2 or 4
     board* pboard;
     int TimerID;
+    short cell[4][40];           // glyph drawn on each display cell, -1 if unknown
+    std::atomic<unsigned char> cgram_dirty;  // cgram characters changed since last draw, set by the simulation
+    unsigned short cgram_valid;              // cgram glyphs rendered, bit (power * 8 + character), draw only
+    unsigned int cgram_glyph[2][8][40];
 } lcd_t;
 
+extern const unsigned char LCDfont[224][5];  // 5x8 character font, codes 0x20 to 0xFF
+
 void lcd_cmd(lcd_t* lcd, char cmd);
 void lcd_data(lcd_t* lcd, char data);
 unsigned char lcd_read_busyf_acounter(lcd_t* lcd);
@@ -90,6 +98,7 @@ void lcd_rst(lcd_t* lcd);
 void lcd_init(lcd_t* lcd, unsigned char cnum, unsigned char lnum, board* pboard_);
 void lcd_end(lcd_t* lcd);
 void lcd_on(lcd_t* lcd, int onoff);
+void lcd_redraw(lcd_t* lcd);
 void lcd_draw(lcd_t* lcd, CanvasCmd_ft CanvasCmd, float x1, float y1, float w1, float h1, int picpwr);
 
 #endif
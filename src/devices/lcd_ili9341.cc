@@ -34,11 +34,50 @@
 
 #include "lcd_ili9341.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define RGB565(c) ((((c) >> 8) & 0xF800) | (((c) >> 5) & 0x07E0) | (((c) >> 3) & 0x001F))
+
+// canvas format copy of the dirty areas, shared by all displays since drawing is done by the GUI thread only
+static unsigned int lcd_ili9341_fb[240][320];
+
+static void lcd_ili9341_rgb565_to_rgb888(unsigned int* dst, const unsigned short* src, const int size) {
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rmask = _mm_set1_epi32(0xF800);
+    const __m128i gmask = _mm_set1_epi32(0x07E0);
+    const __m128i bmask = _mm_set1_epi32(0x001F);
+
+    for (; i + 8 <= size; i += 8) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i lo = _mm_unpacklo_epi16(v, zero);
+        __m128i hi = _mm_unpackhi_epi16(v, zero);
+        lo = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_and_si128(lo, rmask), 8),
+                                       _mm_slli_epi32(_mm_and_si128(lo, gmask), 5)),
+                          _mm_slli_epi32(_mm_and_si128(lo, bmask), 3));
+        hi = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(_mm_and_si128(hi, rmask), 8),
+                                       _mm_slli_epi32(_mm_and_si128(hi, gmask), 5)),
+                          _mm_slli_epi32(_mm_and_si128(hi, bmask), 3));
+        _mm_storeu_si128((__m128i*)(dst + i), lo);
+        _mm_storeu_si128((__m128i*)(dst + i + 4), hi);
+    }
+#endif
+    for (; i < size; i++) {
+        const unsigned int v = src[i];
+        dst[i] = ((v & 0xF800) << 8) | ((v & 0x07E0) << 5) | ((v & 0x001F) << 3);
+    }
+}
+
 void lcd_ili9341_rst(lcd_ili9341_t* lcd) {
     int i, j;
     for (i = 0; i < 240; i++)
         for (j = 0; j < 320; j++)
-            lcd->ram[i][j] = 0xFF000000;
+            lcd->ram[i][j] = 0;
+    lcd_dirty_init(&lcd->dirty, 240, 320);
+    lcd_dirty_all(&lcd->dirty);
 
     bitbang_spi_rst(&lcd->bb_spi);
     lcd->pwr = -1;
@@ -69,11 +108,8 @@ void lcd_ili9341_init(lcd_ili9341_t* lcd) {
 }
 
 void lcd_ili9341_update(lcd_ili9341_t* lcd) {
-    int i, j;
     lcd->update = 1;
-    for (i = 0; i < 240; i++)
-        for (j = 0; j < 320; j++)
-            lcd->ram[i][j] |= 0xFF000000;
+    lcd_dirty_all(&lcd->dirty);
 }
 
 static void lcd_ili9341_readdata(lcd_ili9341_t* lcd) {
@@ -91,7 +127,8 @@ static void lcd_ili9341_readdata(lcd_ili9341_t* lcd) {
 
             dcprint("data[%i][%i]:%#08lX  \n", lcd->x, lcd->y, lcd->color);
 
-            lcd->ram[lcd->x % 240][lcd->y % 320] = lcd->color;
+            lcd->ram[lcd->x % 240][lcd->y % 320] = RGB565(lcd->color);
+            lcd_dirty_mark(&lcd->dirty, lcd->x % 240, lcd->y % 320);
             lcd->update = 1;
 
             lcd->x++;
@@ -133,7 +170,8 @@ static void lcd_ili9341_readdata(lcd_ili9341_t* lcd) {
                     lx = 239 - lx;
                 }
 
-                lcd->ram[lx][ly] = lcd->color;
+                lcd->ram[lx][ly] = RGB565(lcd->color);
+                lcd_dirty_mark(&lcd->dirty, lx, ly);
             }
             lcd->update = 1;
 
@@ -594,38 +632,19 @@ unsigned short lcd_ili9341_8_io(lcd_ili9341_t* lcd, const unsigned char** pins_v
 
 void lcd_ili9341_draw(lcd_ili9341_t* lcd, CanvasCmd_ft CanvasCmd, const int x1, const int y1, const int w1,
                       const int h1, const int picpwr) {
-    unsigned short x, y;
-    unsigned char r, g, b;
+    Rect_t area;
 
     lcd->update = 0;
 
     if (!lcd->on)
         return;
 
-    for (x = 0; x < 240; x++) {
-        for (y = 0; y < 320; y++) {
-            if (lcd->ram[x][y] & 0xFF000000) {
-                lcd->ram[x][y] &= 0x00FFFFFF;  // clear draw
-
-                r = (lcd->ram[x][y] & 0xFF0000) >> 16;
-                g = (lcd->ram[x][y] & 0x00FF00) >> 8;
-                b = (lcd->ram[x][y] & 0x0000FF);
-
-                /*
-                r = (lcd->ram[x][y] & 0x00F800) >> 8;
-                g = (lcd->ram[x][y] & 0x0007E0) >> 3;
-                b = (lcd->ram[x][y] & 0x00001F) << 3;
-                r = ((lcd->ram[x][y] & 0x00F800) >> 11)*8.23;
-                g = ((lcd->ram[x][y] & 0x0007E0) >> 5)*4.05;
-                b = (lcd->ram[x][y] & 0x00001F)*8.23;
-                 */
-
-                (*CanvasCmd)({.cmd = CC_SETCOLOR, .SetColor{r, g, b}});
-
-                // canvas->Rectangle (1, x1 + (x * 2), y1 + (y * 8 * 2)+(z * 2), 2, 2);
-
-                (*CanvasCmd)({.cmd = CC_POINT, .Point{(float)(x1 + y), (float)(y1 + (239 - x))}});
-            }
+    // ram is stored as ram[column][line] of the portrait panel, shown rotated in landscape
+    while (lcd_dirty_next(&lcd->dirty, &area)) {
+        for (int x = area.x; x < area.x + area.width; x++) {
+            lcd_ili9341_rgb565_to_rgb888(&lcd_ili9341_fb[x][area.y], &lcd->ram[x][area.y], area.height);
         }
+        (*CanvasCmd)({.cmd = CC_PUTPIXELS,
+                      .PutPixels{&lcd_ili9341_fb[0][0], 240, 320, 320, 1, area, (float)x1, (float)y1, 270, 1.0}});
     }
 }
@@ -29,6 +29,7 @@
 #include "../lib/draw.h"
 
 #include "bitbang_spi.h"
+#include "lcd_dirty.h"
 
 /* pinout
   1 /RST
@@ -42,7 +43,8 @@
 */
 
 typedef struct {
-    unsigned long int ram[240][320];
+    unsigned short ram[240][320];  // RGB565
+    lcd_dirty_t dirty;             // changed columns of each ram line
     unsigned char pwr;  // previous wr
     unsigned char prd;  // previous rw
     bitbang_spi_t bb_spi;
@@ -34,7 +34,9 @@ void lcd_pcd8544_rst(lcd_pcd8544_t* lcd) {
     int i, j;
     for (i = 0; i < 84; i++)
         for (j = 0; j < 6; j++)
-            lcd->ram[i][j] = 0xFF00;
+            lcd->ram[i][j] = 0;
+    lcd_dirty_init(&lcd->dirty, 84, 6);
+    lcd_dirty_all(&lcd->dirty);
     lcd->update = 1;
     lcd->dat = 0;
     lcd->x = 0;
@@ -54,11 +56,8 @@ void lcd_pcd8544_init(lcd_pcd8544_t* lcd) {
 }
 
 void lcd_pcd8544_update(lcd_pcd8544_t* lcd) {
-    int i, j;
     lcd->update = 1;
-    for (i = 0; i < 84; i++)
-        for (j = 0; j < 6; j++)
-            lcd->ram[i][j] |= 0xFF00;
+    lcd_dirty_all(&lcd->dirty);
 }
 // void lcd_pcd8544_end(lcd_pcd8544_t *lcd){}
 
@@ -130,7 +129,8 @@ unsigned char lcd_pcd8544_io(lcd_pcd8544_t* lcd, unsigned char din, unsigned cha
             } else  // data
             {
                 dprint("data[%i][%i]:%#02X  \n", lcd->x, lcd->y, lcd->dat);
-                lcd->ram[lcd->x][lcd->y] = 0xFF00 | lcd->dat;
+                lcd->ram[lcd->x][lcd->y] = lcd->dat;
+                lcd_dirty_mark(&lcd->dirty, lcd->x, lcd->y);
                 lcd->update = 1;
                 if (lcd->v) {
                     lcd->y++;
@@ -157,40 +157,30 @@ unsigned char lcd_pcd8544_io(lcd_pcd8544_t* lcd, unsigned char din, unsigned cha
 }
 
 void lcd_pcd8544_draw(lcd_pcd8544_t* lcd, CanvasCmd_ft CanvasCmd, int x1, int y1, int w1, int h1, int picpwr) {
-    unsigned char x, y, z;
-
-    if (lcd->e) {
-        (*CanvasCmd)({.cmd = CC_SETFGCOLOR, .SetFgColor{0, 0, 0}});
-        (*CanvasCmd)({.cmd = CC_SETCOLOR, .SetColor{0, 0, 0}});
-    } else {
-        (*CanvasCmd)({.cmd = CC_SETFGCOLOR, .SetFgColor{82, 129, 111}});
-        (*CanvasCmd)({.cmd = CC_SETCOLOR, .SetColor{82, 129, 111}});
-    }
-
-    // canvas->Rectangle (1, x1, y1, w1, h1);//erase all
+    int x, y, z;
+    Rect_t area;
 
     lcd->update = 0;
 
     if ((lcd->pd) || (!lcd->d))
         return;
 
-    for (x = 0; x < 84; x++) {
-        for (y = 0; y < 6; y++) {
-            if (lcd->ram[x][y] & 0xFF00) {
-                lcd->ram[x][y] &= 0x00FF;  // clear draw
+    while (lcd_dirty_next(&lcd->dirty, &area)) {
+        for (x = area.x; x < area.x + area.width; x++) {
+            for (y = area.y; y < area.y + area.height; y++) {
                 for (z = 0; z < 8; z++) {
                     if (!(lcd->ram[x][y] & (0x01 << z)) != (!lcd->e)) {
-                        (*CanvasCmd)({.cmd = CC_SETFGCOLOR, .SetFgColor{0, 0, 0}});
-                        (*CanvasCmd)({.cmd = CC_SETCOLOR, .SetColor{0, 0, 0}});
+                        lcd->fb[y * 8 + z][x] = 0x000000;
                     } else {
-                        (*CanvasCmd)({.cmd = CC_SETFGCOLOR, .SetFgColor{82, 129, 111}});
-                        (*CanvasCmd)({.cmd = CC_SETCOLOR, .SetColor{82, 129, 111}});
+                        lcd->fb[y * 8 + z][x] = 0x52816F;
                     }
-                    (*CanvasCmd)({.cmd = CC_RECTANGLE,
-                                  .Rectangle{1, (float)(x1 + (x * 2)), (float)(y1 + (y * 8 * 2) + (z * 2)), 2, 2}});
-                    // canvas->Point (x1 + x, y1 + y*8 +z);
                 }
             }
         }
+        // banks to pixel lines
+        area.y *= 8;
+        area.height *= 8;
+        (*CanvasCmd)(
+            {.cmd = CC_PUTPIXELS, .PutPixels{&lcd->fb[0][0], 84, 48, 1, 84, area, (float)x1, (float)y1, 0, 2.0}});
     }
 }
@@ -29,6 +29,7 @@
 #include "../lib/draw.h"
 
 #include "bitbang_spi.h"
+#include "lcd_dirty.h"
 
 /* pinout
   1 /RST
@@ -43,6 +44,8 @@
 
 typedef struct {
     unsigned short int ram[84][6];
+    lcd_dirty_t dirty;        // changed columns of each bank
+    unsigned int fb[48][84];  // rendered pixels
     bitbang_spi_t bb_spi;
     unsigned char hrst;
     unsigned char dat;
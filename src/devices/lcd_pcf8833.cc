@@ -85,11 +85,29 @@
 #define MY 0x80
 #define MX 0x40
 
+static void lcd_pcf8833_write(lcd_pcf8833_t* lcd) {
+    int x = lcd->x;
+    int y = lcd->y;
+
+    if ((lcd->madctl & MX) && (lcd->madctl & MX)) {
+        x = 131 - x;
+        y = 131 - y;
+    } else if (lcd->madctl & MX)
+        x = 131 - x;
+    else if (lcd->madctl & MY)
+        y = 131 - y;
+
+    lcd->ram[x][y] = lcd->color & 0x00FFFFFF;
+    lcd_dirty_mark(&lcd->dirty, x, y);
+}
+
 void lcd_pcf8833_rst(lcd_pcf8833_t* lcd) {
     int i, j;
     for (i = 0; i < 132; i++)
         for (j = 0; j < 132; j++)
-            lcd->ram[i][j] = 0xFF000000;
+            lcd->ram[i][j] = 0;
+    lcd_dirty_init(&lcd->dirty, 132, 132);
+    lcd_dirty_all(&lcd->dirty);
 
     lcd->tp = 0;
     lcd->update = 1;
@@ -113,12 +131,14 @@ void lcd_pcf8833_init(lcd_pcf8833_t* lcd) {
     lcd->cmax = 131;
     lcd->rmin = 0;
     lcd->rmax = 131;
+    lcd_dirty_init(&lcd->dirty, 132, 132);
 
     bitbang_spi_init(&lcd->bb_spi, 9);
 }
 
 void lcd_pcf8833_update(lcd_pcf8833_t* lcd) {
     lcd->update = 1;
+    lcd_dirty_all(&lcd->dirty);
 }
 // void lcd_pcf8833_end(lcd_pcf8833_t *lcd){}
 
@@ -270,14 +290,7 @@ unsigned char lcd_pcf8833_io(lcd_pcf8833_t* lcd, unsigned char pdat, unsigned ch
                                     lcd->b = ((lcd->dat & 0xF0) >> 4);
 
                                     lcd->color = 0xFF000000 | (lcd->r << 20) | (lcd->g << 12) | (lcd->b << 4);
-                                    if ((lcd->madctl & MX) && (lcd->madctl & MX))
-                                        lcd->ram[131 - lcd->x][131 - lcd->y] = lcd->color;
-                                    else if (lcd->madctl & MX)
-                                        lcd->ram[131 - lcd->x][lcd->y] = lcd->color;
-                                    else if (lcd->madctl & MY)
-                                        lcd->ram[lcd->x][131 - lcd->y] = lcd->color;
-                                    else
-                                        lcd->ram[lcd->x][lcd->y] = lcd->color;
+                                    lcd_pcf8833_write(lcd);
                                     lcd->update = 1;
                                     lcd->x++;
                                     if (lcd->x > lcd->cmax) {
@@ -295,14 +308,7 @@ unsigned char lcd_pcf8833_io(lcd_pcf8833_t* lcd, unsigned char pdat, unsigned ch
                                     lcd->b = (lcd->dat & 0x0F);
 
                                     lcd->color = 0xFF000000 | (lcd->r << 20) | (lcd->g << 12) | (lcd->b << 4);
-                                    if ((lcd->madctl & MX) && (lcd->madctl & MX))
-                                        lcd->ram[131 - lcd->x][131 - lcd->y] = lcd->color;
-                                    else if (lcd->madctl & MX)
-                                        lcd->ram[131 - lcd->x][lcd->y] = lcd->color;
-                                    else if (lcd->madctl & MY)
-                                        lcd->ram[lcd->x][131 - lcd->y] = lcd->color;
-                                    else
-                                        lcd->ram[lcd->x][lcd->y] = lcd->color;
+                                    lcd_pcf8833_write(lcd);
                                     lcd->update = 1;
                                     lcd->x++;
                                     if (lcd->x > lcd->cmax) {
@@ -329,14 +335,7 @@ unsigned char lcd_pcf8833_io(lcd_pcf8833_t* lcd, unsigned char pdat, unsigned ch
 
                                     lcd->color = 0xFF000000 | (lcd->r << 19) | (lcd->g << 10) | (lcd->b << 3);
 
-                                    if ((lcd->madctl & MX) && (lcd->madctl & MX))
-                                        lcd->ram[131 - lcd->x][131 - lcd->y] = lcd->color;
-                                    else if (lcd->madctl & MX)
-                                        lcd->ram[131 - lcd->x][lcd->y] = lcd->color;
-                                    else if (lcd->madctl & MY)
-                                        lcd->ram[lcd->x][131 - lcd->y] = lcd->color;
-                                    else
-                                        lcd->ram[lcd->x][lcd->y] = lcd->color;
+                                    lcd_pcf8833_write(lcd);
                                     lcd->update = 1;
                                     lcd->x++;
                                     if (lcd->x > lcd->cmax) {
@@ -360,27 +359,12 @@ unsigned char lcd_pcf8833_io(lcd_pcf8833_t* lcd, unsigned char pdat, unsigned ch
 }
 
 void lcd_pcf8833_draw(lcd_pcf8833_t* lcd, CanvasCmd_ft CanvasCmd, int x1, int y1, int w1, int h1, int picpwr) {
-    unsigned char x, y;
-
-    // canvas->Rectangle (1, x1, y1, w1, h1);//erase all
+    Rect_t area;
 
     lcd->update = 0;
 
-    for (x = 0; x < 132; x++) {
-        for (y = 0; y < 132; y++) {
-            if (lcd->ram[x][y] & 0xFF000000) {
-                unsigned int color = lcd->ram[x][y];
-                unsigned char r = ((color & 0x00FF0000) >> 16);
-                unsigned char g = ((color & 0x0000FF00) >> 8);
-                unsigned char b = (color & 0x000000FF);
-
-                lcd->ram[x][y] &= 0x00FFFFFF;  // clear draw
-
-                (*CanvasCmd)({.cmd = CC_SETFGCOLOR, .SetFgColor{r, g, b}});
-                (*CanvasCmd)({.cmd = CC_SETCOLOR, .SetColor{r, g, b}});
-                // canvas->Rectangle (1, x1+(x*2), y1+(y*2), 2,2 );
-                (*CanvasCmd)({.cmd = CC_POINT, .Point{(float)(x1 + x), (float)(y1 + y)}});
-            }
-        }
+    while (lcd_dirty_next(&lcd->dirty, &area)) {
+        (*CanvasCmd)({.cmd = CC_PUTPIXELS,
+                      .PutPixels{&lcd->ram[0][0], 132, 132, 132, 1, area, (float)x1, (float)y1, 0, 1.0}});
     }
 }
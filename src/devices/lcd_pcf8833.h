@@ -28,6 +28,7 @@
 
 #include "../lib/draw.h"
 #include "bitbang_spi.h"
+#include "lcd_dirty.h"
 
 /* pinout
   1 VCC
@@ -43,7 +44,8 @@
 */
 
 typedef struct {
-    unsigned int ram[132][132];
+    unsigned int ram[132][132];  // 0x00RRGGBB
+    lcd_dirty_t dirty;           // changed columns of each ram line
     bitbang_spi_t bb_spi;
     int dc;
     unsigned char colm;
@@ -38,7 +38,9 @@ void lcd_ssd1306_rst(lcd_ssd1306_t* lcd) {
     int i, j;
     for (i = 0; i < 128; i++)
         for (j = 0; j < 8; j++)
-            lcd->ram[i][j] = 0xFF00;
+            lcd->ram[i][j] = 0;
+    lcd_dirty_init(&lcd->dirty, 128, 8);
+    lcd_dirty_all(&lcd->dirty);
 
     bitbang_i2c_rst(&lcd->bb_i2c);
     bitbang_spi_rst(&lcd->bb_spi);
@@ -68,11 +70,8 @@ void lcd_ssd1306_init(lcd_ssd1306_t* lcd) {
 }
 
 void lcd_ssd1306_update(lcd_ssd1306_t* lcd) {
-    int i, j;
     lcd->update = 1;
-    for (i = 0; i < 128; i++)
-        for (j = 0; j < 8; j++)
-            lcd->ram[i][j] |= 0xFF00;
+    lcd_dirty_all(&lcd->dirty);
 }
 
 static void lcd_ssd1306_process(lcd_ssd1306_t* lcd) {
@@ -298,7 +297,10 @@ static void lcd_ssd1306_process(lcd_ssd1306_t* lcd) {
     } else  // data
     {
         dcprint("data[%i][%i]:%#02X  \n", lcd->x, lcd->y, lcd->dat);
-        lcd->ram[lcd->x][lcd->y] = 0xFF00 | lcd->dat;
+        if (lcd->x < 128) {
+            lcd->ram[lcd->x][lcd->y] = lcd->dat;
+            lcd_dirty_mark(&lcd->dirty, lcd->x, lcd->y);
+        }
         lcd->update = 1;
         switch (lcd->am) {
             case 1:  // vertical
@@ -380,28 +382,30 @@ unsigned char lcd_ssd1306_I2C_io(lcd_ssd1306_t* lcd, unsigned char sda, unsigned
 }
 
 void lcd_ssd1306_draw(lcd_ssd1306_t* lcd, CanvasCmd_ft CanvasCmd, int x1, int y1, int w1, int h1, int picpwr) {
-    unsigned char x, y, z;
+    int x, y, z;
+    Rect_t area;
 
     lcd->update = 0;
 
     if (!lcd->on)
         return;
 
-    for (x = 0; x < 128; x++) {
-        for (y = 0; y < 8; y++) {
-            if (lcd->ram[x][y] & 0xFF00) {
-                lcd->ram[x][y] &= 0x00FF;  // clear draw
+    while (lcd_dirty_next(&lcd->dirty, &area)) {
+        for (x = area.x; x < area.x + area.width; x++) {
+            for (y = area.y; y < area.y + area.height; y++) {
                 for (z = 0; z < 8; z++) {
                     if (!(lcd->ram[x][y] & (0x01 << z)) != (!lcd->inv)) {
-                        (*CanvasCmd)({.cmd = CC_SETCOLOR, .SetColor{0xb4, 0xff, 0xfc}});  // front
+                        lcd->fb[y * 8 + z][x] = 0xb4fffc;  // front
                     } else {
-                        (*CanvasCmd)({.cmd = CC_SETCOLOR, .SetColor{0x0f, 0x0f, 0x17}});  // back
+                        lcd->fb[y * 8 + z][x] = 0x0f0f17;  // back
                     }
-                    // canvas->Rectangle (1, x1 + (x * 2), y1 + (y * 8 * 2)+(z * 2), 2,
-                    // 2);
-                    (*CanvasCmd)({.cmd = CC_POINT, .Point{(float)(x1 + x), (float)(y1 + y * 8 + z)}});
                 }
             }
         }
+        // pages to pixel lines
+        area.y *= 8;
+        area.height *= 8;
+        (*CanvasCmd)(
+            {.cmd = CC_PUTPIXELS, .PutPixels{&lcd->fb[0][0], 128, 64, 1, 128, area, (float)x1, (float)y1, 0, 1.0}});
     }
 }
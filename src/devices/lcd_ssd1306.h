@@ -29,6 +29,7 @@
 #include "../lib/draw.h"
 #include "bitbang_i2c.h"
 #include "bitbang_spi.h"
+#include "lcd_dirty.h"
 
 /* pinout
   1 /RST
@@ -43,6 +44,8 @@
 
 typedef struct {
     unsigned short int ram[128][8];
+    lcd_dirty_t dirty;         // changed columns of each page
+    unsigned int fb[64][128];  // rendered pixels
     unsigned char hrst;
     unsigned char dat;
     unsigned char am;   // address mode
@@ -30,14 +30,68 @@
 
 #include "led_ws2812b.h"
 
+// fill the rendered pixel weights of one LED cell
+static void led_ws2812b_kernel(led_ws2812b_t* led) {
+    memset(led->kernel, 0, sizeof(led->kernel));
+
+    if (led->diffuser) {
+        // diffuser panel: each cell is lit by its LED, border pixels blend with the neighbour cell
+        led->sub = 4;
+        const unsigned short own[4] = {192, 256, 256, 192};
+        const signed char nbr[4] = {-1, 0, 0, 1};
+        for (unsigned int v = 0; v < led->sub; v++) {
+            for (unsigned int u = 0; u < led->sub; u++) {
+                led_ws2812b_tap_t* tap = &led->kernel[v][u];
+                const unsigned short wx[2] = {own[u], (unsigned short)(256 - own[u])};
+                const unsigned short wy[2] = {own[v], (unsigned short)(256 - own[v])};
+                for (int j = 0; j < 2; j++) {
+                    for (int i = 0; i < 2; i++) {
+                        const unsigned short w = (wx[i] * wy[j]) >> 8;
+                        if (w) {
+                            tap->dx[tap->n] = i ? nbr[u] : 0;
+                            tap->dy[tap->n] = j ? nbr[v] : 0;
+                            tap->w[tap->n] = w;
+                            tap->n++;
+                        }
+                    }
+                }
+            }
+        }
+    } else {
+        // bare LEDs: only the round die is painted, the package image stays visible
+        led->sub = LED_WS2812B_SUB;
+        const float size = (float)LED_WS2812B_PITCH / led->sub;
+        const float center = LED_WS2812B_PITCH / 2.0;
+        for (unsigned int v = 0; v < led->sub; v++) {
+            for (unsigned int u = 0; u < led->sub; u++) {
+                const float dx = (u + 0.5) * size - center;
+                const float dy = (v + 0.5) * size - center;
+                if ((dx * dx + dy * dy) <= 64.0) {
+                    led->kernel[v][u].n = 1;
+                    led->kernel[v][u].w[0] = 256;
+                }
+            }
+        }
+    }
+}
+
+void led_ws2812b_redraw(led_ws2812b_t* led) {
+    led->rmin = 0;
+    led->rmax = led->nrows - 1;
+    led->cmin = 0;
+    led->cmax = led->ncols - 1;
+    led->update = 1;
+}
+
 void led_ws2812b_rst(led_ws2812b_t* led) {
     unsigned int i;
     for (i = 0; i < led->nleds; i++)
         led->color[i].fcolor = 0xFFFFFFF;
-    led->update = 1;
+    led_ws2812b_redraw(led);
     led->dat = 0;
     led->adin = 0;
-    led->ccounter = 0;
+    led->trise = 0;
+    led->tedge = 0;
     led->bit = 0;
     led->ledc = 0;
 }
@@ -49,12 +103,15 @@ void led_ws2812b_init(led_ws2812b_t* led, const int rows, const int cols, const
     led->nleds = rows * cols;
     led->nbits = 24 * led->nleds;
     led->color = (rgb_color*)malloc(led->nleds * sizeof(rgb_color));
+    led_ws2812b_kernel(led);
+    led->fb = (unsigned int*)malloc(led->nleds * led->sub * led->sub * sizeof(unsigned int));
 
     led_ws2812b_rst(led);
 }
 
 void led_ws2812b_end(led_ws2812b_t* led) {
     free(led->color);
+    free(led->fb);
 }
 
 void led_ws2812b_prepare(led_ws2812b_t* led, float freq) {
@@ -66,75 +123,126 @@ void led_ws2812b_prepare(led_ws2812b_t* led, float freq) {
     led->TRES = freq * 50e-6;
 }
 
-unsigned char led_ws2812b_io(led_ws2812b_t* led, const unsigned char din) {
-    led->ccounter++;
+// called only on DIN changes, time is the edge timestamp in instructions
+unsigned char led_ws2812b_io(led_ws2812b_t* led, const unsigned char din, const uint32_t time) {
+    if (led->adin == din) {
+        return (led->bit < led->nbits) ? 0 : din;
+    }
 
-    if (led->ccounter > led->TRES) {
+    if ((time - led->tedge) > led->TRES) {  // DIN low longer than reset time
         led->bit = 0;
         led->dat = 0;
         led->ledc = 0;
     }
+    led->tedge = time;
+    led->adin = din;
 
     if (led->bit < led->nbits) {
-        if ((!led->adin) && (din))  // DIN rising edge
-        {
-            led->ccounter = 0;
-        }
-        if ((led->adin) && (!din))  // DIN falling edge
-        {
+        if (din) {  // DIN rising edge
+            led->trise = time;
+        } else {  // DIN falling edge, pulse width gives the bit value
             led->dat = led->dat << 1;
-            if (led->ccounter > led->T0H) {
+            if ((time - led->trise) > led->T0H) {
                 led->dat |= 1;
             }
             led->bit++;
-            led->ccounter = 0;
-        }
-
-        led->adin = din;
 
-        if (led->bit == (24 * (led->ledc + 1))) {
-            // printf("color = 0x%06X \n",led->dat);
-            led->color[led->ledc].fcolor = led->dat;
-            led->ledc++;
-            led->update = 1;
+            if (led->bit == (24 * (led->ledc + 1))) {
+                // printf("color = 0x%06X \n",led->dat);
+                if (led->color[led->ledc].fcolor != led->dat) {
+                    const unsigned int row = led->ledc / led->ncols;
+                    const unsigned int col = led->ledc % led->ncols;
+                    if (led->rmin > led->rmax) {
+                        led->rmin = led->rmax = row;
+                        led->cmin = led->cmax = col;
+                    } else {
+                        if (row < led->rmin)
+                            led->rmin = row;
+                        if (row > led->rmax)
+                            led->rmax = row;
+                        if (col < led->cmin)
+                            led->cmin = col;
+                        if (col > led->cmax)
+                            led->cmax = col;
+                    }
+                    led->color[led->ledc].fcolor = led->dat;
+                    led->update = 1;
+                }
+                led->ledc++;
+                led->dat = 0;
+            }
         }
         return 0;
     }
 
-    if ((led->adin) != (din))  // DIN rising/falling edge
-    {
-        led->ccounter = 0;
-    }
     // bit > 24 * nleds
     return din;
 }
 
 void led_ws2812b_draw(led_ws2812b_t* led, CanvasCmd_ft CanvasCmd, const int x1, const int y1, const int w1,
                       const int h1, const int picpwr) {
-    unsigned int x, y, index;
-    int R, G, B;
     led->update = 0;
-    (*CanvasCmd)({.cmd = CC_SETFGCOLOR, .SetFgColor{0, 0, 0}});
-    for (x = 0; x < led->nrows; x++) {
-        for (y = 0; y < led->ncols; y++) {
-            index = (x * led->ncols) + y;
-
-            R = ((led->color[index].R * 4) > 255) ? 255 : (led->color[index].R * 4);
-            G = ((led->color[index].G * 4) > 255) ? 255 : (led->color[index].G * 4);
-            B = ((led->color[index].B * 4) > 255) ? 255 : (led->color[index].B * 4);
-
-            (*CanvasCmd)({.cmd = CC_SETBGCOLOR, .SetBgColor{(unsigned int)R, (unsigned int)G, (unsigned int)B}});
-
-            if (led->diffuser) {
-                (*CanvasCmd)({.cmd = CC_RECTANGLE,
-                              .Rectangle{1, (float)(x1 + (y * 40) - 8), (float)(y1 - (x * 40) - 8), (float)(w1 + 16),
-                                         (float)(h1 + 16)}});
-            } else {
-                (*CanvasCmd)(
-                    {.cmd = CC_SETFGCOLOR, .SetFgColor{led->color[index].R, led->color[index].G, led->color[index].B}});
-                (*CanvasCmd)(
-                    {.cmd = CC_CIRCLE, .Circle{1, (float)(x1 + (y * 40) + 12), (float)(y1 - (x * 40) + 12), 7}});
+
+    if (led->rmin > led->rmax)
+        return;
+
+    const int sub = led->sub;
+    const int fbw = led->ncols * sub;
+    const int nrows = led->nrows;
+    const int ncols = led->ncols;
+
+    // neighbour cells blend across the border of changed LEDs
+    int r0 = led->rmin;
+    int r1 = led->rmax;
+    int c0 = led->cmin;
+    int c1 = led->cmax;
+    if (led->diffuser) {
+        r0 = (r0 > 0) ? r0 - 1 : 0;
+        r1 = (r1 < nrows - 1) ? r1 + 1 : nrows - 1;
+        c0 = (c0 > 0) ? c0 - 1 : 0;
+        c1 = (c1 < ncols - 1) ? c1 + 1 : ncols - 1;
+    }
+    led->rmin = 1;
+    led->rmax = 0;
+
+    for (int r = r0; r <= r1; r++) {
+        // row 0 is the bottom one
+        unsigned int* cell = led->fb + ((nrows - 1 - r) * sub * fbw) + (c0 * sub);
+        for (int c = c0; c <= c1; c++, cell += sub) {
+            for (int v = 0; v < sub; v++) {
+                unsigned int* pixel = cell + v * fbw;
+                for (int u = 0; u < sub; u++) {
+                    const led_ws2812b_tap_t* tap = &led->kernel[v][u];
+                    if (!tap->n) {
+                        pixel[u] = CC_TRANSPARENT;
+                        continue;
+                    }
+                    unsigned int R = 0, G = 0, B = 0;
+                    for (int t = 0; t < tap->n; t++) {
+                        int rn = r - tap->dy[t];
+                        int cn = c + tap->dx[t];
+                        if ((rn < 0) || (rn >= nrows))
+                            rn = r;
+                        if ((cn < 0) || (cn >= ncols))
+                            cn = c;
+                        const rgb_color color = led->color[(rn * ncols) + cn];
+                        R += color.R * tap->w[t];
+                        G += color.G * tap->w[t];
+                        B += color.B * tap->w[t];
+                    }
+                    // brightness gain
+                    R = (R >> 6) > 255 ? 255 : (R >> 6);
+                    G = (G >> 6) > 255 ? 255 : (G >> 6);
+                    B = (B >> 6) > 255 ? 255 : (B >> 6);
+                    pixel[u] = (R << 16) | (G << 8) | B;
+                }
             }
         }
     }
+
+    const Rect_t area = {c0 * sub, (nrows - 1 - r1) * sub, (c1 - c0 + 1) * sub, (r1 - r0 + 1) * sub};
+    (*CanvasCmd)({.cmd = CC_PUTPIXELS,
+                  .PutPixels{led->fb, fbw, nrows * sub, 1, fbw, area, (float)(x1 - 8),
+                             (float)(y1 - 8 - (nrows - 1) * LED_WS2812B_PITCH), 0,
+                             (float)LED_WS2812B_PITCH / sub}});
 }
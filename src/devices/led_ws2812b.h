@@ -26,6 +26,7 @@
 #ifndef LED_WS2812B
 #define LED_WS2812B
 
+#include <inttypes.h>
 #include "../lib/draw.h"
 
 /* pinout
@@ -38,6 +39,9 @@
 #define MAXROWS 64
 #define MAXCOLS 64
 
+#define LED_WS2812B_PITCH 40  // distance between LEDs in part units
+#define LED_WS2812B_SUB 8     // max rendered pixels per LED side
+
 typedef struct {
     union {
         unsigned int fcolor;
@@ -50,10 +54,19 @@ typedef struct {
     };
 } rgb_color;
 
+// weights of the LEDs that light one rendered pixel
+typedef struct {
+    unsigned char n;      // number of taps, 0 for transparent pixel
+    signed char dx[4];    // LED column offset
+    signed char dy[4];    // LED row offset (screen direction)
+    unsigned short w[4];  // weight, taps sum 256
+} led_ws2812b_tap_t;
+
 typedef struct {
-    int T0H;
-    int TRES;
-    int ccounter;      // cycle counter
+    uint32_t T0H;
+    uint32_t TRES;
+    uint32_t trise;    // DIN rising edge timestamp
+    uint32_t tedge;    // last DIN edge timestamp
     unsigned int bit;  // bit counter
     unsigned int nrows;
     unsigned int ncols;
@@ -65,14 +78,19 @@ typedef struct {
     unsigned short adin;
     unsigned int dat;
     unsigned char update;
+    unsigned int sub;                                            // rendered pixels per LED side
+    unsigned int* fb;                                            // rendered pixels
+    led_ws2812b_tap_t kernel[LED_WS2812B_SUB][LED_WS2812B_SUB];  // per LED pixel weights
+    unsigned int rmin, rmax, cmin, cmax;                         // changed LEDs
 } led_ws2812b_t;
 
 void led_ws2812b_rst(led_ws2812b_t* led);
 void led_ws2812b_init(led_ws2812b_t* led, const int rows, const int cols, const int diffuser);
 void led_ws2812b_end(led_ws2812b_t* led);
 void led_ws2812b_prepare(led_ws2812b_t* led, const float freq);
+void led_ws2812b_redraw(led_ws2812b_t* led);
 
-unsigned char led_ws2812b_io(led_ws2812b_t* led, const unsigned char din);
+unsigned char led_ws2812b_io(led_ws2812b_t* led, const unsigned char din, const uint32_t time);
 
 void led_ws2812b_draw(led_ws2812b_t* led, CanvasCmd_ft CanvasCmd, const int x1, const int y1, const int w1,
                       const int h1, const int picpwr);
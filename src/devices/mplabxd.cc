@@ -24,6 +24,7 @@
    ######################################################################## */
 
 #include "mplabxd.h"
+#include "dbg_bpindex.h"
 
 // #define _DEBUG_
 #define dprint \
@@ -116,6 +117,7 @@ static int server_started = 0;
 static board* dbg_board = NULL;
 static unsigned char* ramsend = NULL;
 static unsigned char* ramreceived = NULL;
+static bpindex_t bpi;
 
 void setnblock(int sock_descriptor);
 void setblock(int sock_descriptor);
@@ -162,6 +164,7 @@ int mplabxd_init(board* mboard, unsigned short tcpport) {
     if (!ramsend) {
         ramsend = (unsigned char*)malloc(dbg_board->DBGGetRAMSize());
         ramreceived = (unsigned char*)malloc(dbg_board->DBGGetRAMSize());
+        bpindex_init(&bpi, dbg_board->DBGGetROMSize(), dbg_board->DBGGetRAMSize());
     }
     return 0;
 }
@@ -201,6 +204,7 @@ void mplabxd_end(void) {
         ramsend = NULL;
         ramreceived = NULL;
         dbg_board = NULL;
+        bpindex_end(&bpi);
     }
 }
 
@@ -228,32 +232,19 @@ static unsigned int bpdr[100];
 
 static unsigned short dbuff[2];
 
+static void mplabxd_setbp(const int type, const unsigned int* addrs, const int count) {
+    bpindex_clear(&bpi, type);
+    for (int i = 0; i < count; i++) {
+        bpindex_set(&bpi, type, addrs[i]);
+    }
+}
+
 int mplabxd_testbp(void) {
-    int i;
     if (!PICSimLab.GetMcuDbg()) {
-        for (i = 0; i < bpc; i++) {
-            if (dbg_board->DBGGetPC() == bp[i]) {
-                dprint("breakpoint 0x%04X!!!!!=========================\n", bp[i]);
-                PICSimLab.SetCpuState(CPU_BREAKPOINT);
-                PICSimLab.Set_mcudbg(1);
-                return PICSimLab.GetMcuDbg();
-            }
-        }
-        for (i = 0; i < bpdwc; i++) {
-            if (dbg_board->DBGGetRAMLAWR() == bpdw[i]) {
-                dprint("breakpoint data wr 0x%04X!!!!!=========================\n", bpdw[i]);
-                PICSimLab.SetCpuState(CPU_BREAKPOINT);
-                PICSimLab.Set_mcudbg(1);
-                return PICSimLab.GetMcuDbg();
-            }
-        }
-        for (i = 0; i < bpdrc; i++) {
-            if (dbg_board->DBGGetRAMLARD() == bpdr[i]) {
-                dprint("breakpoint data rd 0x%04X!!!!!=========================\n", bpdr[i]);
-                PICSimLab.SetCpuState(CPU_BREAKPOINT);
-                PICSimLab.Set_mcudbg(1);
-                return PICSimLab.GetMcuDbg();
-            }
+        if (bpindex_test(&bpi, dbg_board)) {
+            dprint("breakpoint type %i 0x%04X!!!!!=========================\n", bpi.last_type, bpi.last_addr);
+            PICSimLab.SetCpuState(CPU_BREAKPOINT);
+            PICSimLab.Set_mcudbg(1);
         }
     }
     return PICSimLab.GetMcuDbg();
@@ -301,6 +292,9 @@ int mplabxd_loop(void) {
                 bpc = 0;
                 bpdwc = 0;
                 bpdrc = 0;
+                bpindex_clear(&bpi, BP_CODE);
+                bpindex_clear(&bpi, BP_DWRITE);
+                bpindex_clear(&bpi, BP_DREAD);
                 break;
             case STEP:
                 dprint("STEP cmd\n");
@@ -364,6 +358,7 @@ int mplabxd_loop(void) {
                         printf("bp %i = %#06X\n", i, bp[i]);
 #endif
                 }
+                mplabxd_setbp(BP_CODE, bp, bpc);
                 dprint("SETBK cmd\n");
                 break;
             case STRUN:
@@ -395,6 +390,7 @@ int mplabxd_loop(void) {
                         printf("bpdw %i = %#06X\n", i, bpdw[i]);
 #endif
                 }
+                mplabxd_setbp(BP_DWRITE, bpdw, bpdwc);
                 dprint("SDWBK cmd\n");
                 break;
             case SDRBK:
@@ -417,6 +413,7 @@ int mplabxd_loop(void) {
                         printf("bpdr %i = %#06X\n", i, bpdr[i]);
 #endif
                 }
+                mplabxd_setbp(BP_DREAD, bpdr, bpdrc);
                 dprint("SDRBK cmd\n");
                 break;
             case GETID:
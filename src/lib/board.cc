@@ -28,6 +28,8 @@
 #include "board.h"
 #include <math.h>
 #include "picsimlab.h"
+#include "profiler.h"
+#include "wave_check.h"
 
 int ioupdated = 0;
 
@@ -50,6 +52,15 @@ board::board(void) {
         Timers[i].Timer = 0;
         Timers[i].Tout = 0;
     }
+    RAMWatchHook = 0;
+    RAMWatchsCount = 0;
+    RAMWatchSize = 0;
+    for (int i = 0; i < MAX_RAMWATCHS; i++) {
+        RAMWatchs[i].Arg = NULL;
+        RAMWatchs[i].Callback = NULL;
+        RAMWatchs[i].addr = 0;
+        RAMWatchs[i].size = 0;
+    }
     for (int i = 0; i < MAX_IDS; i++) {
         input_ids[i] = &input[i];
         output_ids[i] = &output[i];
@@ -401,6 +412,15 @@ void board::StopThread(void) {
 
 void board::InstCounterInc(void) {
     InstCounter++;
+    if (Profiler.IsRunning()) {
+        Profiler.Sample(1);
+    }
+    if (WaveCheck.IsRunning()) {
+        WaveCheck.Sample(this, 1);
+    }
+    if (RAMWatchsCount && !RAMWatchHook) {
+        RAMWatchPoll();
+    }
     for (int t = 0; t < TimersCount; t++) {
         if (TimersList[t]->Enabled) {
             TimersList[t]->Timer--;
@@ -412,6 +432,125 @@ void board::InstCounterInc(void) {
     }
 }
 
+void board::InstCounterAdd(const uint32_t count) {
+    InstCounter += count;
+    if (Profiler.IsRunning()) {
+        Profiler.Sample(count);
+    }
+    if (WaveCheck.IsRunning()) {
+        WaveCheck.Sample(this, count);
+    }
+    if (RAMWatchsCount && !RAMWatchHook) {
+        RAMWatchPoll();
+    }
+    for (int t = 0; t < TimersCount; t++) {
+        // the batch can overshoot the deadline, the next period starts at the deadline and not at the batch end
+        uint32_t left = count;
+        while (TimersList[t]->Enabled && (TimersList[t]->Timer <= left)) {
+            left -= TimersList[t]->Timer;
+            TimersList[t]->Timer = TimersList[t]->Reload;
+            (*TimersList[t]->Callback)(TimersList[t]->Arg);
+        }
+        if (TimersList[t]->Enabled) {
+            TimersList[t]->Timer -= left;
+        }
+    }
+}
+
+uint32_t board::TimerGetNext(void) {
+    uint32_t next = UINT32_MAX;
+    for (int t = 0; t < TimersCount; t++) {
+        if ((TimersList[t]->Enabled) && (TimersList[t]->Timer < next)) {
+            next = TimersList[t]->Timer;
+        }
+    }
+    return next;
+}
+
+int board::RAMWatchRegister(const unsigned int addr, const unsigned int size,
+                            void (*Callback)(void* arg, const unsigned int addr), void* arg) {
+    if (!DBGIsSupported() || !size || (RAMWatchsCount >= MAX_RAMWATCHS)) {
+        return -1;
+    }
+    const unsigned char* ram = DBGGetRAM_p();
+    if (!ram || ((addr + size) > DBGGetRAMSize())) {
+        return -1;
+    }
+
+    int watchn = 0;
+    for (int i = 0; i < MAX_RAMWATCHS; i++) {
+        if (RAMWatchs[i].Callback == NULL) {
+            watchn = i + 1;
+            break;
+        }
+    }
+    RAMWatchs[watchn - 1].addr = addr;
+    RAMWatchs[watchn - 1].size = size;
+    RAMWatchs[watchn - 1].Callback = Callback;
+    RAMWatchs[watchn - 1].Arg = arg;
+    RAMWatchsCount++;
+    RAMWatchUpdateMap();
+    return watchn;
+}
+
+int board::RAMWatchUnregister(const int watch) {
+    if ((watch > 0) && (watch <= MAX_RAMWATCHS) && RAMWatchs[watch - 1].Callback) {
+        RAMWatchs[watch - 1].Callback = NULL;  // free watch
+        RAMWatchsCount--;
+        RAMWatchUpdateMap();
+        return 0;
+    }
+    return -1;
+}
+
+void board::RAMWatchUpdateMap(void) {
+    if (!RAMWatchsCount) {
+        RAMWatchSize = 0;
+        RAMWatchMap.clear();
+        RAMWatchShadow.clear();
+        return;
+    }
+
+    const unsigned char* ram = DBGGetRAM_p();
+    RAMWatchSize = DBGGetRAMSize();
+    RAMWatchMap.assign((RAMWatchSize >> 5) + 1, 0);
+    RAMWatchShadow.resize(RAMWatchSize);
+    for (int i = 0; i < MAX_RAMWATCHS; i++) {
+        if (RAMWatchs[i].Callback) {
+            for (unsigned int a = RAMWatchs[i].addr; a < (RAMWatchs[i].addr + RAMWatchs[i].size); a++) {
+                RAMWatchMap[a >> 5] |= (1U << (a & 31));
+                RAMWatchShadow[a] = ram[a];
+            }
+        }
+    }
+}
+
+void board::RAMWatchNotify(const unsigned int addr) {
+    const unsigned char value = DBGGetRAM_p()[addr];
+    if (value == RAMWatchShadow[addr]) {
+        return;
+    }
+    RAMWatchShadow[addr] = value;
+    for (int i = 0; i < MAX_RAMWATCHS; i++) {
+        if (RAMWatchs[i].Callback && (addr >= RAMWatchs[i].addr) && (addr < (RAMWatchs[i].addr + RAMWatchs[i].size))) {
+            (*RAMWatchs[i].Callback)(RAMWatchs[i].Arg, addr);
+        }
+    }
+}
+
+void board::RAMWatchPoll(void) {
+    const unsigned char* ram = DBGGetRAM_p();
+    for (int i = 0; i < MAX_RAMWATCHS; i++) {
+        if (RAMWatchs[i].Callback) {
+            for (unsigned int a = RAMWatchs[i].addr; a < (RAMWatchs[i].addr + RAMWatchs[i].size); a++) {
+                if (ram[a] != RAMWatchShadow[a]) {
+                    RAMWatchNotify(a);
+                }
+            }
+        }
+    }
+}
+
 int board::TimerRegister_us(const double micros, void (*Callback)(void* arg), void* arg) {
     if (TimersCount < MAX_TIMERS) {
         int timern = 0;
@@ -499,6 +638,16 @@ int board::TimerChange_ms(const int timer, const double miles) {
     return -1;
 }
 
+int board::TimerChange_inst(const int timer, const uint32_t inst) {
+    if (timer <= MAX_TIMERS) {
+        Timers[timer - 1].Reload = inst ? inst : 1;
+        Timers[timer - 1].Timer = Timers[timer - 1].Reload;
+        Timers[timer - 1].Tout = Timers[timer - 1].Reload * 1e6 / MGetInstClockFreq();
+        return 0;
+    }
+    return -1;
+}
+
 int board::TimerSetState(const int timer, const int enabled) {
     if (timer <= MAX_TIMERS) {
         Timers[timer - 1].Enabled = enabled;
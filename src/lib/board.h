@@ -32,6 +32,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <vector>
 
 #define INCOMPLETE                                                      \
     printf("Incomplete: %s -> %s :%i\n", __func__, __FILE__, __LINE__); \
@@ -103,6 +104,19 @@ typedef struct {
     double Tout;  // in us
 } Timers_t;
 
+#define MAX_RAMWATCHS 64
+
+/**
+ * @brief internal RAM write watch struct
+ *
+ */
+typedef struct {
+    unsigned int addr;
+    unsigned int size;
+    void* Arg;
+    void (*Callback)(void* arg, const unsigned int addr);
+} RAMWatch_t;
+
 /**
  * @brief Board class
  *
@@ -416,6 +430,11 @@ public:
      */
     virtual void MReset(int flags) = 0;
 
+    /**
+     * @brief board microcontroller support the DBG* functions (PC and memory access)
+     */
+    virtual int DBGIsSupported(void) { return 0; };
+
     /**
      * @brief board microcontroller get pointer to processor ID
      */
@@ -606,6 +625,11 @@ public:
      */
     int TimerChange_ms(const int timer, const double miles);
 
+    /**
+     * @brief Modify timer value with number of instructions (no rounding)
+     */
+    int TimerChange_inst(const int timer, const uint32_t inst);
+
     /**
      * @brief Enable or disable timer
      */
@@ -621,6 +645,22 @@ public:
      */
     void TimerUpdateFrequency(float freq);
 
+    /**
+     * @brief Get the number of instructions until the next enabled timer expires
+     */
+    uint32_t TimerGetNext(void);
+
+    /**
+     * @brief Register a RAM write watch, the callback receives the address of each changed byte in [addr,addr+size)
+     */
+    int RAMWatchRegister(const unsigned int addr, const unsigned int size,
+                         void (*Callback)(void* arg, const unsigned int addr), void* arg);
+
+    /**
+     * @brief Unregister RAM write watch
+     */
+    int RAMWatchUnregister(const int watch);
+
     /**
      * @brief Lock IO to others threads access
      */
@@ -657,6 +697,22 @@ protected:
      */
     void InstCounterInc(void);
 
+    /**
+     * @brief Add count to the Intructions Counter (count must be less or equal than TimerGetNext())
+     */
+    void InstCounterAdd(const uint32_t count);
+
+    /**
+     * @brief Publish a RAM write, used by backends that know the written address (disables the polling fallback)
+     */
+    void RAMWatchWrite(const unsigned int addr) {
+        if (RAMWatchsCount && (addr < RAMWatchSize) && ((RAMWatchMap[addr >> 5] >> (addr & 31)) & 1)) {
+            RAMWatchNotify(addr);
+        }
+    };
+
+    int RAMWatchHook;  ///< backend publishes RAM writes with RAMWatchWrite
+
     std::string Proc;               ///< Name of processor in use
     std::string DProc;              ///< Name of default board processor
     input_t input[MAX_IDS];         ///< input map elements
@@ -690,6 +746,26 @@ private:
     int TimersCount;
     Timers_t Timers[MAX_TIMERS];
     Timers_t* TimersList[MAX_TIMERS];
+    int RAMWatchsCount;
+    RAMWatch_t RAMWatchs[MAX_RAMWATCHS];
+    unsigned int RAMWatchSize;
+    std::vector<uint32_t> RAMWatchMap;        // one bit per watched address
+    std::vector<unsigned char> RAMWatchShadow;  // last value of watched addresses
+
+    /**
+     * @brief Compare watched addresses with the shadow copy and call the watch callbacks on change
+     */
+    void RAMWatchNotify(const unsigned int addr);
+
+    /**
+     * @brief Check all watched addresses, used when the backend does not publish RAM writes
+     */
+    void RAMWatchPoll(void);
+
+    /**
+     * @brief Rebuild the watched address bitmap
+     */
+    void RAMWatchUpdateMap(void);
 
     /**
      * @brief Read the Input Map
@@ -0,0 +1,820 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#include "canvas_raster.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+#include <algorithm>
+
+#include "../devices/lcd_hd44780.h"
+#include "util.h"
+
+#define RASTER_IMAGE_COLOR 0xB4B4B4  // content of images not decoded
+
+#define RASTER_ALIGN_CENTER_HORIZONTAL 0x0100
+
+CCanvasRaster::CCanvasRaster() {
+    window.width = 0;
+    window.height = 0;
+    surf = NULL;
+    for (int i = 0; i < RASTER_CANVAS_MAX; i++) {
+        target[i] = -1;
+    }
+    canvas = 0;
+    enabled = 0;
+    background = 0x323232;
+    sx = 1.0;
+    sy = 1.0;
+    orientation = 0;
+    pen = 0;
+    brush = 0xFFFFFF;
+    fontsize = 10;
+    bold = 0;
+    lwidth = 1;
+}
+
+CCanvasRaster::~CCanvasRaster() {
+    for (size_t i = 0; i < bitmaps.size(); i++) {
+        delete bitmaps[i];
+    }
+}
+
+void CCanvasRaster::Alloc(raster_surface_t* surface, const unsigned int color) {
+    if (enabled) {
+        surface->pixels.assign(surface->width * surface->height, color);
+    } else {
+        surface->pixels.clear();
+        surface->pixels.shrink_to_fit();
+    }
+}
+
+void CCanvasRaster::SetEnabled(const int en) {
+    enabled = en;
+    Alloc(&window, background);
+    for (size_t i = 0; i < bitmaps.size(); i++) {
+        if (bitmaps[i]) {
+            Alloc(bitmaps[i], RASTER_IMAGE_COLOR);
+        }
+    }
+}
+
+void CCanvasRaster::SetWindowSize(const int width, const int height) {
+    if ((width != window.width) || (height != window.height)) {
+        window.width = width;
+        window.height = height;
+        Alloc(&window, background);
+    }
+}
+
+const raster_surface_t* CCanvasRaster::GetBitmap(const int id) {
+    if ((id >= 0) && (id < (int)bitmaps.size())) {
+        return bitmaps[id];
+    }
+    return NULL;
+}
+
+raster_surface_t* CCanvasRaster::NewBitmap(const int id, const int width, const int height) {
+    if (id < 0) {
+        return NULL;
+    }
+    if (id >= (int)bitmaps.size()) {
+        bitmaps.resize(id + 1, NULL);
+    }
+    if (!bitmaps[id]) {
+        bitmaps[id] = new raster_surface_t;
+    }
+    bitmaps[id]->width = (width > 0) ? width : 0;
+    bitmaps[id]->height = (height > 0) ? height : 0;
+    Alloc(bitmaps[id], RASTER_IMAGE_COLOR);
+    return bitmaps[id];
+}
+
+void CCanvasRaster::FreeBitmap(const int id) {
+    if ((id >= 0) && (id < (int)bitmaps.size()) && bitmaps[id]) {
+        delete bitmaps[id];
+        bitmaps[id] = NULL;
+    }
+}
+
+raster_surface_t* CCanvasRaster::Target(void) {
+    if (target[canvas] < 0) {
+        return &window;
+    }
+    if (target[canvas] < (int)bitmaps.size()) {
+        return bitmaps[target[canvas]];
+    }
+    return NULL;
+}
+
+// user coordinates to surface coordinates, orientation rotates the drawing clockwise in 90 degrees steps
+void CCanvasRaster::Transform(const float x, const float y, float* dx, float* dy) {
+    const float X = x * sx;
+    const float Y = y * sy;
+
+    switch (orientation) {
+        case 1:
+            *dx = surf->width - Y;
+            *dy = X;
+            break;
+        case 2:
+            *dx = surf->width - X;
+            *dy = surf->height - Y;
+            break;
+        case 3:
+            *dx = Y;
+            *dy = surf->height - X;
+            break;
+        default:
+            *dx = X;
+            *dy = Y;
+            break;
+    }
+}
+
+// fill [x1,x2) x [y1,y2)
+void CCanvasRaster::FillRect(int x1, int y1, int x2, int y2, const unsigned int color) {
+    if (x1 < 0)
+        x1 = 0;
+    if (y1 < 0)
+        y1 = 0;
+    if (x2 > surf->width)
+        x2 = surf->width;
+    if (y2 > surf->height)
+        y2 = surf->height;
+    if ((x1 >= x2) || (y1 >= y2))
+        return;
+
+    unsigned int* line = surf->pixels.data() + y1 * surf->width;
+    for (int y = y1; y < y2; y++) {
+        std::fill(line + x1, line + x2, color);
+        line += surf->width;
+    }
+}
+
+// fill [x1,x2] on line y
+void CCanvasRaster::Span(const int y, int x1, int x2, const unsigned int color) {
+    if ((y < 0) || (y >= surf->height))
+        return;
+    if (x1 < 0)
+        x1 = 0;
+    if (x2 >= surf->width)
+        x2 = surf->width - 1;
+    if (x1 > x2)
+        return;
+    unsigned int* line = surf->pixels.data() + y * surf->width;
+    std::fill(line + x1, line + x2 + 1, color);
+}
+
+void CCanvasRaster::Rectangle(const bool filled, const float x, const float y, const float width,
+                              const float height) {
+    float ax, ay, bx, by;
+    Transform(x, y, &ax, &ay);
+    Transform(x + width, y + height, &bx, &by);
+
+    const int x1 = lroundf(std::min(ax, bx));
+    const int y1 = lroundf(std::min(ay, by));
+    const int x2 = lroundf(std::max(ax, bx));
+    const int y2 = lroundf(std::max(ay, by));
+
+    if (filled) {
+        FillRect(x1, y1, x2, y2, brush);
+    }
+    if (lwidth) {
+        const int t = std::max(1L, lround(lwidth * sx));
+        FillRect(x1, y1, x2, y1 + t, pen);
+        FillRect(x1, y2 - t, x2, y2, pen);
+        FillRect(x1, y1, x1 + t, y2, pen);
+        FillRect(x2 - t, y1, x2, y2, pen);
+    }
+}
+
+void CCanvasRaster::Line(const int x1, const int y1, const int x2, const int y2) {
+    const int t = std::max(1L, lround(lwidth * sx));
+    const int h = t / 2;
+    const int dx = abs(x2 - x1);
+    const int dy = -abs(y2 - y1);
+    const int ix = (x1 < x2) ? 1 : -1;
+    const int iy = (y1 < y2) ? 1 : -1;
+    int err = dx + dy;
+    int x = x1;
+    int y = y1;
+
+    while (1) {
+        FillRect(x - h, y - h, x - h + t, y - h + t, pen);
+        if ((x == x2) && (y == y2))
+            break;
+        const int e2 = 2 * err;
+        if (e2 >= dy) {
+            err += dy;
+            x += ix;
+        }
+        if (e2 <= dx) {
+            err += dx;
+            y += iy;
+        }
+    }
+}
+
+void CCanvasRaster::Circle(const bool filled, const float x, const float y, const float radius) {
+    float cx, cy;
+    Transform(x, y, &cx, &cy);
+    const float r = radius * sx;
+    const float ri = r - std::max(1L, lround(lwidth * sx));
+
+    if (r <= 0)
+        return;
+
+    for (int dy = -(int)r; dy <= (int)r; dy++) {
+        const int py = lroundf(cy + dy);
+        const float xo = sqrtf(r * r - dy * dy);
+        if (filled) {
+            Span(py, lroundf(cx - xo), lroundf(cx + xo) - 1, brush);
+        }
+        if (lwidth) {
+            if ((ri > 0) && (abs(dy) < ri)) {
+                const float xi = sqrtf(ri * ri - dy * dy);
+                Span(py, lroundf(cx - xo), lroundf(cx - xi) - 1, pen);
+                Span(py, lroundf(cx + xi), lroundf(cx + xo) - 1, pen);
+            } else {
+                Span(py, lroundf(cx - xo), lroundf(cx + xo) - 1, pen);
+            }
+        }
+    }
+}
+
+// points in surface coordinates, even-odd fill
+void CCanvasRaster::Polygon(const bool filled, const std::vector<Point_t>& points, const int closed) {
+    const int n = points.size();
+
+    if (n < 2)
+        return;
+
+    if (filled) {
+        int ymin = points[0].y;
+        int ymax = points[0].y;
+        for (int i = 1; i < n; i++) {
+            ymin = std::min(ymin, points[i].y);
+            ymax = std::max(ymax, points[i].y);
+        }
+        ymin = std::max(ymin, 0);
+        ymax = std::min(ymax, surf->height - 1);
+
+        std::vector<int> nodes;
+        for (int y = ymin; y <= ymax; y++) {
+            const float fy = y + 0.5f;
+            nodes.clear();
+            for (int i = 0, j = n - 1; i < n; j = i++) {
+                const Point_t& a = points[i];
+                const Point_t& b = points[j];
+                if (((a.y < fy) && (b.y >= fy)) || ((b.y < fy) && (a.y >= fy))) {
+                    nodes.push_back(lroundf(a.x + (fy - a.y) / (b.y - a.y) * (b.x - a.x)));
+                }
+            }
+            std::sort(nodes.begin(), nodes.end());
+            for (size_t i = 1; i < nodes.size(); i += 2) {
+                Span(y, nodes[i - 1], nodes[i] - 1, brush);
+            }
+        }
+    }
+
+    if (lwidth) {
+        for (int i = 1; i < n; i++) {
+            Line(points[i - 1].x, points[i - 1].y, points[i].x, points[i].y);
+        }
+        if (closed) {
+            Line(points[n - 1].x, points[n - 1].y, points[0].x, points[0].y);
+        }
+    }
+}
+
+// elliptic arc in user coordinates, angles in degrees counterclockwise, filled arcs are pie slices
+void CCanvasRaster::Arc(const bool filled, const float cx, const float cy, const float rx, const float ry,
+                        double start, double end) {
+    std::vector<Point_t> points;
+    float dx, dy;
+
+    while (end <= start) {
+        end += 360;
+    }
+
+    const int segs = std::max(8, (int)((end - start) / 360.0 * 2 * M_PI * std::max(rx, ry) * sx / 4));
+
+    if (filled) {
+        Transform(cx, cy, &dx, &dy);
+        points.push_back({(int)lroundf(dx), (int)lroundf(dy)});
+    }
+    for (int i = 0; i <= segs; i++) {
+        const double a = (start + (end - start) * i / segs) * M_PI / 180.0;
+        Transform(cx + rx * cos(a), cy - ry * sin(a), &dx, &dy);
+        points.push_back({(int)lroundf(dx), (int)lroundf(dy)});
+    }
+    Polygon(filled, points, filled);
+}
+
+// font index of character, -1 for bytes not drawn (utf-8 continuation)
+static int raster_glyph(const unsigned char c) {
+    if ((c >= 0x80) && (c < 0xC0)) {
+        return -1;
+    }
+    if ((c < 0x20) || (c >= 0x80)) {
+        return '?' - 0x20;
+    }
+    return c - 0x20;
+}
+
+float CCanvasRaster::TextWidth(const char* str) {
+    const float u = std::max(1L, lround(fontsize * sx / 6.0)) / sx;
+    int n = 0;
+
+    for (const unsigned char* c = (const unsigned char*)str; *c; c++) {
+        if (raster_glyph(*c) >= 0)
+            n++;
+    }
+    return (n * 6 - 1) * u;
+}
+
+// text drawn with the 5x8 character LCD font, 6 * fontsize / 8 points per character
+void CCanvasRaster::Text(const char* str, const float x, const float y, const float angle) {
+    const int k = std::max(1L, lround(fontsize * sx / 6.0));  // font pixel size in surface pixels
+    const float u = k / sx;
+    const float ca = cosf(angle * M_PI / 180.0) * u;
+    const float sa = sinf(angle * M_PI / 180.0) * u;
+    int n = 0;
+
+    for (const unsigned char* c = (const unsigned char*)str; *c; c++) {
+        const int g = raster_glyph(*c);
+        if (g < 0)
+            continue;
+        for (int col = 0; col < 5; col++) {
+            const unsigned char bits = LCDfont[g][col];
+            for (int row = 0; bits && (row < 8); row++) {
+                if (bits & (1 << row)) {
+                    const float gx = n * 6 + col;
+                    float ax, ay, bx, by;
+                    Transform(x + gx * ca + row * sa, y - gx * sa + row * ca, &ax, &ay);
+                    Transform(x + (gx + 1) * ca + (row + 1) * sa, y - (gx + 1) * sa + (row + 1) * ca, &bx, &by);
+                    FillRect(lroundf(std::min(ax, bx)), lroundf(std::min(ay, by)), lroundf(std::max(ax, bx)) + bold,
+                             lroundf(std::max(ay, by)), pen);
+                }
+            }
+        }
+        n++;
+    }
+}
+
+void CCanvasRaster::PutPixels(const CanvasCmd_t& cmd) {
+    const int w = cmd.PutPixels.width;
+    const int h = cmd.PutPixels.height;
+    const int rot = cmd.PutPixels.rotation;
+    const int ow = ((rot == 90) || (rot == 270)) ? h : w;  // size after rotation
+    const int oh = ((rot == 90) || (rot == 270)) ? w : h;
+    const int c0 = std::max(cmd.PutPixels.area.x, 0);
+    const int r0 = std::max(cmd.PutPixels.area.y, 0);
+    const int c1 = std::min(cmd.PutPixels.area.x + cmd.PutPixels.area.width, w);
+    const int r1 = std::min(cmd.PutPixels.area.y + cmd.PutPixels.area.height, h);
+
+    // cell edges in surface coordinates
+    std::vector<int> ex(ow + 1);
+    std::vector<int> ey(oh + 1);
+    for (int i = 0; i <= ow; i++) {
+        ex[i] = lround((cmd.PutPixels.x + i * cmd.PutPixels.scale) * sx);
+    }
+    for (int j = 0; j <= oh; j++) {
+        ey[j] = lround((cmd.PutPixels.y + j * cmd.PutPixels.scale) * sy);
+    }
+
+    const int W = surf->width;
+    const int H = surf->height;
+
+    for (int row = r0; row < r1; row++) {
+        const unsigned int* line = cmd.PutPixels.pixels + row * cmd.PutPixels.ystride;
+        for (int col = c0; col < c1; col++) {
+            if (line[col * cmd.PutPixels.xstride] == CC_TRANSPARENT)
+                continue;
+            const unsigned int color = line[col * cmd.PutPixels.xstride] & 0x00FFFFFF;
+            int i, j;
+            switch (rot) {
+                case 90:
+                    i = h - 1 - row;
+                    j = col;
+                    break;
+                case 180:
+                    i = w - 1 - col;
+                    j = h - 1 - row;
+                    break;
+                case 270:
+                    i = row;
+                    j = w - 1 - col;
+                    break;
+                default:
+                    i = col;
+                    j = row;
+                    break;
+            }
+            switch (orientation) {
+                case 1:
+                    FillRect(W - ey[j + 1], ex[i], W - ey[j], ex[i + 1], color);
+                    break;
+                case 2:
+                    FillRect(W - ex[i + 1], H - ey[j + 1], W - ex[i], H - ey[j], color);
+                    break;
+                case 3:
+                    FillRect(ey[j], H - ex[i + 1], ey[j + 1], H - ex[i], color);
+                    break;
+                default:
+                    FillRect(ex[i], ey[j], ex[i + 1], ey[j + 1], color);
+                    break;
+            }
+        }
+    }
+}
+
+void CCanvasRaster::Blit(raster_surface_t* dst, const raster_surface_t* src, const int x, const int y) {
+    if (dst->pixels.empty() || src->pixels.empty())
+        return;
+
+    const int x1 = std::max(x, 0);
+    const int y1 = std::max(y, 0);
+    const int x2 = std::min(x + src->width, dst->width);
+    const int y2 = std::min(y + src->height, dst->height);
+
+    for (int py = y1; py < y2; py++) {
+        const unsigned int* s = src->pixels.data() + (py - y) * src->width + (x1 - x);
+        std::copy(s, s + (x2 - x1), dst->pixels.data() + py * dst->width + x1);
+    }
+}
+
+int CCanvasRaster::Cmd(const CanvasCmd_t& cmd, const int gret) {
+    // allocation commands are executed even when disabled
+    switch (cmd.cmd) {
+        case CC_CREATE:
+            target[canvas] = cmd.Create.BitmapId;
+            return 0;
+        case CC_DESTROY:
+            target[canvas] = -1;
+            return 0;
+        case CC_FREEBITMAP:
+            FreeBitmap(cmd.FreeBitmap.BitmapId);
+            return 0;
+        case CC_LOADIMAGE:
+        case CC_CREATEIMAGE: {
+            float width = 0;
+            float height = 0;
+            float scale;
+            int orient;
+            if (cmd.cmd == CC_LOADIMAGE) {
+                scale = cmd.LoadImage.scale;
+                orient = cmd.LoadImage.orientation;
+                if (GetImageSize(GetLocalFile(cmd.LoadImage.fname).c_str(), &width, &height) && (gret < 0)) {
+                    return -1;
+                }
+            } else {
+                scale = cmd.CreateImage.scale;
+                orient = cmd.CreateImage.orientation;
+                width = cmd.CreateImage.width;
+                height = cmd.CreateImage.height;
+            }
+            if (orient & 1) {
+                std::swap(width, height);
+            }
+            int id = gret;
+            if (id < 0) {
+                for (id = 0; (id < (int)bitmaps.size()) && bitmaps[id]; id++) {
+                }
+            }
+            NewBitmap(id, lroundf(width * scale), lroundf(height * scale));
+            return id;
+        }
+        case CC_GETBITMAPSIZE:
+            if ((gret < 0) && GetBitmap(cmd.GetBitmapSize.BitmapId)) {
+                *cmd.GetBitmapSize.w = bitmaps[cmd.GetBitmapSize.BitmapId]->width;
+                *cmd.GetBitmapSize.h = bitmaps[cmd.GetBitmapSize.BitmapId]->height;
+                return 0;
+            }
+            return gret;
+        case CC_LIST:
+            for (int i = 0; i < cmd.List.count; i++) {
+                Cmd(cmd.List.cmds[i], gret);
+            }
+            return 0;
+        default:
+            break;
+    }
+
+    if (!enabled) {
+        return gret;
+    }
+
+    surf = Target();
+    if (surf && surf->pixels.empty()) {
+        surf = NULL;
+    }
+
+    switch (cmd.cmd) {
+        case CC_INIT:
+            sx = cmd.Init.sx;
+            sy = cmd.Init.sy;
+            orientation = (cmd.Init.angle > 3) ? ((cmd.Init.angle / 90) & 3) : cmd.Init.angle;
+            break;
+        case CC_CHANGESCALE:
+            sx = cmd.ChangeScale.sx;
+            sy = cmd.ChangeScale.sy;
+            break;
+        case CC_SETCOLOR:
+            pen = brush = (cmd.SetColor.r << 16) | (cmd.SetColor.g << 8) | cmd.SetColor.b;
+            break;
+        case CC_SETFGCOLOR:
+            pen = (cmd.SetFgColor.r << 16) | (cmd.SetFgColor.g << 8) | cmd.SetFgColor.b;
+            break;
+        case CC_SETBGCOLOR:
+            brush = (cmd.SetBgColor.r << 16) | (cmd.SetBgColor.g << 8) | cmd.SetBgColor.b;
+            break;
+        case CC_GETBGCOLOR:
+            if (gret < 0) {
+                *cmd.GetBgColor.r = brush >> 16;
+                *cmd.GetBgColor.g = (brush >> 8) & 0xFF;
+                *cmd.GetBgColor.b = brush & 0xFF;
+                return 0;
+            }
+            return gret;
+        case CC_SETFONTSIZE:
+            fontsize = cmd.SetFontSize.pointsize;
+            break;
+        case CC_SETFONTWEIGHT:
+            bold = (cmd.SetFontWeight.weight == CC_FONTWEIGHT_BOLD);
+            break;
+        case CC_SETLINEWIDTH:
+            lwidth = cmd.SetLineWidth.lwidth;
+            break;
+        default:
+            break;
+    }
+
+    if (!surf) {
+        return gret;
+    }
+
+    switch (cmd.cmd) {
+        case CC_SETBITMAP: {
+            const raster_surface_t* src = GetBitmap(cmd.SetBitmap.BitmapId);
+            if (src && !src->pixels.empty()) {
+                const int w = std::min(surf->width, (int)(src->width * cmd.SetBitmap.xs));
+                const int h = std::min(surf->height, (int)(src->height * cmd.SetBitmap.ys));
+                for (int y = 0; y < h; y++) {
+                    const unsigned int* s = src->pixels.data() + (int)(y / cmd.SetBitmap.ys) * src->width;
+                    unsigned int* d = surf->pixels.data() + y * surf->width;
+                    for (int x = 0; x < w; x++) {
+                        d[x] = s[(int)(x / cmd.SetBitmap.xs)];
+                    }
+                }
+            }
+        } break;
+        case CC_POINT: {
+            float x, y;
+            Transform(cmd.Point.x, cmd.Point.y, &x, &y);
+            FillRect(lroundf(x), lroundf(y), lroundf(x) + 1, lroundf(y) + 1, pen);
+        } break;
+        case CC_LINE: {
+            float x1, y1, x2, y2;
+            Transform(cmd.Line.x1, cmd.Line.y1, &x1, &y1);
+            Transform(cmd.Line.x2, cmd.Line.y2, &x2, &y2);
+            Line(lroundf(x1), lroundf(y1), lroundf(x2), lroundf(y2));
+        } break;
+        case CC_RECTANGLE:
+            Rectangle(cmd.Rectangle.filled, cmd.Rectangle.x, cmd.Rectangle.y, cmd.Rectangle.width,
+                      cmd.Rectangle.height);
+            break;
+        case CC_CIRCLE:
+            Circle(cmd.Circle.filled, cmd.Circle.x, cmd.Circle.y, cmd.Circle.radius);
+            break;
+        case CC_ROTATEDTEXT:
+            Text(cmd.RotatedText.str, cmd.RotatedText.x, cmd.RotatedText.y, cmd.RotatedText.angle);
+            break;
+        case CC_TEXTONRECT: {
+            const Rect_t& r = cmd.TextOnRect.rect;
+            const float u = std::max(1L, lround(fontsize * sx / 6.0)) / sx;
+            float x = r.x;
+            float y = r.y;
+            if (cmd.TextOnRect.align & RASTER_ALIGN_CENTER_HORIZONTAL) {
+                x += (r.width - TextWidth(cmd.TextOnRect.str)) / 2;
+            } else if (cmd.TextOnRect.align & CC_ALIGN_RIGHT) {
+                x += r.width - TextWidth(cmd.TextOnRect.str);
+            }
+            if (cmd.TextOnRect.align & CC_ALIGN_CENTER_VERTICAL) {
+                y += (r.height - 7 * u) / 2;
+            }
+            Text(cmd.TextOnRect.str, x, y, 0);
+        } break;
+        case CC_POLYGON:
+        case CC_LINES: {
+            const bool poly = (cmd.cmd == CC_POLYGON);
+            const Point_t* p = poly ? cmd.Polygon.points : cmd.Lines.points;
+            const int n = poly ? cmd.Polygon.npoints : cmd.Lines.npoints;
+            std::vector<Point_t> points(n);
+            for (int i = 0; i < n; i++) {
+                float x, y;
+                Transform(p[i].x, p[i].y, &x, &y);
+                points[i] = {(int)lroundf(x), (int)lroundf(y)};
+            }
+            Polygon(poly && cmd.Polygon.filled, points, poly);
+        } break;
+        case CC_PUTBITMAP: {
+            const raster_surface_t* src = GetBitmap(cmd.PutBitmap.BitmapId);
+            if (src) {
+                Blit(surf, src, lroundf(cmd.PutBitmap.x), lroundf(cmd.PutBitmap.y));
+            }
+        } break;
+        case CC_ARC: {
+            const float dx1 = cmd.Arc.x1 - cmd.Arc.xc;
+            const float dy1 = cmd.Arc.y1 - cmd.Arc.yc;
+            const float r = sqrtf(dx1 * dx1 + dy1 * dy1);
+            const double start = atan2(-dy1, dx1) * 180.0 / M_PI;
+            double end = atan2(-(cmd.Arc.y2 - cmd.Arc.yc), cmd.Arc.x2 - cmd.Arc.xc) * 180.0 / M_PI;
+            if (end == start) {
+                end += 360;
+            }
+            Arc(cmd.Arc.filled, cmd.Arc.xc, cmd.Arc.yc, r, r, start, end);
+        } break;
+        case CC_ELLIPTICARC:
+            Arc(cmd.EllipticArc.filled, cmd.EllipticArc.x + cmd.EllipticArc.width / 2,
+                cmd.EllipticArc.y + cmd.EllipticArc.height / 2, cmd.EllipticArc.width / 2,
+                cmd.EllipticArc.height / 2, cmd.EllipticArc.start, cmd.EllipticArc.end);
+            break;
+        case CC_PUTPIXELS:
+            PutPixels(cmd);
+            break;
+        default:
+            break;
+    }
+    return gret;
+}
+
+// file output
+
+static void raster_png_chunk(FILE* fout, const char* type, const unsigned char* data, const unsigned int size) {
+    const unsigned char len[4] = {(unsigned char)(size >> 24), (unsigned char)(size >> 16),
+                                  (unsigned char)(size >> 8), (unsigned char)size};
+    uLong crc = crc32(0, (const Bytef*)type, 4);
+    crc = crc32(crc, data, size);
+    const unsigned char crcb[4] = {(unsigned char)(crc >> 24), (unsigned char)(crc >> 16), (unsigned char)(crc >> 8),
+                                   (unsigned char)crc};
+    fwrite(len, 1, 4, fout);
+    fwrite(type, 1, 4, fout);
+    fwrite(data, 1, size, fout);
+    fwrite(crcb, 1, 4, fout);
+}
+
+int CCanvasRaster::WriteFile(const raster_surface_t* surface, const char* fname) {
+    const int w = surface->width;
+    const int h = surface->height;
+
+    if (surface->pixels.empty()) {
+        return -1;
+    }
+
+    FILE* fout = fopen_UTF8(fname, "wb");
+    if (!fout) {
+        printf("PICSimLab: Error creating frame file %s\n", fname);
+        return -1;
+    }
+
+    const char* ext = strrchr(fname, '.');
+    std::vector<unsigned char> buff;
+
+    if (ext && !strcasecmp(ext, ".png")) {
+        // RGB rows with filter type 0
+        buff.resize(h * (1 + 3 * w));
+        unsigned char* p = buff.data();
+        for (int y = 0; y < h; y++) {
+            const unsigned int* s = surface->pixels.data() + y * w;
+            *p++ = 0;
+            for (int x = 0; x < w; x++) {
+                *p++ = s[x] >> 16;
+                *p++ = s[x] >> 8;
+                *p++ = s[x];
+            }
+        }
+        uLongf zsize = compressBound(buff.size());
+        std::vector<unsigned char> zbuff(zsize);
+        compress2(zbuff.data(), &zsize, buff.data(), buff.size(), Z_BEST_SPEED);
+
+        const unsigned char ihdr[13] = {(unsigned char)(w >> 24), (unsigned char)(w >> 16), (unsigned char)(w >> 8),
+                                        (unsigned char)w, (unsigned char)(h >> 24), (unsigned char)(h >> 16),
+                                        (unsigned char)(h >> 8), (unsigned char)h, 8, 2, 0, 0, 0};
+        fwrite("\x89PNG\r\n\x1a\n", 1, 8, fout);
+        raster_png_chunk(fout, "IHDR", ihdr, 13);
+        raster_png_chunk(fout, "IDAT", zbuff.data(), zsize);
+        raster_png_chunk(fout, "IEND", NULL, 0);
+    } else if (ext && !strcasecmp(ext, ".ppm")) {
+        buff.resize(3 * w * h);
+        unsigned char* p = buff.data();
+        for (int i = 0; i < w * h; i++) {
+            *p++ = surface->pixels[i] >> 16;
+            *p++ = surface->pixels[i] >> 8;
+            *p++ = surface->pixels[i];
+        }
+        fprintf(fout, "P6\n%i %i\n255\n", w, h);
+        fwrite(buff.data(), 1, buff.size(), fout);
+    } else {
+        buff.resize(4 * w * h);
+        unsigned char* p = buff.data();
+        for (int i = 0; i < w * h; i++) {
+            *p++ = surface->pixels[i] >> 16;
+            *p++ = surface->pixels[i] >> 8;
+            *p++ = surface->pixels[i];
+            *p++ = 0xFF;
+        }
+        fwrite(buff.data(), 1, buff.size(), fout);
+    }
+
+    fclose(fout);
+    return 0;
+}
+
+// svg length in pixels (96 dpi)
+static int raster_svg_length(const std::string& tag, const char* name, float* value) {
+    const std::string attr = std::string(name) + "=\"";
+    size_t pos = 0;
+
+    while ((pos = tag.find(attr, pos)) != std::string::npos) {
+        if ((pos > 0) && isspace((unsigned char)tag[pos - 1])) {
+            const char* str = tag.c_str() + pos + attr.length();
+            char* end;
+            *value = strtof(str, &end);
+            if (!strncmp(end, "mm", 2)) {
+                *value *= 96.0 / 25.4;
+            } else if (!strncmp(end, "cm", 2)) {
+                *value *= 96.0 / 2.54;
+            } else if (!strncmp(end, "in", 2)) {
+                *value *= 96.0;
+            } else if (!strncmp(end, "pt", 2)) {
+                *value *= 96.0 / 72.0;
+            }
+            return (end != str) && (*end != '%');
+        }
+        pos++;
+    }
+    return 0;
+}
+
+int CCanvasRaster::GetImageSize(const char* fname, float* width, float* height) {
+    char buff[4096];
+
+    FILE* fin = fopen_UTF8(fname, "rb");
+    if (!fin) {
+        return -1;
+    }
+    const size_t size = fread(buff, 1, sizeof(buff) - 1, fin);
+    fclose(fin);
+    buff[size] = 0;
+
+    if ((size >= 24) && !memcmp(buff, "\x89PNG", 4)) {
+        const unsigned char* p = (const unsigned char*)buff;
+        *width = (p[16] << 24) | (p[17] << 16) | (p[18] << 8) | p[19];
+        *height = (p[20] << 24) | (p[21] << 16) | (p[22] << 8) | p[23];
+        return 0;
+    }
+
+    const char* svg = strstr(buff, "<svg");
+    if (svg) {
+        const char* end = strchr(svg, '>');
+        const std::string tag(svg, end ? end : buff + size);
+        if (raster_svg_length(tag, "width", width) && raster_svg_length(tag, "height", height)) {
+            return 0;
+        }
+        const size_t pos = tag.find("viewBox=\"");
+        float x, y;
+        if ((pos != std::string::npos) &&
+            (sscanf(tag.c_str() + pos + 9, "%f%*[ ,]%f%*[ ,]%f%*[ ,]%f", &x, &y, width, height) == 4)) {
+            return 0;
+        }
+    }
+    return -1;
+}
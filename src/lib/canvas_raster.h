@@ -0,0 +1,129 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#ifndef CANVAS_RASTER_H
+#define CANVAS_RASTER_H
+
+#include <string>
+#include <vector>
+
+#include "draw.h"
+
+#define RASTER_CANVAS_MAX 256  // canvases selected with SelectCanvas (one per part)
+
+typedef struct {
+    int width;
+    int height;
+    std::vector<unsigned int> pixels;  // 0x00RRGGBB, empty when rasterizer is disabled
+} raster_surface_t;
+
+/**
+ * @brief Software rasterizer of canvas commands
+ *
+ * Executes canvas commands on in memory surfaces, so frames can be rendered without GUI (NOGUI build,
+ * frame dump). Image files are not decoded, loaded images are blank surfaces with the image size and only
+ * the content drawn by canvas commands is visible. While disabled only the bitmap allocation is tracked.
+ */
+class CCanvasRaster {
+public:
+    CCanvasRaster();
+    ~CCanvasRaster();
+
+    /**
+     * @brief  Execute command, gret is the value returned by the GUI for the same command (-1 if none)
+     */
+    int Cmd(const CanvasCmd_t& cmd, const int gret);
+
+    /**
+     * @brief  Select the canvas used by the next commands (spare parts use one canvas per part)
+     */
+    void SelectCanvas(const int n) { canvas = ((n >= 0) && (n < RASTER_CANVAS_MAX)) ? n : 0; };
+
+    void SetEnabled(const int en);
+
+    int GetEnabled(void) { return enabled; };
+
+    /**
+     * @brief  Set size of the window surface, drawn when no bitmap is selected with CC_CREATE
+     */
+    void SetWindowSize(const int width, const int height);
+
+    const raster_surface_t* GetWindow(void) { return &window; };
+
+    const raster_surface_t* GetBitmap(const int id);
+
+    void SetBackground(const unsigned int color) { background = color; };
+
+    /**
+     * @brief  Copy src to dst at position x, y (clipped)
+     */
+    static void Blit(raster_surface_t* dst, const raster_surface_t* src, const int x, const int y);
+
+    /**
+     * @brief  Write surface to file, format by extension: .png, .ppm or raw RGBA for any other
+     */
+    static int WriteFile(const raster_surface_t* surface, const char* fname);
+
+    /**
+     * @brief  Read image size from SVG or PNG file header
+     */
+    static int GetImageSize(const char* fname, float* width, float* height);
+
+private:
+    raster_surface_t* NewBitmap(const int id, const int width, const int height);
+    void FreeBitmap(const int id);
+    void Alloc(raster_surface_t* surface, const unsigned int color);
+    raster_surface_t* Target(void);
+    void Transform(const float x, const float y, float* dx, float* dy);
+    void FillRect(int x1, int y1, int x2, int y2, const unsigned int color);
+    void Span(const int y, int x1, int x2, const unsigned int color);
+    void Rectangle(const bool filled, const float x, const float y, const float width, const float height);
+    void Line(const int x1, const int y1, const int x2, const int y2);
+    void Circle(const bool filled, const float x, const float y, const float radius);
+    void Polygon(const bool filled, const std::vector<Point_t>& points, const int closed);
+    void Arc(const bool filled, const float cx, const float cy, const float rx, const float ry, double start,
+             double end);
+    void Text(const char* str, const float x, const float y, const float angle);
+    float TextWidth(const char* str);
+    void PutPixels(const CanvasCmd_t& cmd);
+
+    raster_surface_t window;
+    raster_surface_t* surf;  // surface of the command in execution, NULL if not drawable
+    std::vector<raster_surface_t*> bitmaps;
+    int target[RASTER_CANVAS_MAX];  // bitmap of each canvas, -1 window
+    int canvas;
+    int enabled;
+    unsigned int background;
+    double sx;
+    double sy;
+    int orientation;
+    unsigned int pen;
+    unsigned int brush;
+    int fontsize;
+    int bold;
+    int lwidth;
+};
+
+#endif  // CANVAS_RASTER_H
@@ -58,4 +58,128 @@ void DrawLED(CanvasCmd_ft CanvasCmd, const output_t* output) {
     (*CanvasCmd)({.cmd = CC_CIRCLE, .Circle{1, output->x1, output->y1, output->r + 1}});
     (*CanvasCmd)({.cmd = CC_SETBGCOLOR, .SetBgColor{r1, g1, b1}});
     (*CanvasCmd)({.cmd = CC_CIRCLE, .Circle{1, output->x1, output->y1, output->r - 2}});
-}
\ No newline at end of file
+}
+// Canvas command list
+
+#define CMDLIST_BLOCK_SIZE 4096
+
+CCanvasCmdList::CCanvasCmdList(void) {
+    block_used = CMDLIST_BLOCK_SIZE;
+    runs = 0;
+}
+
+CCanvasCmdList::~CCanvasCmdList(void) {
+    for (size_t i = 0; i < blocks.size(); i++) {
+        free(blocks[i]);
+    }
+}
+
+void* CCanvasCmdList::Alloc(const size_t size) {
+    const size_t asize = (size + 7) & ~((size_t)7);
+
+    if (asize > CMDLIST_BLOCK_SIZE) {
+        // large data gets its own block, inserted before the current one
+        char* block = (char*)malloc(asize);
+        blocks.insert(blocks.end() - (blocks.size() ? 1 : 0), block);
+        return block;
+    }
+
+    if ((block_used + asize) > CMDLIST_BLOCK_SIZE) {
+        blocks.push_back((char*)malloc(CMDLIST_BLOCK_SIZE));
+        block_used = 0;
+    }
+
+    void* ptr = blocks.back() + block_used;
+    block_used += asize;
+    return ptr;
+}
+
+int CCanvasCmdList::Add(const CanvasCmd_t& cmd) {
+    switch (cmd.cmd) {
+        case CC_INIT:
+        case CC_CHANGESCALE:
+        case CC_END:
+        case CC_SETBITMAP:
+        case CC_SETCOLOR:
+        case CC_SETFGCOLOR:
+        case CC_SETBGCOLOR:
+        case CC_SETFONTSIZE:
+        case CC_SETFONTWEIGHT:
+        case CC_SETLINEWIDTH:
+        case CC_POINT:
+        case CC_LINE:
+        case CC_RECTANGLE:
+        case CC_CIRCLE:
+        case CC_PUTBITMAP:
+        case CC_ARC:
+        case CC_ELLIPTICARC:
+            cmds.push_back(cmd);
+            break;
+        case CC_ROTATEDTEXT: {
+            char* str = (char*)Alloc(strlen(cmd.RotatedText.str) + 1);
+            strcpy(str, cmd.RotatedText.str);
+            cmds.push_back(cmd);
+            cmds.back().RotatedText.str = str;
+        } break;
+        case CC_TEXTONRECT: {
+            char* str = (char*)Alloc(strlen(cmd.TextOnRect.str) + 1);
+            strcpy(str, cmd.TextOnRect.str);
+            cmds.push_back(cmd);
+            cmds.back().TextOnRect.str = str;
+        } break;
+        case CC_POLYGON: {
+            Point_t* points = (Point_t*)Alloc(cmd.Polygon.npoints * sizeof(Point_t));
+            memcpy(points, cmd.Polygon.points, cmd.Polygon.npoints * sizeof(Point_t));
+            cmds.push_back(cmd);
+            cmds.back().Polygon.points = points;
+        } break;
+        case CC_LINES: {
+            Point_t* points = (Point_t*)Alloc(cmd.Lines.npoints * sizeof(Point_t));
+            memcpy(points, cmd.Lines.points, cmd.Lines.npoints * sizeof(Point_t));
+            cmds.push_back(cmd);
+            cmds.back().Lines.points = points;
+        } break;
+        case CC_LIST:
+            for (int i = 0; i < cmd.List.count; i++) {
+                if (!Add(cmd.List.cmds[i])) {
+                    return 0;
+                }
+            }
+            break;
+        default:
+            // commands with return values or referencing buffers owned by the caller
+            return 0;
+    }
+    return 1;
+}
+
+void CCanvasCmdList::Copy(const CCanvasCmdList& list, const int first) {
+    for (size_t i = first; i < list.cmds.size(); i++) {
+        Add(list.cmds[i]);
+    }
+}
+
+int CCanvasCmdList::Run(CanvasCmd_ft CanvasCmd) {
+    int ret = 0;
+
+    if (cmds.size() && CanvasCmd) {
+        ret = (*CanvasCmd)({.cmd = CC_LIST, .List{cmds.data(), (int)cmds.size()}});
+        runs++;
+    }
+    Clear();
+    return ret;
+}
+
+void CCanvasCmdList::Clear(void) {
+    cmds.clear();
+    // keep the first block for reuse
+    for (size_t i = 1; i < blocks.size(); i++) {
+        free(blocks[i]);
+    }
+    if (blocks.size()) {
+        blocks.resize(1);
+        block_used = 0;
+    } else {
+        block_used = CMDLIST_BLOCK_SIZE;
+    }
+}
@@ -55,6 +55,8 @@ enum PICSimLabCanvasCmd {
     CC_ARC,
     CC_ELLIPTICARC,
     CC_LINES,
+    CC_PUTPIXELS,
+    CC_LIST,
     CC_LAST
 };
 
@@ -65,7 +67,10 @@ enum PICSimLabCanvasCmd {
 #define CC_ALIGN_CENTER_VERTICAL 0x0800
 #define CC_ALIGN_CENTER 0x0900
 
+#define CC_TRANSPARENT 0xFF000000  // CC_PUTPIXELS pixel left untouched
+
 #include <string>
+#include <vector>
 
 #include "board.h"
 
@@ -77,7 +82,7 @@ typedef struct {
     int x, y;
 } Point_t;
 
-typedef struct {
+typedef struct _CanvasCmd_t {
     PICSimLabCanvasCmd cmd;
     union {
         struct {
@@ -217,11 +222,71 @@ typedef struct {
             const Point_t* points;
             const int npoints;
         } Lines;
+        struct {
+            const unsigned int* pixels;  // 0x00RRGGBB or CC_TRANSPARENT
+            const int width;
+            const int height;
+            const int xstride;  // distance in pixels between columns
+            const int ystride;  // distance in pixels between lines
+            const Rect_t area;  // buffer region to draw
+            float x;
+            float y;
+            const int rotation;  // 0, 90, 180 or 270 degrees clockwise
+            const float scale;   // size of one buffer pixel
+        } PutPixels;
+        struct {
+            const struct _CanvasCmd_t* cmds;
+            const int count;
+        } List;
     };
 } CanvasCmd_t;
 
 typedef int (*CanvasCmd_ft)(CanvasCmd_t);
 
+/**
+ * @brief Recorded list of canvas commands (display list)
+ *
+ * Texts and point arrays referenced by the commands are copied to an arena of fixed size blocks,
+ * so they stay valid until the list is cleared.
+ */
+class CCanvasCmdList {
+public:
+    CCanvasCmdList(void);
+    ~CCanvasCmdList(void);
+
+    /**
+     * @brief Append a command, returns 0 if the command returns values and must be sent directly
+     */
+    int Add(const CanvasCmd_t& cmd);
+
+    /**
+     * @brief Append the commands of list starting at first
+     */
+    void Copy(const CCanvasCmdList& list, const int first);
+
+    /**
+     * @brief Send all recorded commands as one CC_LIST command and clear the list
+     */
+    int Run(CanvasCmd_ft CanvasCmd);
+
+    void Clear(void);
+
+    int GetCount(void) const { return cmds.size(); };
+
+    /**
+     * @brief Return the number of times the list was sent
+     */
+    unsigned int GetRuns(void) const { return runs; };
+
+private:
+    void* Alloc(const size_t size);
+
+    std::vector<CanvasCmd_t> cmds;
+    std::vector<char*> blocks;
+    size_t block_used;
+    unsigned int runs;
+};
+
 // Draw Functions
 void DrawLED(CanvasCmd_ft CanvasCmd, const output_t* output);
 void DrawSlider(CanvasCmd_ft CanvasCmd, const output_t* output, const unsigned char pos, const std::string val,
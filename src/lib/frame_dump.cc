@@ -0,0 +1,264 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#include "frame_dump.h"
+
+#include <stdio.h>
+#include <algorithm>
+
+#include "picsimlab.h"
+#include "spareparts.h"
+
+CFrameDump FrameDump;
+
+CFrameDump::CFrameDump() {
+    parts_frame.width = 0;
+    parts_frame.height = 0;
+    video_frame.width = 0;
+    video_frame.height = 0;
+    video_fps = 0;
+    video_next = 0;
+    board_gui = NULL;
+    parts_gui = NULL;
+    quanta = 0;
+    last = 0;
+    every = 0;
+    frames = 0;
+    running = 0;
+    enabled = 0;
+}
+
+void CFrameDump::Install(void) {
+    if (PICSimLab.OnCanvasCmd != &CFrameDump::BoardCanvasCmd) {
+        board_gui = PICSimLab.OnCanvasCmd;
+        PICSimLab.OnCanvasCmd = &CFrameDump::BoardCanvasCmd;
+    }
+    if (SpareParts.OnCanvasCmd != &CFrameDump::PartsCanvasCmd) {
+        parts_gui = SpareParts.OnCanvasCmd;
+        SpareParts.OnCanvasCmd = &CFrameDump::PartsCanvasCmd;
+    }
+}
+
+// commands the rasterizer must see even when disabled, to keep its bitmaps in step with the GUI ones
+static int RasterTracks(const PICSimLabCanvasCmd cmd) {
+    switch (cmd) {
+        case CC_CREATE:
+        case CC_DESTROY:
+        case CC_FREEBITMAP:
+        case CC_LOADIMAGE:
+        case CC_CREATEIMAGE:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int CFrameDump::BoardCanvasCmd(const CanvasCmd_t cmd) {
+    const int ret = FrameDump.board_gui ? (*FrameDump.board_gui)(cmd) : -1;
+    if (FrameDump.board_gui && !FrameDump.enabled && !RasterTracks(cmd.cmd)) {
+        return ret;
+    }
+    std::lock_guard<std::mutex> lock(FrameDump.mutex);
+    if (FrameDump.enabled && (cmd.cmd == CC_INIT)) {
+        FrameDump.board_raster.SetWindowSize(PICSimLab.plWidth * PICSimLab.GetScale(),
+                                             PICSimLab.plHeight * PICSimLab.GetScale());
+    }
+    const int rret = FrameDump.board_raster.Cmd(cmd, ret);
+    return FrameDump.board_gui ? ret : rret;
+}
+
+int CFrameDump::PartsCanvasCmd(const CanvasCmd_t cmd) {
+    const int ret = FrameDump.parts_gui ? (*FrameDump.parts_gui)(cmd) : -1;
+    if (FrameDump.parts_gui && !FrameDump.enabled && !RasterTracks(cmd.cmd)) {
+        return ret;
+    }
+    std::lock_guard<std::mutex> lock(FrameDump.mutex);
+    FrameDump.parts_raster.SelectCanvas(SpareParts.GetPartOnDraw());
+    const int rret = FrameDump.parts_raster.Cmd(cmd, ret);
+    return FrameDump.parts_gui ? ret : rret;
+}
+
+void CFrameDump::Enable(const int en) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (en != enabled) {
+        enabled = en;
+        board_raster.SetEnabled(en);
+        parts_raster.SetEnabled(en);
+        if (!en) {
+            parts_frame.pixels.clear();
+            parts_frame.pixels.shrink_to_fit();
+            video_frame.pixels.clear();
+            video_frame.pixels.shrink_to_fit();
+        }
+    }
+    if (en) {
+        // redraw the whole board
+        PICSimLab.SetNeedResize(1);
+    }
+}
+
+int CFrameDump::Start(const char* dir_, const char* format_, const unsigned int every_) {
+    Stop();
+
+    dir = dir_;
+    format = format_;
+    if ((format != "png") && (format != "ppm") && (format != "raw")) {
+        printf("PICSimLab: Unknown frame format %s\n", format_);
+        return -1;
+    }
+    PICSimLab.SystemCmd(PSC_CREATEDIR, dir.c_str());
+
+    Enable(1);
+    every = every_;
+    last = quanta;
+    frames = 0;
+    running = 1;
+    return 0;
+}
+
+void CFrameDump::Stop(void) {
+    if (running) {
+        running = 0;
+        printf("PICSimLab: %lu frames written to %s\n", frames, dir.c_str());
+    }
+    Enable(video_fps != 0);
+}
+
+// compose parts as in spare parts window without offset
+void CFrameDump::ComposeParts(void) {
+    const float scale = SpareParts.GetScale();
+    int width = 0;
+    int height = 0;
+    for (int i = 0; i < SpareParts.GetCount(); i++) {
+        const raster_surface_t* bmp = parts_raster.GetBitmap(SpareParts.GetPart(i)->GetBitmap());
+        if (bmp) {
+            width = std::max(width, (int)(SpareParts.GetPart(i)->GetX() * scale) + bmp->width);
+            height = std::max(height, (int)(SpareParts.GetPart(i)->GetY() * scale) + bmp->height);
+        }
+    }
+    parts_frame.width = width;
+    parts_frame.height = height;
+    parts_frame.pixels.assign(width * height, 0x323232);
+    for (int i = 0; i < SpareParts.GetCount(); i++) {
+        const raster_surface_t* bmp = parts_raster.GetBitmap(SpareParts.GetPart(i)->GetBitmap());
+        if (bmp) {
+            CCanvasRaster::Blit(&parts_frame, bmp, SpareParts.GetPart(i)->GetX() * scale,
+                                SpareParts.GetPart(i)->GetY() * scale);
+        }
+    }
+}
+
+int CFrameDump::WriteFrame(const char* fname, const int parts) {
+    if (!parts) {
+        return CCanvasRaster::WriteFile(board_raster.GetWindow(), fname);
+    }
+    ComposeParts();
+    return CCanvasRaster::WriteFile(&parts_frame, fname);
+}
+
+int CFrameDump::Dump(const char* fname, const int parts) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!enabled) {
+        printf("PICSimLab: Frame rendering not started\n");
+        return -1;
+    }
+    return WriteFrame(fname, parts);
+}
+
+int CFrameDump::StartVideo(const char* fname, const unsigned int fps) {
+    StopVideo();
+
+    if (!fps) {
+        return -1;
+    }
+    video_fname = fname;
+    video_next = quanta * BASETIMER * 1000ULL;
+    video_fps = fps;  // file is opened at first frame, when the frame size is known
+    Enable(1);
+    return 0;
+}
+
+void CFrameDump::StopVideo(void) {
+    if (video_fps) {
+        video.Close();
+        video_fps = 0;
+    }
+    Enable(running);
+}
+
+// board and spare parts side by side, the frame size is fixed at the first frame
+void CFrameDump::CaptureVideo(void) {
+    const uint64_t now = quanta * BASETIMER * 1000ULL;
+    const uint64_t period = 1000000 / video_fps;
+    const raster_surface_t* board = board_raster.GetWindow();
+
+    if (now < video_next) {
+        return;
+    }
+
+    ComposeParts();
+
+    if (!video.IsOpen()) {
+        const int width = (board->width + parts_frame.width + 1) & ~1;
+        const int height = (std::max(board->height, parts_frame.height) + 1) & ~1;
+        if (!video.Open(video_fname.c_str(), width, height, video_fps)) {
+            video_fps = 0;
+            return;
+        }
+    }
+
+    video_frame.width = video.GetWidth();
+    video_frame.height = video.GetHeight();
+    video_frame.pixels.assign(video_frame.width * video_frame.height, 0x323232);
+    CCanvasRaster::Blit(&video_frame, board, 0, 0);
+    CCanvasRaster::Blit(&video_frame, &parts_frame, board->width, 0);
+
+    // frames not drawn in time repeat the last drawn frame
+    const unsigned int count = (now - video_next) / period + 1;
+    video.Push(video_frame.pixels, video_next, count);
+    video_next += count * period;
+}
+
+void CFrameDump::EndDraw(void) {
+    if (video_fps) {
+        std::lock_guard<std::mutex> lock(mutex);
+        CaptureVideo();
+    }
+
+    if (!running || !every || ((quanta - last) < every)) {
+        return;
+    }
+    last = quanta;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    char fname[1024];
+    snprintf(fname, sizeof(fname), "%s/board_%06lu.%s", dir.c_str(), frames, format.c_str());
+    WriteFrame(fname, 0);
+    if (SpareParts.GetCount()) {
+        snprintf(fname, sizeof(fname), "%s/parts_%06lu.%s", dir.c_str(), frames, format.c_str());
+        WriteFrame(fname, 1);
+    }
+    frames++;
+}
@@ -0,0 +1,122 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#ifndef FRAME_DUMP_H
+#define FRAME_DUMP_H
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#include "canvas_raster.h"
+#include "y4m_writer.h"
+
+/**
+ * @brief Headless frame rendering and dump
+ *
+ * Canvas commands sent to the GUI by the board and spare parts are also executed by software rasterizers,
+ * so frames can be written to files without a display (NOGUI build). Frames are written on demand or,
+ * after Start, at the first board draw after each every simulation quanta (calls of Run_CPU).
+ * Video capture writes the board and spare parts side by side to a Y4M file in virtual time (BASETIMER ms
+ * each quantum), so it runs faster than real time when the simulation is not throttled.
+ */
+class CFrameDump {
+public:
+    CFrameDump();
+
+    /**
+     * @brief  Insert the rasterizers between PICSimLab, SpareParts and the GUI canvas handlers
+     */
+    void Install(void);
+
+    /**
+     * @brief  Start writing frames to dir each every simulation quanta, format png, ppm or raw
+     */
+    int Start(const char* dir, const char* format, const unsigned int every);
+
+    void Stop(void);
+
+    int IsRunning(void) { return running; };
+
+    /**
+     * @brief  Write current board (parts = 0) or spare parts frame to file, format by file extension
+     */
+    int Dump(const char* fname, const int parts = 0);
+
+    /**
+     * @brief  Count one simulation quantum (called from the simulation thread)
+     */
+    void Quantum(void) { quanta++; };
+
+    /**
+     * @brief  Called at end of each board draw, writes frames when running
+     */
+    void EndDraw(void);
+
+    unsigned long GetFrames(void) { return frames; };
+
+    /**
+     * @brief  Start video capture to Y4M file, fps in frames per second of virtual time
+     */
+    int StartVideo(const char* fname, const unsigned int fps);
+
+    void StopVideo(void);
+
+    int IsCapturing(void) { return video_fps != 0; };
+
+    uint64_t GetVideoFrames(void) { return video.GetWritten(); };
+
+private:
+    static int BoardCanvasCmd(const CanvasCmd_t cmd);
+    static int PartsCanvasCmd(const CanvasCmd_t cmd);
+    void Enable(const int en);
+    int WriteFrame(const char* fname, const int parts);
+    void ComposeParts(void);
+    void CaptureVideo(void);
+    CCanvasRaster board_raster;
+    CCanvasRaster parts_raster;
+    raster_surface_t parts_frame;
+    raster_surface_t video_frame;
+    CY4MWriter video;
+    std::string video_fname;
+    unsigned int video_fps;
+    uint64_t video_next;  // virtual time of next video frame in us
+    CanvasCmd_ft board_gui;
+    CanvasCmd_ft parts_gui;
+    std::mutex mutex;
+    std::atomic<uint64_t> quanta;
+    uint64_t last;
+    unsigned int every;
+    unsigned long frames;
+    std::string dir;
+    std::string format;
+    int running;
+    std::atomic<int> enabled;
+};
+
+extern CFrameDump FrameDump;
+
+#endif  // FRAME_DUMP_H
@@ -0,0 +1,140 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#include "image_cache.h"
+
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include "util.h"
+
+typedef struct {
+    time_t mtime;
+    off_t fsize;
+    uint64_t hash;
+} imgc_file_t;
+
+// content hash of files already read, checked by modification time and size
+static std::unordered_map<std::string, imgc_file_t> file_hash;
+
+// FNV-1a 64 bits
+static int imgc_file_hash(const std::string& fname, uint64_t* hash) {
+    struct stat st;
+
+    if (stat(fname.c_str(), &st)) {
+        return -1;
+    }
+
+    auto it = file_hash.find(fname);
+    if ((it != file_hash.end()) && (it->second.mtime == st.st_mtime) && (it->second.fsize == st.st_size)) {
+        *hash = it->second.hash;
+        return 0;
+    }
+
+    FILE* fin = fopen_UTF8(fname.c_str(), "rb");
+    if (!fin) {
+        return -1;
+    }
+
+    unsigned char buff[65536];
+    uint64_t h = 0xCBF29CE484222325ULL;
+    size_t nr;
+    while ((nr = fread(buff, 1, sizeof(buff), fin)) > 0) {
+        for (size_t i = 0; i < nr; i++) {
+            h = (h ^ buff[i]) * 0x100000001B3ULL;
+        }
+    }
+    fclose(fin);
+
+    file_hash[fname] = {st.st_mtime, st.st_size, h};
+    *hash = h;
+    return 0;
+}
+
+CImageCache::CImageCache(void (*FreeImage_)(void* image), const size_t max_size_) {
+    FreeImage = FreeImage_;
+    max_size = max_size_;
+    size = 0;
+    hits = 0;
+    misses = 0;
+}
+
+CImageCache::~CImageCache() {
+    Clear();
+}
+
+std::string CImageCache::Key(const std::string& fname, const float scale, const int orientation) {
+    uint64_t hash;
+    char key[64];
+
+    if (imgc_file_hash(fname, &hash)) {
+        return "";
+    }
+    snprintf(key, sizeof(key), "%016llx_%.4f_%i", (unsigned long long)hash, scale, orientation);
+    return key;
+}
+
+void* CImageCache::Get(const std::string& key) {
+    auto it = index.find(key);
+    if (it == index.end()) {
+        misses++;
+        return NULL;
+    }
+    hits++;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->image;
+}
+
+void CImageCache::Put(const std::string& key, void* image, const size_t isize) {
+    auto it = index.find(key);
+    if (it != index.end()) {
+        size -= it->second->size;
+        (*FreeImage)(it->second->image);
+        entries.erase(it->second);
+        index.erase(it);
+    }
+
+    entries.push_front({key, image, isize});
+    index[key] = entries.begin();
+    size += isize;
+
+    // keep at least the new entry
+    while ((size > max_size) && (entries.size() > 1)) {
+        imgc_entry_t& last = entries.back();
+        size -= last.size;
+        (*FreeImage)(last.image);
+        index.erase(last.key);
+        entries.pop_back();
+    }
+}
+
+void CImageCache::Clear(void) {
+    for (auto& entry : entries) {
+        (*FreeImage)(entry.image);
+    }
+    entries.clear();
+    index.clear();
+    size = 0;
+}
@@ -0,0 +1,85 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#ifndef IMAGE_CACHE_H
+#define IMAGE_CACHE_H
+
+#include <stdint.h>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#define IMAGE_CACHE_SIZE (64 * 1024 * 1024)  // maximum size of cached images in bytes
+
+typedef struct {
+    std::string key;
+    void* image;
+    size_t size;
+} imgc_entry_t;
+
+/**
+ * @brief LRU cache of rasterized images
+ *
+ * Keys are made of the image file content hash, scale and orientation, so the same artwork loaded from
+ * another path (workspace files extracted again to a temporary dir) is found too. Entries hold an opaque
+ * GUI image owned by the cache and freed with the function given to the constructor when evicted.
+ */
+class CImageCache {
+public:
+    CImageCache(void (*FreeImage_)(void* image), const size_t max_size_ = IMAGE_CACHE_SIZE);
+    ~CImageCache();
+
+    /**
+     * @brief  Return the cache key of the image file, empty if the file can not be read
+     */
+    static std::string Key(const std::string& fname, const float scale, const int orientation);
+
+    /**
+     * @brief  Return the cached image or NULL, the entry becomes the most recently used
+     */
+    void* Get(const std::string& key);
+
+    /**
+     * @brief  Insert image of size bytes, least recently used entries are freed to keep the cache size
+     */
+    void Put(const std::string& key, void* image, const size_t size);
+
+    void Clear(void);
+
+    unsigned long GetHits(void) { return hits; };
+
+    unsigned long GetMisses(void) { return misses; };
+
+private:
+    void (*FreeImage)(void* image);
+    std::list<imgc_entry_t> entries;  // most recently used first
+    std::unordered_map<std::string, std::list<imgc_entry_t>::iterator> index;
+    size_t size;
+    size_t max_size;
+    unsigned long hits;
+    unsigned long misses;
+};
+
+#endif  // IMAGE_CACHE_H
@@ -28,6 +28,7 @@
 #include "spareparts.h"
 
 #include <math.h>
+#include <string.h>
 #include <picsim/picsim.h>
 
 COscilloscope Oscilloscope;
@@ -39,15 +40,27 @@ COscilloscope::COscilloscope() {
     triggerlv = 2.5;
     chpin[0] = 0;
     chpin[1] = 1;
+    for (int c = 2; c < OSC_MAX_CHANNELS; c++) {
+        chpin[c] = -1;
+    }
     soffset = 250;
     run = 1;
 
-    fp = 0;
+    memset(frames, 0, sizeof(frames));
+    fhead = 0;
+    ftail = 0;
+    view = OSC_FRAMES - 1;
+    wframe = &frames[0];
+    memset(env_min, 0, sizeof(env_min));
+    memset(env_max, 0, sizeof(env_max));
+    tpin_ = 0;
+    memset(lpins, 0, sizeof(lpins));
+    deep_chunks = 0;
+    deep_req = 0;
     tch = 0;
     is = 0;
     t = 0;
     tr = 0;
-    update = 0;
 
     measures[0] = 1;
     measures[1] = 2;
@@ -61,41 +74,73 @@ COscilloscope::COscilloscope() {
 }
 
 void COscilloscope::SetSample(void) {
-    double pins[2];
+    SetSample(1);
+}
 
+void COscilloscope::SetSample(const unsigned int count) {
     const picpin* ppins = pboard->MGetPinsValues();
 
+    if (deep_req.load(std::memory_order_acquire)) {
+        deep_req = 0;
+        if (deep_chunks) {
+            capture.Start(deep_chunks, Dt);
+        } else {
+            capture.Stop();
+        }
+    }
+
     if (!run)
         return;
 
-    if ((ppins[chpin[0]].ptype == PT_ANALOG) && (ppins[chpin[0]].dir == PD_IN))
-        pins[0] = ppins[chpin[0]].avalue;
-    else
-        pins[0] = ppins[chpin[0]].value * vmax;
+    // the pin values read now are the ones at the end of the batch, the steps before keep the last values
+    for (unsigned int s = 1; s < count; s++) {
+        Sample(lpins);
+    }
+
+    for (int c = 0; c < OSC_MAX_CHANNELS; c++) {
+        const int pin = chpin[c];
+        if (pin < 0)
+            lpins[c] = 0;
+        else if ((ppins[pin].ptype == PT_ANALOG) && (ppins[pin].dir == PD_IN))
+            lpins[c] = ppins[pin].avalue;
+        else
+            lpins[c] = ppins[pin].value * vmax;
+    }
+
+    Sample(lpins);
+}
+
+void COscilloscope::Sample(const float* pins) {
+    // envelope of all samples between two points, so pulses shorter than a point are not lost
+    for (int c = 0; c < OSC_MAX_CHANNELS; c++) {
+        env_min[c] = (pins[c] < env_min[c]) ? pins[c] : env_min[c];
+        env_max[c] = (pins[c] > env_max[c]) ? pins[c] : env_max[c];
+    }
 
-    if ((ppins[chpin[1]].ptype == PT_ANALOG) && (ppins[chpin[1]].dir == PD_IN))
-        pins[1] = ppins[chpin[1]].avalue;
-    else
-        pins[1] = ppins[chpin[1]].value * vmax;
+    if (capture.IsRunning()) {
+        capture.Sample(pins);
+    }
 
     // sampling
     if (t > Rt) {
         t -= Rt;
-        databuffer[fp][0][is] = -pins[0] + ((1.0 * rand() / RAND_MAX) - 0.5) * 0.1;
-        databuffer[fp][1][is] = -pins[1] + ((1.0 * rand() / RAND_MAX) - 0.5) * 0.1;
+        for (int c = 0; c < OSC_MAX_CHANNELS; c++) {
+            wframe->data[c][is] = -pins[c];
+            wframe->emin[c][is] = -env_max[c];
+            wframe->emax[c][is] = -env_min[c];
+            env_min[c] = pins[c];
+            env_max[c] = pins[c];
+        }
         is++;
 
-        if ((tscale > 30) && is) {
-            databuffer[!fp][0][is - 1] = databuffer[fp][0][is - 1];
-            databuffer[!fp][1][is - 1] = databuffer[fp][1][is - 1];
-
-            ch[0] = &databuffer[!fp][0][0];
-            ch[1] = &databuffer[!fp][1][0];
-            update = is;  // Request redraw screen
+        if (tscale > 30) {
+            // roll mode, only send a partial frame when GUI is idle
+            if (fhead.load(std::memory_order_relaxed) == ftail.load(std::memory_order_acquire)) {
+                PublishFrame(0, is);
+            }
 
             if (is >= WMAX) {
                 t = 0;
-                fp = !fp;  // togle fp
                 is = 0;
             }
         } else if (is >= NPOINTS)  // buffer full
@@ -107,16 +152,7 @@ void COscilloscope::SetSample(void) {
             }
             tr = 0;
             t = 0;
-            if (tscale > 30) {
-                ch[0] = &databuffer[fp][0][0];
-                ch[1] = &databuffer[fp][1][0];
-                update = is;  // Request redraw screen
-            } else {
-                ch[0] = &databuffer[fp][0][soffset];
-                ch[1] = &databuffer[fp][1][soffset];
-                update = is - soffset + 1;  // Request redraw screen
-            }
-            fp = !fp;  // togle fp
+            PublishFrame(soffset, is - soffset + 1);
             is = 0;
         }
     }
@@ -125,22 +161,67 @@ void COscilloscope::SetSample(void) {
     // trigger
     if ((usetrigger) && (tscale <= 30)) {
         if ((!tr) && (is >= NPOINTS / 2)) {
-            if ((pins_[tch] < triggerlv) && (pins[tch] >= triggerlv)) {
+            if ((tpin_ < triggerlv) && (pins[tch] >= triggerlv)) {
                 tr = 1;
 
                 is = is - (NPOINTS / 2);
 
-                for (int i = 0; i < NPOINTS / 2; i++) {
-                    databuffer[fp][0][i] = databuffer[fp][0][i + is];
-                    databuffer[fp][1][i] = databuffer[fp][1][i + is];
+                for (int c = 0; c < OSC_MAX_CHANNELS; c++) {
+                    memmove(wframe->data[c], wframe->data[c] + is, (NPOINTS / 2) * sizeof(float));
+                    memmove(wframe->emin[c], wframe->emin[c] + is, (NPOINTS / 2) * sizeof(float));
+                    memmove(wframe->emax[c], wframe->emax[c] + is, (NPOINTS / 2) * sizeof(float));
                 }
                 is = (NPOINTS / 2);
             }
         }
     }
 
-    pins_[0] = pins[0];
-    pins_[1] = pins[1];
+    tpin_ = pins[tch];
+}
+
+// simulation thread: send the frame in acquisition to GUI and start a new one
+void COscilloscope::PublishFrame(const int start, const int update) {
+    const unsigned int head = fhead.load(std::memory_order_relaxed);
+
+    // the frame before ftail is in use by GUI and the next frame must be free to acquisition,
+    // if queue is full the frame is dropped and reused
+    if ((head - ftail.load(std::memory_order_acquire)) >= (OSC_FRAMES - 2)) {
+        return;
+    }
+
+    osc_frame_t* frame = &frames[head % OSC_FRAMES];
+    osc_frame_t* next = &frames[(head + 1) % OSC_FRAMES];
+
+    frame->start = start;
+    frame->update = update;
+
+    if (tscale > 30) {
+        // roll mode keep old samples on screen
+        memcpy(next->data, frame->data, sizeof(frame->data));
+        memcpy(next->emin, frame->emin, sizeof(frame->emin));
+        memcpy(next->emax, frame->emax, sizeof(frame->emax));
+    }
+    wframe = next;
+
+    fhead.store(head + 1, std::memory_order_release);
+}
+
+// GUI thread: get the newest frame
+int COscilloscope::FetchFrame(void) {
+    decoder.Update();
+
+    const unsigned int head = fhead.load(std::memory_order_acquire);
+    unsigned int tail = ftail.load(std::memory_order_relaxed);
+
+    if (tail == head) {
+        return 0;
+    }
+
+    // skip old frames
+    tail = head - 1;
+    view = tail % OSC_FRAMES;
+    ftail.store(head, std::memory_order_release);
+    return frames[view].update;
 }
 
 void COscilloscope::NextMeasure(int mn) {
@@ -163,7 +244,8 @@ void COscilloscope::CalculateStats(int channel) {
     ch_status[channel].Vmin = 1000;
     double sumSamples = 0;
     double sumSquares = 0;
-    double val = -ch[channel][0];
+    const float* ch = GetChannel(channel);
+    double val = -ch[0];
     int i = 1;
     bool ltr_down = (val < ch_status[channel].Vavr);  // last transition down
     bool firstUp = true;
@@ -174,7 +256,7 @@ void COscilloscope::CalculateStats(int channel) {
     unsigned short numPCycles = 0;  // Number of positive semi-cycles
 
     for (i = 1; i < (NPOINTS / 2) - 1; i++) {
-        val = -ch[channel][i];
+        val = -ch[i];
 
         if (ch_status[channel].Vmax < val)
             ch_status[channel].Vmax = val;
@@ -241,6 +323,37 @@ void COscilloscope::ClearStats(int channel) {
     memset(&ch_status[channel], 0, sizeof(ch_status_t));
 }
 
+int COscilloscope::AddDecoder(const int type, const int* ch, const unsigned int speed) {
+    if (!deep_chunks) {
+        SetDeep(CAP_DEFAULT_CHUNKS);
+    }
+    decoder.Start(&capture, vmax / 2.0);
+    return decoder.Add(type, ch, speed);
+}
+
+int COscilloscope::ExportCapture(const char* fname) {
+    std::vector<std::string> names;
+    std::vector<std::string> note_names;
+    std::vector<cap_note_t> notes;
+
+    for (int c = 0; c < OSC_MAX_CHANNELS; c++) {
+        if ((chpin[c] < 0) || !pboard) {
+            names.push_back("");
+        } else if (pboard->GetUseSpareParts()) {
+            names.push_back(SpareParts.GetPinName(chpin[c] + 1));
+        } else {
+            names.push_back(pboard->MGetPinName(chpin[c] + 1));
+        }
+    }
+
+    for (int d = 0; d < decoder.GetCount(); d++) {
+        note_names.push_back(decoder.GetName(d, 1));
+    }
+    decoder.GetNotes(0, UINT64_MAX, notes, DEC_MAX_NOTES);
+
+    return capture.Export(fname, names, note_names, notes);
+}
+
 void COscilloscope::Reset(void) {
     vmax = pboard->MGetVCC();
 }
@@ -284,6 +397,9 @@ void COscilloscope::WritePreferences(void) {
     WindowCmd(PW_MAIN, "combo3", PWA_COMBOGETTEXT, NULL, &buff);
     PICSimLab.SavePrefs("osc_ch2", buff);
 
+    PICSimLab.SavePrefs("osc_chx", WriteLogicPins());
+    PICSimLab.SavePrefs("osc_deep", std::to_string(deep_chunks));
+
     WindowCmd(PW_MAIN, "spind5", PWA_SPINDGETVALUE, NULL, &fvalue);
     PICSimLab.SavePrefs("osc_tscale", std::to_string(fvalue));
     WindowCmd(PW_MAIN, "spind6", PWA_SPINDGETVALUE, NULL, &fvalue);
@@ -364,6 +480,14 @@ void COscilloscope::ReadPreferences(char* name, char* value) {
         SetChannelPin(1, atoi(value) - 1);
     }
 
+    if (!strcmp(name, "osc_chx")) {
+        ReadLogicPins(value);
+    }
+
+    if (!strcmp(name, "osc_deep")) {
+        SetDeep(atoi(value));
+    }
+
     if (!strcmp(name, "osc_tscale")) {
         WindowCmd(PW_MAIN, "spind5", PWA_SPINDSETVALUE, value);
     }
@@ -486,6 +610,9 @@ std::vector<std::string> COscilloscope::WritePreferencesList(void) {
     line += buff;
     list.push_back(line);
 
+    line = "osc_chx,0,0,0:" + WriteLogicPins();
+    list.push_back(line);
+
     return list;
 }
 
@@ -593,6 +720,30 @@ void COscilloscope::ReadPreferencesList(std::vector<std::string>& pl) {
     SetBaseTimer();
 }
 
+// pins of logic channels 3 to 8 (1 based, 0 = off)
+std::string COscilloscope::WriteLogicPins(void) {
+    std::string pins;
+    for (int c = 2; c < OSC_MAX_CHANNELS; c++) {
+        if (c > 2) {
+            pins += ",";
+        }
+        pins += std::to_string(chpin[c] + 1);
+    }
+    return pins;
+}
+
+void COscilloscope::ReadLogicPins(const char* value) {
+    const char* ptr = value;
+    for (int c = 2; c < OSC_MAX_CHANNELS; c++) {
+        char* end;
+        SetChannelPin(c, strtol(ptr, &end, 10) - 1);
+        if (*end != ',') {
+            break;
+        }
+        ptr = end + 1;
+    }
+}
+
 void COscilloscope::SetBaseTimer(void) {
     board* pboard = PICSimLab.GetBoard();
 
@@ -662,6 +813,11 @@ void COscilloscope::SetBaseTimer(void) {
     WindowCmd(PW_MAIN, "spind6", PWA_SPINDGETVALUE, NULL, &toffset);
 
     SetTimeScaleAndOffset(tscale, toffset);
+
+    // restart deep capture with new sample time
+    if (deep_chunks) {
+        SetDeep(deep_chunks);
+    }
 }
 
 void COscilloscope::SetTimeScaleAndOffset(float tscale_, float toffset_) {
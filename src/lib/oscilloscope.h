@@ -26,8 +26,11 @@
 #ifndef OSCILLOSCOPE
 #define OSCILLOSCOPE
 
+#include <atomic>
 #include <vector>
 #include "board.h"
+#include "scope_capture.h"
+#include "scope_decoder.h"
 #include "types.h"
 
 #define WMAX 350
@@ -37,6 +40,10 @@
 
 #define MAX_MEASURES 10
 
+#define OSC_FRAMES 4  // frame queue size between simulation and GUI threads
+
+#define OSC_MAX_CHANNELS 8  // channels 1 and 2 are analog, 3 to 8 are drawn as logic lanes
+
 typedef struct {
     double Vrms;
     double Vavr;
@@ -48,6 +55,14 @@ typedef struct {
     double Duty;
 } ch_status_t;
 
+typedef struct {
+    float data[OSC_MAX_CHANNELS][NPOINTS];  // last sample of each point
+    float emin[OSC_MAX_CHANNELS][NPOINTS];  // envelope minimum of all samples of each point
+    float emax[OSC_MAX_CHANNELS][NPOINTS];  // envelope maximum of all samples of each point
+    int start;                              // first point to draw (trigger offset)
+    int update;                             // update cursor position
+} osc_frame_t;
+
 class COscilloscope {
 public:
     COscilloscope();
@@ -59,6 +74,11 @@ public:
      */
     void SetSample(void);
 
+    /**
+     * @brief  Sample count steps of a batch run, the pins changed only at the end of the batch
+     */
+    void SetSample(const unsigned int count);
+
     void SetBoard(board* b) { pboard = b; };
 
     void NextMeasure(int mn);
@@ -73,17 +93,37 @@ public:
     int GetTriggerChannel(void) { return tch; };
     void SetTriggerChannel(int tc) { tch = tc; };
 
-    double* GetChannel(int cn) { return ch[cn]; };
+    /**
+     * @brief  Get channel data of the frame in use by GUI
+     */
+    const float* GetChannel(int cn) { return &frames[view].data[cn][frames[view].start]; };
+
+    /**
+     * @brief  Get channel envelope (min/max of all samples between two points) of the frame in use by GUI
+     */
+    const float* GetChannelMin(int cn) { return &frames[view].emin[cn][frames[view].start]; };
+    const float* GetChannelMax(int cn) { return &frames[view].emax[cn][frames[view].start]; };
+
+    /**
+     * @brief  Return 1 if there are more than one sample per point (envelope must be drawn)
+     */
+    int GetEnvelope(void) { return Rt > Dt; };
+
+    /**
+     * @brief  Get the newest frame from simulation thread, return the update position or 0 if no new frame
+     */
+    int FetchFrame(void);
 
     void CalculateStats(int channel);
     void ClearStats(int channel);
 
     ch_status_t GetChannelStatus(int cn) { return ch_status[cn]; };
 
-    int GetUpdate(void) { return update; };
-    void SetUpdate(int up) { update = up; };
-
+    /**
+     * @brief  Set channel input pin (0 based), negative value turns the channel off
+     */
     void SetChannelPin(int ch, int pin) { chpin[ch] = pin; };
+    int GetChannelPin(int ch) { return chpin[ch]; };
 
     int GetSampleOffset(void) { return soffset; };
 
@@ -95,11 +135,36 @@ public:
     void SetTriggerLevel(double tl) { triggerlv = tl; };
 
     void SetVMax(float vm) { vmax = vm; };
+    float GetVMax(void) { return vmax; };
 
     double GetRT(void) { return Rt; };
     double GetDT(void) { return Dt; };
     double Getxz(void) { return xz; };
 
+    /**
+     * @brief  Start deep capture with a ring of nchunks chunks of CAP_CHUNK events or stop it if nchunks is 0,
+     * the request is done by simulation thread in next sample
+     */
+    void SetDeep(const unsigned int nchunks) {
+        deep_chunks = nchunks;
+        deep_req = 1;
+    };
+    unsigned int GetDeep(void) { return deep_chunks; };
+
+    CScopeCapture* GetCapture(void) { return &capture; };
+
+    CScopeDecoder* GetDecoder(void) { return &decoder; };
+
+    /**
+     * @brief  Add a protocol decoder of channels ch (0 based), deep capture is started if it is off
+     */
+    int AddDecoder(const int type, const int* ch, const unsigned int speed = 0);
+
+    /**
+     * @brief  Export deep capture to VCD file
+     */
+    int ExportCapture(const char* fname);
+
     void Reset(void);
 
     void SetBaseTimer(void);
@@ -124,17 +189,29 @@ private:
     double triggerlv;
     int tch;  // trigger channel
     int soffset;
-    int chpin[2];
-    double databuffer[2][2][NPOINTS];  // flip buffers + 2 channels + 700 points
-    int fp;                            // actual flip buffer
-    double* ch[2];                     // actual channel data (pointer to databuffer)
-    ch_status_t ch_status[2];          // channel measurament status
-    double pins_[2];                   // last value of input pins
-    int is;                            // input samples
-    double t;                          // time
-    int tr;                            // trigger
+    int chpin[OSC_MAX_CHANNELS];
+    void PublishFrame(const int start, const int update);
+    void Sample(const float* pins);
+    std::string WriteLogicPins(void);
+    void ReadLogicPins(const char* value);
+    osc_frame_t frames[OSC_FRAMES];           // SPSC frame queue
+    std::atomic<unsigned int> fhead;          // next frame to publish (simulation thread)
+    std::atomic<unsigned int> ftail;          // next frame to fetch (GUI thread)
+    osc_frame_t* wframe;                      // frame in acquisition
+    int view;                                 // frame in use by GUI
+    ch_status_t ch_status[OSC_MAX_CHANNELS];  // channel measurament status
+    float env_min[OSC_MAX_CHANNELS];          // envelope minimum since last point
+    float env_max[OSC_MAX_CHANNELS];          // envelope maximum since last point
+    float tpin_;                              // last value of trigger channel
+    float lpins[OSC_MAX_CHANNELS];            // last sampled pin values
+    CScopeCapture capture;                    // deep capture
+    CScopeDecoder decoder;                    // deep capture protocol decoders
+    unsigned int deep_chunks;                 // deep capture size (0 = off)
+    std::atomic<int> deep_req;                // deep capture start/stop request
+    int is;                                   // input samples
+    double t;                                 // time
+    int tr;                                   // trigger
     int run;
-    int update;
     int measures[5];
     float vmax;
     double xz;
@@ -52,6 +52,15 @@ part::part(const unsigned x, const unsigned y, const char* name, const char* typ
     for (int i = 0; i < MAX_IDS; i++) {
         input_ids[i] = &input[i];
         output_ids[i] = &output[i];
+        OutputCache[i] = NULL;
+    }
+}
+
+part::~part(void) {
+    for (int i = 0; i < MAX_IDS; i++) {
+        if (OutputCache[i]) {
+            delete OutputCache[i];
+        }
     }
 }
 
@@ -77,6 +86,19 @@ void part::ReadMaps(void) {
     for (int i = 0; i < outputc; i++) {
         output_ids[GetOutputId(output[i].name)] = &output[i];
     }
+
+    // static outputs are recorded again with the new map
+    for (int i = 0; i < MAX_IDS; i++) {
+        if (OutputCache[i]) {
+            OutputCache[i]->Clear();
+        }
+    }
+}
+
+void part::SetOutputStatic(const unsigned short id) {
+    if ((id < MAX_IDS) && (!OutputCache[id])) {
+        OutputCache[id] = new CCanvasCmdList();
+    }
 }
 
 void part::ReadInputMap(std::string fname) {
@@ -541,6 +563,7 @@ std::string part::GetName(void) {
 }
 
 void part::Draw(void) {
+    CCanvasCmdList* list = SpareParts.GetCanvasCmdList();
     Update = 0;
 
     for (int i = 0; i < outputc; i++) {
@@ -555,7 +578,21 @@ void part::Draw(void) {
             }
             Update++;  // set to update buffer
 
-            DrawOutput(i);
+            CCanvasCmdList* cache = (output[i].id < MAX_IDS) ? OutputCache[output[i].id] : NULL;
+
+            if (cache && list && cache->GetCount()) {
+                list->Copy(*cache, 0);  // replay static layer
+            } else if (cache && list) {
+                const int first = list->GetCount();
+                const unsigned int runs = list->GetRuns();
+                DrawOutput(i);
+                // record only if all commands of the output are in the list
+                if (runs == list->GetRuns()) {
+                    cache->Copy(*list, first);
+                }
+            } else {
+                DrawOutput(i);
+            }
         }
     }
 
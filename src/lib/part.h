@@ -27,6 +27,7 @@
 #define PART_H
 
 #include "board.h"
+#include "draw.h"
 
 /**
  * @brief PCWProp
@@ -256,7 +257,7 @@ public:
     /**
      * @brief  Called once on part destruction
      */
-    virtual ~part(void) {};
+    virtual ~part(void);
 
     /**
      * @brief  Return the Bitmap of part
@@ -407,11 +408,17 @@ protected:
      */
     int PointInside(int x, int y, input_t input);
 
+    /**
+     * @brief  Set output as static layer, its drawing depends only on the part map and is recorded once and replayed
+     */
+    void SetOutputStatic(const unsigned short id);
+
     void SetPCWProperties(const PCWProp* pcwprop);
     void SetPCWComboWithPinNames(const char* combo_name, const unsigned char pin);
     unsigned char GetPWCComboSelectedPin(const char* combo_name);
 
 private:
+    CCanvasCmdList* OutputCache[MAX_IDS];  ///< recorded commands of static outputs by id
     const PCWProp* PCWProperties;
     int PCWCount;
     std::string Name;
@@ -24,8 +24,11 @@
    ######################################################################## */
 
 #include "picsimlab.h"
+#include "frame_dump.h"
 #include "oscilloscope.h"
+#include "profiler.h"
 #include "spareparts.h"
+#include "wave_check.h"
 
 #include <unistd.h>
 
@@ -91,6 +94,7 @@ CPICSimLab::CPICSimLab() {
     OnUpdateGUI = NULL;
     OnConfigMenuGUI = NULL;
     OnCanvasCmd = NULL;
+    CmdListOpen = 0;
     OnWindowCmd = NULL;
 }
 
@@ -125,6 +129,9 @@ void CPICSimLab::SetJUMPSTEPS(int js) {
 
 void CPICSimLab::DeleteBoard(void) {
     if (pboard) {
+        Profiler.Stop();
+        WaveCheck.Stop();
+        FrameDump.StopVideo();
         delete pboard;
         pboard = NULL;
     }
@@ -231,12 +238,30 @@ void CPICSimLab::ConfigMenuGUI(const PICSimlabGUIMenu type) {
 }
 
 int CPICSimLab::CanvasCmd(const CanvasCmd_t cmd) {
+    if (PICSimLab.CmdListOpen) {
+        if (PICSimLab.CmdList.Add(cmd)) {
+            return 0;
+        }
+        // keep the order: recorded commands are sent before this one
+        PICSimLab.CmdList.Run(PICSimLab.OnCanvasCmd);
+    }
     if (PICSimLab.OnCanvasCmd) {
         return (*PICSimLab.OnCanvasCmd)(cmd);
     }
     return -1;
 }
 
+void CPICSimLab::CanvasCmdListBegin(void) {
+    CmdList.Clear();
+    CmdListOpen = 1;
+}
+
+void CPICSimLab::CanvasCmdListEnd(void) {
+    CmdListOpen = 0;
+    CmdList.Run(OnCanvasCmd);
+    FrameDump.EndDraw();
+}
+
 void CPICSimLab::SetClock(const float clk, const int update) {
     if ((OnClockSet)) {
         (*OnClockSet)(clk, update);
@@ -1158,6 +1183,7 @@ int CPICSimLab::LoadHexFile(std::string fname) {
         EndSimulation(0, cmd);
     }
 
+    Profiler.Stop();
     GetBoard()->MEnd();
     GetBoard()->MSetSerial(SERIALDEVICE);
 
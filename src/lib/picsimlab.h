@@ -254,6 +254,12 @@ public:
 
     static int CanvasCmd(const CanvasCmd_t cmd);
 
+    /**
+     * @brief Record the following canvas commands in a list, sent to the GUI by CanvasCmdListEnd
+     */
+    void CanvasCmdListBegin(void);
+    void CanvasCmdListEnd(void);
+
     static int WindowCmd(const int id, const char* ControlName, const PICSimLabWindowAction action, const char* Value,
                          void* ReturnBuff = NULL);
 
@@ -286,6 +292,8 @@ public:
 private:
     void StartRControl(void);
     board* pboard;
+    CCanvasCmdList CmdList;
+    int CmdListOpen;
     int lab;
     int lab_;
     std::string SHARE;
@@ -0,0 +1,425 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#include "profiler.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+#include "util.h"
+
+// #define _DEBUG_
+#define dprint \
+    if (1) {   \
+    } else     \
+        printf
+
+CProfiler Profiler;
+
+CProfiler::CProfiler() {
+    pboard = NULL;
+    running = 0;
+    size = 0;
+    inst_pc = 0;
+    retired = 0;
+    inst_count = NULL;
+    cycles_count = NULL;
+}
+
+CProfiler::~CProfiler() {
+    if (inst_count) {
+        free(inst_count);
+        free(cycles_count);
+    }
+}
+
+int CProfiler::Start(board* b) {
+    if (!b->DBGIsSupported()) {
+        printf("PICSimLab: Profiler not supported by %s\n", b->GetName().c_str());
+        return 1;
+    }
+
+    pboard = b;
+
+    if (size != pboard->DBGGetROMSize()) {
+        size = pboard->DBGGetROMSize();
+        inst_count = (uint64_t*)realloc(inst_count, size * sizeof(uint64_t));
+        cycles_count = (uint64_t*)realloc(cycles_count, size * sizeof(uint64_t));
+        Clear();
+    }
+    inst_pc = pboard->DBGGetPC();
+    retired = 0;
+    running = 1;
+    return 0;
+}
+
+void CProfiler::Stop(void) {
+    running = 0;
+}
+
+void CProfiler::Clear(void) {
+    if (size) {
+        memset(inst_count, 0, size * sizeof(uint64_t));
+        memset(cycles_count, 0, size * sizeof(uint64_t));
+    }
+}
+
+uint64_t CProfiler::GetTotalCycles(void) {
+    uint64_t total = 0;
+    for (unsigned int i = 0; i < size; i++) {
+        total += cycles_count[i];
+    }
+    return total;
+}
+
+// symbols ---------------------------------------------------------------------
+
+int CProfiler::FindSymbol(const unsigned int addr) {
+    // symbols are sorted by address, return the last one with address <= addr
+    int first = 0;
+    int last = symbols.size() - 1;
+    int found = -1;
+
+    while (first <= last) {
+        int mid = (first + last) / 2;
+        if (symbols[mid].addr <= addr) {
+            found = mid;
+            first = mid + 1;
+        } else {
+            last = mid - 1;
+        }
+    }
+    return found;
+}
+
+int CProfiler::LoadELF(FILE* fin) {
+    unsigned char ehdr[52];
+
+    if (fread(ehdr, 1, 52, fin) != 52) {
+        return 1;
+    }
+
+    // only 32 bits little endian (AVR, ARM, PIC32, XC8)
+    if ((ehdr[4] != 1) || (ehdr[5] != 1)) {
+        printf("PICSimLab: Profiler only support ELF32 little endian files\n");
+        return 1;
+    }
+
+#define LE16(p) ((p)[0] | ((p)[1] << 8))
+#define LE32(p) ((uint32_t)((p)[0] | ((p)[1] << 8) | ((p)[2] << 16) | ((uint32_t)(p)[3] << 24)))
+
+    uint32_t shoff = LE32(ehdr + 32);
+    unsigned int shentsize = LE16(ehdr + 46);
+    unsigned int shnum = LE16(ehdr + 48);
+
+    if ((shentsize < 40) || (!shnum)) {
+        return 1;
+    }
+
+    unsigned char* shdr = (unsigned char*)malloc(shentsize * shnum);
+    fseek(fin, shoff, SEEK_SET);
+    if (fread(shdr, shentsize, shnum, fin) != shnum) {
+        free(shdr);
+        return 1;
+    }
+
+    for (unsigned int s = 0; s < shnum; s++) {
+        unsigned char* sh = shdr + s * shentsize;
+
+        if (LE32(sh + 4) != 2) {  // SHT_SYMTAB
+            continue;
+        }
+
+        uint32_t symoff = LE32(sh + 16);
+        uint32_t symsize = LE32(sh + 20);
+        uint32_t link = LE32(sh + 24);
+
+        if (link >= shnum) {
+            continue;
+        }
+
+        unsigned char* strsh = shdr + link * shentsize;
+        uint32_t stroff = LE32(strsh + 16);
+        uint32_t strsize = LE32(strsh + 20);
+
+        unsigned char* syms = (unsigned char*)malloc(symsize);
+        char* strs = (char*)malloc(strsize + 1);
+
+        fseek(fin, symoff, SEEK_SET);
+        size_t nsym = fread(syms, 1, symsize, fin) / 16;
+        fseek(fin, stroff, SEEK_SET);
+        strs[fread(strs, 1, strsize, fin)] = 0;
+
+        for (size_t i = 0; i < nsym; i++) {
+            unsigned char* sym = syms + i * 16;
+            uint32_t name = LE32(sym);
+            unsigned char type = sym[12] & 0x0F;
+            unsigned char bind = sym[12] >> 4;
+            unsigned int shndx = LE16(sym + 14);
+
+            // functions and global labels of asm code
+            if ((type == 2) || ((type == 0) && (bind == 1) && shndx && (shndx < 0xFF00))) {
+                if ((name < strsize) && strs[name]) {
+                    symbols.push_back({LE32(sym + 4), strs + name});
+                }
+            }
+        }
+        free(syms);
+        free(strs);
+    }
+    free(shdr);
+#undef LE16
+#undef LE32
+    return 0;
+}
+
+int CProfiler::LoadMap(FILE* fin) {
+    char line[1024];
+    char s1[512];
+    char s2[512];
+    char s3[512];
+    unsigned int addr;
+
+    while (fgets(line, 1023, fin)) {
+        int n = sscanf(line, "%511s %511s %511s", s1, s2, s3);
+
+        if ((n == 3) && (strlen(s2) == 1) && strchr("TtWw", s2[0])) {
+            // nm output: 0000012a T main
+            if (sscanf(s1, "%x", &addr) == 1) {
+                symbols.push_back({addr, s3});
+            }
+        } else if ((n == 2) && (!strncmp(s1, "0x", 2)) && (isalpha(s2[0]) || (s2[0] == '_'))) {
+            // GNU ld map: 0x0000012a    main
+            if (sscanf(s1 + 2, "%x", &addr) == 1) {
+                symbols.push_back({addr, s2});
+            }
+        }
+    }
+    return 0;
+}
+
+int CProfiler::LoadSymbols(const char* fname) {
+    FILE* fin;
+    char magic[4];
+    int ret;
+
+    if (!(fin = fopen_UTF8(fname, "rb"))) {
+        printf("PICSimLab: Profiler can't open symbol file %s\n", fname);
+        return 1;
+    }
+
+    symbols.clear();
+
+    if ((fread(magic, 1, 4, fin) == 4) && (!memcmp(magic, "\177ELF", 4))) {
+        rewind(fin);
+        ret = LoadELF(fin);
+    } else {
+        rewind(fin);
+        ret = LoadMap(fin);
+    }
+    fclose(fin);
+
+    std::sort(symbols.begin(), symbols.end(),
+              [](const prof_symbol_t& a, const prof_symbol_t& b) { return a.addr < b.addr; });
+
+    dprint("PICSimLab: Profiler %i symbols loaded from %s\n", (int)symbols.size(), fname);
+    return ret || symbols.empty();
+}
+
+int CProfiler::LoadSymbolsAuto(const std::string fname) {
+    static const char* exts[] = {".elf", ".map", ".sym", NULL};
+
+    std::string base = fname.substr(0, fname.find_last_of('.'));
+
+    for (int i = 0; exts[i]; i++) {
+        FILE* fin = fopen_UTF8((base + exts[i]).c_str(), "rb");
+        if (fin) {
+            fclose(fin);
+            if (!LoadSymbols((base + exts[i]).c_str())) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+// output ----------------------------------------------------------------------
+
+int CProfiler::DumpCallgrind(FILE* fout) {
+    uint64_t tinst = 0;
+    uint64_t tcycles = 0;
+
+    for (unsigned int i = 0; i < size; i++) {
+        tinst += inst_count[i];
+        tcycles += cycles_count[i];
+    }
+
+    fprintf(fout, "# callgrind format\n");
+    fprintf(fout, "version: 1\n");
+    fprintf(fout, "creator: PICSimLab\n");
+    fprintf(fout, "cmd: %s\n", pboard ? pboard->GetProcessorName().c_str() : "");
+    fprintf(fout, "positions: instr\n");
+    fprintf(fout, "events: Instructions Cycles\n");
+    fprintf(fout, "summary: %llu %llu\n\n", (unsigned long long)tinst, (unsigned long long)tcycles);
+
+    int lsym = -2;
+    for (unsigned int i = 0; i < size; i++) {
+        if (cycles_count[i] || inst_count[i]) {
+            int sym = FindSymbol(i);
+            if (sym != lsym) {
+                fprintf(fout, "fn=%s\n", (sym >= 0) ? symbols[sym].name.c_str() : "unknown");
+                lsym = sym;
+            }
+            fprintf(fout, "0x%x %llu %llu\n", i, (unsigned long long)inst_count[i],
+                    (unsigned long long)cycles_count[i]);
+        }
+    }
+    fprintf(fout, "\ntotals: %llu %llu\n", (unsigned long long)tinst, (unsigned long long)tcycles);
+    return 0;
+}
+
+// minimal protobuf encoder for pprof profile.proto
+static void pb_varint(std::string& buf, uint64_t v) {
+    while (v >= 0x80) {
+        buf += (char)((v & 0x7F) | 0x80);
+        v >>= 7;
+    }
+    buf += (char)v;
+}
+
+static void pb_uint(std::string& buf, const int field, const uint64_t v) {
+    pb_varint(buf, field << 3);
+    pb_varint(buf, v);
+}
+
+static void pb_bytes(std::string& buf, const int field, const std::string& data) {
+    pb_varint(buf, (field << 3) | 2);
+    pb_varint(buf, data.size());
+    buf += data;
+}
+
+static std::string pb_valuetype(const int type, const int unit) {
+    std::string vt;
+    pb_uint(vt, 1, type);
+    pb_uint(vt, 2, unit);
+    return vt;
+}
+
+int CProfiler::DumpPprof(FILE* fout) {
+    std::string prof;
+    std::string msg;
+
+    // string table: 0 "", 1 instructions, 2 count, 3 cycles, 4 firmware, 5 unknown, symbols...
+    static const char* strs[] = {"", "instructions", "count", "cycles", "firmware", "unknown"};
+    const int sym_str = 6;
+
+    pb_bytes(prof, 1, pb_valuetype(1, 2));
+    pb_bytes(prof, 1, pb_valuetype(3, 2));
+
+    for (unsigned int i = 0; i < size; i++) {
+        if (cycles_count[i] || inst_count[i]) {
+            msg.clear();
+            pb_uint(msg, 1, i + 1);  // location id
+            pb_uint(msg, 2, inst_count[i]);
+            pb_uint(msg, 2, cycles_count[i]);
+            pb_bytes(prof, 2, msg);
+        }
+    }
+
+    msg.clear();
+    pb_uint(msg, 1, 1);     // id
+    pb_uint(msg, 3, size);  // memory_limit
+    pb_uint(msg, 5, 4);     // filename
+    pb_uint(msg, 7, 1);     // has_functions
+    pb_bytes(prof, 3, msg);
+
+    for (unsigned int i = 0; i < size; i++) {
+        if (cycles_count[i] || inst_count[i]) {
+            std::string line;
+            int sym = FindSymbol(i);
+            pb_uint(line, 1, sym + 2);  // function id (1 = unknown)
+
+            msg.clear();
+            pb_uint(msg, 1, i + 1);  // id
+            pb_uint(msg, 2, 1);      // mapping id
+            pb_uint(msg, 3, i);      // address
+            pb_bytes(msg, 4, line);
+            pb_bytes(prof, 4, msg);
+        }
+    }
+
+    msg.clear();
+    pb_uint(msg, 1, 1);
+    pb_uint(msg, 2, 5);
+    pb_uint(msg, 3, 5);
+    pb_bytes(prof, 5, msg);
+    for (unsigned int s = 0; s < symbols.size(); s++) {
+        msg.clear();
+        pb_uint(msg, 1, s + 2);
+        pb_uint(msg, 2, sym_str + s);
+        pb_uint(msg, 3, sym_str + s);
+        pb_bytes(prof, 5, msg);
+    }
+
+    for (int s = 0; s < sym_str; s++) {
+        pb_bytes(prof, 6, strs[s]);
+    }
+    for (unsigned int s = 0; s < symbols.size(); s++) {
+        pb_bytes(prof, 6, symbols[s].name);
+    }
+
+    pb_bytes(prof, 11, pb_valuetype(3, 2));  // period type
+    pb_uint(prof, 12, 1);                    // period
+
+    return fwrite(prof.data(), 1, prof.size(), fout) != prof.size();
+}
+
+int CProfiler::Dump(const char* fname, const int format) {
+    FILE* fout;
+    int ret;
+
+    if (!size) {
+        return 1;
+    }
+
+    if (!(fout = fopen_UTF8(fname, (format == PROF_PPROF) ? "wb" : "w"))) {
+        printf("PICSimLab: Profiler can't create file %s\n", fname);
+        return 1;
+    }
+
+    switch (format) {
+        case PROF_PPROF:
+            ret = DumpPprof(fout);
+            break;
+        default:
+            ret = DumpCallgrind(fout);
+            break;
+    }
+    fclose(fout);
+    return ret;
+}
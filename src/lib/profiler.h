@@ -0,0 +1,119 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "board.h"
+
+enum { PROF_CALLGRIND, PROF_PPROF };
+
+typedef struct {
+    unsigned int addr;
+    std::string name;
+} prof_symbol_t;
+
+class CProfiler {
+public:
+    CProfiler();
+    ~CProfiler();
+
+    /**
+     * @brief  Start profiling, counters are sized by board DBGGetROMSize
+     */
+    int Start(board* b);
+
+    /**
+     * @brief  Stop profiling, counters are kept until next Start or Clear
+     */
+    void Stop(void);
+
+    /**
+     * @brief  Clear all counters
+     */
+    void Clear(void);
+
+    int IsRunning(void) { return running; };
+
+    /**
+     * @brief  Mark the end of an instruction (called by the backend at its instruction boundary)
+     */
+    void Retire(void) { retired++; };
+
+    /**
+     * @brief  Account cycles to the instruction in execution (called from board instruction counter)
+     */
+    void Sample(const uint32_t cycles) {
+        if (inst_pc < size) {
+            cycles_count[inst_pc] += cycles;
+            inst_count[inst_pc] += retired;
+        }
+        if (retired) {
+            inst_pc = pboard->DBGGetPC();
+            retired = 0;
+        }
+    };
+
+    /**
+     * @brief  Load symbols from ELF file or text map (nm output or GNU ld map)
+     */
+    int LoadSymbols(const char* fname);
+
+    /**
+     * @brief  Try to load symbols from files with same base name of firmware file
+     */
+    int LoadSymbolsAuto(const std::string fname);
+
+    /**
+     * @brief  Write profile in callgrind or pprof format
+     */
+    int Dump(const char* fname, const int format);
+
+    uint64_t GetTotalCycles(void);
+
+    int GetSymbolCount(void) { return symbols.size(); };
+
+private:
+    int LoadELF(FILE* fin);
+    int LoadMap(FILE* fin);
+    int FindSymbol(const unsigned int addr);
+    int DumpCallgrind(FILE* fout);
+    int DumpPprof(FILE* fout);
+    board* pboard;
+    int running;
+    unsigned int size;
+    unsigned int inst_pc;  // address of the instruction in execution
+    unsigned int retired;  // instructions ended since the last Sample
+    uint64_t* inst_count;
+    uint64_t* cycles_count;
+    std::vector<prof_symbol_t> symbols;
+};
+
+extern CProfiler Profiler;
+
+#endif  // PROFILER_H
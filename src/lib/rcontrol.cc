@@ -60,9 +60,13 @@
 
 #include "../devices/lcd_hd44780.h"
 #include "../devices/vterm.h"
+#include "frame_dump.h"
+#include "oscilloscope.h"
 #include "picsimlab.h"
+#include "profiler.h"
 #include "rcontrol.h"
 #include "spareparts.h"
+#include "wave_check.h"
 
 static int sockfd = -1;
 static int listenfd = -1;
@@ -72,6 +76,7 @@ static int server_started = 0;
 static char buffer[BSIZE];
 static int bp = 0;
 static char file_to_load[BSIZE];
+static double wave_tolerance = 1.0;  // us
 
 void setnblock(int sock_descriptor) {
 #ifndef _WIN_
@@ -650,6 +655,33 @@ int rcontrol_loop(void) {
                         ret = sendtext("ERROR\r\n>");
                     }
                     break;
+                case 'f':
+                    if (!strncmp(cmd, "frame", 5)) {
+                        // Command frame
+                        // ========================================================
+                        char arg[BSIZE];
+                        char format[8] = "png";
+                        unsigned int every = 0;
+                        if (strlen(cmd) < 6) {
+                            snprintf(lstemp, 200, "Frames: %s %lu\r\nOk\r\n>",
+                                     FrameDump.IsRunning() ? "running" : "stopped", FrameDump.GetFrames());
+                            ret = sendtext(lstemp);
+                        } else if (sscanf(cmd + 6, "start %1023s %u %7s", arg, &every, format) >= 1) {
+                            ret = sendtext(FrameDump.Start(arg, format, every) ? "ERROR\r\n>" : "Ok\r\n>");
+                        } else if (!strcmp(cmd + 6, "stop")) {
+                            FrameDump.Stop();
+                            ret = sendtext("Ok\r\n>");
+                        } else if (!strncmp(cmd + 6, "board ", 6)) {
+                            ret = sendtext(FrameDump.Dump(cmd + 12, 0) ? "ERROR\r\n>" : "Ok\r\n>");
+                        } else if (!strncmp(cmd + 6, "parts ", 6)) {
+                            ret = sendtext(FrameDump.Dump(cmd + 12, 1) ? "ERROR\r\n>" : "Ok\r\n>");
+                        } else {
+                            ret = sendtext("ERROR\r\n>");
+                        }
+                    } else {
+                        ret = sendtext("ERROR\r\n>");
+                    }
+                    break;
                 case 'g':
                     if (!strncmp(cmd, "get ", 4)) {
                         // Command
@@ -799,20 +831,40 @@ int rcontrol_loop(void) {
                         ret += sendtext("  dumpf [a] [s]- dump Flash memory\r\n");
                         ret += sendtext("  dumpr [a] [s]- dump RAM memory\r\n");
                         ret += sendtext("  exit         - shutdown PICSimLab\r\n");
+                        ret += sendtext(
+                            "  frame [cmd]  - show frame rendering status or execute cmd start dir [n] [fmt]\r\n"
+                            "                 (render canvas without GUI, write frames each n quanta as png,\r\n"
+                            "                 ppm or raw), stop, board file or parts file (write one frame)\r\n");
                         ret += sendtext("  get ob       - get object value\r\n");
                         ret += sendtext("  help         - show this message\r\n");
                         ret += sendtext("  info         - show actual setup info and objects\r\n");
                         ret += sendtext("  loadhex file - load hex file (use full path)\r\n");
                         ret += sendtext("  pins         - show pins directions and values\r\n");
                         ret += sendtext("  pinsl        - show pins formated info\r\n");
+                        ret += sendtext(
+                            "  prof [cmd]   - show profiler status or execute cmd start/stop/clear,\r\n"
+                            "                 sym file, dump file (callgrind) or pprof file\r\n");
                         ret += sendtext("  quit         - exit remote control interface\r\n");
                         ret += sendtext("  reset        - reset the board\r\n");
+                        ret += sendtext(
+                            "  scope [cmd]  - show oscilloscope channels or execute cmd chN p (set logic\r\n"
+                            "                 channel N 3-8 to pin p, 0 = off), deep [n|off] (deep capture\r\n"
+                            "                 of n chunks of 64k events), export file (deep capture VCD),\r\n"
+                            "                 dec (show decoded frames), dec off, dec uart ch [baud],\r\n"
+                            "                 dec i2c scl sda, dec spi sck data [cs] or dec 1wire ch\r\n");
                         ret += sendtext("  set ob vl    - set object with value\r\n");
                         ret += sendtext(
                             "  sim [cmd]    - show simulation status or execute "
                             "cmd start/stop\r\n");
                         ret += sendtext("  sync         - wait to syncronize with timer event\r\n");
                         ret += sendtext("  version      - show PICSimLab version\r\n");
+                        ret += sendtext(
+                            "  video [cmd]  - show video capture status or execute cmd start file [fps]\r\n"
+                            "                 (Y4M video of board and parts in simulation time) or stop\r\n");
+                        ret += sendtext(
+                            "  wave [cmd]   - show golden waveform check result or execute cmd start file\r\n"
+                            "                 (VCD or PWF reference), stop, tol us (tolerance window) or\r\n"
+                            "                 free on/off (run without real time sync while checking)\r\n");
 
                         ret += sendtext("Ok\r\n>");
                     } else {
@@ -939,6 +991,38 @@ int rcontrol_loop(void) {
                             ret += sendtext(lstemp);
                         }
                         ret += sendtext("Ok\r\n>");
+                    } else if (!strncmp(cmd, "prof", 4)) {
+                        // Command prof
+                        // ========================================================
+                        if (strlen(cmd) < 5) {
+                            snprintf(lstemp, 100, "%s, %i symbols, %llu cycles\r\nOk\r\n>",
+                                     Profiler.IsRunning() ? "running" : "stopped", Profiler.GetSymbolCount(),
+                                     (unsigned long long)Profiler.GetTotalCycles());
+                            ret = sendtext(lstemp);
+                        } else if (!strcmp(cmd + 5, "start")) {
+                            if (Profiler.IsRunning() || !Profiler.Start(PICSimLab.GetBoard())) {
+                                if (!Profiler.GetSymbolCount()) {
+                                    Profiler.LoadSymbolsAuto(PICSimLab.GetFNAME());
+                                }
+                                ret = sendtext("Ok\r\n>");
+                            } else {
+                                ret = sendtext("ERROR\r\n>");
+                            }
+                        } else if (!strcmp(cmd + 5, "stop")) {
+                            Profiler.Stop();
+                            ret = sendtext("Ok\r\n>");
+                        } else if (!strcmp(cmd + 5, "clear")) {
+                            Profiler.Clear();
+                            ret = sendtext("Ok\r\n>");
+                        } else if (!strncmp(cmd + 5, "sym ", 4)) {
+                            ret = sendtext(Profiler.LoadSymbols(cmd + 9) ? "ERROR\r\n>" : "Ok\r\n>");
+                        } else if (!strncmp(cmd + 5, "dump ", 5)) {
+                            ret = sendtext(Profiler.Dump(cmd + 10, PROF_CALLGRIND) ? "ERROR\r\n>" : "Ok\r\n>");
+                        } else if (!strncmp(cmd + 5, "pprof ", 6)) {
+                            ret = sendtext(Profiler.Dump(cmd + 11, PROF_PPROF) ? "ERROR\r\n>" : "Ok\r\n>");
+                        } else {
+                            ret = sendtext("ERROR\r\n>");
+                        }
                     } else {
                         ret = sendtext("ERROR\r\n>");
                     }
@@ -1098,6 +1182,107 @@ int rcontrol_loop(void) {
                             }
                         }
 
+                    } else if (!strncmp(cmd, "scope", 5)) {
+                        // Command scope =====================================================
+                        int ch, pin;
+                        Board = PICSimLab.GetBoard();
+
+                        if (strlen(cmd) < 6) {
+                            for (int c = 0; c < OSC_MAX_CHANNELS; c++) {
+                                pin = Oscilloscope.GetChannelPin(c);
+                                if (pin < 0) {
+                                    snprintf(lstemp, 200, "ch%i off\r\n", c + 1);
+                                } else {
+                                    snprintf(lstemp, 200, "ch%i pin %2i %s\r\n", c + 1, pin + 1,
+                                             (const char*)Board->MGetPinName(pin + 1).c_str());
+                                }
+                                ret += sendtext(lstemp);
+                            }
+                            CScopeCapture* capture = Oscilloscope.GetCapture();
+                            snprintf(lstemp, 200, "deep %u chunks, %s, %llu events, %llu samples\r\n",
+                                     Oscilloscope.GetDeep(), capture->IsRunning() ? "running" : "stopped",
+                                     (unsigned long long)capture->GetEventCount(),
+                                     (unsigned long long)(capture->GetEndTime() - capture->GetStartTime()));
+                            ret += sendtext(lstemp);
+                            ret += sendtext("Ok\r\n>");
+                        } else if ((sscanf(cmd + 6, "ch%i %i", &ch, &pin) == 2) && (ch > 2) &&
+                                   (ch <= OSC_MAX_CHANNELS) && (pin >= 0) && (pin <= Board->MGetPinCount())) {
+                            Oscilloscope.SetChannelPin(ch - 1, pin - 1);
+                            ret = sendtext("Ok\r\n>");
+                        } else if (!strncmp(cmd + 6, "dec", 3)) {
+                            CScopeDecoder* decoder = Oscilloscope.GetDecoder();
+                            const char* arg = cmd + 9;
+                            int args[3] = {-1, -1, -1};
+                            int type = DEC_NONE;
+                            int nargs = 0;
+                            int minargs = 1;
+
+                            if (!strncmp(arg, " uart ", 6)) {
+                                type = DEC_UART;
+                                nargs = sscanf(arg + 6, "%i %i", &args[0], &args[1]);
+                            } else if (!strncmp(arg, " i2c ", 5)) {
+                                type = DEC_I2C;
+                                minargs = 2;
+                                nargs = sscanf(arg + 5, "%i %i", &args[0], &args[1]);
+                            } else if (!strncmp(arg, " spi ", 5)) {
+                                type = DEC_SPI;
+                                minargs = 2;
+                                nargs = sscanf(arg + 5, "%i %i %i", &args[0], &args[1], &args[2]);
+                            } else if (!strncmp(arg, " 1wire ", 7)) {
+                                type = DEC_1WIRE;
+                                nargs = sscanf(arg + 7, "%i", &args[0]);
+                            }
+
+                            if (!*arg) {
+                                for (int d = 0; d < decoder->GetCount(); d++) {
+                                    snprintf(lstemp, 200, "dec%i %s\r\n", d, decoder->GetName(d).c_str());
+                                    ret += sendtext(lstemp);
+                                }
+                                std::vector<cap_note_t> notes;
+                                decoder->GetLastNotes(notes, 20);
+                                const double dt = Oscilloscope.GetCapture()->GetDt();
+                                for (unsigned int i = 0; i < notes.size(); i++) {
+                                    snprintf(lstemp, 200, "%14.3fus dec%i %s\r\n", notes[i].time * dt * 1e6,
+                                             notes[i].decoder, notes[i].text);
+                                    ret += sendtext(lstemp);
+                                }
+                                ret += sendtext("Ok\r\n>");
+                            } else if (!strcmp(arg, " off")) {
+                                decoder->Clear();
+                                ret = sendtext("Ok\r\n>");
+                            } else if ((type != DEC_NONE) && (nargs >= minargs)) {
+                                // channels are 1 based, uart second argument is the baud rate
+                                int ch[3] = {-1, -1, -1};
+                                const int nch = (type == DEC_UART) ? 1 : nargs;
+                                int valid = 1;
+                                for (int i = 0; i < nch; i++) {
+                                    ch[i] = args[i] - 1;
+                                    if ((ch[i] < 0) || (ch[i] >= OSC_MAX_CHANNELS)) {
+                                        valid = 0;
+                                    }
+                                }
+                                const unsigned int speed = ((type == DEC_UART) && (nargs > 1)) ? args[1] : 9600;
+                                if (valid && (Oscilloscope.AddDecoder(type, ch, speed) >= 0)) {
+                                    ret = sendtext("Ok\r\n>");
+                                } else {
+                                    ret = sendtext("ERROR\r\n>");
+                                }
+                            } else {
+                                ret = sendtext("ERROR\r\n>");
+                            }
+                        } else if (!strcmp(cmd + 6, "deep off")) {
+                            Oscilloscope.SetDeep(0);
+                            ret = sendtext("Ok\r\n>");
+                        } else if (!strncmp(cmd + 6, "deep", 4)) {
+                            int nchunks = CAP_DEFAULT_CHUNKS;
+                            sscanf(cmd + 10, "%i", &nchunks);
+                            Oscilloscope.SetDeep((nchunks > 0) ? nchunks : CAP_DEFAULT_CHUNKS);
+                            ret = sendtext("Ok\r\n>");
+                        } else if (!strncmp(cmd + 6, "export ", 7)) {
+                            ret = sendtext(Oscilloscope.ExportCapture(cmd + 13) ? "ERROR\r\n>" : "Ok\r\n>");
+                        } else {
+                            ret = sendtext("ERROR\r\n>");
+                        }
                     } else if (!strcmp(cmd, "sync")) {
                         // Command sync =====================================================
                         PICSimLab.SetSync(0);
@@ -1119,6 +1304,54 @@ int rcontrol_loop(void) {
                                  _VERSION_, _DATE_, _ARCH_, _PKG_);
                         ret += sendtext(lstemp);
                         ret += sendtext("Ok\r\n>");
+                    } else if (!strncmp(cmd, "video", 5)) {
+                        // Command video
+                        // =====================================================
+                        char arg[BSIZE];
+                        unsigned int fps = 25;
+                        if (strlen(cmd) < 6) {
+                            snprintf(lstemp, 200, "Video: %s %llu\r\nOk\r\n>",
+                                     FrameDump.IsCapturing() ? "capturing" : "stopped",
+                                     (unsigned long long)FrameDump.GetVideoFrames());
+                            ret = sendtext(lstemp);
+                        } else if (sscanf(cmd + 6, "start %1023s %u", arg, &fps) >= 1) {
+                            ret = sendtext(FrameDump.StartVideo(arg, fps) ? "ERROR\r\n>" : "Ok\r\n>");
+                        } else if (!strcmp(cmd + 6, "stop")) {
+                            FrameDump.StopVideo();
+                            ret = sendtext("Ok\r\n>");
+                        } else {
+                            ret = sendtext("ERROR\r\n>");
+                        }
+                    } else {
+                        ret = sendtext("ERROR\r\n>");
+                    }
+                    break;
+                case 'w':
+                    if (!strncmp(cmd, "wave", 4)) {
+                        // Command wave
+                        // ========================================================
+                        if (strlen(cmd) < 5) {
+                            snprintf(lstemp, 200, "%s\r\nOk\r\n>", WaveCheck.GetReport().c_str());
+                            ret = sendtext(lstemp);
+                        } else if (!strncmp(cmd + 5, "start ", 6)) {
+                            ret = sendtext(WaveCheck.Start(PICSimLab.GetBoard(), cmd + 11, wave_tolerance)
+                                               ? "ERROR\r\n>"
+                                               : "Ok\r\n>");
+                        } else if (!strcmp(cmd + 5, "stop")) {
+                            WaveCheck.Stop();
+                            ret = sendtext("Ok\r\n>");
+                        } else if (!strncmp(cmd + 5, "tol ", 4)) {
+                            wave_tolerance = atof(cmd + 9);
+                            ret = sendtext("Ok\r\n>");
+                        } else if (!strcmp(cmd + 5, "free on")) {
+                            WaveCheck.SetFreeRun(1);
+                            ret = sendtext("Ok\r\n>");
+                        } else if (!strcmp(cmd + 5, "free off")) {
+                            WaveCheck.SetFreeRun(0);
+                            ret = sendtext("Ok\r\n>");
+                        } else {
+                            ret = sendtext("ERROR\r\n>");
+                        }
                     } else {
                         ret = sendtext("ERROR\r\n>");
                     }
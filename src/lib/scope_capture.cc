@@ -0,0 +1,376 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#include "scope_capture.h"
+
+#include <float.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util.h"
+
+CScopeCapture::CScopeCapture() {
+    chunks = NULL;
+    nchunks = 0;
+    running = 0;
+    dt = 0;
+    memset(last, 0, sizeof(last));
+    count = 0;
+    time = 0;
+}
+
+CScopeCapture::~CScopeCapture() {
+    running = 0;
+    Free(chunks, nchunks);
+}
+
+int CScopeCapture::Start(const unsigned int nchunks_, const double dt_) {
+    const unsigned int nc = (nchunks_ < CAP_MIN_CHUNKS) ? CAP_MIN_CHUNKS : nchunks_;
+
+    running = 0;
+    if (nc != nchunks) {
+        // chunks are allocated when needed
+        cap_chunk_t** table = (cap_chunk_t**)calloc(nc, sizeof(cap_chunk_t*));
+        if (!table) {
+            return 1;
+        }
+        cap_chunk_t** old = chunks;
+        const unsigned int nold = nchunks;
+        {
+            // wait GUI and decoder readers of the old ring
+            std::lock_guard<std::mutex> guard(lock);
+            chunks = table;
+            nchunks = nc;
+            count = 0;
+        }
+        Free(old, nold);
+    }
+    dt = dt_;
+    Clear();
+    running = 1;
+    return 0;
+}
+
+// memory is kept to allow the GUI to show and export the capture after stop
+void CScopeCapture::Stop(void) {
+    running = 0;
+}
+
+void CScopeCapture::Free(cap_chunk_t** table, const unsigned int n) {
+    if (table) {
+        for (unsigned int i = 0; i < n; i++) {
+            free(table[i]);
+        }
+        free(table);
+    }
+}
+
+void CScopeCapture::Clear(void) {
+    std::lock_guard<std::mutex> guard(lock);
+    memset(last, 0, sizeof(last));
+    count = 0;
+    time = 0;
+}
+
+// simulation thread
+void CScopeCapture::Push(const uint64_t now, const int channel, const float value) {
+    const uint64_t n = count.load(std::memory_order_relaxed);
+    const unsigned int slot = (n >> CAP_CHUNK_BITS) % nchunks;
+    const unsigned int i = n & (CAP_CHUNK - 1);
+    const unsigned int b = i >> CAP_BLOCK_BITS;
+
+    cap_chunk_t* chunk = chunks[slot];
+
+    if (i == 0) {
+        if (!chunk) {
+            chunk = (cap_chunk_t*)malloc(sizeof(cap_chunk_t));
+            if (!chunk) {
+                running = 0;
+                return;
+            }
+            chunks[slot] = chunk;
+        }
+        for (int node = 0; node < 2 * CAP_BLOCKS; node++) {
+            for (int c = 0; c < CAP_CHANNELS; c++) {
+                chunk->tree[node].vmin[c] = FLT_MAX;
+                chunk->tree[node].vmax[c] = -FLT_MAX;
+            }
+        }
+    }
+
+    if ((i & (CAP_BLOCK - 1)) == 0) {
+        memcpy(chunk->state[b], last, sizeof(last));
+    }
+
+    cap_event_t* ev = &chunk->events[i];
+    ev->time = now;
+    ev->value = value;
+    ev->channel = channel;
+    last[channel] = value;
+
+    // update block and all its parents
+    for (unsigned int node = CAP_BLOCKS + b; node; node >>= 1) {
+        if (value < chunk->tree[node].vmin[channel])
+            chunk->tree[node].vmin[channel] = value;
+        if (value > chunk->tree[node].vmax[channel])
+            chunk->tree[node].vmax[channel] = value;
+    }
+
+    // the pyramid must be updated before the event is visible to GUI thread
+    count.store(n + 1, std::memory_order_release);
+}
+
+// first event that can be read safely, the oldest chunk of ring is excluded because it can be reused
+// by the simulation thread while GUI is reading
+uint64_t CScopeCapture::GetFirst(const uint64_t cnt) {
+    const uint64_t chunk = cnt >> CAP_CHUNK_BITS;
+    if (chunk < (nchunks - 2)) {
+        return 0;
+    }
+    return (chunk - (nchunks - 2)) << CAP_CHUNK_BITS;
+}
+
+uint64_t CScopeCapture::GetStartTime(void) {
+    std::lock_guard<std::mutex> guard(lock);
+    const uint64_t cnt = count.load(std::memory_order_acquire);
+    const uint64_t first = GetFirst(cnt);
+
+    if (!first) {
+        return 0;
+    }
+    return GetEvent(first)->time;
+}
+
+// first event in [first,last) with time >= t
+uint64_t CScopeCapture::LowerBound(uint64_t first, uint64_t last, const uint64_t t) {
+    while (first < last) {
+        const uint64_t mid = first + ((last - first) >> 1);
+        if (GetEvent(mid)->time < t) {
+            first = mid + 1;
+        } else {
+            last = mid;
+        }
+    }
+    return first;
+}
+
+// channel values before event n
+void CScopeCapture::GetState(const uint64_t n, float* state) {
+    const uint64_t block = n & ~((uint64_t)CAP_BLOCK - 1);
+    cap_chunk_t* chunk = GetChunk(n);
+
+    memcpy(state, chunk->state[(n & (CAP_CHUNK - 1)) >> CAP_BLOCK_BITS], sizeof(float) * CAP_CHANNELS);
+    for (uint64_t i = block; i < n; i++) {
+        const cap_event_t* ev = &chunk->events[i & (CAP_CHUNK - 1)];
+        state[ev->channel] = ev->value;
+    }
+}
+
+void CScopeCapture::CombineNode(const cap_node_t* node, float* vmin, float* vmax) {
+    for (int c = 0; c < CAP_CHANNELS; c++) {
+        vmin[c] = (node->vmin[c] < vmin[c]) ? node->vmin[c] : vmin[c];
+        vmax[c] = (node->vmax[c] > vmax[c]) ? node->vmax[c] : vmax[c];
+    }
+}
+
+// GUI thread
+void CScopeCapture::GetMinMax(const uint64_t t0, const uint64_t t1, float* vmin, float* vmax) {
+    std::lock_guard<std::mutex> guard(lock);
+    const uint64_t cnt = count.load(std::memory_order_acquire);
+
+    if (!chunks || !cnt) {
+        memcpy(vmin, last, sizeof(last));
+        memcpy(vmax, last, sizeof(last));
+        return;
+    }
+
+    const uint64_t first = GetFirst(cnt);
+    uint64_t i0 = LowerBound(first, cnt, t0 + 1);
+    const uint64_t i1 = LowerBound(i0, cnt, t1);
+
+    // value at t0 (after all events of t0)
+    if (i0 < cnt) {
+        GetState(i0, vmin);
+    } else {
+        GetState(cnt - 1, vmin);
+        const cap_event_t* ev = GetEvent(cnt - 1);
+        vmin[ev->channel] = ev->value;
+    }
+    memcpy(vmax, vmin, sizeof(float) * CAP_CHANNELS);
+
+    while (i0 < i1) {
+        const uint64_t base = i0 & ~((uint64_t)CAP_CHUNK - 1);
+        const uint64_t cend = ((base + CAP_CHUNK) < i1) ? (base + CAP_CHUNK) : i1;
+        cap_chunk_t* chunk = GetChunk(i0);
+
+        if ((i0 == base) && (cend == (base + CAP_CHUNK))) {
+            // full chunk
+            CombineNode(&chunk->tree[1], vmin, vmax);
+            i0 = cend;
+            continue;
+        }
+
+        // events before first full block
+        while ((i0 < cend) && ((i0 & (CAP_BLOCK - 1)) || ((cend - i0) < CAP_BLOCK))) {
+            const cap_event_t* ev = &chunk->events[i0 & (CAP_CHUNK - 1)];
+            if (ev->value < vmin[ev->channel])
+                vmin[ev->channel] = ev->value;
+            if (ev->value > vmax[ev->channel])
+                vmax[ev->channel] = ev->value;
+            i0++;
+        }
+
+        // full blocks
+        const unsigned int b0 = (i0 - base) >> CAP_BLOCK_BITS;
+        const unsigned int b1 = (cend - base) >> CAP_BLOCK_BITS;
+        if (b1 > b0) {
+            for (unsigned int l = b0 + CAP_BLOCKS, r = b1 + CAP_BLOCKS; l < r; l >>= 1, r >>= 1) {
+                if (l & 1) {
+                    CombineNode(&chunk->tree[l++], vmin, vmax);
+                }
+                if (r & 1) {
+                    CombineNode(&chunk->tree[--r], vmin, vmax);
+                }
+            }
+            i0 = base + ((uint64_t)b1 << CAP_BLOCK_BITS);
+        }
+
+        // events after last full block
+        while (i0 < cend) {
+            const cap_event_t* ev = &chunk->events[i0 & (CAP_CHUNK - 1)];
+            if (ev->value < vmin[ev->channel])
+                vmin[ev->channel] = ev->value;
+            if (ev->value > vmax[ev->channel])
+                vmax[ev->channel] = ev->value;
+            i0++;
+        }
+    }
+}
+
+int CScopeCapture::GetEvents(uint64_t* pos, cap_event_t* buff, const int size) {
+    std::lock_guard<std::mutex> guard(lock);
+    const uint64_t cnt = count.load(std::memory_order_acquire);
+
+    if (!chunks) {
+        return 0;
+    }
+
+    const uint64_t first = GetFirst(cnt);
+    if (*pos < first) {
+        *pos = first;
+    }
+
+    int n = 0;
+    while ((n < size) && (*pos < cnt)) {
+        buff[n++] = *GetEvent((*pos)++);
+    }
+    return n;
+}
+
+int CScopeCapture::Export(const char* fname, const std::vector<std::string>& names,
+                          const std::vector<std::string>& note_names, const std::vector<cap_note_t>& notes) {
+    std::lock_guard<std::mutex> guard(lock);
+    const uint64_t cnt = count.load(std::memory_order_acquire);
+
+    if (!chunks) {
+        return 1;
+    }
+
+    FILE* fout = fopen_UTF8(fname, "w");
+    if (!fout) {
+        return 1;
+    }
+
+    const uint64_t first = GetFirst(cnt);
+    float state[CAP_CHANNELS];
+    memset(state, 0, sizeof(state));
+    if (first < cnt) {
+        GetState(first, state);
+    }
+
+    fprintf(fout,
+            "$version Generated by PICSimLab $end\n"
+            "$timescale %ips $end\n"
+            "$scope module oscilloscope $end\n",
+            (int)(dt * 1e12));
+
+    for (int c = 0; c < CAP_CHANNELS; c++) {
+        if ((c < (int)names.size()) && names[c].length()) {
+            fprintf(fout, "$var real 32 %c  %i-%s $end\n", '!' + c, c + 1, names[c].c_str());
+        }
+    }
+    for (unsigned int d = 0; d < note_names.size(); d++) {
+        fprintf(fout, "$var string 1 %c  %s $end\n", '!' + CAP_CHANNELS + d, note_names[d].c_str());
+    }
+    uint64_t ltime = (first && (first < cnt)) ? GetEvent(first)->time : 0;
+    fprintf(fout,
+            "$upscope $end\n"
+            "$enddefinitions $end\n"
+            "#%llu\n"
+            "$dumpvars\n",
+            (unsigned long long)ltime);
+
+    for (int c = 0; c < CAP_CHANNELS; c++) {
+        if ((c < (int)names.size()) && names[c].length()) {
+            fprintf(fout, "r%f %c\n", state[c], '!' + c);
+        }
+    }
+    fprintf(fout, "$end\n");
+
+    // notes are sorted by time
+    unsigned int nn = 0;
+    while ((nn < notes.size()) && (notes[nn].time < ltime)) {
+        nn++;
+    }
+
+    for (uint64_t n = first; n <= cnt; n++) {
+        const cap_event_t* ev = (n < cnt) ? GetEvent(n) : NULL;
+
+        while ((nn < notes.size()) && (!ev || (notes[nn].time <= ev->time))) {
+            if (notes[nn].decoder < (int)note_names.size()) {
+                if (notes[nn].time != ltime) {
+                    ltime = notes[nn].time;
+                    fprintf(fout, "#%llu\n", (unsigned long long)ltime);
+                }
+                fprintf(fout, "s%s %c\n", notes[nn].text, '!' + CAP_CHANNELS + notes[nn].decoder);
+            }
+            nn++;
+        }
+
+        if (!ev || ((int)ev->channel >= (int)names.size()) || !names[ev->channel].length()) {
+            continue;
+        }
+        if (ev->time != ltime) {
+            ltime = ev->time;
+            fprintf(fout, "#%llu\n", (unsigned long long)ltime);
+        }
+        fprintf(fout, "r%f %c\n", ev->value, '!' + ev->channel);
+    }
+    fprintf(fout, "#%llu\n", (unsigned long long)GetEndTime());
+
+    fclose(fout);
+    return 0;
+}
@@ -0,0 +1,166 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#ifndef SCOPE_CAPTURE_H
+#define SCOPE_CAPTURE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#define CAP_CHANNELS 8  // same as OSC_MAX_CHANNELS
+
+#define CAP_CHUNK_BITS 16
+#define CAP_CHUNK (1 << CAP_CHUNK_BITS)  // events per chunk
+#define CAP_BLOCK_BITS 6
+#define CAP_BLOCK (1 << CAP_BLOCK_BITS)     // events per block (leaf of min/max pyramid)
+#define CAP_BLOCKS (CAP_CHUNK / CAP_BLOCK)  // blocks per chunk
+
+#define CAP_MIN_CHUNKS 3
+#define CAP_DEFAULT_CHUNKS 64  // 4M events
+
+typedef struct {
+    uint64_t time;     // instruction count
+    float value;       // new channel value
+    uint32_t channel;  // channel number
+} cap_event_t;
+
+typedef struct {
+    uint64_t time;  // start time
+    uint64_t end;   // end time
+    int decoder;    // decoder number
+    char text[24];  // decoded data
+} cap_note_t;
+
+typedef struct {
+    float vmin[CAP_CHANNELS];
+    float vmax[CAP_CHANNELS];
+} cap_node_t;
+
+typedef struct {
+    cap_event_t events[CAP_CHUNK];
+    float state[CAP_BLOCKS][CAP_CHANNELS];  // channel values before the first event of each block
+    cap_node_t tree[2 * CAP_BLOCKS];        // min/max pyramid, node 1 is the root and blocks are the leaves
+} cap_chunk_t;
+
+/**
+ * @brief Deep memory capture of oscilloscope channels
+ *
+ * Only value changes are stored (edge timestamps) in a ring of chunks. Each chunk keeps a min/max
+ * pyramid of its events, so the min/max of any time interval is found in O(log n) and a screen of
+ * any zoom level is rendered in O(width). Start runs in the simulation thread and replaces the ring only
+ * after the readers of the GUI and decoder threads release it.
+ */
+class CScopeCapture {
+public:
+    CScopeCapture();
+    ~CScopeCapture();
+
+    /**
+     * @brief  Start capture with a ring of nchunks chunks, dt is the time of one sample in seconds
+     */
+    int Start(const unsigned int nchunks, const double dt);
+
+    /**
+     * @brief  Stop capture, captured events are kept until next Start
+     */
+    void Stop(void);
+
+    /**
+     * @brief  Discard all captured events
+     */
+    void Clear(void);
+
+    int IsRunning(void) { return running; };
+
+    unsigned int GetChunks(void) { return nchunks; };
+
+    double GetDt(void) { return dt; };
+
+    /**
+     * @brief  Store one sample of all channels (called from simulation thread)
+     */
+    void Sample(const float* values) {
+        const uint64_t now = time.load(std::memory_order_relaxed);
+        for (int c = 0; c < CAP_CHANNELS; c++) {
+            if (values[c] != last[c]) {
+                Push(now, c, values[c]);
+            }
+        }
+        time.store(now + 1, std::memory_order_relaxed);
+    };
+
+    /**
+     * @brief  Get time of the oldest sample available
+     */
+    uint64_t GetStartTime(void);
+
+    /**
+     * @brief  Get time of the next sample
+     */
+    uint64_t GetEndTime(void) { return time.load(std::memory_order_relaxed); };
+
+    uint64_t GetEventCount(void) { return count.load(std::memory_order_relaxed); };
+
+    /**
+     * @brief  Get min and max of all channels in the time interval [t0,t1)
+     */
+    void GetMinMax(const uint64_t t0, const uint64_t t1, float* vmin, float* vmax);
+
+    /**
+     * @brief  Copy up to size events starting at event pos, pos is updated to next event to read
+     */
+    int GetEvents(uint64_t* pos, cap_event_t* buff, const int size);
+
+    /**
+     * @brief  Export capture in VCD format, names are the channel names (empty channels are not exported),
+     * notes are exported as string variables with names in note_names
+     */
+    int Export(const char* fname, const std::vector<std::string>& names,
+               const std::vector<std::string>& note_names = std::vector<std::string>(),
+               const std::vector<cap_note_t>& notes = std::vector<cap_note_t>());
+
+private:
+    static void Free(cap_chunk_t** table, const unsigned int n);
+    void Push(const uint64_t now, const int channel, const float value);
+    cap_chunk_t* GetChunk(const uint64_t n) { return chunks[(n >> CAP_CHUNK_BITS) % nchunks]; };
+    cap_event_t* GetEvent(const uint64_t n) { return &GetChunk(n)->events[n & (CAP_CHUNK - 1)]; };
+    uint64_t GetFirst(const uint64_t cnt);
+    uint64_t LowerBound(uint64_t first, uint64_t last, const uint64_t t);
+    void GetState(const uint64_t n, float* state);
+    void CombineNode(const cap_node_t* node, float* vmin, float* vmax);
+    std::mutex lock;  // held by readers and by Start when the ring is replaced
+    cap_chunk_t** chunks;
+    std::atomic<unsigned int> nchunks;
+    std::atomic<int> running;
+    double dt;
+    float last[CAP_CHANNELS];     // last value of each channel
+    std::atomic<uint64_t> count;  // number of events published
+    std::atomic<uint64_t> time;   // sample counter
+};
+
+#endif  // SCOPE_CAPTURE_H
@@ -0,0 +1,437 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#include "scope_decoder.h"
+
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+CScopeDecoder::CScopeDecoder() {
+    pcapture = NULL;
+#ifndef _NOTHREAD
+    worker = NULL;
+#endif
+    running = 0;
+    threshold = 2.5;
+    pos = 0;
+    count = 0;
+    memset(decoders, 0, sizeof(decoders));
+}
+
+CScopeDecoder::~CScopeDecoder() {
+    Stop();
+}
+
+void CScopeDecoder::Start(CScopeCapture* capture, const float threshold_) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    pcapture = capture;
+    threshold = threshold_;
+#ifndef _NOTHREAD
+    if (!worker) {
+        running = 1;
+        worker = new std::thread(&CScopeDecoder::Worker, this);
+    }
+#else
+    running = 1;
+#endif
+}
+
+void CScopeDecoder::Stop(void) {
+    running = 0;
+#ifndef _NOTHREAD
+    if (worker) {
+        worker->join();
+        delete worker;
+        worker = NULL;
+    }
+#endif
+}
+
+int CScopeDecoder::Add(const int type, const int* ch, const unsigned int speed) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    if ((count >= DEC_MAX) || (type <= DEC_NONE) || (type > DEC_1WIRE)) {
+        return -1;
+    }
+
+    Init(&decoders[count], type, ch, speed);
+    return count++;
+}
+
+void CScopeDecoder::Init(dec_t* dec, const int type, const int* ch, const unsigned int speed) {
+    memset(dec, 0, sizeof(dec_t));
+    dec->type = type;
+    for (int i = 0; i < 3; i++) {
+        dec->ch[i] = ch[i];
+    }
+    dec->speed = speed ? speed : 9600;
+
+    switch (type) {
+        case DEC_UART:
+            dec->level[0] = 1;
+            dec->bit = -1;
+            break;
+        case DEC_I2C:
+            // address 0 with mask 0 accepts any address, the ACK returned is not used
+            bitbang_i2c_init(&dec->i2c, 0, 0);
+            dec->i2c.sdao = 1;  // bus idle
+            dec->level[0] = 1;
+            dec->level[1] = 1;
+            break;
+        case DEC_SPI:
+            bitbang_spi_init(&dec->spi, 8);
+            break;
+        case DEC_1WIRE:
+            dec->level[0] = 1;
+            break;
+    }
+}
+
+void CScopeDecoder::Clear(void) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    count = 0;
+    notes.clear();
+}
+
+std::string CScopeDecoder::GetName(const int n, const int vcd) {
+    char name[64];
+    const dec_t* dec = &decoders[n];
+    const char sep = vcd ? '_' : ' ';
+
+    switch (dec->type) {
+        case DEC_UART:
+            snprintf(name, 64, "uart%cch%i%c%u", sep, dec->ch[0] + 1, sep, dec->speed);
+            break;
+        case DEC_I2C:
+            snprintf(name, 64, "i2c%cch%i%cch%i", sep, dec->ch[0] + 1, sep, dec->ch[1] + 1);
+            break;
+        case DEC_SPI:
+            if (dec->ch[2] < 0) {
+                snprintf(name, 64, "spi%cch%i%cch%i", sep, dec->ch[0] + 1, sep, dec->ch[1] + 1);
+            } else {
+                snprintf(name, 64, "spi%cch%i%cch%i%cch%i", sep, dec->ch[0] + 1, sep, dec->ch[1] + 1, sep,
+                         dec->ch[2] + 1);
+            }
+            break;
+        case DEC_1WIRE:
+            snprintf(name, 64, "1wire%cch%i", sep, dec->ch[0] + 1);
+            break;
+        default:
+            snprintf(name, 64, "none");
+            break;
+    }
+    return name;
+}
+
+static bool note_time_less(const cap_note_t& note, const uint64_t time) {
+    return note.time < time;
+}
+
+void CScopeDecoder::GetNotes(const uint64_t t0, const uint64_t t1, std::vector<cap_note_t>& list,
+                             const unsigned int max) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    list.clear();
+    for (auto it = std::lower_bound(notes.begin(), notes.end(), t0, note_time_less);
+         (it != notes.end()) && (it->time < t1) && (list.size() < max); it++) {
+        list.push_back(*it);
+    }
+}
+
+void CScopeDecoder::GetLastNotes(std::vector<cap_note_t>& list, const unsigned int n) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    list.clear();
+    const unsigned int first = (notes.size() > n) ? notes.size() - n : 0;
+    for (unsigned int i = first; i < notes.size(); i++) {
+        list.push_back(notes[i]);
+    }
+}
+
+// capture restarted, decode from the beginning
+void CScopeDecoder::Reset(void) {
+    pos = 0;
+    notes.clear();
+    for (int d = 0; d < count; d++) {
+        dec_t dec = decoders[d];
+        Init(&decoders[d], dec.type, dec.ch, dec.speed);
+    }
+}
+
+// decode one block of new edges, return the number of edges read
+int CScopeDecoder::Run(cap_event_t* buff) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    if (!pcapture || !count) {
+        return 0;
+    }
+
+    if (pcapture->GetEventCount() < pos) {
+        Reset();
+    }
+
+    const int n = pcapture->GetEvents(&pos, buff, DEC_BUFFER_SIZE);
+    for (int i = 0; i < n; i++) {
+        Decode(&buff[i]);
+    }
+
+    // uart frames ended without a new edge
+    if (n < DEC_BUFFER_SIZE) {
+        const uint64_t now = pcapture->GetEndTime();
+        for (int d = 0; d < count; d++) {
+            if (decoders[d].type == DEC_UART) {
+                UARTSample(d, now);
+            }
+        }
+    }
+    return n;
+}
+
+#ifndef _NOTHREAD
+void CScopeDecoder::Worker(void) {
+    cap_event_t* buff = new cap_event_t[DEC_BUFFER_SIZE];
+
+    while (running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        while (running && (Run(buff) == DEC_BUFFER_SIZE)) {
+        }
+    }
+
+    delete[] buff;
+}
+#endif
+
+void CScopeDecoder::Update(void) {
+#ifdef _NOTHREAD
+    if (running && count) {
+        cap_event_t* buff = new cap_event_t[DEC_BUFFER_SIZE];
+
+        while (Run(buff) == DEC_BUFFER_SIZE) {
+        }
+
+        delete[] buff;
+    }
+#endif
+}
+
+void CScopeDecoder::Decode(const cap_event_t* ev) {
+    for (int d = 0; d < count; d++) {
+        dec_t* dec = &decoders[d];
+
+        for (int i = 0; i < 3; i++) {
+            if (dec->ch[i] != (int)ev->channel) {
+                continue;
+            }
+            const unsigned char level = ev->value > threshold;
+            if (level == dec->level[i]) {
+                continue;
+            }
+            switch (dec->type) {
+                case DEC_UART:
+                    DecodeUART(d, level, ev->time);
+                    break;
+                case DEC_I2C:
+                    dec->level[i] = level;
+                    DecodeI2C(d, ev->time);
+                    break;
+                case DEC_SPI:
+                    dec->level[i] = level;
+                    DecodeSPI(d, ev->time);
+                    break;
+                case DEC_1WIRE:
+                    Decode1Wire(d, level, ev->time);
+                    break;
+            }
+        }
+    }
+}
+
+// sample bits in middle of bit time until time, the line level is the level before the edge at time
+void CScopeDecoder::UARTSample(const int d, const uint64_t time) {
+    dec_t* dec = &decoders[d];
+    const double tbit = 1.0 / (dec->speed * pcapture->GetDt());  // samples per bit
+
+    while (dec->bit >= 0) {
+        const uint64_t ts = dec->fstart + (uint64_t)((dec->bit + 0.5) * tbit);
+        if (ts >= time) {
+            break;
+        }
+        const unsigned char level = dec->level[0];
+        if (dec->bit == 0) {
+            if (level) {
+                // glitch, not a start bit
+                dec->bit = -1;
+                break;
+            }
+        } else if (dec->bit <= 8) {
+            dec->sr |= level << (dec->bit - 1);
+        } else {
+            // stop bit
+            const unsigned char c = dec->sr;
+            if (!level) {
+                AddNote(d, dec->fstart, ts, "%02X!FE", c);  // framing error
+            } else if (isprint(c) && (c != ' ')) {
+                AddNote(d, dec->fstart, ts, "%02X'%c'", c, c);
+            } else {
+                AddNote(d, dec->fstart, ts, "%02X", c);
+            }
+            dec->bit = -1;
+            break;
+        }
+        dec->bit++;
+    }
+}
+
+void CScopeDecoder::DecodeUART(const int d, const unsigned char level, const uint64_t time) {
+    dec_t* dec = &decoders[d];
+
+    UARTSample(d, time);
+
+    if ((dec->bit < 0) && dec->level[0] && !level) {
+        // start bit
+        dec->bit = 0;
+        dec->sr = 0;
+        dec->fstart = time;
+    }
+    dec->level[0] = level;
+}
+
+void CScopeDecoder::DecodeI2C(const int d, const uint64_t time) {
+    dec_t* dec = &decoders[d];
+    const unsigned char bit = dec->i2c.bit;
+
+    bitbang_i2c_io(&dec->i2c, dec->level[0], dec->level[1]);
+
+    if ((bit == 0) && (dec->i2c.bit == 1)) {
+        dec->fstart = time;
+    }
+
+    switch (bitbang_i2c_get_status(&dec->i2c)) {
+        case I2C_START:
+            AddNote(d, time, time, "S");
+            break;
+        case I2C_STOP:
+            AddNote(d, time, time, "P");
+            break;
+        case I2C_ADDR:
+            AddNote(d, dec->fstart, time, "A%02XW", dec->i2c.datar >> 1);
+            break;
+        case I2C_DATAR:
+            if (dec->i2c.byte == 1) {
+                AddNote(d, dec->fstart, time, "A%02XR", dec->i2c.datar >> 1);
+            } else {
+                AddNote(d, dec->fstart, time, "R%02X", dec->i2c.datar);
+            }
+            break;
+        case I2C_DATAW:
+            AddNote(d, dec->fstart, time, "W%02X", dec->i2c.datar);
+            break;
+    }
+}
+
+void CScopeDecoder::DecodeSPI(const int d, const uint64_t time) {
+    dec_t* dec = &decoders[d];
+    const unsigned char cs = (dec->ch[2] < 0) ? 0 : dec->level[2];
+
+    bitbang_spi_io(&dec->spi, dec->level[0], dec->level[1], cs);
+
+    switch (bitbang_spi_get_status(&dec->spi)) {
+        case SPI_BIT:
+            if (dec->spi.bit == 1) {
+                dec->fstart = time;
+            }
+            break;
+        case SPI_DATA:
+            AddNote(d, dec->fstart, time, "%02X", dec->spi.data);
+            break;
+    }
+}
+
+void CScopeDecoder::Decode1Wire(const int d, const unsigned char level, const uint64_t time) {
+    dec_t* dec = &decoders[d];
+
+    if (!level) {
+        dec->tfall = time;
+    } else {
+        const double dt_us = pcapture->GetDt() * 1e6;
+        const double pulse = (time - dec->tfall) * dt_us;
+
+        if (pulse >= 480) {
+            AddNote(d, dec->tfall, time, "RST");
+            dec->trst = time;
+            dec->bit = -1;  // wait presence pulse
+            dec->sr = 0;
+        } else if ((dec->bit < 0) && (((dec->tfall - dec->trst) * dt_us) < 80)) {
+            AddNote(d, dec->tfall, time, "PRES");
+            dec->bit = 0;
+        } else {
+            // time slot, short pulse is 1
+            if (dec->bit <= 0) {
+                dec->bit = 0;
+                dec->fstart = dec->tfall;
+            }
+            if (pulse < 15) {
+                dec->sr |= 1 << dec->bit;
+            }
+            dec->bit++;
+            if (dec->bit == 8) {
+                AddNote(d, dec->fstart, time, "%02X", dec->sr);
+                dec->bit = 0;
+                dec->sr = 0;
+            }
+        }
+    }
+    dec->level[0] = level;
+}
+
+void CScopeDecoder::AddNote(const int d, const uint64_t start, const uint64_t end, const char* fmt, ...) {
+    cap_note_t note;
+    va_list args;
+
+    note.time = start;
+    note.end = end;
+    note.decoder = d;
+    va_start(args, fmt);
+    vsnprintf(note.text, sizeof(note.text), fmt, args);
+    va_end(args);
+
+    if (notes.size() >= DEC_MAX_NOTES) {
+        notes.pop_front();
+    }
+
+    // keep notes sorted by start time, uart frames are finished after other decoders edges
+    auto it = notes.end();
+    while ((it != notes.begin()) && ((it - 1)->time > start)) {
+        it--;
+    }
+    notes.insert(it, note);
+}
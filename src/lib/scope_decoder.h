@@ -0,0 +1,142 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#ifndef SCOPE_DECODER_H
+#define SCOPE_DECODER_H
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#ifndef _NOTHREAD
+#include <thread>
+#endif
+#include <vector>
+
+#include "../devices/bitbang_i2c.h"
+#include "../devices/bitbang_spi.h"
+#include "scope_capture.h"
+
+#define DEC_MAX 4             // max number of decoders
+#define DEC_MAX_NOTES 65536   // max number of decoded frames kept
+#define DEC_BUFFER_SIZE 4096  // events read from capture each time
+
+enum { DEC_NONE, DEC_UART, DEC_I2C, DEC_SPI, DEC_1WIRE };
+
+typedef struct {
+    int type;
+    int ch[3];               // capture channels: uart rx, i2c scl/sda, spi sck/data/cs, 1-wire dq (-1 = not used)
+    unsigned int speed;      // uart baud rate
+    unsigned char level[3];  // channels logic level
+    bitbang_i2c_t i2c;
+    bitbang_spi_t spi;
+    int bit;                 // uart and 1-wire bit counter
+    unsigned int sr;         // uart and 1-wire shift register
+    uint64_t fstart;         // start time of frame in progress
+    uint64_t tfall;          // 1-wire time of last falling edge
+    uint64_t trst;           // 1-wire end time of last reset pulse
+} dec_t;
+
+/**
+ * @brief Protocol decoders of deep capture channels
+ *
+ * A worker thread reads the edges stored by CScopeCapture and runs the decoders, the simulation thread
+ * is not used and the cost depends only on the number of edges. Decoded frames are stored as notes sorted
+ * by time. Without threads (_NOTHREAD) the decoders run from Update, called by the oscilloscope when it
+ * fetches a frame.
+ */
+class CScopeDecoder {
+public:
+    CScopeDecoder();
+    ~CScopeDecoder();
+
+    /**
+     * @brief  Start worker thread reading edges of capture, threshold is the logic level
+     */
+    void Start(CScopeCapture* capture, const float threshold);
+
+    /**
+     * @brief  Stop worker thread
+     */
+    void Stop(void);
+
+    /**
+     * @brief  Decode the new edges, only needed without worker thread (_NOTHREAD)
+     */
+    void Update(void);
+
+    /**
+     * @brief  Add a decoder, return the decoder number or -1 on error
+     */
+    int Add(const int type, const int* ch, const unsigned int speed = 0);
+
+    /**
+     * @brief  Remove all decoders and notes
+     */
+    void Clear(void);
+
+    int GetCount(void) { return count; };
+
+    /**
+     * @brief  Get decoder description, if vcd is 1 the name has no spaces
+     */
+    std::string GetName(const int n, const int vcd = 0);
+
+    /**
+     * @brief  Get notes with start time in [t0,t1), up to max notes
+     */
+    void GetNotes(const uint64_t t0, const uint64_t t1, std::vector<cap_note_t>& list, const unsigned int max);
+
+    /**
+     * @brief  Get the last n notes
+     */
+    void GetLastNotes(std::vector<cap_note_t>& list, const unsigned int n);
+
+private:
+    void Worker(void);
+    int Run(cap_event_t* buff);
+    void Init(dec_t* dec, const int type, const int* ch, const unsigned int speed);
+    void Reset(void);
+    void Decode(const cap_event_t* ev);
+    void DecodeUART(const int d, const unsigned char level, const uint64_t time);
+    void DecodeI2C(const int d, const uint64_t time);
+    void DecodeSPI(const int d, const uint64_t time);
+    void Decode1Wire(const int d, const unsigned char level, const uint64_t time);
+    void UARTSample(const int d, const uint64_t time);
+    void AddNote(const int d, const uint64_t start, const uint64_t end, const char* fmt, ...);
+    CScopeCapture* pcapture;
+#ifndef _NOTHREAD
+    std::thread* worker;
+#endif
+    std::atomic<int> running;
+    std::mutex lock;  // protects decoders and notes
+    float threshold;
+    uint64_t pos;  // next capture event to read
+    dec_t decoders[DEC_MAX];
+    int count;
+    std::deque<cap_note_t> notes;
+};
+
+#endif  // SCOPE_DECODER_H
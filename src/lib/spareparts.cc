@@ -42,6 +42,7 @@ CSpareParts::CSpareParts() {
     LoadConfigFile = "";
     fdtype = -1;
     PartOnDraw = -1;
+    CmdListOpen = 0;
 
     OnCanvasCmd = NULL;
     OnWindowCmd = NULL;
@@ -480,6 +481,8 @@ bool CSpareParts::LoadConfig(std::string fname, const int disable_debug) {
             } else if (!strcmp(name, "osc_ch2")) {
                 osc_list.push_back(prefs.at(i));
                 Oscilloscope.ReadPreferencesList(osc_list);
+            } else if (!strcmp(name, "osc_chx")) {
+                Oscilloscope.ReadPreferences(name, temp);
             } else if ((parts[partsc_] = create_part(name, x, y, PICSimLab.GetBoard(), partsc_))) {
                 printf("Spare parts: parts[%02i] (%s) created \n", partsc_, name);
                 partsc = partsc_ + 1;
@@ -654,10 +657,10 @@ bool CSpareParts::SaveConfig(std::string fname) {
         prefs.push_back(osc_list.at(ol));
     }
 
+    // part preferences can be longer than temp (file names), the load side reads up to 4095 chars
     for (int i = 0; i < GetCount(); i++) {
-        snprintf(temp, 256, "%s,%i,%i,%i:%s", GetPart(i)->GetName().c_str(), GetPart(i)->GetX(), GetPart(i)->GetY(),
-                 GetPart(i)->GetOrientation(), GetPart(i)->WritePreferences().c_str());
-        prefs.push_back(temp);
+        snprintf(temp, 256, ",%i,%i,%i:", GetPart(i)->GetX(), GetPart(i)->GetY(), GetPart(i)->GetOrientation());
+        prefs.push_back(GetPart(i)->GetName() + temp + GetPart(i)->WritePreferences());
     }
 
     return SaveToFile(prefs, fname.c_str());
@@ -675,12 +678,29 @@ void CSpareParts::SetfdOldFilename(const std::string ofn) {
 }
 
 int CSpareParts::CanvasCmd(const CanvasCmd_t cmd) {
+    if (SpareParts.CmdListOpen) {
+        if (SpareParts.CmdList.Add(cmd)) {
+            return 0;
+        }
+        // keep the order: recorded commands are sent before this one
+        SpareParts.CmdList.Run(SpareParts.OnCanvasCmd);
+    }
     if (SpareParts.OnCanvasCmd) {
         return (*SpareParts.OnCanvasCmd)(cmd);
     }
     return -1;
 }
 
+void CSpareParts::CanvasCmdListBegin(void) {
+    CmdList.Clear();
+    CmdListOpen = 1;
+}
+
+void CSpareParts::CanvasCmdListEnd(void) {
+    CmdListOpen = 0;
+    CmdList.Run(OnCanvasCmd);
+}
+
 int CSpareParts::WPropCmd(const char* ControlName, const PICSimLabWindowAction action, const char* Value,
                           void* ReturnBuff) {
     if (SpareParts.OnWindowCmd) {
@@ -62,6 +62,11 @@ public:
      */
     void PostProcess(void);
 
+    /**
+     * @brief  Return the number of parts that need process every clock cycle (valid after PreProcess)
+     */
+    int GetAlwaysUpdateCount(void) { return partsc_aup; };
+
     /**
      * @brief  Return the name of all pins
      */
@@ -110,11 +115,27 @@ public:
 
     std::string GetOldFilename(void) { return oldfname; };
 
-    void SetPartOnDraw(int pod) { PartOnDraw = pod; };
+    void SetPartOnDraw(int pod) {
+        if (CmdListOpen && (pod != PartOnDraw)) {
+            CmdList.Run(OnCanvasCmd);
+        }
+        PartOnDraw = pod;
+    };
     int GetPartOnDraw(void) { return PartOnDraw; };
 
     static int CanvasCmd(const CanvasCmd_t cmd);
 
+    /**
+     * @brief Record the following canvas commands in a list, sent to the GUI by CanvasCmdListEnd
+     */
+    void CanvasCmdListBegin(void);
+    void CanvasCmdListEnd(void);
+
+    /**
+     * @brief Return the list of recorded commands, or NULL when not recording
+     */
+    CCanvasCmdList* GetCanvasCmdList(void) { return CmdListOpen ? &CmdList : NULL; };
+
     static int WPropCmd(const char* ControlName, const PICSimLabWindowAction action, const char* Value,
                         void* ReturnBuff = NULL);
 
@@ -146,6 +167,8 @@ private:
     int fdtype;
     std::string oldfname;
     int PartOnDraw;
+    CCanvasCmdList CmdList;
+    int CmdListOpen;
 };
 
 extern CSpareParts SpareParts;
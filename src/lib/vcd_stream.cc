@@ -0,0 +1,447 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#include "vcd_stream.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "util.h"
+
+static int is_space(const char c) {
+    return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n');
+}
+
+static int next_token(const char* text, const size_t len, size_t* pos, const char** token, size_t* tlen) {
+    size_t p = *pos;
+    while ((p < len) && is_space(text[p])) {
+        p++;
+    }
+    if (p >= len) {
+        *pos = p;
+        return 0;
+    }
+    *token = text + p;
+    while ((p < len) && !is_space(text[p])) {
+        p++;
+    }
+    *tlen = (text + p) - *token;
+    *pos = p;
+    return 1;
+}
+
+static int token_is(const char* token, const size_t len, const char* str) {
+    return (strlen(str) == len) && !strncmp(token, str, len);
+}
+
+static uint64_t parse_u64(const char* token, const size_t len) {
+    uint64_t v = 0;
+    for (size_t i = 0; (i < len) && (token[i] >= '0') && (token[i] <= '9'); i++) {
+        v = (v * 10) + (token[i] - '0');
+    }
+    return v;
+}
+
+CVCDStream::CVCDStream() {
+    data = NULL;
+    size = 0;
+    pos = 0;
+    data_start = 0;
+    ctime = 0;
+    end_time = 0;
+    timescale = 1e-12;
+    wave = NULL;
+    memset(code1, -1, sizeof(code1));
+}
+
+CVCDStream::~CVCDStream() {
+    Close();
+}
+
+int CVCDStream::Open(const char* fname) {
+    char magic[4] = {0, 0, 0, 0};
+
+    Close();
+
+    FILE* fin = fopen_UTF8(fname, "rb");
+    if (!fin) {
+        printf("PICSimLab: Error open VCD file \"%s\"!\n", fname);
+        return 0;
+    }
+    const size_t rsize = fread(magic, 1, 4, fin);
+    fclose(fin);
+
+    if ((rsize == 4) && !memcmp(magic, PWF_MAGIC, 4)) {
+        wave = new CWaveReader();
+        if (!wave->Open(fname)) {
+            Close();
+            return 0;
+        }
+        const std::string& header = wave->GetHeader();
+        ParseHeader(header.c_str(), header.size(), &data_start);
+        wave_map.resize(wave->GetIdCount());
+        for (unsigned int i = 0; i < wave_map.size(); i++) {
+            wave_map[i] = FindVar(wave->GetId(i), strlen(wave->GetId(i)));
+        }
+        end_time = wave->GetEndTime();
+        return 1;
+    }
+
+#ifdef _WIN32
+    HANDLE hfile = CreateFileA(fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hfile == INVALID_HANDLE_VALUE) {
+        return 0;
+    }
+    LARGE_INTEGER fsize;
+    GetFileSizeEx(hfile, &fsize);
+    size = fsize.QuadPart;
+    HANDLE hmap = size ? CreateFileMappingA(hfile, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    if (hmap) {
+        data = (const char*)MapViewOfFile(hmap, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(hmap);
+    }
+    CloseHandle(hfile);
+#else
+    int fd = open(fname, O_RDONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    struct stat st;
+    fstat(fd, &st);
+    size = st.st_size;
+    if (size) {
+        void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        data = (map != MAP_FAILED) ? (const char*)map : NULL;
+    }
+    close(fd);
+#endif
+
+    if (!data) {
+        printf("PICSimLab: Error mapping VCD file \"%s\"!\n", fname);
+        size = 0;
+        return 0;
+    }
+
+    if (!ParseHeader(data, size, &data_start)) {
+        printf("PICSimLab: Invalid VCD file \"%s\"!\n", fname);
+        Close();
+        return 0;
+    }
+
+    // sparse time index
+    size_t offset = data_start;
+    while (offset < size) {
+        vcds_index_t entry;
+        entry.time = FindTime(&offset, 0);
+        if (entry.time == UINT64_MAX) {
+            break;
+        }
+        entry.offset = offset;
+        index.push_back(entry);
+        offset += VCDS_INDEX_STEP;
+    }
+
+    offset = size;
+    end_time = FindTime(&offset, 1);
+    if (end_time == UINT64_MAX) {
+        end_time = 0;
+    }
+
+    Seek(0);
+    return 1;
+}
+
+void CVCDStream::Close(void) {
+    if (data) {
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+#else
+        munmap((void*)data, size);
+#endif
+        data = NULL;
+    }
+    if (wave) {
+        delete wave;
+        wave = NULL;
+    }
+    size = 0;
+    pos = 0;
+    data_start = 0;
+    ctime = 0;
+    end_time = 0;
+    timescale = 1e-12;
+    vars.clear();
+    index.clear();
+    codes.clear();
+    wave_map.clear();
+    memset(code1, -1, sizeof(code1));
+}
+
+int CVCDStream::ParseHeader(const char* text, const size_t len, size_t* end) {
+    size_t p = 0;
+    const char* token;
+    size_t tlen;
+
+    while (next_token(text, len, &p, &token, &tlen)) {
+        if (token_is(token, tlen, "$enddefinitions")) {
+            while (next_token(text, len, &p, &token, &tlen) && !token_is(token, tlen, "$end")) {
+            }
+            *end = p;
+            return 1;
+        } else if (token_is(token, tlen, "$timescale")) {
+            std::string ts;
+            while (next_token(text, len, &p, &token, &tlen) && !token_is(token, tlen, "$end")) {
+                ts.append(token, tlen);
+            }
+            double num = 1;
+            char unit[3] = "s";
+            sscanf(ts.c_str(), "%lf%2s", &num, unit);
+            const char* units[] = {"s", "ms", "us", "ns", "ps", "fs"};
+            timescale = num;
+            for (int i = 0; i < 6; i++) {
+                if (!strcmp(unit, units[i])) {
+                    break;
+                }
+                timescale *= 1e-3;
+            }
+        } else if (token_is(token, tlen, "$var")) {
+            const char* tk[6];
+            size_t tl[6];
+            int n = 0;
+            while (next_token(text, len, &p, &token, &tlen) && !token_is(token, tlen, "$end")) {
+                if (n < 6) {
+                    tk[n] = token;
+                    tl[n] = tlen;
+                    n++;
+                }
+            }
+            if (n >= 4) {
+                vcds_var_t var;
+                var.real = token_is(tk[0], tl[0], "real");
+                var.width = var.real ? 1 : parse_u64(tk[1], tl[1]);
+                if ((var.width < 1) || (var.width > 64)) {
+                    var.width = 64;
+                }
+                var.code.assign(tk[2], tl[2]);
+                var.name.assign(tk[3], tl[3]);
+                // aliases share the value of first variable with same code
+                if (FindVar(tk[2], tl[2]) < 0) {
+                    const unsigned short id = vars.size();
+                    if ((tl[2] == 1) && ((unsigned char)tk[2][0] < 128)) {
+                        code1[(unsigned char)tk[2][0]] = id;
+                    } else {
+                        codes[var.code] = id;
+                    }
+                    vars.push_back(var);
+                }
+            }
+        } else if (token[0] == '$') {
+            // $date, $version, $comment, $scope and $upscope
+            while (next_token(text, len, &p, &token, &tlen) && !token_is(token, tlen, "$end")) {
+            }
+        }
+    }
+    *end = p;
+    return 0;
+}
+
+int CVCDStream::FindVar(const char* code, const size_t len) {
+    if ((len == 1) && ((unsigned char)code[0] < 128)) {
+        return code1[(unsigned char)code[0]];
+    }
+    auto it = codes.find(std::string(code, len));
+    if (it != codes.end()) {
+        return it->second;
+    }
+    return -1;
+}
+
+int CVCDStream::GetToken(const char** token, size_t* len) {
+    return next_token(data, size, &pos, token, len);
+}
+
+uint64_t CVCDStream::FindTime(size_t* offset, const int backward) {
+    size_t p = *offset;
+
+    if (backward) {
+        while (p > data_start) {
+            p--;
+            if ((data[p] == '#') && is_space(data[p - 1])) {
+                break;
+            }
+        }
+    } else {
+        while ((p < size) && !((data[p] == '#') && ((p == data_start) || is_space(data[p - 1])))) {
+            p++;
+        }
+    }
+
+    if ((p <= data_start && data[p] != '#') || (p >= size)) {
+        return UINT64_MAX;
+    }
+
+    *offset = p;
+    size_t e = p + 1;
+    while ((e < size) && !is_space(data[e])) {
+        e++;
+    }
+    return parse_u64(data + p + 1, e - p - 1);
+}
+
+int CVCDStream::Seek(const uint64_t time) {
+    if (wave) {
+        return wave->Seek(time);
+    }
+
+    if (!data) {
+        return 0;
+    }
+
+    pos = data_start;
+    ctime = 0;
+
+    // last index entry before time
+    unsigned int lo = 0;
+    unsigned int hi = index.size();
+    while (lo < hi) {
+        const unsigned int mid = (lo + hi) / 2;
+        if (index[mid].time < time) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo) {
+        pos = index[lo - 1].offset;
+        ctime = index[lo - 1].time;
+    }
+
+    // skip changes before time
+    while (1) {
+        const size_t ppos = pos;
+        const uint64_t ptime = ctime;
+        vcdw_record_t rec;
+        if (!Next(&rec)) {
+            break;
+        }
+        if (rec.time >= time) {
+            pos = ppos;
+            ctime = ptime;
+            break;
+        }
+    }
+    return 1;
+}
+
+int CVCDStream::Next(vcdw_record_t* rec) {
+    const char* token;
+    size_t len;
+
+    if (wave) {
+        while (wave->Next(rec)) {
+            if ((rec->id < wave_map.size()) && (wave_map[rec->id] >= 0)) {
+                rec->id = wave_map[rec->id];
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    while (GetToken(&token, &len)) {
+        int id;
+        switch (token[0]) {
+            case '#':
+                ctime = parse_u64(token + 1, len - 1);
+                break;
+            case '$':
+                if (token_is(token, len, "$comment")) {
+                    while (GetToken(&token, &len) && !token_is(token, len, "$end")) {
+                    }
+                }
+                // $dumpvars, $dumpall, $dumpon, $dumpoff and $end are ignored
+                break;
+            case 'x':
+            case 'X':
+            case 'z':
+            case 'Z':
+                // unknown values ($dumpvars) are not reported
+                break;
+            case '0':
+            case '1':
+                if ((id = FindVar(token + 1, len - 1)) >= 0) {
+                    rec->time = ctime;
+                    rec->id = id;
+                    rec->type = VCDW_BIT;
+                    rec->width = 1;
+                    rec->bits = (token[0] == '1');
+                    rec->value = rec->bits;
+                    return 1;
+                }
+                break;
+            case 'b':
+            case 'B': {
+                uint64_t bits = 0;
+                for (size_t i = 1; i < len; i++) {
+                    bits = (bits << 1) | (token[i] == '1');
+                }
+                if (GetToken(&token, &len) && ((id = FindVar(token, len)) >= 0)) {
+                    rec->time = ctime;
+                    rec->id = id;
+                    rec->type = VCDW_VECTOR;
+                    rec->width = vars[id].width;
+                    rec->bits = bits;
+                    rec->value = bits;
+                    return 1;
+                }
+            } break;
+            case 'r':
+            case 'R': {
+                char num[64];
+                const size_t nlen = (len < sizeof(num)) ? len - 1 : sizeof(num) - 1;
+                memcpy(num, token + 1, nlen);
+                num[nlen] = 0;
+                if (GetToken(&token, &len) && ((id = FindVar(token, len)) >= 0)) {
+                    rec->time = ctime;
+                    rec->id = id;
+                    rec->type = VCDW_REAL;
+                    rec->width = 32;
+                    rec->bits = 0;
+                    rec->value = atof(num);
+                    return 1;
+                }
+            } break;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#ifndef VCD_STREAM_H
+#define VCD_STREAM_H
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "vcd_writer.h"
+#include "wave_reader.h"
+
+#define VCDS_INDEX_STEP 1048576  // file bytes between time index entries
+
+typedef struct {
+    std::string name;
+    std::string code;
+    unsigned int width;
+    int real;
+} vcds_var_t;
+
+typedef struct {
+    uint64_t time;
+    uint64_t offset;
+} vcds_index_t;
+
+/**
+ * @brief Streaming reader of VCD and PICSimLab binary waveform files
+ *
+ * VCD files are memory mapped and parsed on demand, only the variables and a sparse time index (one entry
+ * each VCDS_INDEX_STEP bytes) are kept in memory, so the memory used does not depend on file size.
+ * PWF files are read with CWaveReader. Records returned by Next have id set to the variable index.
+ */
+class CVCDStream {
+public:
+    CVCDStream();
+    ~CVCDStream();
+
+    /**
+     * @brief  Open file, parse header and build time index
+     */
+    int Open(const char* fname);
+
+    void Close(void);
+
+    int IsOpen(void) { return (data != NULL) || (wave != NULL); };
+
+    /**
+     * @brief  Return time unit in seconds
+     */
+    double GetTimescale(void) { return timescale; };
+
+    unsigned int GetVarCount(void) { return vars.size(); };
+
+    const vcds_var_t& GetVar(const unsigned int n) { return vars[n]; };
+
+    uint64_t GetEndTime(void) { return end_time; };
+
+    /**
+     * @brief  Position stream at first change with time greater or equal to time (time 0 includes $dumpvars)
+     */
+    int Seek(const uint64_t time);
+
+    /**
+     * @brief  Read next value change, return 0 at end of file
+     */
+    int Next(vcdw_record_t* rec);
+
+private:
+    int ParseHeader(const char* text, const size_t len, size_t* end);
+    int FindVar(const char* code, const size_t len);
+    int GetToken(const char** token, size_t* len);
+    uint64_t FindTime(size_t* offset, const int backward);
+    const char* data;
+    size_t size;
+    size_t pos;
+    size_t data_start;
+    uint64_t ctime;
+    uint64_t end_time;
+    double timescale;
+    std::vector<vcds_var_t> vars;
+    std::vector<vcds_index_t> index;
+    std::unordered_map<std::string, unsigned short> codes;
+    short code1[128];  // variables with one char identifier code
+    CWaveReader* wave;
+    std::vector<short> wave_map;  // PWF identifier to variable index
+};
+
+#endif  // VCD_STREAM_H
@@ -0,0 +1,369 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#include "vcd_writer.h"
+
+#include <stdarg.h>
+#include <string.h>
+#include <zlib.h>
+#include <chrono>
+
+#include "util.h"
+
+static void put_u32(FILE* fout, const uint32_t v) {
+    unsigned char b[4];
+    for (int i = 0; i < 4; i++) {
+        b[i] = v >> (i * 8);
+    }
+    fwrite(b, 4, 1, fout);
+}
+
+static void put_u64(FILE* fout, const uint64_t v) {
+    unsigned char b[8];
+    for (int i = 0; i < 8; i++) {
+        b[i] = v >> (i * 8);
+    }
+    fwrite(b, 8, 1, fout);
+}
+
+static unsigned int put_varint(unsigned char* buff, uint64_t v) {
+    unsigned int n = 0;
+    while (v >= 0x80) {
+        buff[n++] = (v & 0x7F) | 0x80;
+        v >>= 7;
+    }
+    buff[n++] = v;
+    return n;
+}
+
+CVCDWriter::CVCDWriter() {
+    fout = NULL;
+    format = VCDW_VCD;
+    ring = NULL;
+    rhead = 0;
+    rtail = 0;
+    written = 0;
+    dropped = 0;
+    highwater = 0;
+    running = 0;
+#ifndef _NOTHREAD
+    worker = NULL;
+#endif
+    bsize = 0;
+    ltime = 0;
+    block = NULL;
+    zblock = NULL;
+    block_count = 0;
+    block_start = 0;
+    foffset = 0;
+}
+
+CVCDWriter::~CVCDWriter() {
+    Close();
+}
+
+int CVCDWriter::Open(const char* fname, const int format_) {
+    Close();
+
+    fout = fopen_UTF8(fname, "wb");
+    if (!fout) {
+        printf("PICSimLab: Error open VCD file \"%s\"!\n", fname);
+        return 0;
+    }
+
+    format = format_;
+    if (!ring) {
+        ring = new vcdw_record_t[VCDW_RING_SIZE];
+    }
+    if ((format == VCDW_PWF) && !block) {
+        block = new unsigned char[PWF_BLOCK_SIZE];
+        zblock = new unsigned char[compressBound(PWF_BLOCK_SIZE)];
+    }
+    rhead = 0;
+    rtail = 0;
+    written = 0;
+    dropped = 0;
+    highwater = 0;
+    bsize = 0;
+    ltime = 0;
+    block_count = 0;
+    block_start = 0;
+    foffset = 0;
+    header.clear();
+    index.clear();
+    ids.clear();
+    return 1;
+}
+
+void CVCDWriter::Printf(const char* fmt, ...) {
+    if (!fout || running) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    if (format == VCDW_PWF) {
+        char line[512];
+        vsnprintf(line, sizeof(line), fmt, args);
+        header += line;
+    } else {
+        vfprintf(fout, fmt, args);
+    }
+    va_end(args);
+}
+
+void CVCDWriter::SetId(const unsigned short id, const char* code) {
+    if (id >= ids.size()) {
+        ids.resize(id + 1);
+    }
+    ids[id] = code;
+}
+
+std::string CVCDWriter::MakeId(unsigned int n) {
+    std::string code;
+    do {
+        code += (char)('!' + (n % 94));
+        n /= 94;
+    } while (n);
+    return code;
+}
+
+unsigned short CVCDWriter::AddVar(const char* type, const unsigned int width, const char* name) {
+    const unsigned short id = ids.size();
+    const std::string code = MakeId(id);
+    SetId(id, code.c_str());
+    Printf("$var %s %u %s %s $end\n", type, width, code.c_str(), name);
+    return id;
+}
+
+void CVCDWriter::Start(void) {
+    if (fout && !running) {
+        if (format == VCDW_PWF) {
+            // file header: magic, VCD header text and identifier codes
+            fwrite(PWF_MAGIC, 4, 1, fout);
+            put_u32(fout, header.size());
+            fwrite(header.c_str(), header.size(), 1, fout);
+            put_u32(fout, ids.size());
+            for (unsigned int i = 0; i < ids.size(); i++) {
+                fputc(ids[i].size(), fout);
+                fwrite(ids[i].c_str(), ids[i].size(), 1, fout);
+                foffset += 1 + ids[i].size();
+            }
+            foffset += 12 + header.size();
+        }
+        fflush(fout);
+        running = 1;
+#ifndef _NOTHREAD
+        worker = new std::thread(&CVCDWriter::Worker, this);
+#endif
+    }
+}
+
+void CVCDWriter::Close(void) {
+    running = 0;
+#ifndef _NOTHREAD
+    if (worker) {
+        worker->join();
+        delete worker;
+        worker = NULL;
+    }
+#endif
+
+    if (fout) {
+        Flush();
+        if (format == VCDW_PWF) {
+            WriteBlock();
+            WriteIndex();
+        } else if (dropped) {
+            fprintf(fout, "$comment %llu changes dropped, writer ring full $end\n",
+                    (unsigned long long)dropped.load());
+        }
+        if (dropped) {
+            printf("PICSimLab: VCD writer dropped %llu changes (ring high water %u of %u)\n",
+                   (unsigned long long)dropped.load(), highwater.load(), VCDW_RING_SIZE);
+        }
+        fclose(fout);
+        fout = NULL;
+    }
+
+    if (ring) {
+        delete[] ring;
+        ring = NULL;
+    }
+    if (block) {
+        delete[] block;
+        delete[] zblock;
+        block = NULL;
+        zblock = NULL;
+    }
+}
+
+void CVCDWriter::Encode(const vcdw_record_t* rec) {
+    if (bsize > (PWF_BLOCK_SIZE - 32)) {
+        WriteBlock();
+    }
+
+    if (!block_count) {
+        block_start = rec->time;
+        ltime = rec->time;
+    }
+
+    // record: time delta, key (id << 2 | 0 bit 0, 1 bit 1, 2 real, 3 vector) and real or vector value
+    bsize += put_varint(block + bsize, rec->time - ltime);
+    ltime = rec->time;
+    if (rec->type == VCDW_BIT) {
+        bsize += put_varint(block + bsize, (rec->id << 2) | (rec->bits & 1));
+    } else if (rec->type == VCDW_VECTOR) {
+        bsize += put_varint(block + bsize, (rec->id << 2) | 3);
+        block[bsize++] = rec->width;
+        bsize += put_varint(block + bsize, rec->bits);
+    } else {
+        uint32_t v;
+        bsize += put_varint(block + bsize, (rec->id << 2) | 2);
+        memcpy(&v, &rec->value, 4);
+        for (int i = 0; i < 4; i++) {
+            block[bsize++] = v >> (i * 8);
+        }
+    }
+    block_count++;
+}
+
+void CVCDWriter::WriteBlock(void) {
+    if (!block_count) {
+        return;
+    }
+
+    uLongf zsize = compressBound(PWF_BLOCK_SIZE);
+    compress2(zblock, &zsize, block, bsize, Z_BEST_SPEED);
+
+    // block: start time, end time, record count, raw size, compressed size and data
+    index.push_back(block_start);
+    index.push_back(ltime);
+    index.push_back(foffset);
+    put_u64(fout, block_start);
+    put_u64(fout, ltime);
+    put_u32(fout, block_count);
+    put_u32(fout, bsize);
+    put_u32(fout, zsize);
+    fwrite(zblock, zsize, 1, fout);
+    fflush(fout);
+    foffset += 28 + zsize;
+
+    bsize = 0;
+    block_count = 0;
+}
+
+void CVCDWriter::WriteIndex(void) {
+    const unsigned int count = index.size() / 3;
+
+    put_u32(fout, count);
+    for (unsigned int i = 0; i < index.size(); i++) {
+        put_u64(fout, index[i]);
+    }
+    put_u64(fout, dropped);
+    put_u64(fout, foffset);
+    fwrite(PWF_IMAGIC, 4, 1, fout);
+}
+
+int CVCDWriter::Flush(void) {
+    unsigned int tail = rtail.load(std::memory_order_relaxed);
+    const unsigned int head = rhead.load(std::memory_order_acquire);
+    const unsigned int count = head - tail;
+
+    while (tail != head) {
+        const vcdw_record_t* rec = &ring[tail & (VCDW_RING_SIZE - 1)];
+
+        if (format == VCDW_PWF) {
+            Encode(rec);
+            tail++;
+            rtail.store(tail, std::memory_order_release);
+            continue;
+        }
+
+        const char* code = (rec->id < ids.size()) ? ids[rec->id].c_str() : "?";
+
+        if (bsize > (VCDW_BUFFER_SIZE - 256)) {
+            fwrite(buffer, bsize, 1, fout);
+            bsize = 0;
+        }
+
+        if (rec->time != ltime) {
+            char digits[24];
+            int nd = 0;
+            ltime = rec->time;
+            uint64_t t = ltime;
+            do {
+                digits[nd++] = '0' + (t % 10);
+                t /= 10;
+            } while (t);
+            buffer[bsize++] = '#';
+            while (nd) {
+                buffer[bsize++] = digits[--nd];
+            }
+            buffer[bsize++] = '\n';
+        }
+
+        if (rec->type == VCDW_BIT) {
+            buffer[bsize++] = '0' + (rec->bits & 1);
+            while (*code) {
+                buffer[bsize++] = *code++;
+            }
+            buffer[bsize++] = '\n';
+        } else if (rec->type == VCDW_VECTOR) {
+            buffer[bsize++] = 'b';
+            for (int b = rec->width - 1; b >= 0; b--) {
+                buffer[bsize++] = '0' + ((rec->bits >> b) & 1);
+            }
+            buffer[bsize++] = ' ';
+            while (*code) {
+                buffer[bsize++] = *code++;
+            }
+            buffer[bsize++] = '\n';
+        } else {
+            bsize += snprintf(buffer + bsize, VCDW_BUFFER_SIZE - bsize, "r%f %s\n", rec->value, code);
+        }
+
+        tail++;
+        rtail.store(tail, std::memory_order_release);
+    }
+
+    if (bsize && (format == VCDW_VCD)) {
+        fwrite(buffer, bsize, 1, fout);
+        bsize = 0;
+        fflush(fout);
+    }
+
+    written.fetch_add(count, std::memory_order_relaxed);
+    return count;
+}
+
+#ifndef _NOTHREAD
+void CVCDWriter::Worker(void) {
+    while (running) {
+        if (!Flush()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+#endif
@@ -0,0 +1,196 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#ifndef VCD_WRITER_H
+#define VCD_WRITER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <string>
+#ifndef _NOTHREAD
+#include <thread>
+#endif
+#include <vector>
+
+#define VCDW_RING_SIZE 262144   // change records in ring (power of two)
+#define VCDW_BUFFER_SIZE 65536  // formatted text written to file each time
+
+#define PWF_BLOCK_SIZE 262144  // uncompressed size of binary waveform blocks
+#define PWF_MAGIC "PWF1"       // binary waveform file start
+#define PWF_IMAGIC "PWFI"      // binary waveform index trailer
+
+enum { VCDW_BIT, VCDW_REAL, VCDW_VECTOR };
+
+enum { VCDW_VCD, VCDW_PWF };
+
+typedef struct {
+    uint64_t time;
+    uint64_t bits;  // bit or vector value
+    float value;    // real value
+    unsigned short id;
+    unsigned char type;
+    unsigned char width;  // vector width
+} vcdw_record_t;
+
+/**
+ * @brief Asynchronous VCD file writer
+ *
+ * The simulation thread pushes binary change records into a lock-free single producer/single consumer
+ * ring, a worker thread formats them and writes large blocks to the file. When the ring is full the record
+ * is dropped and counted, the simulation never waits for disk. Without threads (_NOTHREAD) the ring is
+ * written by Update, called by the part once per PostProcess.
+ *
+ * With VCDW_PWF format the changes are stored in the PICSimLab binary waveform format instead of text:
+ * the VCD header followed by zlib compressed blocks of records with delta encoded timestamps and a block
+ * index at end of file to allow seek by time (see CWaveReader).
+ */
+class CVCDWriter {
+public:
+    CVCDWriter();
+    ~CVCDWriter();
+
+    /**
+     * @brief  Open file, the header must be written with Printf before Start
+     */
+    int Open(const char* fname, const int format = VCDW_VCD);
+
+    /**
+     * @brief  Write VCD header text, only used before Start
+     */
+    void Printf(const char* fmt, ...);
+
+    /**
+     * @brief  Set the VCD identifier code of variable id
+     */
+    void SetId(const unsigned short id, const char* code);
+
+    /**
+     * @brief  Declare a variable with a generated identifier code, return the variable id
+     */
+    unsigned short AddVar(const char* type, const unsigned int width, const char* name);
+
+    /**
+     * @brief  Return the shortest VCD identifier code of number n (printable chars '!' to '~')
+     */
+    static std::string MakeId(unsigned int n);
+
+    /**
+     * @brief  Start worker thread
+     */
+    void Start(void);
+
+    /**
+     * @brief  Stop worker thread, write pending records and close file
+     */
+    void Close(void);
+
+    int IsOpen(void) { return fout != NULL; };
+
+    /**
+     * @brief  Write queued records, only needed without worker thread (_NOTHREAD)
+     */
+    void Update(void) {
+#ifdef _NOTHREAD
+        if (running) {
+            Flush();
+        }
+#endif
+    };
+
+    /**
+     * @brief  Queue a change record, called only from simulation thread
+     */
+    void Push(const uint64_t time, const unsigned short id, const unsigned char type, const unsigned char width,
+              const uint64_t bits, const float value) {
+        const unsigned int head = rhead.load(std::memory_order_relaxed);
+        const unsigned int used = head - rtail.load(std::memory_order_acquire);
+        if (used >= VCDW_RING_SIZE) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        if (used >= highwater.load(std::memory_order_relaxed)) {
+            highwater.store(used + 1, std::memory_order_relaxed);
+        }
+        vcdw_record_t* rec = &ring[head & (VCDW_RING_SIZE - 1)];
+        rec->time = time;
+        rec->id = id;
+        rec->type = type;
+        rec->width = width;
+        rec->bits = bits;
+        rec->value = value;
+        rhead.store(head + 1, std::memory_order_release);
+    };
+
+    void Bit(const uint64_t time, const unsigned short id, const int value) {
+        Push(time, id, VCDW_BIT, 1, value != 0, 0);
+    };
+
+    void Real(const uint64_t time, const unsigned short id, const float value) {
+        Push(time, id, VCDW_REAL, 32, 0, value);
+    };
+
+    void Vector(const uint64_t time, const unsigned short id, const unsigned char width, const uint64_t bits) {
+        Push(time, id, VCDW_VECTOR, width, (width < 64) ? (bits & ((1ULL << width) - 1)) : bits, 0);
+    };
+
+    uint64_t GetWritten(void) { return written.load(std::memory_order_relaxed); };
+
+    uint64_t GetDropped(void) { return dropped.load(std::memory_order_relaxed); };
+
+    unsigned int GetHighWater(void) { return highwater.load(std::memory_order_relaxed); };
+
+private:
+    void Worker(void);
+    int Flush(void);
+    void Encode(const vcdw_record_t* rec);
+    void WriteBlock(void);
+    void WriteIndex(void);
+    FILE* fout;
+    int format;
+    vcdw_record_t* ring;
+    std::atomic<unsigned int> rhead;
+    std::atomic<unsigned int> rtail;
+    std::atomic<uint64_t> written;
+    std::atomic<uint64_t> dropped;
+    std::atomic<unsigned int> highwater;
+    std::atomic<int> running;
+#ifndef _NOTHREAD
+    std::thread* worker;
+#endif
+    std::vector<std::string> ids;
+    char buffer[VCDW_BUFFER_SIZE];
+    unsigned int bsize;
+    uint64_t ltime;
+    std::string header;
+    unsigned char* block;
+    unsigned char* zblock;
+    unsigned int block_count;
+    uint64_t block_start;
+    uint64_t foffset;
+    std::vector<uint64_t> index;  // start time, end time and file offset of each block
+};
+
+#endif  // VCD_WRITER_H
@@ -0,0 +1,256 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#include "wave_check.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "picsimlab.h"
+
+CWaveCheck WaveCheck;
+
+CWaveCheck::CWaveCheck() {
+    next_valid = 0;
+    next_time = 0;
+    inst_per_unit = 0;
+    tolerance = 0;
+    now = 0;
+    end_time = 0;
+    freq = 1;
+    checked = 0;
+    running = 0;
+    free_run = 0;
+    exit_on_end = 0;
+    status = WC_IDLE;
+}
+
+CWaveCheck::~CWaveCheck() {
+    Stop();
+    vcd.Close();
+}
+
+int CWaveCheck::Start(board* b, const char* fname, const double tolerance_us) {
+    std::lock_guard<std::mutex> guard(lock);
+    running = 0;
+    status = WC_IDLE;
+    report = "";
+    pins.clear();
+    var_pin.clear();
+
+    if (!b || !vcd.Open(fname)) {
+        report = std::string("error loading ") + fname;
+        return -1;
+    }
+
+    freq = b->MGetInstClockFreq();
+    inst_per_unit = vcd.GetTimescale() * freq;
+    tolerance = tolerance_us * 1e-6 * freq + 0.5;
+
+    const picpin* ppins = b->MGetPinsValues();
+    var_pin.assign(vcd.GetVarCount(), -1);
+    for (unsigned int i = 0; i < vcd.GetVarCount(); i++) {
+        const vcds_var_t& var = vcd.GetVar(i);
+        const int pin = (!var.real && (var.width == 1)) ? FindPin(b, var.name) : 0;
+        if (!pin) {
+            printf("PICSimLab: Wave check ignoring variable \"%s\"\n", var.name.c_str());
+            continue;
+        }
+        int used = 0;
+        for (unsigned int p = 0; p < pins.size(); p++) {
+            used |= (pins[p].pin == (unsigned int)pin);
+        }
+        if (!used) {
+            wc_pin_t wpin;
+            wpin.pin = pin;
+            wpin.live = ppins[pin - 1].value;
+            wpin.ref = WC_UNKNOWN;
+            pins.push_back(wpin);
+            var_pin[i] = pins.size() - 1;
+        }
+    }
+
+    if (pins.empty()) {
+        vcd.Close();
+        report = "no reference variable matches a board pin";
+        return -1;
+    }
+
+    vcd.Seek(0);
+    next_valid = vcd.Next(&next);
+    next_time = next.time * inst_per_unit + 0.5;
+    end_time = vcd.GetEndTime() * inst_per_unit + 0.5;
+    now = 0;
+    checked = 0;
+    running = 1;
+    status = WC_RUNNING;
+
+    printf("PICSimLab: Wave check of %i pins with \"%s\" (tolerance %llu instructions)\n", (int)pins.size(), fname,
+           (unsigned long long)tolerance);
+    return 0;
+}
+
+void CWaveCheck::Stop(void) {
+    // reference and pins are released in next Start
+    std::lock_guard<std::mutex> guard(lock);
+    running = 0;
+    if (status == WC_RUNNING) {
+        status = WC_IDLE;
+    }
+}
+
+// reference names are "NAME", "N-NAME" (VCD Dump) or "pinN", bus ranges "[7:0]" are removed
+int CWaveCheck::FindPin(board* b, const std::string& vname) {
+    std::string name = vname.substr(0, vname.find(' '));
+
+    const size_t dash = name.find('-');
+    if ((dash != std::string::npos) && dash && (strspn(name.c_str(), "0123456789") == dash)) {
+        name = name.substr(dash + 1);
+    }
+
+    const int count = b->MGetPinCount();
+    for (int i = 1; i <= count; i++) {
+        if (!strcasecmp(b->MGetPinName(i).c_str(), name.c_str())) {
+            return i;
+        }
+    }
+
+    const char* str = name.c_str();
+    if (!strncasecmp(str, "pin", 3)) {
+        str += 3;
+    }
+    char* end;
+    const long n = strtol(str, &end, 10);
+    if ((end != str) && (*end == 0) && (n > 0) && (n <= count)) {
+        return n;
+    }
+    return 0;
+}
+
+void CWaveCheck::Check(board* b) {
+    // queue reference transitions up to the end of the tolerance window
+    while (next_valid && (next_time <= (now + tolerance))) {
+        const int p = (next.id < var_pin.size()) ? var_pin[next.id] : -1;
+        if (p >= 0) {
+            pins[p].queue.push_back({next_time, (unsigned char)(next.bits & 1)});
+        }
+        next_valid = vcd.Next(&next);
+        next_time = next.time * inst_per_unit + 0.5;
+    }
+
+    const picpin* ppins = b->MGetPinsValues();
+
+    for (unsigned int i = 0; i < pins.size(); i++) {
+        wc_pin_t& p = pins[i];
+        const unsigned char value = ppins[p.pin - 1].value;
+
+        if (value != p.live) {
+            // simulated transition must match the next reference transition
+            p.live = value;
+            while (!p.queue.empty() && (p.queue.front().value == p.ref)) {
+                p.queue.pop_front();
+            }
+            if (p.queue.empty() || (p.queue.front().value != value)) {
+                char buff[256];
+                snprintf(buff, sizeof(buff), "FAIL at %.3f us: pin %i (%s) expected %c actual %i", now * 1e6 / freq,
+                         p.pin, b->MGetPinName(p.pin).c_str(), (p.ref == WC_UNKNOWN) ? 'x' : '0' + p.ref, value);
+                report = buff;
+                Finish(b, WC_FAIL);
+                return;
+            }
+            p.ref = value;
+            p.queue.pop_front();
+            checked++;
+        }
+
+        // reference transitions not seen in simulation until the end of tolerance window
+        while (!p.queue.empty()) {
+            const wc_event_t& ev = p.queue.front();
+            if ((ev.value == p.ref) || ((p.ref == WC_UNKNOWN) && (ev.value == p.live))) {
+                p.ref = ev.value;
+                p.queue.pop_front();
+                continue;
+            }
+            if (now > (ev.time + tolerance)) {
+                char buff[256];
+                snprintf(buff, sizeof(buff), "FAIL at %.3f us: pin %i (%s) expected %i actual %i",
+                         ev.time * 1e6 / freq, p.pin, b->MGetPinName(p.pin).c_str(), ev.value, p.live);
+                report = buff;
+                Finish(b, WC_FAIL);
+                return;
+            }
+            break;
+        }
+    }
+
+    if (!next_valid && (now > (end_time + tolerance))) {
+        char buff[256];
+        snprintf(buff, sizeof(buff), "PASS %lu transitions checked on %i pins in %.3f us", checked, (int)pins.size(),
+                 now * 1e6 / freq);
+        report = buff;
+        Finish(b, WC_PASS);
+    }
+}
+
+void CWaveCheck::Finish(board* b, const int result) {
+    running = 0;
+    status = result;
+    printf("PICSimLab: Wave check %s\n", report.c_str());
+    fflush(stdout);
+
+    if (exit_on_end) {
+        PICSimLab.SetToDestroy(RC_EXIT);
+    } else if (result == WC_FAIL) {
+        PICSimLab.SetSimulationRun(0);
+    }
+}
+
+std::string CWaveCheck::GetReport(void) {
+    std::lock_guard<std::mutex> guard(lock);
+    char buff[256];
+    switch (status) {
+        case WC_RUNNING:
+            snprintf(buff, sizeof(buff), "running, %lu transitions checked on %i pins", checked, (int)pins.size());
+            return buff;
+        case WC_PASS:
+        case WC_FAIL:
+            return report;
+        default:
+            return report.length() ? report : "stopped";
+    }
+}
+
+int CWaveCheck::GetExitCode(void) {
+    switch (status) {
+        case WC_PASS:
+            return 0;
+        case WC_FAIL:
+            return 1;
+        default:
+            return 2;
+    }
+}
@@ -0,0 +1,145 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#ifndef WAVE_CHECK_H
+#define WAVE_CHECK_H
+
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "board.h"
+#include "vcd_stream.h"
+
+enum { WC_IDLE, WC_RUNNING, WC_PASS, WC_FAIL };
+
+#define WC_UNKNOWN 2  // reference value not known yet
+
+typedef struct {
+    uint64_t time;  // instruction count
+    unsigned char value;
+} wc_event_t;
+
+typedef struct {
+    unsigned int pin;              // board pin
+    unsigned char live;            // simulated value
+    unsigned char ref;             // reference value
+    std::deque<wc_event_t> queue;  // reference transitions not checked yet
+} wc_pin_t;
+
+/**
+ * @brief Golden waveform regression check
+ *
+ * Board pin transitions are compared on the fly with a reference waveform (VCD or PWF). Reference
+ * variables are mapped to board pins by name ("N-NAME" as written by VCD Dump). A transition matches
+ * if the reference has the same transition on the same pin inside the tolerance window, the check
+ * stops at the first divergence.
+ */
+class CWaveCheck {
+public:
+    CWaveCheck();
+    ~CWaveCheck();
+
+    /**
+     * @brief  Load reference waveform and start check, tolerance in us
+     */
+    int Start(board* b, const char* fname, const double tolerance_us);
+
+    /**
+     * @brief  Stop check, result is kept until next Start
+     */
+    void Stop(void);
+
+    int IsRunning(void) { return running; };
+
+    /**
+     * @brief  Compare pins after count instructions (called from board instruction counter)
+     */
+    void Sample(board* b, const uint32_t count) {
+        // skipped while Start or Stop replace the reference
+        std::unique_lock<std::mutex> guard(lock, std::try_to_lock);
+        if (guard.owns_lock() && running) {
+            now += count;
+            Check(b);
+        }
+    };
+
+    int GetStatus(void) { return status; };
+
+    /**
+     * @brief  Return status text, on failure the first divergence (time, pin, expected and actual value)
+     */
+    std::string GetReport(void);
+
+    /**
+     * @brief  Return process exit code: 0 pass, 1 fail, 2 not finished or error
+     */
+    int GetExitCode(void);
+
+    /**
+     * @brief  Run simulation without real time sync while check is running
+     */
+    void SetFreeRun(const int fr) { free_run = fr; };
+
+    int GetFreeRun(void) { return free_run && running; };
+
+    /**
+     * @brief  Exit PICSimLab when check ends (command line mode)
+     */
+    void SetExitOnEnd(const int ee) { exit_on_end = ee; };
+
+    int GetExitOnEnd(void) { return exit_on_end; };
+
+    int GetPinCount(void) { return pins.size(); };
+
+private:
+    void Check(board* b);
+    void Finish(board* b, const int result);
+    int FindPin(board* b, const std::string& vname);
+    CVCDStream vcd;
+    std::vector<wc_pin_t> pins;
+    std::vector<int> var_pin;  // reference variable to pins index, -1 not mapped
+    vcdw_record_t next;
+    int next_valid;
+    uint64_t next_time;
+    double inst_per_unit;
+    uint64_t tolerance;
+    uint64_t now;
+    uint64_t end_time;
+    double freq;
+    unsigned long checked;
+    std::atomic<int> running;
+    int free_run;
+    int exit_on_end;
+    std::atomic<int> status;
+    std::string report;
+    std::mutex lock;  // held by Check and by Start, Stop and GetReport (remote control thread)
+};
+
+extern CWaveCheck WaveCheck;
+
+#endif  // WAVE_CHECK_H
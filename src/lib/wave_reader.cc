@@ -0,0 +1,357 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#include "wave_reader.h"
+
+#include <string.h>
+#include <zlib.h>
+
+#include "util.h"
+
+static int file_seek(FILE* fin, const uint64_t offset, const int whence) {
+#ifdef _WIN32
+    return _fseeki64(fin, offset, whence);
+#else
+    return fseeko(fin, offset, whence);
+#endif
+}
+
+static uint64_t file_tell(FILE* fin) {
+#ifdef _WIN32
+    return _ftelli64(fin);
+#else
+    return ftello(fin);
+#endif
+}
+
+static int get_u32(FILE* fin, uint32_t* v) {
+    unsigned char b[4];
+    if (fread(b, 4, 1, fin) != 1) {
+        return 0;
+    }
+    *v = 0;
+    for (int i = 3; i >= 0; i--) {
+        *v = (*v << 8) | b[i];
+    }
+    return 1;
+}
+
+static int get_u64(FILE* fin, uint64_t* v) {
+    unsigned char b[8];
+    if (fread(b, 8, 1, fin) != 1) {
+        return 0;
+    }
+    *v = 0;
+    for (int i = 7; i >= 0; i--) {
+        *v = (*v << 8) | b[i];
+    }
+    return 1;
+}
+
+static uint64_t get_varint(const std::vector<unsigned char>& buff, unsigned int* pos) {
+    uint64_t v = 0;
+    int shift = 0;
+    while (*pos < buff.size()) {
+        const unsigned char b = buff[(*pos)++];
+        v |= (uint64_t)(b & 0x7F) << shift;
+        shift += 7;
+        if (!(b & 0x80)) {
+            break;
+        }
+    }
+    return v;
+}
+
+CWaveReader::CWaveReader() {
+    fin = NULL;
+    rpos = 0;
+    rcount = 0;
+    cblock = 0;
+    rtime = 0;
+    dropped = 0;
+}
+
+CWaveReader::~CWaveReader() {
+    Close();
+}
+
+int CWaveReader::Open(const char* fname) {
+    char magic[4];
+    uint32_t size;
+
+    Close();
+
+    fin = fopen_UTF8(fname, "rb");
+    if (!fin) {
+        printf("PICSimLab: Error open waveform file \"%s\"!\n", fname);
+        return 0;
+    }
+
+    if ((fread(magic, 4, 1, fin) != 1) || memcmp(magic, PWF_MAGIC, 4) || !get_u32(fin, &size)) {
+        printf("PICSimLab: Invalid waveform file \"%s\"!\n", fname);
+        Close();
+        return 0;
+    }
+
+    header.resize(size);
+    if (size && (fread(&header[0], size, 1, fin) != 1)) {
+        Close();
+        return 0;
+    }
+
+    if (!get_u32(fin, &size)) {
+        Close();
+        return 0;
+    }
+    ids.resize(size);
+    for (unsigned int i = 0; i < ids.size(); i++) {
+        char code[256];
+        const int len = fgetc(fin);
+        if ((len < 0) || (len && (fread(code, len, 1, fin) != 1))) {
+            Close();
+            return 0;
+        }
+        ids[i].assign(code, len);
+    }
+
+    const uint64_t data_offset = file_tell(fin);
+    uint64_t index_offset = 0;
+    uint32_t count = 0;
+
+    // block index at end of file
+    if (!file_seek(fin, -12, SEEK_END) && get_u64(fin, &index_offset) && (fread(magic, 4, 1, fin) == 1) &&
+        !memcmp(magic, PWF_IMAGIC, 4) && !file_seek(fin, index_offset, SEEK_SET) && get_u32(fin, &count)) {
+        blocks.resize(count);
+        for (unsigned int i = 0; i < count; i++) {
+            get_u64(fin, &blocks[i].tstart);
+            get_u64(fin, &blocks[i].tend);
+            get_u64(fin, &blocks[i].offset);
+        }
+        get_u64(fin, &dropped);
+    } else {
+        // no index, walk the blocks headers
+        uint64_t offset = data_offset;
+        pwf_block_t blk;
+        uint32_t zsize;
+        file_seek(fin, 0, SEEK_END);
+        const uint64_t fsize = file_tell(fin);
+        file_seek(fin, offset, SEEK_SET);
+        while (get_u64(fin, &blk.tstart) && get_u64(fin, &blk.tend) && get_u32(fin, &count) && get_u32(fin, &size) &&
+               get_u32(fin, &zsize) && ((offset + 28 + zsize) <= fsize)) {
+            blk.offset = offset;
+            blocks.push_back(blk);
+            offset += 28 + zsize;
+            file_seek(fin, offset, SEEK_SET);
+        }
+    }
+
+    LoadBlock(0);
+    return 1;
+}
+
+void CWaveReader::Close(void) {
+    if (fin) {
+        fclose(fin);
+        fin = NULL;
+    }
+    header.clear();
+    ids.clear();
+    blocks.clear();
+    raw.clear();
+    rpos = 0;
+    rcount = 0;
+    cblock = 0;
+    dropped = 0;
+}
+
+int CWaveReader::LoadBlock(const unsigned int n) {
+    uint64_t tstart, tend;
+    uint32_t count, size, zsize;
+
+    cblock = n;
+    rcount = 0;
+
+    if ((n >= blocks.size()) || file_seek(fin, blocks[n].offset, SEEK_SET)) {
+        return 0;
+    }
+
+    if (!get_u64(fin, &tstart) || !get_u64(fin, &tend) || !get_u32(fin, &count) || !get_u32(fin, &size) ||
+        !get_u32(fin, &zsize)) {
+        return 0;
+    }
+
+    std::vector<unsigned char> zdata(zsize);
+    if (fread(zdata.data(), zsize, 1, fin) != 1) {
+        return 0;
+    }
+
+    uLongf rsize = size;
+    raw.resize(size);
+    if (uncompress(raw.data(), &rsize, zdata.data(), zsize) != Z_OK) {
+        return 0;
+    }
+
+    rpos = 0;
+    rcount = count;
+    rtime = tstart;
+    return 1;
+}
+
+int CWaveReader::Decode(vcdw_record_t* rec) {
+    rtime += get_varint(raw, &rpos);
+    const uint64_t key = get_varint(raw, &rpos);
+
+    rec->time = rtime;
+    rec->id = key >> 2;
+    rec->bits = 0;
+    rec->value = 0;
+    switch (key & 3) {
+        case 0:
+        case 1:
+            rec->type = VCDW_BIT;
+            rec->width = 1;
+            rec->bits = key & 1;
+            break;
+        case 2: {
+            uint32_t f = 0;
+            if ((rpos + 4) > raw.size()) {
+                rcount = 0;
+                return 0;
+            }
+            for (int i = 3; i >= 0; i--) {
+                f = (f << 8) | raw[rpos + i];
+            }
+            rpos += 4;
+            rec->type = VCDW_REAL;
+            rec->width = 32;
+            memcpy(&rec->value, &f, 4);
+        } break;
+        case 3:
+            if (rpos >= raw.size()) {
+                rcount = 0;
+                return 0;
+            }
+            rec->type = VCDW_VECTOR;
+            rec->width = raw[rpos++];
+            if (rec->width > 64) {
+                rec->width = 64;
+            }
+            rec->bits = get_varint(raw, &rpos);
+            break;
+    }
+    rcount--;
+    return 1;
+}
+
+int CWaveReader::Seek(const uint64_t time) {
+    // last block starting before time
+    unsigned int lo = 0;
+    unsigned int hi = blocks.size();
+    while (lo < hi) {
+        const unsigned int mid = (lo + hi) / 2;
+        if (blocks[mid].tstart <= time) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    unsigned int n = lo ? lo - 1 : 0;
+
+    while ((n < blocks.size()) && (blocks[n].tend < time)) {
+        n++;
+    }
+
+    if (!LoadBlock(n)) {
+        return 0;
+    }
+
+    // skip records before time
+    while (rcount) {
+        const unsigned int pos = rpos;
+        const uint64_t ptime = rtime;
+        vcdw_record_t rec;
+        Decode(&rec);
+        if (rec.time >= time) {
+            rpos = pos;
+            rtime = ptime;
+            rcount++;
+            break;
+        }
+    }
+    return 1;
+}
+
+int CWaveReader::Next(vcdw_record_t* rec) {
+    while (!rcount) {
+        if (((cblock + 1) >= blocks.size()) || !LoadBlock(cblock + 1)) {
+            return 0;
+        }
+    }
+    return Decode(rec);
+}
+
+int CWaveReader::ExportVCD(const char* fname) {
+    if (!fin) {
+        return 0;
+    }
+
+    FILE* fout = fopen_UTF8(fname, "w");
+    if (!fout) {
+        printf("PICSimLab: Error open VCD file \"%s\"!\n", fname);
+        return 0;
+    }
+
+    fwrite(header.c_str(), header.size(), 1, fout);
+
+    vcdw_record_t rec;
+    uint64_t ltime = 0;
+    Seek(0);
+    while (Next(&rec)) {
+        const char* code = (rec.id < ids.size()) ? ids[rec.id].c_str() : "?";
+        if (rec.time != ltime) {
+            ltime = rec.time;
+            fprintf(fout, "#%llu\n", (unsigned long long)ltime);
+        }
+        if (rec.type == VCDW_BIT) {
+            fprintf(fout, "%i%s\n", (int)rec.bits, code);
+        } else if (rec.type == VCDW_VECTOR) {
+            char bits[65];
+            for (int b = 0; b < rec.width; b++) {
+                bits[b] = '0' + ((rec.bits >> (rec.width - 1 - b)) & 1);
+            }
+            bits[rec.width] = 0;
+            fprintf(fout, "b%s %s\n", bits, code);
+        } else {
+            fprintf(fout, "r%f %s\n", rec.value, code);
+        }
+    }
+
+    if (dropped) {
+        fprintf(fout, "$comment %llu changes dropped, writer ring full $end\n", (unsigned long long)dropped);
+    }
+
+    fclose(fout);
+    return 1;
+}
@@ -0,0 +1,102 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#ifndef WAVE_READER_H
+#define WAVE_READER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "vcd_writer.h"
+
+typedef struct {
+    uint64_t tstart;
+    uint64_t tend;
+    uint64_t offset;
+} pwf_block_t;
+
+/**
+ * @brief Reader of PICSimLab binary waveform files written by CVCDWriter
+ *
+ * Only the block index is kept in memory, Seek uses it to load the single block containing the requested
+ * time. Files without index (recording not closed) are indexed by walking the block headers.
+ */
+class CWaveReader {
+public:
+    CWaveReader();
+    ~CWaveReader();
+
+    /**
+     * @brief  Open file and load header, identifiers and block index
+     */
+    int Open(const char* fname);
+
+    void Close(void);
+
+    const std::string& GetHeader(void) { return header; };
+
+    unsigned int GetIdCount(void) { return ids.size(); };
+
+    const char* GetId(const unsigned int id) { return ids[id].c_str(); };
+
+    uint64_t GetStartTime(void) { return blocks.size() ? blocks[0].tstart : 0; };
+
+    uint64_t GetEndTime(void) { return blocks.size() ? blocks.back().tend : 0; };
+
+    uint64_t GetDropped(void) { return dropped; };
+
+    /**
+     * @brief  Position reader at first record with time greater or equal to time
+     */
+    int Seek(const uint64_t time);
+
+    /**
+     * @brief  Read next record, return 0 at end of file
+     */
+    int Next(vcdw_record_t* rec);
+
+    /**
+     * @brief  Convert waveform to a text VCD file
+     */
+    int ExportVCD(const char* fname);
+
+private:
+    int LoadBlock(const unsigned int n);
+    int Decode(vcdw_record_t* rec);
+    FILE* fin;
+    std::string header;
+    std::vector<std::string> ids;
+    std::vector<pwf_block_t> blocks;
+    std::vector<unsigned char> raw;
+    unsigned int rpos;
+    unsigned int rcount;
+    unsigned int cblock;
+    uint64_t rtime;
+    uint64_t dropped;
+};
+
+#endif  // WAVE_READER_H
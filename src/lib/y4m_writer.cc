@@ -0,0 +1,192 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#include "y4m_writer.h"
+
+#include <algorithm>
+
+#include "util.h"
+
+CY4MWriter::CY4MWriter() {
+    fout = NULL;
+    width = 0;
+    height = 0;
+    fps = 25;
+    running = 0;
+#ifndef _NOTHREAD
+    worker = NULL;
+#endif
+    written = 0;
+}
+
+CY4MWriter::~CY4MWriter() {
+    Close();
+}
+
+int CY4MWriter::Open(const char* fname, const int width_, const int height_, const unsigned int fps_) {
+    Close();
+
+    if ((width_ <= 0) || (height_ <= 0) || (width_ & 1) || (height_ & 1) || !fps_) {
+        return 0;
+    }
+
+    fout = fopen_UTF8(fname, "wb");
+    if (!fout) {
+        printf("PICSimLab: Error open video file \"%s\"!\n", fname);
+        return 0;
+    }
+
+    width = width_;
+    height = height_;
+    fps = fps_;
+    written = 0;
+    yuv.resize(width * height * 3 / 2);
+    fprintf(fout, "YUV4MPEG2 W%i H%i F%u:1 Ip A1:1 C420jpeg XPICSimLab\n", width, height, fps);
+
+    running = 1;
+#ifndef _NOTHREAD
+    worker = new std::thread(&CY4MWriter::Worker, this);
+#endif
+    return 1;
+}
+
+void CY4MWriter::Close(void) {
+#ifdef _NOTHREAD
+    running = 0;
+#else
+    if (worker) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            running = 0;
+        }
+        cond.notify_all();
+        worker->join();
+        delete worker;
+        worker = NULL;
+    }
+#endif
+
+    if (fout) {
+        fclose(fout);
+        fout = NULL;
+        printf("PICSimLab: Video capture %llu frames written\n", (unsigned long long)written);
+    }
+    queue.clear();
+    pool.clear();
+    yuv.clear();
+}
+
+void CY4MWriter::Push(std::vector<unsigned int>& pixels, const uint64_t time, const unsigned int count) {
+    if (!fout || !count || (pixels.size() != (size_t)(width * height))) {
+        return;
+    }
+
+#ifdef _NOTHREAD
+    Write(pixels.data(), time, count);
+#else
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [this] { return queue.size() < Y4MW_QUEUE_SIZE; });
+
+    queue.push_back({std::vector<unsigned int>(), time, count});
+    queue.back().pixels.swap(pixels);
+    if (pool.size()) {
+        // give back a used buffer to the caller
+        pixels.swap(pool.back());
+        pool.pop_back();
+    }
+    lock.unlock();
+    cond.notify_all();
+#endif
+}
+
+// RGB to YCbCr 4:2:0 (JPEG full range), chroma is the average of each 2x2 block
+void CY4MWriter::Convert(const unsigned int* pixels) {
+    unsigned char* py = yuv.data();
+    unsigned char* pu = py + width * height;
+    unsigned char* pv = pu + (width / 2) * (height / 2);
+
+    for (int y = 0; y < height; y += 2) {
+        const unsigned int* l0 = pixels + y * width;
+        const unsigned int* l1 = l0 + width;
+        unsigned char* y0 = py + y * width;
+        unsigned char* y1 = y0 + width;
+        for (int x = 0; x < width; x += 2) {
+            int r = 0, g = 0, b = 0;
+            const unsigned int p[4] = {l0[x], l0[x + 1], l1[x], l1[x + 1]};
+            for (int i = 0; i < 4; i++) {
+                const int pr = p[i] >> 16;
+                const int pg = (p[i] >> 8) & 0xFF;
+                const int pb = p[i] & 0xFF;
+                const int luma = (77 * pr + 150 * pg + 29 * pb + 128) >> 8;
+                ((i < 2) ? y0 : y1)[x + (i & 1)] = luma;
+                r += pr;
+                g += pg;
+                b += pb;
+            }
+            // sums of 4 pixels, scale 1/(4 * 256)
+            *pu++ = std::min(255, ((-43 * r - 85 * g + 128 * b + 512) >> 10) + 128);
+            *pv++ = std::min(255, ((128 * r - 107 * g - 21 * b + 512) >> 10) + 128);
+        }
+    }
+}
+
+void CY4MWriter::Write(const unsigned int* pixels, const uint64_t time, const unsigned int count) {
+    const uint64_t period = 1000000 / fps;
+
+    Convert(pixels);
+    for (unsigned int i = 0; i < count; i++) {
+        fprintf(fout, "FRAME XVT=%llu\n", (unsigned long long)(time + i * period));
+        fwrite(yuv.data(), yuv.size(), 1, fout);
+    }
+    written += count;
+}
+
+#ifndef _NOTHREAD
+void CY4MWriter::Worker(void) {
+    while (1) {
+        y4mw_frame_t frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cond.wait(lock, [this] { return queue.size() || !running; });
+            if (queue.empty()) {
+                break;  // stopped and all frames written
+            }
+            frame.pixels.swap(queue.front().pixels);
+            frame.time = queue.front().time;
+            frame.count = queue.front().count;
+            queue.pop_front();
+        }
+        cond.notify_all();
+
+        Write(frame.pixels.data(), frame.time, frame.count);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (pool.size() < Y4MW_QUEUE_SIZE) {
+            pool.push_back(std::vector<unsigned int>());
+            pool.back().swap(frame.pixels);
+        }
+    }
+}
+#endif
@@ -0,0 +1,108 @@
+/* ########################################################################
+
+   PICSimLab - Programmable IC Simulator Laboratory
+
+   ########################################################################
+
+   Copyright (c) : 2010-2024  Luis Claudio Gambôa Lopes <lcgamboa@yahoo.com>
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program; if not, write to the Free Software
+   Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+
+   For e-mail suggestions :  lcgamboa@yahoo.com
+   ######################################################################## */
+
+#ifndef Y4M_WRITER_H
+#define Y4M_WRITER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+#ifndef _NOTHREAD
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+#define Y4MW_QUEUE_SIZE 8  // frames waiting conversion
+
+typedef struct {
+    std::vector<unsigned int> pixels;  // 0x00RRGGBB
+    uint64_t time;                     // virtual time of first frame in us
+    unsigned int count;                // frame repetitions
+} y4mw_frame_t;
+
+/**
+ * @brief Asynchronous YUV4MPEG2 (Y4M) video writer
+ *
+ * Frames are queued by the GUI thread and a worker thread converts them to YUV 4:2:0 (full range) and
+ * writes them to the file. Each frame header carries its virtual time in us (XVT=), frames not drawn in
+ * time are written as repetitions of the last drawn frame, so the video follows the simulation time and
+ * not the real time. When the queue is full Push waits, no frame is dropped. Without threads (_NOTHREAD)
+ * Push converts and writes the frame itself.
+ */
+class CY4MWriter {
+public:
+    CY4MWriter();
+    ~CY4MWriter();
+
+    /**
+     * @brief  Open file and start worker thread, frame size must be even
+     */
+    int Open(const char* fname, const int width, const int height, const unsigned int fps);
+
+    /**
+     * @brief  Write pending frames, stop worker thread and close file
+     */
+    void Close(void);
+
+    int IsOpen(void) { return fout != NULL; };
+
+    int GetWidth(void) { return width; };
+
+    int GetHeight(void) { return height; };
+
+    unsigned int GetFps(void) { return fps; };
+
+    /**
+     * @brief  Queue count repetitions of frame starting at virtual time (us), pixels is swapped with an empty buffer
+     */
+    void Push(std::vector<unsigned int>& pixels, const uint64_t time, const unsigned int count);
+
+    uint64_t GetWritten(void) { return written; };
+
+private:
+    void Worker(void);
+    void Convert(const unsigned int* pixels);
+    void Write(const unsigned int* pixels, const uint64_t time, const unsigned int count);
+    FILE* fout;
+    int width;
+    int height;
+    unsigned int fps;
+    std::deque<y4mw_frame_t> queue;
+    std::vector<std::vector<unsigned int>> pool;  // free frame buffers
+    int running;
+#ifndef _NOTHREAD
+    std::mutex mutex;
+    std::condition_variable cond;
+    std::thread* worker;
+#endif
+    std::vector<unsigned char> yuv;
+    std::atomic<uint64_t> written;
+};
+
+#endif  // Y4M_WRITER_H
@@ -417,7 +417,7 @@ void cpart_LCD_hd44780::LoadPartImage(void) {
         output[i].update = 1;
     }
 
-    lcd.update = 1;
+    lcd_redraw(&lcd);
 }
 
 part_init(PART_LCD_HD44780_Name, cpart_LCD_hd44780, "Output");
@@ -66,6 +66,10 @@ cpart_LCD_ili9341::cpart_LCD_ili9341(const unsigned x, const unsigned y, const c
     Y = y;
 
     BitmapId = -1;
+
+    // power pins labels
+    SetOutputStatic(O_F1);
+    SetOutputStatic(O_F2);
     type_com = -1;
     ChangeType(TC_SPI);
 
@@ -43,6 +43,11 @@ cpart_LCD_pcd8544::cpart_LCD_pcd8544(const unsigned x, const unsigned y, const c
     ReadMaps();
     BitmapId = -1;
 
+    // power pins labels
+    SetOutputStatic(O_F1);
+    SetOutputStatic(O_F2);
+    SetOutputStatic(O_F3);
+
     LoadPartImage();
 
     lcd_pcd8544_init(&lcd);
@@ -44,6 +44,13 @@ cpart_LCD_pcf8833::cpart_LCD_pcf8833(const unsigned x, const unsigned y, const c
     ReadMaps();
     BitmapId = -1;
 
+    // power pins labels
+    SetOutputStatic(O_F1);
+    SetOutputStatic(O_F2);
+    SetOutputStatic(O_F3);
+    SetOutputStatic(O_F4);
+    SetOutputStatic(O_F5);
+
     LoadPartImage();
 
     lcd_pcf8833_init(&lcd);
@@ -43,6 +43,10 @@ cpart_LCD_ssd1306::cpart_LCD_ssd1306(const unsigned x, const unsigned y, const c
     ReadMaps();
     BitmapId = -1;
 
+    // power pins labels
+    SetOutputStatic(O_F1);
+    SetOutputStatic(O_F2);
+
     LoadPartImage();
 
     lcd_ssd1306_init(&lcd);
@@ -126,6 +126,7 @@ void cpart_led_ws2812b::LoadPartImage(void) {
         yoff = 0;
         part::LoadPartImage();
     }
+    led_ws2812b_redraw(&led);
 }
 
 void cpart_led_ws2812b::DrawOutput(const unsigned int i) {
@@ -179,7 +180,6 @@ void cpart_led_ws2812b::DrawOutput(const unsigned int i) {
         case O_LED:
             // draw led text
             if (led.update) {
-                SpareParts.CanvasCmd({.cmd = CC_SETCOLOR, .SetColor{0, 90 + 40, 0}});
                 led_ws2812b_draw(&led, SpareParts.CanvasCmd, output[i].x1, output[i].y1 + yoff,
                                  output[i].x2 - output[i].x1, output[i].y2 - output[i].y1, 1);
             }
@@ -306,9 +306,10 @@ void cpart_led_ws2812b::PreProcess(void) {
 void cpart_led_ws2812b::Process(void) {
     const picpin* ppins = SpareParts.GetPinsValues();
 
-    if (input_pins[0] > 0) {
+    // decode only on DIN edges
+    if ((input_pins[0] > 0) && (ppins[input_pins[0] - 1].value != led.adin)) {
         unsigned char out;
-        out = led_ws2812b_io(&led, ppins[input_pins[0] - 1].value);
+        out = led_ws2812b_io(&led, ppins[input_pins[0] - 1].value, pboard->GetInstCounter());
 
         if (out != ppins[output_pins[0] - 1].value) {
             SpareParts.WritePin(output_pins[0], out);
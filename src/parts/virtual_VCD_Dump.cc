@@ -28,12 +28,39 @@
 #include "../lib/oscilloscope.h"
 #include "../lib/picsimlab.h"
 #include "../lib/spareparts.h"
+#include "../lib/wave_reader.h"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #endif
 
-static const char markers[] = "!$%&[()]";
+// parse a list of numbers and ranges: "20,21,30-37"
+static int parse_list(const char* text, unsigned char* list, const int max) {
+    int count = 0;
+    const char* ptr = text;
+
+    while (*ptr && (count < max)) {
+        char* end;
+        long first = strtol(ptr, &end, 10);
+        if (end == ptr) {
+            ptr++;
+            continue;
+        }
+        long last = first;
+        ptr = end;
+        if (*ptr == '-') {
+            last = strtol(ptr + 1, &end, 10);
+            if (end == (ptr + 1)) {
+                last = first;
+            }
+            ptr = end;
+        }
+        for (long v = first; (v <= last) && (count < max); v++) {
+            list[count++] = ((v > 0) && (v < 256)) ? v : 0;
+        }
+    }
+    return count;
+}
 
 /* outputs */
 enum { O_P1, O_P2, O_P3, O_P4, O_P5, O_P6, O_P7, O_P8, O_L1, O_L2, O_L3, O_L4, O_L5, O_L6, O_L7, O_L8, O_NAME, O_REC };
@@ -41,32 +68,19 @@ enum { O_P1, O_P2, O_P3, O_P4, O_P5, O_P6, O_P7, O_P8, O_L1, O_L2, O_L3, O_L4, O
 /*inputs*/
 enum { I_START, I_VIEW };
 
-static PCWProp pcwprop[9] = {{PCW_COMBO, "Pin 1"}, {PCW_COMBO, "Pin 2"}, {PCW_COMBO, "Pin 3"},
-                             {PCW_COMBO, "Pin 4"}, {PCW_COMBO, "Pin 5"}, {PCW_COMBO, "Pin 6"},
-                             {PCW_COMBO, "Pin 7"}, {PCW_COMBO, "Pin 8"}, {PCW_END, ""}};
+static PCWProp pcwprop[12] = {{PCW_COMBO, "Pin 1"}, {PCW_COMBO, "Pin 2"}, {PCW_COMBO, "Pin 3"},
+                              {PCW_COMBO, "Pin 4"}, {PCW_COMBO, "Pin 5"}, {PCW_COMBO, "Pin 6"},
+                              {PCW_COMBO, "Pin 7"}, {PCW_COMBO, "Pin 8"}, {PCW_COMBO, "Format"},
+                              {PCW_EDIT, "Pins 9+"}, {PCW_EDIT, "Buses"}, {PCW_END, ""}};
 
 cpart_VCD_Dump::cpart_VCD_Dump(const unsigned x, const unsigned y, const char* name, const char* type, board* pboard_,
                                const int id_)
     : part(x, y, name, type, pboard_, id_) {
     always_update = 1;
 
-    input_pins[0] = 0;
-    input_pins[1] = 0;
-    input_pins[2] = 0;
-    input_pins[3] = 0;
-    input_pins[4] = 0;
-    input_pins[5] = 0;
-    input_pins[6] = 0;
-    input_pins[7] = 0;
-
-    old_value_pins[0] = 2;
-    old_value_pins[1] = 2;
-    old_value_pins[2] = 2;
-    old_value_pins[3] = 2;
-    old_value_pins[4] = 2;
-    old_value_pins[5] = 2;
-    old_value_pins[6] = 2;
-    old_value_pins[7] = 2;
+    memset(input_pins, 0, VCD_DUMP_MAX);
+    nchannels = 8;
+    old_bits = 0;
 
     char tname[128];
     PICSimLab.SystemCmd(PSC_GETTEMPDIR, NULL, tname);
@@ -76,16 +90,21 @@ cpart_VCD_Dump::cpart_VCD_Dump(const unsigned x, const unsigned y, const char* n
 
     strncat(f_vcd_name, ".vcd", 200);
 
-    f_vcd = fopen_UTF8(f_vcd_name, "w");
-    fclose(f_vcd);
-    f_vcd = NULL;
+    strncpy(f_pwf_name, f_vcd_name, 200);
+    strcpy(f_pwf_name + strlen(f_pwf_name) - 4, ".pwf");
+
+    FILE* fout = fopen_UTF8(f_vcd_name, "w");
+    if (fout) {
+        fclose(fout);
+    }
 
     rec = 0;
+    format = VCDW_VCD;
     vcd_count = 0;
 
     SetPCWProperties(pcwprop);
 
-    PinCount = 8;
+    PinCount = nchannels;
     Pins = input_pins;
 }
 
@@ -99,11 +118,9 @@ cpart_VCD_Dump::~cpart_VCD_Dump(void) {
     SpareParts.CanvasCmd({.cmd = CC_FREEBITMAP, .FreeBitmap{BitmapId}});
     SpareParts.CanvasCmd({.cmd = CC_DESTROY});
 
-    if (f_vcd) {
-        fclose(f_vcd);
-        f_vcd = NULL;
-    }
+    vcd.Close();
     unlink(f_vcd_name);
+    unlink(f_pwf_name);
 }
 
 void cpart_VCD_Dump::DrawOutput(const unsigned int i) {
@@ -231,17 +248,35 @@ unsigned short cpart_VCD_Dump::GetOutputId(char* name) {
 }
 
 std::string cpart_VCD_Dump::WritePreferences(void) {
-    char prefs[256];
+    char prefs[1024];
+    // avoid save empty fields
+    std::string extra = extra_pins.length() ? extra_pins : " ";
+    std::string bus = buses.length() ? buses : " ";
 
-    sprintf(prefs, "%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu", input_pins[0], input_pins[1], input_pins[2],
-            input_pins[3], input_pins[4], input_pins[5], input_pins[6], input_pins[7], rec);
+    snprintf(prefs, sizeof(prefs), "%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%.256s%%%.256s", input_pins[0],
+             input_pins[1], input_pins[2], input_pins[3], input_pins[4], input_pins[5], input_pins[6], input_pins[7],
+             rec, format, extra.c_str(), bus.c_str());
 
     return prefs;
 }
 
 void cpart_VCD_Dump::ReadPreferences(std::string value) {
-    sscanf(value.c_str(), "%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu", &input_pins[0], &input_pins[1],
-           &input_pins[2], &input_pins[3], &input_pins[4], &input_pins[5], &input_pins[6], &input_pins[7], &rec);
+    char extra[512] = " ";
+    char bus[512] = " ";
+
+    sscanf(value.c_str(), "%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%511[^%%]%%%511[^\n]", &input_pins[0],
+           &input_pins[1], &input_pins[2], &input_pins[3], &input_pins[4], &input_pins[5], &input_pins[6],
+           &input_pins[7], &rec, &format, extra, bus);
+    format &= 0x01;
+
+    extra_pins = strcmp(extra, " ") ? extra : "";
+    buses = strcmp(bus, " ") ? bus : "";
+    ChangeChannels();
+}
+
+void cpart_VCD_Dump::ChangeChannels(void) {
+    nchannels = 8 + parse_list(extra_pins.c_str(), input_pins + 8, VCD_DUMP_MAX - 8);
+    PinCount = nchannels;
 }
 
 void cpart_VCD_Dump::ConfigurePropertiesWindow(void) {
@@ -253,6 +288,12 @@ void cpart_VCD_Dump::ConfigurePropertiesWindow(void) {
     SetPCWComboWithPinNames("combo6", input_pins[5]);
     SetPCWComboWithPinNames("combo7", input_pins[6]);
     SetPCWComboWithPinNames("combo8", input_pins[7]);
+
+    SpareParts.WPropCmd("combo9", PWA_COMBOSETITEMS, "VCD,PWF,");
+    SpareParts.WPropCmd("combo9", PWA_COMBOSETTEXT, (format == VCDW_PWF) ? "PWF" : "VCD");
+
+    SpareParts.WPropCmd("edit10", PWA_EDITSETTEXT, extra_pins.c_str());
+    SpareParts.WPropCmd("edit11", PWA_EDITSETTEXT, buses.c_str());
 }
 
 void cpart_VCD_Dump::ReadPropertiesWindow(void) {
@@ -264,92 +305,138 @@ void cpart_VCD_Dump::ReadPropertiesWindow(void) {
     input_pins[5] = GetPWCComboSelectedPin("combo6");
     input_pins[6] = GetPWCComboSelectedPin("combo7");
     input_pins[7] = GetPWCComboSelectedPin("combo8");
+
+    char buff[512];
+    SpareParts.WPropCmd("combo9", PWA_COMBOGETTEXT, NULL, buff);
+    format = strcmp(buff, "PWF") ? VCDW_VCD : VCDW_PWF;
+
+    SpareParts.WPropCmd("edit10", PWA_EDITGETTEXT, NULL, buff);
+    extra_pins = buff;
+    SpareParts.WPropCmd("edit11", PWA_EDITGETTEXT, NULL, buff);
+    buses = buff;
+    ChangeChannels();
 }
 
 void cpart_VCD_Dump::PreProcess(void) {
-    if (rec && (f_vcd == NULL)) {
+    if (rec && !vcd.IsOpen()) {
         float tscale = 1.0e12 / pboard->MGetInstClockFreq();  // ps step
 
-        f_vcd = fopen_UTF8(f_vcd_name, "w");
+        vcd.Open((format == VCDW_PWF) ? f_pwf_name : f_vcd_name, format);
         vcd_count = 0;
+        old_bits = 0;
+
+        vcd.Printf("$version Generated by PICSimLab $end\n"
+                   "$timescale %ips $end\n"
+                   "$scope module logic $end\n",
+                   (int)tscale);
+
+        // buses: "name:first-last" channel ranges separated by ';'
+        signed char bus_first[VCD_DUMP_MAX];
+        unsigned char bus_width[VCD_DUMP_MAX];
+        std::string bus_name[VCD_DUMP_MAX];
+        memset(bus_first, -1, VCD_DUMP_MAX);
+        size_t pos = 0;
+        while (pos < buses.length()) {
+            size_t end = buses.find(';', pos);
+            if (end == std::string::npos) {
+                end = buses.length();
+            }
+            const std::string item = buses.substr(pos, end - pos);
+            const size_t sep = item.find(':');
+            unsigned char range[VCD_DUMP_MAX];
+            const int count = (sep != std::string::npos) ? parse_list(item.c_str() + sep + 1, range, VCD_DUMP_MAX) : 0;
+            const int first = count ? range[0] - 1 : -1;
+            const int width = count ? range[count - 1] - range[0] + 1 : 0;
+            int valid = (first >= 0) && (width > 0) && ((first + width) <= nchannels);
+            for (int i = first; valid && (i < (first + width)); i++) {
+                valid = (bus_first[i] < 0);
+            }
+            if (valid) {
+                for (int i = first; i < (first + width); i++) {
+                    bus_first[i] = first;
+                }
+                bus_width[first] = width;
+                bus_name[first] = item.substr(0, sep);
+            }
+            pos = end + 1;
+        }
+
+        vars.clear();
+        for (int i = 0; i < nchannels; i++) {
+            vcd_dump_var_t var;
+            char name[300];
+            if (bus_first[i] == i) {
+                var.first = i;
+                var.width = bus_width[i];
+                snprintf(name, sizeof(name), "%s [%i:0]", bus_name[i].c_str(), var.width - 1);
+            } else if ((bus_first[i] < 0) && input_pins[i]) {
+                var.first = i;
+                var.width = 1;
+                snprintf(name, sizeof(name), "%i-%s", i + 1, (const char*)SpareParts.GetPinName(input_pins[i]).c_str());
+            } else {
+                continue;
+            }
+            var.mask = ((var.width < 64) ? ((1ULL << var.width) - 1) : ~0ULL) << var.first;
+            var.id = vcd.AddVar("wire", var.width, name);
+            vars.push_back(var);
+        }
+
+        vcd.Printf("$upscope $end\n"
+                   "$enddefinitions $end\n"
+                   "$dumpvars\n");
 
-        fprintf(f_vcd,
-                "$version Generated by PICSimLab $end\n"
-                "$timescale %ips $end\n"
-                "$scope module logic $end\n",
-                (int)tscale);
-
-        if (input_pins[0])
-            fprintf(f_vcd, "$var wire 1 !  1-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[0]).c_str());
-        if (input_pins[1])
-            fprintf(f_vcd, "$var wire 1 $  2-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[1]).c_str());
-        if (input_pins[2])
-            fprintf(f_vcd, "$var wire 1 %%  3-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[2]).c_str());
-        if (input_pins[3])
-            fprintf(f_vcd, "$var wire 1 &  4-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[3]).c_str());
-        if (input_pins[4])
-            fprintf(f_vcd, "$var wire 1 [  5-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[4]).c_str());
-        if (input_pins[5])
-            fprintf(f_vcd, "$var wire 1 (  6-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[5]).c_str());
-        if (input_pins[6])
-            fprintf(f_vcd, "$var wire 1 )  7-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[6]).c_str());
-        if (input_pins[7])
-            fprintf(f_vcd, "$var wire 1 ]  8-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[7]).c_str());
-
-        fprintf(f_vcd,
-                "$upscope $end\n"
-                "$enddefinitions $end\n"
-                "$dumpvars\n");
-
-        if (input_pins[0])
-            fprintf(f_vcd, "x!\n");
-        if (input_pins[1])
-            fprintf(f_vcd, "x$\n");
-        if (input_pins[2])
-            fprintf(f_vcd, "x%%\n");
-        if (input_pins[3])
-            fprintf(f_vcd, "x&\n");
-        if (input_pins[4])
-            fprintf(f_vcd, "x[\n");
-        if (input_pins[5])
-            fprintf(f_vcd, "x(\n");
-        if (input_pins[6])
-            fprintf(f_vcd, "x)\n");
-        if (input_pins[7])
-            fprintf(f_vcd, "x[\n");
-        fprintf(f_vcd, "$end\n");
-    } else if (!rec && (f_vcd != NULL)) {
-        if (f_vcd) {
-            fclose(f_vcd);
-            f_vcd = NULL;
+        for (unsigned int i = 0; i < vars.size(); i++) {
+            if (vars[i].width == 1) {
+                vcd.Printf("x%s\n", CVCDWriter::MakeId(vars[i].id).c_str());
+            } else {
+                vcd.Printf("bx %s\n", CVCDWriter::MakeId(vars[i].id).c_str());
+            }
         }
+        vcd.Printf("$end\n");
+
+        vcd.Start();
+    } else if (!rec && vcd.IsOpen()) {
+        vcd.Close();
     }
 }
 
 void cpart_VCD_Dump::Process(void) {
-    if (rec && f_vcd) {
+    if (rec && vcd.IsOpen()) {
         const picpin* ppins = SpareParts.GetPinsValues();
 
         vcd_count++;
-        int tprint = 0;
-
-        for (int i = 0; i < 8; i++) {
-            if (input_pins[i] != 0) {
-                if (ppins[input_pins[i] - 1].value != old_value_pins[i]) {
-                    if (!tprint) {
-                        tprint = 1;
-                        fprintf(f_vcd, "#%li\n", vcd_count);
+
+        // pack channels and compare all at once
+        uint64_t bits = 0;
+        for (int i = 0; i < nchannels; i++) {
+            if (input_pins[i]) {
+                bits |= (uint64_t)(ppins[input_pins[i] - 1].value & 1) << i;
+            }
+        }
+
+        uint64_t changed = bits ^ old_bits;
+        if (vcd_count == 1) {
+            changed = ~0ULL;
+        }
+
+        if (changed) {
+            for (unsigned int i = 0; i < vars.size(); i++) {
+                if (changed & vars[i].mask) {
+                    if (vars[i].width == 1) {
+                        vcd.Bit(vcd_count, vars[i].id, (bits >> vars[i].first) & 1);
+                    } else {
+                        vcd.Vector(vcd_count, vars[i].id, vars[i].width, (bits & vars[i].mask) >> vars[i].first);
                     }
-                    old_value_pins[i] = ppins[input_pins[i] - 1].value;
-                    fprintf(f_vcd, "%i%c\n", old_value_pins[i], markers[i]);
-                    fflush(f_vcd);
                 }
             }
+            old_bits = bits;
         }
     }
 }
 
 void cpart_VCD_Dump::PostProcess(void) {
+    vcd.Update();
+
     const picpin* ppins = SpareParts.GetPinsValues();
 
     for (int i = 0; i < 8; i++) {
@@ -388,8 +475,14 @@ void cpart_VCD_Dump::OnMouseButtonPress(unsigned int inputId, unsigned int butto
                     document.body.removeChild(element);
                     URL.revokeObjectURL(text);
                 },
-                f_vcd_name);
+                (format == VCDW_PWF) ? f_pwf_name : f_vcd_name);
 #else
+            if (format == VCDW_PWF) {
+                CWaveReader wave;
+                if (wave.Open(f_pwf_name)) {
+                    wave.ExportVCD(f_vcd_name);
+                }
+            }
             PICSimLab.SystemCmd(PSC_LAUNCHDEFAULAPPLICATION, f_vcd_name);
 #endif
             break;
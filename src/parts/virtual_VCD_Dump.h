@@ -27,9 +27,19 @@
 #define PART_VCD_DUMP_H
 
 #include "../lib/part.h"
+#include "../lib/vcd_writer.h"
 
 #define PART_VCD_DUMP_Name "VCD Dump"
 
+#define VCD_DUMP_MAX 64  // max number of channels, 8 in part picture and the others in "Pins 9+" list
+
+typedef struct {
+    uint64_t mask;  // channels bits of variable
+    unsigned char first;
+    unsigned char width;
+    unsigned short id;
+} vcd_dump_var_t;
+
 class cpart_VCD_Dump : public part {
 public:
     std::string GetAboutInfo(void) override { return "L.C. Gamboa \n <lcgamboa@yahoo.com>"; };
@@ -51,12 +61,19 @@ public:
 
 private:
     void RegisterRemoteControl(void) override;
-    unsigned char input_pins[8];
-    unsigned char old_value_pins[8];
+    void ChangeChannels(void);
+    unsigned char input_pins[VCD_DUMP_MAX];
+    unsigned char nchannels;
+    std::string extra_pins;  // board pins of channels 9 and up: "20,21,30-37"
+    std::string buses;       // channels dumped as vectors: "DATA:1-8;ADDR:9-16"
+    std::vector<vcd_dump_var_t> vars;
+    uint64_t old_bits;
     char f_vcd_name[200];
-    FILE* f_vcd;
+    char f_pwf_name[200];
+    CVCDWriter vcd;
     unsigned long vcd_count;
     unsigned char rec;
+    unsigned char format;
 };
 
 #endif /* PART_VCD_DUMP_H */
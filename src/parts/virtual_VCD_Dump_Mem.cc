@@ -28,26 +28,57 @@
 #include "../lib/oscilloscope.h"
 #include "../lib/picsimlab.h"
 #include "../lib/spareparts.h"
+#include "../lib/wave_reader.h"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
 #endif
 
-static const char markers[] = "!$%&[()]";
-
 /* outputs */
 enum { O_P1, O_P2, O_P3, O_P4, O_P5, O_P6, O_P7, O_P8, O_L1, O_L2, O_L3, O_L4, O_L5, O_L6, O_L7, O_L8, O_NAME, O_REC };
 
 /*inputs*/
 enum { I_START, I_VIEW };
 
-static PCWProp pcwprop[2] = {{PCW_SPIN, "Addr"}, /* {PCW_COMBO, "Size"},*/ {PCW_END, ""}};
+static PCWProp pcwprop[4] = {{PCW_SPIN, "Addr"}, {PCW_COMBO, "Format"}, {PCW_EDIT, "Vars"}, {PCW_END, ""}};
+
+static void cpart_vcd_dump_mem_callback(void* arg, const unsigned int addr) {
+    cpart_VCD_Dump_Mem* dump = (cpart_VCD_Dump_Mem*)arg;
+    dump->OnWrite(addr);
+}
+
+// parse a list of variables "addr[:size]" (size in bytes), ex: "0x20,0x30:2,100:4"
+static int parse_vars(const char* text, std::vector<vcd_mem_var_t>& list, const int max) {
+    const char* ptr = text;
+
+    list.clear();
+    while (*ptr && ((int)list.size() < max)) {
+        char* end;
+        vcd_mem_var_t var;
+        var.addr = strtoul(ptr, &end, 0);
+        if (end == ptr) {
+            ptr++;
+            continue;
+        }
+        var.size = 1;
+        ptr = end;
+        if (*ptr == ':') {
+            const unsigned long size = strtoul(ptr + 1, &end, 0);
+            if ((size == 2) || (size == 4) || (size == 8)) {
+                var.size = size;
+            }
+            ptr = end;
+        }
+        var.id = 0;
+        var.watch = -1;
+        list.push_back(var);
+    }
+    return list.size();
+}
 
 cpart_VCD_Dump_Mem::cpart_VCD_Dump_Mem(const unsigned x, const unsigned y, const char* name, const char* type,
                                        board* pboard_, const int id_)
     : part(x, y, name, type, pboard_, id_) {
-    always_update = 1;
-
     output_bits[0] = 2;
     output_bits[1] = 2;
     output_bits[2] = 2;
@@ -58,10 +89,15 @@ cpart_VCD_Dump_Mem::cpart_VCD_Dump_Mem(const unsigned x, const unsigned y, const
     output_bits[7] = 2;
 
     mem_addr = 0;
-    mem_size = 8;
+    watch_addr = 0;
+    mem_watch = -1;
+    mem_old = 0;
 
-    mcount = 0;
-    memset(output_bits_alm, 0, 8 * sizeof(unsigned long));
+    memset(output_bits_alm, 0, sizeof(output_bits_alm));
+    inst_time = 0;
+    inst_last = pboard->GetInstCounter();
+    bits_start = 0;
+    bits_last = 0;
 
     char tname[128];
     PICSimLab.SystemCmd(PSC_GETTEMPDIR, NULL, tname);
@@ -71,12 +107,16 @@ cpart_VCD_Dump_Mem::cpart_VCD_Dump_Mem(const unsigned x, const unsigned y, const
 
     strncat(f_vcd_name, ".vcd", 200);
 
-    f_vcd = fopen_UTF8(f_vcd_name, "w");
-    fclose(f_vcd);
-    f_vcd = NULL;
+    strncpy(f_pwf_name, f_vcd_name, 200);
+    strcpy(f_pwf_name + strlen(f_pwf_name) - 4, ".pwf");
+
+    FILE* fout = fopen_UTF8(f_vcd_name, "w");
+    if (fout) {
+        fclose(fout);
+    }
 
     rec = 0;
-    vcd_count = 0;
+    format = VCDW_VCD;
 
     SetPCWProperties(pcwprop);
 
@@ -94,11 +134,13 @@ cpart_VCD_Dump_Mem::~cpart_VCD_Dump_Mem(void) {
     SpareParts.CanvasCmd({.cmd = CC_FREEBITMAP, .FreeBitmap{BitmapId}});
     SpareParts.CanvasCmd({.cmd = CC_DESTROY});
 
-    if (f_vcd) {
-        fclose(f_vcd);
-        f_vcd = NULL;
+    Watch(0);
+    if (mem_watch > 0) {
+        pboard->RAMWatchUnregister(mem_watch);
     }
+    vcd.Close();
     unlink(f_vcd_name);
+    unlink(f_pwf_name);
 }
 
 void cpart_VCD_Dump_Mem::DrawOutput(const unsigned int i) {
@@ -209,14 +251,19 @@ unsigned short cpart_VCD_Dump_Mem::GetOutputId(char* name) {
 }
 
 std::string cpart_VCD_Dump_Mem::WritePreferences(void) {
-    char prefs[256];
-    sprintf(prefs, "%hu,%hhu", mem_addr, rec);
+    char prefs[512];
+    // avoid save empty fields
+    std::string vtext = vars_text.length() ? vars_text : " ";
+    snprintf(prefs, sizeof(prefs), "%hu,%hhu,%hhu,%.256s", mem_addr, rec, format, vtext.c_str());
     return prefs;
 }
 
 void cpart_VCD_Dump_Mem::ReadPreferences(std::string value) {
-    sscanf(value.c_str(), "%hu,%hhu", &mem_addr, &rec);
+    char vtext[512] = " ";
+    sscanf(value.c_str(), "%hu,%hhu,%hhu,%511[^\n]", &mem_addr, &rec, &format, vtext);
     rec &= 0x01;
+    format &= 0x01;
+    vars_text = strcmp(vtext, " ") ? vtext : "";
 }
 
 void cpart_VCD_Dump_Mem::ConfigurePropertiesWindow(void) {
@@ -224,8 +271,10 @@ void cpart_VCD_Dump_Mem::ConfigurePropertiesWindow(void) {
     SpareParts.WPropCmd("spin1", PWA_SPINSETMAX, std::to_string(pboard->DBGGetRAMSize()).c_str());
     SpareParts.WPropCmd("spin1", PWA_SPINSETVALUE, std::to_string(mem_addr).c_str());
 
-    // SpareParts.WPropCmd("combo2", PWA_COMBOSETITEMS, "8, 16, 32, 64, ");
-    // SpareParts.WPropCmd("combo2", PWA_COMBOSETTEXT, std::to_string(mem_size).c_str());
+    SpareParts.WPropCmd("combo2", PWA_COMBOSETITEMS, "VCD,PWF,");
+    SpareParts.WPropCmd("combo2", PWA_COMBOSETTEXT, (format == VCDW_PWF) ? "PWF" : "VCD");
+
+    SpareParts.WPropCmd("edit3", PWA_EDITSETTEXT, vars_text.c_str());
 }
 
 void cpart_VCD_Dump_Mem::ReadPropertiesWindow(void) {
@@ -233,132 +282,164 @@ void cpart_VCD_Dump_Mem::ReadPropertiesWindow(void) {
     SpareParts.WPropCmd("spin1", PWA_SPINGETVALUE, NULL, &value);
     mem_addr = value;
 
-    // char buff[64];
-    // SpareParts.WPropCmd("combo2", PWA_COMBOGETTEXT, NULL, buff);
-    // sscanf(buff, "%hhu", &mem_size);
+    char buff[512];
+    SpareParts.WPropCmd("combo2", PWA_COMBOGETTEXT, NULL, buff);
+    format = strcmp(buff, "PWF") ? VCDW_VCD : VCDW_PWF;
+
+    SpareParts.WPropCmd("edit3", PWA_EDITGETTEXT, NULL, buff);
+    vars_text = buff;
 }
 
 void cpart_VCD_Dump_Mem::PreProcess(void) {
-    memset(output_bits_alm, 0, 8 * sizeof(unsigned long));
-    JUMPSTEPS_ = PICSimLab.GetJUMPSTEPS() * 4.0 / PICSimLab.GetBoard()->MGetClocksPerInstructions();
-    mcount = JUMPSTEPS_;
-
-    if ((pboard->DBGGetRAM_p() != NULL) && (mem_addr < pboard->DBGGetRAMSize())) {
-        mem_ptr = &(pboard->DBGGetRAM_p()[mem_addr]);
-        mem_old = (*mem_ptr) ^ 0xFF;
-    } else {
-        mem_ptr = NULL;
-        mem_old = 0;
+    memset(output_bits_alm, 0, sizeof(output_bits_alm));
+    bits_start = GetTime();
+    bits_last = bits_start;
+
+    // the displayed address is always watched, the board calls OnWrite only when it changes
+    if ((mem_watch <= 0) || (watch_addr != mem_addr)) {
+        if (mem_watch > 0) {
+            pboard->RAMWatchUnregister(mem_watch);
+        }
+        mem_watch = pboard->RAMWatchRegister(mem_addr, 1, cpart_vcd_dump_mem_callback, this);
+        watch_addr = mem_addr;
+        mem_old = (mem_watch > 0) ? pboard->DBGGetRAM_p()[mem_addr] : 0;
     }
 
-    if (rec && (f_vcd == NULL)) {
+    if (rec && !vcd.IsOpen()) {
         float tscale = 1.0e12 / pboard->MGetInstClockFreq();  // ps step
 
-        f_vcd = fopen_UTF8(f_vcd_name, "w");
-        vcd_count = 0;
-
-        fprintf(f_vcd,
-                "$version Generated by PICSimLab $end\n"
-                "$timescale %ips $end\n"
-                "$scope module logic $end\n",
-                (int)tscale);
-
-        fprintf(f_vcd, "$var wire 1 !  1-mem[%d][0] $end\n", mem_addr);
-        fprintf(f_vcd, "$var wire 1 $  2-mem[%d][1] $end\n", mem_addr);
-        fprintf(f_vcd, "$var wire 1 %%  3-mem[%d][2] $end\n", mem_addr);
-        fprintf(f_vcd, "$var wire 1 &  4-mem[%d][3] $end\n", mem_addr);
-        fprintf(f_vcd, "$var wire 1 [  5-mem[%d][4] $end\n", mem_addr);
-        fprintf(f_vcd, "$var wire 1 (  6-mem[%d][5] $end\n", mem_addr);
-        fprintf(f_vcd, "$var wire 1 )  7-mem[%d][6] $end\n", mem_addr);
-        fprintf(f_vcd, "$var wire 1 ]  8-mem[%d][7] $end\n", mem_addr);
-
-        fprintf(f_vcd,
-                "$upscope $end\n"
-                "$enddefinitions $end\n"
-                "$dumpvars\n");
-
-        fprintf(f_vcd, "x!\n");
-        fprintf(f_vcd, "x$\n");
-        fprintf(f_vcd, "x%%\n");
-        fprintf(f_vcd, "x&\n");
-        fprintf(f_vcd, "x[\n");
-        fprintf(f_vcd, "x(\n");
-        fprintf(f_vcd, "x)\n");
-        fprintf(f_vcd, "x[\n");
-        fprintf(f_vcd, "$end\n");
-    } else if (!rec && (f_vcd != NULL)) {
-        if (f_vcd) {
-            fclose(f_vcd);
-            f_vcd = NULL;
+        vcd.Open((format == VCDW_PWF) ? f_pwf_name : f_vcd_name, format);
+
+        vcd.Printf("$version Generated by PICSimLab $end\n"
+                   "$timescale %ips $end\n"
+                   "$scope module logic $end\n",
+                   (int)tscale);
+
+        char name[64];
+        for (int i = 0; i < 8; i++) {
+            snprintf(name, sizeof(name), "%i-mem[%d][%i]", i + 1, mem_addr, i);
+            vcd.AddVar("wire", 1, name);  // ids 0 to 7
+        }
+
+        parse_vars(vars_text.c_str(), vars, VCD_DUMP_MEM_MAX);
+        for (unsigned int i = 0; i < vars.size(); i++) {
+            snprintf(name, sizeof(name), "mem[0x%04X] [%i:0]", vars[i].addr, vars[i].size * 8 - 1);
+            vars[i].id = vcd.AddVar("reg", vars[i].size * 8, name);
+        }
+
+        vcd.Printf("$upscope $end\n"
+                   "$enddefinitions $end\n"
+                   "$dumpvars\n");
+
+        for (int i = 0; i < 8; i++) {
+            vcd.Printf("x%s\n", CVCDWriter::MakeId(i).c_str());
+        }
+        for (unsigned int i = 0; i < vars.size(); i++) {
+            vcd.Printf("bx %s\n", CVCDWriter::MakeId(vars[i].id).c_str());
+        }
+        vcd.Printf("$end\n");
+
+        vcd.Start();
+        Watch(1);
+
+        // initial values at time 0, next records only on RAM writes
+        inst_time = 0;
+        inst_last = pboard->GetInstCounter();
+        bits_start = 0;
+        bits_last = 0;
+        for (int i = 0; (mem_watch > 0) && (i < 8); i++) {
+            vcd.Bit(0, i, (mem_old >> i) & 1);
+        }
+        for (unsigned int i = 0; i < vars.size(); i++) {
+            if (vars[i].watch > 0) {
+                vcd.Vector(0, vars[i].id, vars[i].size * 8, ReadVar(vars[i]));
+            }
         }
+    } else if (!rec && vcd.IsOpen()) {
+        Watch(0);
+        vcd.Close();
     }
 }
 
-void cpart_VCD_Dump_Mem::Process(void) {
-    if (rec && f_vcd) {
-        vcd_count++;
-        int tprint = 0;
-
-        if ((mem_ptr != NULL) && ((*mem_ptr) ^ mem_old)) {
-            for (int i = 0; i < 8; i++) {
-                if (((*mem_ptr) & (1 << i)) != (mem_old & (1 << i))) {
-                    if (!tprint) {
-                        tprint = 1;
-                        fprintf(f_vcd, "#%li\n", vcd_count);
-                    }
-                    int val = ((*mem_ptr) & (1 << i)) > 0;
-                    if (val) {
-                        mem_old |= (1 << i);
-                    } else {
-                        mem_old &= ~(1 << i);
-                    }
-                    fprintf(f_vcd, "%i%c\n", val, markers[i]);
-                    fflush(f_vcd);
-                }
+void cpart_VCD_Dump_Mem::Watch(const int enable) {
+    for (unsigned int i = 0; i < vars.size(); i++) {
+        if (vars[i].watch > 0) {
+            pboard->RAMWatchUnregister(vars[i].watch);
+            vars[i].watch = -1;
+        }
+        if (enable) {
+            vars[i].watch = pboard->RAMWatchRegister(vars[i].addr, vars[i].size, cpart_vcd_dump_mem_callback, this);
+        }
+    }
+}
+
+uint64_t cpart_VCD_Dump_Mem::ReadVar(const vcd_mem_var_t& var) {
+    const unsigned char* ram = pboard->DBGGetRAM_p();
+    uint64_t value = 0;
+    for (int b = var.size - 1; b >= 0; b--) {
+        value = (value << 8) | ram[var.addr + b];
+    }
+    return value;
+}
+
+void cpart_VCD_Dump_Mem::OnWrite(const unsigned int addr) {
+    const unsigned char* ram = pboard->DBGGetRAM_p();
+    const int recording = rec && vcd.IsOpen();
+    const uint64_t time = GetTime();
+
+    if ((addr == mem_addr) && (mem_watch > 0)) {
+        SumBits(time);
+        const unsigned char changed = ram[addr] ^ mem_old;
+        mem_old = ram[addr];
+        for (int i = 0; recording && (i < 8); i++) {
+            if (changed & (1 << i)) {
+                vcd.Bit(time, i, (mem_old >> i) & 1);
             }
         }
-    } else {
-        if (mem_ptr != NULL) {
-            mem_old = (*mem_ptr);
-        } else {
-            mem_old = 0;
+    }
+
+    for (unsigned int i = 0; recording && (i < vars.size()); i++) {
+        if ((vars[i].watch > 0) && (addr >= vars[i].addr) && (addr < (vars[i].addr + vars[i].size))) {
+            vcd.Vector(time, vars[i].id, vars[i].size * 8, ReadVar(vars[i]));
         }
     }
+}
 
-    mcount++;
-    if (mcount >= JUMPSTEPS_) {
-        if (mem_old & 0x01)
-            output_bits_alm[0]++;
-        if (mem_old & 0x02)
-            output_bits_alm[1]++;
-        if (mem_old & 0x04)
-            output_bits_alm[2]++;
-        if (mem_old & 0x08)
-            output_bits_alm[3]++;
-        if (mem_old & 0x10)
-            output_bits_alm[4]++;
-        if (mem_old & 0x20)
-            output_bits_alm[5]++;
-        if (mem_old & 0x40)
-            output_bits_alm[6]++;
-        if (mem_old & 0x80)
-            output_bits_alm[7]++;
-
-        mcount = -1;
+// board instruction counter extended to 64 bits, called at least once each cycle
+uint64_t cpart_VCD_Dump_Mem::GetTime(void) {
+    const uint32_t now = pboard->GetInstCounter();
+    inst_time += (uint32_t)(now - inst_last);
+    inst_last = now;
+    return inst_time;
+}
+
+// add the time since the last sum to the high bits of the displayed address
+void cpart_VCD_Dump_Mem::SumBits(const uint64_t now) {
+    for (int i = 0; i < 8; i++) {
+        if (mem_old & (1 << i)) {
+            output_bits_alm[i] += now - bits_last;
+        }
     }
+    bits_last = now;
 }
 
+void cpart_VCD_Dump_Mem::Process(void) {}
+
 void cpart_VCD_Dump_Mem::PostProcess(void) {
-    long int NSTEPJ = PICSimLab.GetNSTEPJ();
+    vcd.Update();
+
+    // LED brightness is the fraction of the cycle with the bit high
+    const uint64_t now = GetTime();
+    SumBits(now);
+    const uint64_t span = now - bits_start;
 
-    output_bits[0] = (((output_bits_alm[0] * 200.0) / NSTEPJ) + 55);
-    output_bits[1] = (((output_bits_alm[1] * 200.0) / NSTEPJ) + 55);
-    output_bits[2] = (((output_bits_alm[2] * 200.0) / NSTEPJ) + 55);
-    output_bits[3] = (((output_bits_alm[3] * 200.0) / NSTEPJ) + 55);
-    output_bits[4] = (((output_bits_alm[4] * 200.0) / NSTEPJ) + 55);
-    output_bits[5] = (((output_bits_alm[5] * 200.0) / NSTEPJ) + 55);
-    output_bits[6] = (((output_bits_alm[6] * 200.0) / NSTEPJ) + 55);
-    output_bits[7] = (((output_bits_alm[7] * 200.0) / NSTEPJ) + 55);
+    for (int i = 0; i < 8; i++) {
+        if (span) {
+            output_bits[i] = ((output_bits_alm[i] * 200.0) / span) + 55;
+        } else {
+            output_bits[i] = (mem_old & (1 << i)) ? 255 : 55;
+        }
+    }
 
     for (int i = 0; i < 8; i++) {
         if ((output_ids[O_L1 + i]->value != output_bits[i])) {
@@ -396,8 +477,14 @@ void cpart_VCD_Dump_Mem::OnMouseButtonPress(unsigned int inputId, unsigned int b
                     document.body.removeChild(element);
                     URL.revokeObjectURL(text);
                 },
-                f_vcd_name);
+                (format == VCDW_PWF) ? f_pwf_name : f_vcd_name);
 #else
+            if (format == VCDW_PWF) {
+                CWaveReader wave;
+                if (wave.Open(f_pwf_name)) {
+                    wave.ExportVCD(f_vcd_name);
+                }
+            }
             PICSimLab.SystemCmd(PSC_LAUNCHDEFAULAPPLICATION, f_vcd_name);
 #endif
             break;
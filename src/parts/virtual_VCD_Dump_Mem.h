@@ -26,10 +26,21 @@
 #ifndef PART_VCD_DUMP_MEM_H
 #define PART_VCD_DUMP_MEM_H
 
+#include <vector>
 #include "../lib/part.h"
+#include "../lib/vcd_writer.h"
 
 #define PART_VCD_DUMP_MEM_Name "VCD Dump Memory"
 
+#define VCD_DUMP_MEM_MAX 32
+
+typedef struct {
+    unsigned int addr;
+    unsigned char size;  // in bytes, little endian
+    unsigned short id;   // vcd variable id
+    int watch;           // board RAM watch
+} vcd_mem_var_t;
+
 class cpart_VCD_Dump_Mem : public part {
 public:
     std::string GetAboutInfo(void) override { return "L.C. Gamboa \n <lcgamboa@yahoo.com>"; };
@@ -50,22 +61,32 @@ public:
     void ReadPreferences(std::string value) override;
     unsigned short GetInputId(char* name) override;
     unsigned short GetOutputId(char* name) override;
+    void OnWrite(const unsigned int addr);
 
 private:
     void RegisterRemoteControl(void) override;
+    void Watch(const int enable);
+    uint64_t ReadVar(const vcd_mem_var_t& var);
+    uint64_t GetTime(void);
+    void SumBits(const uint64_t now);
 
-    unsigned long output_bits_alm[8];
+    uint64_t output_bits_alm[8];  // instructions with bit high in this cycle
     unsigned char output_bits[8];
-    long mcount;
-    int JUMPSTEPS_;
+    uint64_t bits_start;  // time of cycle start
+    uint64_t bits_last;   // time of last bits sum
     char f_vcd_name[200];
-    FILE* f_vcd;
-    unsigned long vcd_count;
+    char f_pwf_name[200];
+    CVCDWriter vcd;
+    uint64_t inst_time;  // instructions since recording start
+    uint32_t inst_last;  // board instruction counter at last GetTime
     unsigned char rec;
-    unsigned char mem_size;
+    unsigned char format;
     unsigned short mem_addr;
-    unsigned char* mem_ptr;
+    unsigned short watch_addr;
+    int mem_watch;
     unsigned char mem_old;
+    std::string vars_text;
+    std::vector<vcd_mem_var_t> vars;
 };
 
 #endif /* PART_VCD_DUMP_MEM_H */
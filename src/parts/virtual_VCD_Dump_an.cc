@@ -28,6 +28,7 @@
 #include "../lib/oscilloscope.h"
 #include "../lib/picsimlab.h"
 #include "../lib/spareparts.h"
+#include "../lib/wave_reader.h"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
@@ -41,9 +42,10 @@ enum { O_P1, O_P2, O_P3, O_P4, O_P5, O_P6, O_P7, O_P8, O_L1, O_L2, O_L3, O_L4, O
 /*inputs*/
 enum { I_START, I_VIEW };
 
-static PCWProp pcwprop[9] = {{PCW_COMBO, "Pin 1"}, {PCW_COMBO, "Pin 2"}, {PCW_COMBO, "Pin 3"},
-                             {PCW_COMBO, "Pin 4"}, {PCW_COMBO, "Pin 5"}, {PCW_COMBO, "Pin 6"},
-                             {PCW_COMBO, "Pin 7"}, {PCW_COMBO, "Pin 8"}, {PCW_END, ""}};
+static PCWProp pcwprop[10] = {{PCW_COMBO, "Pin 1"}, {PCW_COMBO, "Pin 2"}, {PCW_COMBO, "Pin 3"},
+                              {PCW_COMBO, "Pin 4"}, {PCW_COMBO, "Pin 5"}, {PCW_COMBO, "Pin 6"},
+                              {PCW_COMBO, "Pin 7"}, {PCW_COMBO, "Pin 8"}, {PCW_COMBO, "Format"},
+                              {PCW_END, ""}};
 
 cpart_VCD_Dump_an::cpart_VCD_Dump_an(const unsigned x, const unsigned y, const char* name, const char* type,
                                      board* pboard_, const int id_)
@@ -76,11 +78,16 @@ cpart_VCD_Dump_an::cpart_VCD_Dump_an(const unsigned x, const unsigned y, const c
 
     strncat(f_vcd_name, ".vcd", 200);
 
-    f_vcd = fopen_UTF8(f_vcd_name, "w");
-    fclose(f_vcd);
-    f_vcd = NULL;
+    strncpy(f_pwf_name, f_vcd_name, 200);
+    strcpy(f_pwf_name + strlen(f_pwf_name) - 4, ".pwf");
+
+    FILE* fout = fopen_UTF8(f_vcd_name, "w");
+    if (fout) {
+        fclose(fout);
+    }
 
     rec = 0;
+    format = VCDW_VCD;
     vcd_count = 0;
 
     SetPCWProperties(pcwprop);
@@ -99,11 +106,9 @@ cpart_VCD_Dump_an::~cpart_VCD_Dump_an(void) {
     SpareParts.CanvasCmd({.cmd = CC_FREEBITMAP, .FreeBitmap{BitmapId}});
     SpareParts.CanvasCmd({.cmd = CC_DESTROY});
 
-    if (f_vcd) {
-        fclose(f_vcd);
-        f_vcd = NULL;
-    }
+    vcd.Close();
     unlink(f_vcd_name);
+    unlink(f_pwf_name);
 }
 
 void cpart_VCD_Dump_an::DrawOutput(const unsigned int i) {
@@ -241,15 +246,17 @@ unsigned short cpart_VCD_Dump_an::GetOutputId(char* name) {
 std::string cpart_VCD_Dump_an::WritePreferences(void) {
     char prefs[256];
 
-    sprintf(prefs, "%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu", input_pins[0], input_pins[1], input_pins[2],
-            input_pins[3], input_pins[4], input_pins[5], input_pins[6], input_pins[7], rec);
+    sprintf(prefs, "%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu", input_pins[0], input_pins[1], input_pins[2],
+            input_pins[3], input_pins[4], input_pins[5], input_pins[6], input_pins[7], rec, format);
 
     return prefs;
 }
 
 void cpart_VCD_Dump_an::ReadPreferences(std::string value) {
-    sscanf(value.c_str(), "%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu", &input_pins[0], &input_pins[1],
-           &input_pins[2], &input_pins[3], &input_pins[4], &input_pins[5], &input_pins[6], &input_pins[7], &rec);
+    sscanf(value.c_str(), "%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu", &input_pins[0], &input_pins[1],
+           &input_pins[2], &input_pins[3], &input_pins[4], &input_pins[5], &input_pins[6], &input_pins[7], &rec,
+           &format);
+    format &= 0x01;
 }
 
 void cpart_VCD_Dump_an::ConfigurePropertiesWindow(void) {
@@ -261,6 +268,9 @@ void cpart_VCD_Dump_an::ConfigurePropertiesWindow(void) {
     SetPCWComboWithPinNames("combo6", input_pins[5]);
     SetPCWComboWithPinNames("combo7", input_pins[6]);
     SetPCWComboWithPinNames("combo8", input_pins[7]);
+
+    SpareParts.WPropCmd("combo9", PWA_COMBOSETITEMS, "VCD,PWF,");
+    SpareParts.WPropCmd("combo9", PWA_COMBOSETTEXT, (format == VCDW_PWF) ? "PWF" : "VCD");
 }
 
 void cpart_VCD_Dump_an::ReadPropertiesWindow(void) {
@@ -272,78 +282,72 @@ void cpart_VCD_Dump_an::ReadPropertiesWindow(void) {
     input_pins[5] = GetPWCComboSelectedPin("combo6");
     input_pins[6] = GetPWCComboSelectedPin("combo7");
     input_pins[7] = GetPWCComboSelectedPin("combo8");
+
+    char buff[64];
+    SpareParts.WPropCmd("combo9", PWA_COMBOGETTEXT, NULL, buff);
+    format = strcmp(buff, "PWF") ? VCDW_VCD : VCDW_PWF;
 }
 
 void cpart_VCD_Dump_an::PreProcess(void) {
-    if (rec && (f_vcd == NULL)) {
+    if (rec && !vcd.IsOpen()) {
         float tscale = 1.0e12 / pboard->MGetInstClockFreq();  // ns step
 
-        f_vcd = fopen_UTF8(f_vcd_name, "w");
+        vcd.Open((format == VCDW_PWF) ? f_pwf_name : f_vcd_name, format);
         vcd_count = 0;
 
-        fprintf(f_vcd,
-                "$version Generated by PICSimLab $end\n"
-                "$timescale %ips $end\n"
-                "$scope module analogic $end\n",
-                (int)tscale);
+        vcd.Printf("$version Generated by PICSimLab $end\n"
+                   "$timescale %ips $end\n"
+                   "$scope module analogic $end\n",
+                   (int)tscale);
 
         if (input_pins[0])
-            fprintf(f_vcd, "$var real 32 !  1-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[0]).c_str());
+            vcd.Printf("$var real 32 !  1-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[0]).c_str());
         if (input_pins[1])
-            fprintf(f_vcd, "$var real 32 $  2-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[1]).c_str());
+            vcd.Printf("$var real 32 $  2-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[1]).c_str());
         if (input_pins[2])
-            fprintf(f_vcd, "$var real 32 %%  3-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[2]).c_str());
+            vcd.Printf("$var real 32 %%  3-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[2]).c_str());
         if (input_pins[3])
-            fprintf(f_vcd, "$var real 32 &  4-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[3]).c_str());
+            vcd.Printf("$var real 32 &  4-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[3]).c_str());
         if (input_pins[4])
-            fprintf(f_vcd, "$var real 32 [  5-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[4]).c_str());
+            vcd.Printf("$var real 32 [  5-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[4]).c_str());
         if (input_pins[5])
-            fprintf(f_vcd, "$var real 32 (  6-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[5]).c_str());
+            vcd.Printf("$var real 32 (  6-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[5]).c_str());
         if (input_pins[6])
-            fprintf(f_vcd, "$var real 32 )  7-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[6]).c_str());
+            vcd.Printf("$var real 32 )  7-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[6]).c_str());
         if (input_pins[7])
-            fprintf(f_vcd, "$var real 32 ]  8-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[7]).c_str());
-
-        fprintf(f_vcd,
-                "$upscope $end\n"
-                "$enddefinitions $end\n");
-    } else if (!rec && (f_vcd != NULL)) {
-        if (f_vcd) {
-            fclose(f_vcd);
-            f_vcd = NULL;
+            vcd.Printf("$var real 32 ]  8-%s $end\n", (const char*)SpareParts.GetPinName(input_pins[7]).c_str());
+
+        vcd.Printf("$upscope $end\n"
+                   "$enddefinitions $end\n");
+
+        for (int i = 0; i < 8; i++) {
+            const char code[2] = {markers[i], 0};
+            vcd.SetId(i, code);
         }
+        vcd.Start();
+    } else if (!rec && vcd.IsOpen()) {
+        vcd.Close();
     }
 }
 
 void cpart_VCD_Dump_an::Process(void) {
-    if (rec && f_vcd) {
+    if (rec && vcd.IsOpen()) {
         const picpin* ppins = SpareParts.GetPinsValues();
 
         vcd_count++;
-        int tprint = 0;
 
         for (int i = 0; i < 8; i++) {
             if (input_pins[i] != 0) {
                 if (ppins[input_pins[i] - 1].dir == PD_IN) {
                     if (ppins[input_pins[i] - 1].avalue != old_value_pins[i]) {
-                        if (!tprint) {
-                            tprint = 1;
-                            fprintf(f_vcd, "#%li\n", vcd_count);
-                        }
                         old_value_pins[i] = ppins[input_pins[i] - 1].avalue;
-                        fprintf(f_vcd, "r%f %c\n", old_value_pins[i], markers[i]);
-                        fflush(f_vcd);
+                        vcd.Real(vcd_count, i, old_value_pins[i]);
                     }
                 } else  // out
                 {
                     if (ppins[input_pins[i] - 1].oavalue != old_value_pins[i]) {
-                        if (!tprint) {
-                            tprint = 1;
-                            fprintf(f_vcd, "#%li\n", vcd_count);
-                        }
                         old_value_pins[i] = ppins[input_pins[i] - 1].oavalue;
-                        fprintf(f_vcd, "r%f %c\n", old_value_pins[i] / 51, markers[i]);
-                        fflush(f_vcd);
+                        vcd.Real(vcd_count, i, old_value_pins[i] / 51);
                     }
                 }
             }
@@ -352,6 +356,8 @@ void cpart_VCD_Dump_an::Process(void) {
 }
 
 void cpart_VCD_Dump_an::PostProcess(void) {
+    vcd.Update();
+
     const picpin* ppins = SpareParts.GetPinsValues();
 
     for (int i = 0; i < 8; i++) {
@@ -390,8 +396,14 @@ void cpart_VCD_Dump_an::OnMouseButtonPress(unsigned int inputId, unsigned int bu
                     document.body.removeChild(element);
                     URL.revokeObjectURL(text);
                 },
-                f_vcd_name);
+                (format == VCDW_PWF) ? f_pwf_name : f_vcd_name);
 #else
+            if (format == VCDW_PWF) {
+                CWaveReader wave;
+                if (wave.Open(f_pwf_name)) {
+                    wave.ExportVCD(f_vcd_name);
+                }
+            }
             PICSimLab.SystemCmd(PSC_LAUNCHDEFAULAPPLICATION, f_vcd_name);
 #endif
             break;
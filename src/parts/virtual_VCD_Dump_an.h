@@ -27,6 +27,7 @@
 #define PART_VCD_DUMP_AN_H
 
 #include "../lib/part.h"
+#include "../lib/vcd_writer.h"
 
 #define PART_VCD_DUMP_AN_Name "VCD Dump (Analogic)"
 
@@ -56,9 +57,11 @@ private:
     unsigned char input_pins[8];
     float old_value_pins[8];
     char f_vcd_name[200];
-    FILE* f_vcd;
+    char f_pwf_name[200];
+    CVCDWriter vcd;
     unsigned long vcd_count;
     unsigned char rec;
+    unsigned char format;
 };
 
 #endif /* PART_VCD_DUMP_AN_H */
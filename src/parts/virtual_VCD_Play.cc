@@ -33,44 +33,74 @@
 #include <emscripten.h>
 #endif
 
+// parse a list of numbers and ranges: "20,21,30-37"
+static int parse_list(const char* text, unsigned char* list, const int max) {
+    int count = 0;
+    const char* ptr = text;
+
+    while (*ptr && (count < max)) {
+        char* end;
+        long first = strtol(ptr, &end, 10);
+        if (end == ptr) {
+            ptr++;
+            continue;
+        }
+        long last = first;
+        ptr = end;
+        if (*ptr == '-') {
+            last = strtol(ptr + 1, &end, 10);
+            if (end == (ptr + 1)) {
+                last = first;
+            }
+            ptr = end;
+        }
+        for (long v = first; (v <= last) && (count < max); v++) {
+            list[count++] = ((v > 0) && (v < 256)) ? v : 0;
+        }
+    }
+    return count;
+}
+
 /* outputs */
 enum { O_P1, O_P2, O_P3, O_P4, O_P5, O_P6, O_P7, O_P8, O_L1, O_L2, O_L3, O_L4, O_L5, O_L6, O_L7, O_L8, O_NAME, O_PLAY };
 
 /*inputs*/
 enum { I_PLAY, I_VIEW, I_LOAD };
 
-static PCWProp pcwprop[9] = {{PCW_COMBO, "Pin 1"}, {PCW_COMBO, "Pin 2"}, {PCW_COMBO, "Pin 3"},
-                             {PCW_COMBO, "Pin 4"}, {PCW_COMBO, "Pin 5"}, {PCW_COMBO, "Pin 6"},
-                             {PCW_COMBO, "Pin 7"}, {PCW_COMBO, "Pin 8"}, {PCW_END, ""}};
+static PCWProp pcwprop[10] = {{PCW_COMBO, "Pin 1"}, {PCW_COMBO, "Pin 2"}, {PCW_COMBO, "Pin 3"},
+                              {PCW_COMBO, "Pin 4"}, {PCW_COMBO, "Pin 5"}, {PCW_COMBO, "Pin 6"},
+                              {PCW_COMBO, "Pin 7"}, {PCW_COMBO, "Pin 8"}, {PCW_EDIT, "Pins 9+"},
+                              {PCW_END, ""}};
+
+static void cpart_vcd_play_callback(void* arg) {
+    cpart_VCD_Play* vcd_play = (cpart_VCD_Play*)arg;
+    vcd_play->OnTime();
+}
 
 cpart_VCD_Play::cpart_VCD_Play(const unsigned x, const unsigned y, const char* name, const char* type, board* pboard_,
                                const int id_)
     : part(x, y, name, type, pboard_, id_) {
-    always_update = 1;
-
-    output_pins[0] = 0;
-    output_pins[1] = 0;
-    output_pins[2] = 0;
-    output_pins[3] = 0;
-    output_pins[4] = 0;
-    output_pins[5] = 0;
-    output_pins[6] = 0;
-    output_pins[7] = 0;
+    memset(output_pins, 0, VCD_PLAY_MAX);
+    nchannels = 8;
 
     f_vcd_name[0] = '*';
     f_vcd_name[1] = 0;
 
     play = 0;
-
-    vcd_data = NULL;
-    vcd_data_count = 0;
-    vcd_count = 0;
-    vcd_ptr = 0;
-    vcd_step = 0;
+    playing = 0;
+    next_valid = 0;
+    inst_per_unit = 0;
+    play_inst = 0;
+
+    // value changes are applied by a board timer scheduled to the time of the next change
+    TimerID = pboard->TimerRegister_us(1000, cpart_vcd_play_callback, this);
+    if (TimerID > 0) {
+        pboard->TimerSetState(TimerID, 0);
+    }
 
     SetPCWProperties(pcwprop);
 
-    PinCount = 8;
+    PinCount = nchannels;
     Pins = output_pins;
 }
 
@@ -83,10 +113,10 @@ cpart_VCD_Play::~cpart_VCD_Play(void) {
     SpareParts.SetPartOnDraw(id);
     SpareParts.CanvasCmd({.cmd = CC_FREEBITMAP, .FreeBitmap{BitmapId}});
     SpareParts.CanvasCmd({.cmd = CC_DESTROY});
-    if (vcd_data) {
-        free(vcd_data);
-        vcd_data = NULL;
+    if (TimerID > 0) {
+        pboard->TimerUnregister(TimerID);
     }
+    vcd.Close();
 }
 
 void cpart_VCD_Play::DrawOutput(const unsigned int i) {
@@ -216,17 +246,23 @@ unsigned short cpart_VCD_Play::GetOutputId(char* name) {
 }
 
 std::string cpart_VCD_Play::WritePreferences(void) {
-    char prefs[256];
-    sprintf(prefs, "%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%s", output_pins[0], output_pins[1], output_pins[2],
-            output_pins[3], output_pins[4], output_pins[5], output_pins[6], output_pins[7], play, f_vcd_name);
+    char prefs[1024];
+    snprintf(prefs, sizeof(prefs), "%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%s%%%.256s", output_pins[0],
+             output_pins[1], output_pins[2], output_pins[3], output_pins[4], output_pins[5], output_pins[6],
+             output_pins[7], play, f_vcd_name, extra_pins.c_str());
 
     return prefs;
 }
 
 void cpart_VCD_Play::ReadPreferences(std::string value) {
-    sscanf(value.c_str(), "%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%s", &output_pins[0], &output_pins[1],
-           &output_pins[2], &output_pins[3], &output_pins[4], &output_pins[5], &output_pins[6], &output_pins[7], &play,
-           f_vcd_name);
+    char extra[512] = "";
+
+    sscanf(value.c_str(), "%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%hhu,%199[^%%\n]%%%511[^\n]", &output_pins[0],
+           &output_pins[1], &output_pins[2], &output_pins[3], &output_pins[4], &output_pins[5], &output_pins[6],
+           &output_pins[7], &play, f_vcd_name, extra);
+
+    extra_pins = extra;
+    ChangeChannels();
 
     if (f_vcd_name[0] != '*') {
         if (!strncmp(f_vcd_name, "/tmp/picsimlab_workspace/", 25)) {
@@ -259,6 +295,8 @@ void cpart_VCD_Play::ConfigurePropertiesWindow(void) {
     SetPCWComboWithPinNames("combo6", output_pins[5]);
     SetPCWComboWithPinNames("combo7", output_pins[6]);
     SetPCWComboWithPinNames("combo8", output_pins[7]);
+
+    SpareParts.WPropCmd("edit9", PWA_EDITSETTEXT, extra_pins.c_str());
 }
 
 void cpart_VCD_Play::ReadPropertiesWindow(void) {
@@ -270,51 +308,86 @@ void cpart_VCD_Play::ReadPropertiesWindow(void) {
     output_pins[5] = GetPWCComboSelectedPin("combo6");
     output_pins[6] = GetPWCComboSelectedPin("combo7");
     output_pins[7] = GetPWCComboSelectedPin("combo8");
+
+    char buff[512];
+    SpareParts.WPropCmd("edit9", PWA_EDITGETTEXT, NULL, buff);
+    extra_pins = buff;
+    ChangeChannels();
 }
 
-void cpart_VCD_Play::PreProcess(void) {
-    vcd_inc = 1.0 / ((timescale * 1e-12) * pboard->MGetInstClockFreq());
+void cpart_VCD_Play::ChangeChannels(void) {
+    nchannels = 8 + parse_list(extra_pins.c_str(), output_pins + 8, VCD_PLAY_MAX - 8);
+    PinCount = nchannels;
 }
 
-void cpart_VCD_Play::Process(void) {
-    if (play) {
-        if (vcd_data[vcd_ptr].count <= vcd_count) {
-            SpareParts.SetPin(output_pins[0], (vcd_data[vcd_ptr].data & 0x01) > 0);
-            SpareParts.SetPin(output_pins[1], (vcd_data[vcd_ptr].data & 0x02) > 0);
-            SpareParts.SetPin(output_pins[2], (vcd_data[vcd_ptr].data & 0x04) > 0);
-            SpareParts.SetPin(output_pins[3], (vcd_data[vcd_ptr].data & 0x08) > 0);
-            SpareParts.SetPin(output_pins[4], (vcd_data[vcd_ptr].data & 0x10) > 0);
-            SpareParts.SetPin(output_pins[5], (vcd_data[vcd_ptr].data & 0x20) > 0);
-            SpareParts.SetPin(output_pins[6], (vcd_data[vcd_ptr].data & 0x40) > 0);
-            SpareParts.SetPin(output_pins[7], (vcd_data[vcd_ptr].data & 0x80) > 0);
-            vcd_ptr++;
-            if (vcd_ptr >= vcd_data_count) {
-                vcd_ptr = 0;
-                vcd_count = 0;
-            }
+void cpart_VCD_Play::PreProcess(void) {
+    inst_per_unit = vcd.GetTimescale() * pboard->MGetInstClockFreq();
+
+    if (play && !playing && vcd.IsOpen() && (TimerID > 0)) {
+        playing = 1;
+        Rewind();
+        pboard->TimerSetState(TimerID, 1);
+        OnTime();
+    } else if (!play && playing) {
+        playing = 0;
+        if (TimerID > 0) {
+            pboard->TimerSetState(TimerID, 0);
+        }
+        for (int i = 0; i < nchannels; i++) {
+            SpareParts.SetPin(output_pins[i], 0);
         }
+    }
+}
+
+void cpart_VCD_Play::Process(void) {}
+
+void cpart_VCD_Play::Rewind(void) {
+    vcd.Seek(0);
+    next_valid = vcd.Next(&next);
+    play_inst = 0;
+}
 
-        vcd_step += vcd_inc;
-        if (vcd_step >= 1) {
-            vcd_count += (int)(vcd_step + 0.5);
-            vcd_step = 0;
+void cpart_VCD_Play::OnTime(void) {
+    // apply all changes due until now
+    while (next_valid && ((uint64_t)(next.time * inst_per_unit + 0.5) <= play_inst)) {
+        const int ch = (next.id < var_channel.size()) ? var_channel[next.id] : -1;
+        if (ch >= 0) {
+            if (next.type == VCDW_REAL) {
+                SpareParts.SetAPin(output_pins[ch], next.value);
+            } else {
+                for (int i = 0; (i < next.width) && ((ch + i) < nchannels); i++) {
+                    SpareParts.SetPin(output_pins[ch + i], (next.bits >> i) & 1);
+                }
+            }
         }
-    } else {
-        if (vcd_count) {
-            SpareParts.SetPin(output_pins[0], 0);
-            SpareParts.SetPin(output_pins[1], 0);
-            SpareParts.SetPin(output_pins[2], 0);
-            SpareParts.SetPin(output_pins[3], 0);
-            SpareParts.SetPin(output_pins[4], 0);
-            SpareParts.SetPin(output_pins[5], 0);
-            SpareParts.SetPin(output_pins[6], 0);
-            SpareParts.SetPin(output_pins[7], 0);
+        next_valid = vcd.Next(&next);
+        if (!next_valid) {
+            // loop, files with only initial values are applied once
+            if (vcd.GetEndTime()) {
+                Rewind();
+            }
+            break;
         }
+    }
+    Schedule();
+}
 
-        vcd_count = 0;
-        vcd_ptr = 0;
-        vcd_step = 0;
+void cpart_VCD_Play::Schedule(void) {
+    if (TimerID <= 0) {
+        return;
+    }
+    if (!next_valid) {
+        pboard->TimerSetState(TimerID, 0);
+        return;
+    }
+    const uint64_t target = next.time * inst_per_unit + 0.5;
+    uint64_t delta = (target > play_inst) ? target - play_inst : 1;
+    // long gaps are split in several timer events
+    if (delta > 0x7FFFFFFF) {
+        delta = 0x7FFFFFFF;
     }
+    play_inst += delta;
+    pboard->TimerChange_inst(TimerID, delta);
 }
 
 void cpart_VCD_Play::PostProcess(void) {
@@ -334,7 +407,7 @@ void cpart_VCD_Play::OnMouseButtonPress(unsigned int inputId, unsigned int butto
         case I_LOAD:
             SpareParts.WindowCmd(PW_MAIN, "filedialog1", PWA_FILEDIALOGSETTYPE,
                                  std::to_string(PFD_OPEN | PFD_CHANGE_DIR).c_str());
-            SpareParts.WindowCmd(PW_MAIN, "filedialog1", PWA_FILEDIALOGSETFILTER, "Value change dump (*.vcd)|*.vcd");
+            SpareParts.WindowCmd(PW_MAIN, "filedialog1", PWA_FILEDIALOGSETFILTER, "Waveform (*.vcd;*.pwf)|*.vcd;*.pwf");
 
             if (f_vcd_name[0] == '*') {
                 SpareParts.WindowCmd(PW_MAIN, "filedialog1", PWA_FILEDIALOGSETFNAME, "untitled.vcd");
@@ -394,99 +467,34 @@ void cpart_VCD_Play::filedialog_EvOnClose(int retId) {
 }
 
 int cpart_VCD_Play::LoadVCD(std::string fname) {
-    FILE* fvcd;
-    fvcd = fopen_UTF8(fname.c_str(), "r");
-    char buff[256];
-    int data = 0;
-    char* id;
-    char* value;
-    char signal[8] = {0, 0, 0, 0, 0, 0, 0, 0};
-    int signal_count = 0;
-    unsigned char old_play = play;
-
-    play = 0;
-    vcd_data_count = 0;
-
-    unsigned int vcd_count_ = -1;
-
-    if (vcd_data) {
-        free(vcd_data);
-        vcd_data = NULL;
-    }
-
-    if (fvcd) {
-        while (fgets(buff, 255, fvcd)) {
-            if (buff[0] == '#') {
-                vcd_data_count++;
-            }
-
-            if (!data)  // option read
-            {
-                id = strtok(buff, " \n\r");
-                if (!strcmp(id, "$timescale")) {
-                    int itimescale;
-                    value = strtok(NULL, " ");
-                    sscanf(value, "%ips", &itimescale);
-                    timescale = itimescale;
-                } else if (!strcmp(id, "$var")) {
-                    value = strtok(NULL, " ");  // wire
-                    value = strtok(NULL, " ");  // 1
-                    value = strtok(NULL, " ");  // const
-                    signal[signal_count++] = value[0];
-                } else if (!strcmp(id, "$end") || (id[0] == '#')) {
-                    data = 1;
-                }
-            }
+    if (playing) {
+        playing = 0;
+        if (TimerID > 0) {
+            pboard->TimerSetState(TimerID, 0);
         }
-        vcd_data_count--;
-
-        vcd_data = (vcd_reg_t*)malloc((vcd_data_count + 1) * sizeof(vcd_reg_t));
+    }
 
-        if (!vcd_data) {
-            printf("vcd_play: malloc error \n");
-            fclose(fvcd);
-            return 0;
-        }
+    var_channel.clear();
+    next_valid = 0;
 
-        rewind(fvcd);
+    if (!vcd.Open(fname.c_str())) {
+        printf("vcd play: Error open file %s\n", (const char*)fname.c_str());
+        return 0;
+    }
 
-        data = 0;
-        while (fgets(buff, 255, fvcd)) {
-            if (!data)  // option read
-            {
-                id = strtok(buff, " \n\r");
-                if (!strcmp(id, "$end") || (id[0] == '#')) {
-                    data = 1;
-                }
-            } else  // data read
-            {
-                if (buff[0] == '#') {
-                    vcd_count_++;
-                    sscanf(buff + 1, "%lu", &vcd_data[vcd_count_].count);
-                } else {
-                    for (int i = 0; i < 8; i++) {
-                        if (signal[i] == buff[1]) {
-                            if (buff[0] == '1') {
-                                vcd_data[vcd_count_].data |= (1 << i);
-                                break;
-                            } else {
-                                vcd_data[vcd_count_].data &= ~(1 << i);
-                                break;
-                            }
-                        }
-                    }
-                }
-            }
+    // variables are mapped to output channels in declaration order, buses use one channel per bit (LSB first)
+    int ch = 0;
+    for (unsigned int i = 0; i < vcd.GetVarCount(); i++) {
+        const vcds_var_t& var = vcd.GetVar(i);
+        const int width = var.real ? 1 : var.width;
+        if ((ch + width) <= VCD_PLAY_MAX) {
+            var_channel.push_back(ch);
+            ch += width;
+        } else {
+            var_channel.push_back(-1);
         }
-        fclose(fvcd);
-        vcd_count = 0;
-        vcd_ptr = 0;
-        vcd_step = 0;
-        play = old_play;
-    } else {
-        printf("vcd play: Error open file %s\n", (const char*)fname.c_str());
     }
-    return 0;
+    return 1;
 }
 
 part_init(PART_VCD_Play_Name, cpart_VCD_Play, "Virtual");
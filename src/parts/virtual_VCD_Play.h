@@ -26,14 +26,13 @@
 #ifndef PART_VCD_Play_H
 #define PART_VCD_Play_H
 
+#include <vector>
 #include "../lib/part.h"
+#include "../lib/vcd_stream.h"
 
 #define PART_VCD_Play_Name "VCD Play"
 
-typedef struct {
-    unsigned long count;
-    unsigned char data;
-} vcd_reg_t;
+#define VCD_PLAY_MAX 64
 
 class cpart_VCD_Play : public part {
 public:
@@ -55,19 +54,26 @@ public:
     unsigned short GetInputId(char* name) override;
     unsigned short GetOutputId(char* name) override;
     int LoadVCD(std::string fname);
+    void OnTime(void);
 
 private:
     void RegisterRemoteControl(void) override;
-    unsigned char output_pins[8];
+    void ChangeChannels(void);
+    void Rewind(void);
+    void Schedule(void);
+    unsigned char output_pins[VCD_PLAY_MAX];
+    unsigned char nchannels;
+    std::string extra_pins;
     char f_vcd_name[200];
     unsigned char play;
-    float timescale;
-    unsigned long vcd_count;
-    float vcd_inc;
-    float vcd_step;
-    vcd_reg_t* vcd_data;
-    int vcd_data_count;
-    int vcd_ptr;
+    unsigned char playing;
+    CVCDStream vcd;
+    std::vector<int> var_channel;  // first output channel of each variable, -1 if not mapped
+    vcdw_record_t next;            // next value change to apply
+    int next_valid;
+    double inst_per_unit;  // board instructions per VCD time unit
+    uint64_t play_inst;    // board instructions since start of play
+    int TimerID;
 };
 
 #endif /* PART_VCD_Play_H */
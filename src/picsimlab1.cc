@@ -42,8 +42,12 @@ CPWindow1 Window1;
 #include "picsimlab4.h"
 #include "picsimlab5.h"
 
+#include "lib/frame_dump.h"
+#include "lib/image_cache.h"
 #include "lib/oscilloscope.h"
 #include "lib/picsimlab.h"
+#include "lib/profiler.h"
+#include "lib/wave_check.h"
 #include "lib/spareparts.h"
 
 #include "lib/rcontrol.h"
@@ -199,15 +203,15 @@ void CPWindow1::DrawBoard(void) {
             draw1.SetHeight(nh);
 
             draw1.SetVisible(0);
-            draw1.SetImgFileName(
-                GetLocalFile(PICSimLab.GetSharePath() + "boards/" + PICSimLab.GetBoard()->GetPictureFileName()),
-                PICSimLab.GetScale(), PICSimLab.GetScale());
+            SetBoardImage();
         }
 
         if (PICSimLab.GetBoard()) {
             PICSimLab.GetBoard()->SetScale(PICSimLab.GetScale());
             PICSimLab.GetBoard()->EvOnShow();
+            PICSimLab.CanvasCmdListBegin();
             PICSimLab.GetBoard()->Draw();
+            PICSimLab.CanvasCmdListEnd();
         }
         draw1.SetVisible(1);
 
@@ -221,7 +225,9 @@ void CPWindow1::DrawBoard(void) {
         PICSimLab.SetNeedResize(0);
         statusbar1.Draw();
     } else if (PICSimLab.GetBoard()) {
+        PICSimLab.CanvasCmdListBegin();
         PICSimLab.GetBoard()->Draw();
+        PICSimLab.CanvasCmdListEnd();
     }
 #ifndef _WIN_
     Draw();
@@ -231,14 +237,17 @@ void CPWindow1::DrawBoard(void) {
 void CPWindow1::thread1_EvThreadRun(CControl*) {
     double t0, t1, etime;
     do {
-        if (PICSimLab.tgo) {
+        // golden waveform check can run without wait the timer
+        if (PICSimLab.tgo || (WaveCheck.GetFreeRun() && PICSimLab.GetSimulationRun())) {
             t0 = cpuTime();
 
             PICSimLab.status |= ST_TH;
             PICSimLab.GetBoard()->Run_CPU();
+            FrameDump.Quantum();
             if (PICSimLab.GetDebugStatus())
                 PICSimLab.GetBoard()->DebugLoop();
-            PICSimLab.tgo--;
+            if (PICSimLab.tgo)
+                PICSimLab.tgo--;
             PICSimLab.status &= ~ST_TH;
 
             t1 = cpuTime();
@@ -708,6 +717,9 @@ void CPWindow1::_EvOnCreate(CControl* control) {
     SpareParts.OnCanvasCmd = &CPWindow5::OnCanvasCmd;
     SpareParts.OnWindowCmd = &CPWindow5::OnWindowCmd;
 
+    // software rasterizers between the simulation and the GUI canvas, used by frame dump
+    FrameDump.Install();
+
     Oscilloscope.OnWindowCmd = &CPWindow4::OnWindowCmd;
 
     PICSimLab.Init();
@@ -818,6 +830,63 @@ void CPWindow1::_EvOnCreate(CControl* control) {
 
     fflush(stdout);
 
+    // golden waveform check options: --wave=reference.vcd [--wave-tol=us]
+    // headless frame dump options: --frames=dir [--frames-every=quanta] [--frames-format=png|ppm|raw]
+    // video capture options: --video=file.y4m [--video-fps=fps]
+    std::string wave_fname;
+    double wave_tol = 1.0;
+    std::string frames_dir;
+    std::string frames_format = "png";
+    unsigned int frames_every = 1;
+    std::string video_fname;
+    unsigned int video_fps = 25;
+    for (int i = 1; i < Application->Aargc; i++) {
+        int opt = 1;
+        if (!strncmp(Application->Aargv[i], "--wave=", 7)) {
+#ifdef wxUSE_UNICODE
+            wave_fname = (const char*)lxString(Application->Aargvw[i]).utf8_str();
+            wave_fname = wave_fname.substr(7);
+#else
+            wave_fname = Application->Aargv[i] + 7;
+#endif
+        } else if (!strncmp(Application->Aargv[i], "--wave-tol=", 11)) {
+            wave_tol = atof(Application->Aargv[i] + 11);
+        } else if (!strncmp(Application->Aargv[i], "--frames=", 9)) {
+#ifdef wxUSE_UNICODE
+            frames_dir = (const char*)lxString(Application->Aargvw[i]).utf8_str();
+            frames_dir = frames_dir.substr(9);
+#else
+            frames_dir = Application->Aargv[i] + 9;
+#endif
+        } else if (!strncmp(Application->Aargv[i], "--frames-every=", 15)) {
+            frames_every = atoi(Application->Aargv[i] + 15);
+        } else if (!strncmp(Application->Aargv[i], "--frames-format=", 16)) {
+            frames_format = Application->Aargv[i] + 16;
+        } else if (!strncmp(Application->Aargv[i], "--video=", 8)) {
+#ifdef wxUSE_UNICODE
+            video_fname = (const char*)lxString(Application->Aargvw[i]).utf8_str();
+            video_fname = video_fname.substr(8);
+#else
+            video_fname = Application->Aargv[i] + 8;
+#endif
+        } else if (!strncmp(Application->Aargv[i], "--video-fps=", 12)) {
+            video_fps = atoi(Application->Aargv[i] + 12);
+        } else {
+            opt = 0;
+        }
+        if (opt) {
+            // remove option from positional arguments
+            for (int j = i; j < (Application->Aargc - 1); j++) {
+                Application->Aargv[j] = Application->Aargv[j + 1];
+#ifdef wxUSE_UNICODE
+                Application->Aargvw[j] = Application->Aargvw[j + 1];
+#endif
+            }
+            Application->Aargc--;
+            i--;
+        }
+    }
+
     if (Application->Aargc == 2) {  // only .pzw file
 #ifdef wxUSE_UNICODE
         fn.Assign(Application->Aargvw[1]);
@@ -941,6 +1010,24 @@ void CPWindow1::_EvOnCreate(CControl* control) {
         PICSimLab.Configure(home, 0, 1);
     }
     label1.SetText(PICSimLab.GetBoard()->GetClkLabel());
+
+    if (wave_fname.length()) {
+        // command line regression run, exit code is the check result
+        WaveCheck.SetFreeRun(1);
+        WaveCheck.SetExitOnEnd(1);
+        if (WaveCheck.Start(PICSimLab.GetBoard(), wave_fname.c_str(), wave_tol)) {
+            printf("PICSimLab: Wave check %s\n", WaveCheck.GetReport().c_str());
+            PICSimLab.SetToDestroy(RC_EXIT);
+        }
+    }
+
+    if (frames_dir.length()) {
+        FrameDump.Start(frames_dir.c_str(), frames_format.c_str(), frames_every);
+    }
+
+    if (video_fname.length()) {
+        FrameDump.StartVideo(video_fname.c_str(), video_fps);
+    }
 }
 
 void CPWindow1::OnConfigure(void) {
@@ -1071,9 +1158,7 @@ void CPWindow1::Configure(void) {
     filedialog1.SetDir(PICSimLab.GetPath());
 
     draw1.SetVisible(0);
-    draw1.SetImgFileName(
-        GetLocalFile(PICSimLab.GetSharePath() + "boards/" + PICSimLab.GetBoard()->GetPictureFileName()),
-        PICSimLab.GetScale(), PICSimLab.GetScale());
+    SetBoardImage();
 
 #ifndef NO_TOOLS
     if ((!PICSimLab.GetBoard()->GetProcessorName().compare("atmega328p")) ||
@@ -1086,7 +1171,9 @@ void CPWindow1::Configure(void) {
 
     PICSimLab.GetBoard()->Reset();
     PICSimLab.GetBoard()->EvOnShow();
+    PICSimLab.CanvasCmdListBegin();
     PICSimLab.GetBoard()->Draw();
+    PICSimLab.CanvasCmdListEnd();
     draw1.SetVisible(1);
 
     SetTitle(((PICSimLab.GetInstanceNumber() > 0)
@@ -1133,6 +1220,8 @@ void CPWindow1::_EvOnDestroy(CControl* control) {
         lxRemoveDir(PICSimLab.GetPzwTmpdir());
     }
 
+    ClearBitmapCache();
+
 #if !defined(__EMSCRIPTEN__) && !defined(_CONSOLE_LOG_)
     fflush(stdout);
     freopen(NULLFILE, "w", stdout);
@@ -1173,6 +1262,10 @@ void CPWindow1::_EvOnDestroy(CControl* control) {
     printf("PICSimLab: Finish Ok\n");
     fflush(stdout);
 #endif
+
+    if (WaveCheck.GetExitOnEnd()) {
+        exit(WaveCheck.GetExitCode());
+    }
 }
 
 void CPWindow1::menu1_File_LoadHex_EvMenuActive(CControl* control) {
@@ -1445,6 +1538,234 @@ void CPWindow1::OnConfigMenuGUI(const PICSimlabGUIMenu type) {
     }
 }
 
+// the canvas has no raw pixel access, the buffer is drawn as runs of equal color
+void CanvasPutPixels(CCanvas* canvas, const CanvasCmd_t& cmd) {
+    const int w = cmd.PutPixels.width;
+    const int h = cmd.PutPixels.height;
+    const float s = cmd.PutPixels.scale;
+    const float x = cmd.PutPixels.x;
+    const float y = cmd.PutPixels.y;
+    const int xs = cmd.PutPixels.xstride;
+    const int c0 = (cmd.PutPixels.area.x < 0) ? 0 : cmd.PutPixels.area.x;
+    const int r0 = (cmd.PutPixels.area.y < 0) ? 0 : cmd.PutPixels.area.y;
+    int c1 = cmd.PutPixels.area.x + cmd.PutPixels.area.width;
+    int r1 = cmd.PutPixels.area.y + cmd.PutPixels.area.height;
+    unsigned int last = 0xFFFFFFFF;
+
+    if (c1 > w)
+        c1 = w;
+    if (r1 > h)
+        r1 = h;
+
+    for (int row = r0; row < r1; row++) {
+        const unsigned int* line = cmd.PutPixels.pixels + row * cmd.PutPixels.ystride;
+        int col = c0;
+        while (col < c1) {
+            if (line[col * xs] == CC_TRANSPARENT) {
+                col++;
+                continue;
+            }
+            const unsigned int color = line[col * xs] & 0x00FFFFFF;
+            int end = col + 1;
+            while ((end < c1) && (line[end * xs] != CC_TRANSPARENT) && ((line[end * xs] & 0x00FFFFFF) == color)) {
+                end++;
+            }
+            if (color != last) {
+                canvas->SetFgColor(color >> 16, (color >> 8) & 0xFF, color & 0xFF);
+                canvas->SetColor(color >> 16, (color >> 8) & 0xFF, color & 0xFF);
+                last = color;
+            }
+            const float len = (end - col) * s;
+            switch (cmd.PutPixels.rotation) {
+                case 90:
+                    canvas->Rectangle(1, x + (h - 1 - row) * s, y + col * s, s, len);
+                    break;
+                case 180:
+                    canvas->Rectangle(1, x + (w - end) * s, y + (h - 1 - row) * s, len, s);
+                    break;
+                case 270:
+                    canvas->Rectangle(1, x + row * s, y + (w - end) * s, s, len);
+                    break;
+                default:
+                    canvas->Rectangle(1, x + col * s, y + row * s, len, s);
+                    break;
+            }
+            col = end;
+        }
+    }
+}
+
+// recorded lists have only drawing commands (see CCanvasCmdList::Add), run on the canvas without the dispatch
+void CanvasRunList(CCanvas* canvas, lxBitmap** bitmaps, const CanvasCmd_t* cmds, const int count) {
+    for (const CanvasCmd_t* cmd = cmds; cmd < (cmds + count); cmd++) {
+        switch (cmd->cmd) {
+            case CC_INIT:
+                canvas->Init(cmd->Init.sx, cmd->Init.sy, cmd->Init.angle);
+                break;
+            case CC_CHANGESCALE:
+                canvas->ChangeScale(cmd->ChangeScale.sx, cmd->ChangeScale.sy);
+                break;
+            case CC_END:
+                canvas->End();
+                break;
+            case CC_SETBITMAP:
+                canvas->SetBitmap(bitmaps[cmd->SetBitmap.BitmapId], cmd->SetBitmap.xs, cmd->SetBitmap.ys);
+                break;
+            case CC_SETCOLOR:
+                canvas->SetColor(cmd->SetColor.r, cmd->SetColor.g, cmd->SetColor.b);
+                break;
+            case CC_SETFGCOLOR:
+                canvas->SetFgColor(cmd->SetFgColor.r, cmd->SetFgColor.g, cmd->SetFgColor.b);
+                break;
+            case CC_SETBGCOLOR:
+                canvas->SetBgColor(cmd->SetBgColor.r, cmd->SetBgColor.g, cmd->SetBgColor.b);
+                break;
+            case CC_SETFONTSIZE:
+                canvas->SetFontSize(cmd->SetFontSize.pointsize);
+                break;
+            case CC_SETFONTWEIGHT:
+                canvas->SetFontWeight(cmd->SetFontWeight.weight);
+                break;
+            case CC_SETLINEWIDTH:
+                canvas->SetLineWidth(cmd->SetLineWidth.lwidth);
+                break;
+            case CC_POINT:
+                canvas->Point(cmd->Point.x, cmd->Point.y);
+                break;
+            case CC_LINE:
+                canvas->Line(cmd->Line.x1, cmd->Line.y1, cmd->Line.x2, cmd->Line.y2);
+                break;
+            case CC_RECTANGLE:
+                canvas->Rectangle(cmd->Rectangle.filled, cmd->Rectangle.x, cmd->Rectangle.y, cmd->Rectangle.width,
+                                  cmd->Rectangle.height);
+                break;
+            case CC_CIRCLE:
+                canvas->Circle(cmd->Circle.filled, cmd->Circle.x, cmd->Circle.y, cmd->Circle.radius);
+                break;
+            case CC_ROTATEDTEXT:
+                canvas->RotatedText(cmd->RotatedText.str, cmd->RotatedText.x, cmd->RotatedText.y,
+                                    cmd->RotatedText.angle);
+                break;
+            case CC_TEXTONRECT: {
+                lxRect rect;
+                rect.x = cmd->TextOnRect.rect.x;
+                rect.y = cmd->TextOnRect.rect.y;
+                rect.width = cmd->TextOnRect.rect.width;
+                rect.height = cmd->TextOnRect.rect.height;
+                canvas->TextOnRect(cmd->TextOnRect.str, rect, cmd->TextOnRect.align);
+            } break;
+            case CC_POLYGON:
+                canvas->Polygon(cmd->Polygon.filled, (lxPoint*)cmd->Polygon.points, cmd->Polygon.npoints);
+                break;
+            case CC_PUTBITMAP:
+                canvas->PutBitmap(bitmaps[cmd->PutBitmap.BitmapId], cmd->PutBitmap.x, cmd->PutBitmap.y);
+                break;
+            case CC_ARC:
+                canvas->Arc(cmd->Arc.filled, cmd->Arc.x1, cmd->Arc.y1, cmd->Arc.x2, cmd->Arc.y2, cmd->Arc.xc,
+                            cmd->Arc.yc);
+                break;
+            case CC_ELLIPTICARC:
+                canvas->EllipticArc(cmd->EllipticArc.filled, cmd->EllipticArc.x, cmd->EllipticArc.y,
+                                    cmd->EllipticArc.width, cmd->EllipticArc.height, cmd->EllipticArc.start,
+                                    cmd->EllipticArc.end);
+                break;
+            case CC_LINES:
+                canvas->Lines((lxPoint*)cmd->Lines.points, cmd->Lines.npoints);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void FreeCachedBitmap(void* bitmap) {
+    delete (lxBitmap*)bitmap;
+}
+
+// rasterized board and part images
+static CImageCache ImageCache(FreeCachedBitmap);
+
+lxBitmap* GetCachedBitmap(CPWindow* win, const std::string& fname, const float scale, const int orientation) {
+    const std::string key = CImageCache::Key(fname, scale, orientation);
+    if (!key.size()) {
+        return NULL;
+    }
+
+    lxBitmap* bitmap = (lxBitmap*)ImageCache.Get(key);
+    if (!bitmap) {
+        lxImage image(win);
+        if (!image.LoadFile(fname, orientation, scale, scale, 0)) {
+            return NULL;
+        }
+        bitmap = new lxBitmap(&image, win);
+        image.Destroy();
+        lxSize ps = bitmap->GetSize();
+        ImageCache.Put(key, bitmap, ps.GetWidth() * ps.GetHeight() * 4);
+    }
+    return bitmap;
+}
+
+void ClearBitmapCache(void) {
+    ImageCache.Clear();
+}
+
+// the bitmap has no copy method, it is drawn on a blank one
+static lxBitmap* CopyBitmap(CPWindow* win, lxBitmap* src) {
+    lxSize ps = src->GetSize();
+    lxImage image(win);
+    if (!image.CreateBlank(ps.GetWidth(), ps.GetHeight(), 0, 1.0, 1.0)) {
+        return NULL;
+    }
+    lxBitmap* dst = new lxBitmap(&image, win);
+    image.Destroy();
+
+    CCanvas canvas;
+    canvas.Create(win->GetWWidget(), dst);
+    canvas.Init(1.0, 1.0);
+    canvas.PutBitmap(src, 0, 0);
+    canvas.End();
+    canvas.Destroy();
+    return dst;
+}
+
+lxBitmap* LoadBitmapCached(CPWindow* win, const CanvasCmd_t& cmd) {
+    const std::string fname = GetLocalFile(cmd.LoadImage.fname);
+
+    // parts draw on their bitmaps, a copy of the cached image is returned (copies have no alpha channel)
+    if (!cmd.LoadImage.usealpha) {
+        lxBitmap* cached = GetCachedBitmap(win, fname, cmd.LoadImage.scale, cmd.LoadImage.orientation);
+        if (cached) {
+            return CopyBitmap(win, cached);
+        }
+    }
+
+    lxImage image(win);
+    if (image.LoadFile(fname, cmd.LoadImage.orientation, cmd.LoadImage.scale, cmd.LoadImage.scale,
+                       cmd.LoadImage.usealpha)) {
+        lxBitmap* bitmap = new lxBitmap(&image, win);
+        image.Destroy();
+        return bitmap;
+    }
+    return NULL;
+}
+
+void CPWindow1::SetBoardImage(void) {
+    const std::string fname =
+        GetLocalFile(PICSimLab.GetSharePath() + "boards/" + PICSimLab.GetBoard()->GetPictureFileName());
+    lxBitmap* bitmap = GetCachedBitmap(this, fname, PICSimLab.GetScale(), 0);
+
+    if (bitmap) {
+        lxSize ps = bitmap->GetSize();
+        draw1.SetWidth(ps.GetWidth());
+        draw1.SetHeight(ps.GetHeight());
+        draw1.Canvas.Init(1.0, 1.0);
+        draw1.Canvas.PutBitmap(bitmap, 0, 0);
+        draw1.Canvas.End();
+    } else {
+        draw1.SetImgFileName(fname, PICSimLab.GetScale(), PICSimLab.GetScale());
+    }
+}
+
 int CPWindow1::OnCanvasCmd(const CanvasCmd_t cmd) {
     switch (cmd.cmd) {
         case CC_INIT:
@@ -1556,21 +1877,18 @@ int CPWindow1::OnCanvasCmd(const CanvasCmd_t cmd) {
             return 0;
         } break;
         case CC_LOADIMAGE: {
-            lxImage image(&Window1);
-            if (image.LoadFile(GetLocalFile(cmd.LoadImage.fname), cmd.LoadImage.orientation, cmd.LoadImage.scale,
-                               cmd.LoadImage.scale, cmd.LoadImage.usealpha)) {
-                // find enpty bitmap
-                int bid = -1;
-                for (int i = 0; i < BITMAPS_MAX; i++) {
-                    if (Window1.Bitmaps[i] == NULL) {
-                        bid = i;
-                        break;
-                    }
+            // find enpty bitmap
+            int bid = -1;
+            for (int i = 0; i < BITMAPS_MAX; i++) {
+                if (Window1.Bitmaps[i] == NULL) {
+                    bid = i;
+                    break;
                 }
+            }
 
-                if ((bid >= 0) && (bid < BITMAPS_MAX)) {
-                    Window1.Bitmaps[bid] = new lxBitmap(&image, &Window1);
-                    image.Destroy();
+            if ((bid >= 0) && (bid < BITMAPS_MAX)) {
+                Window1.Bitmaps[bid] = LoadBitmapCached(&Window1, cmd);
+                if (Window1.Bitmaps[bid]) {
                     return bid;
                 }
             }
@@ -1610,6 +1928,14 @@ int CPWindow1::OnCanvasCmd(const CanvasCmd_t cmd) {
         case CC_LINES:
             Window1.draw1.Canvas.Lines((lxPoint*)cmd.Lines.points, cmd.Lines.npoints);
             break;
+        case CC_PUTPIXELS:
+            CanvasPutPixels(&Window1.draw1.Canvas, cmd);
+            return 0;
+            break;
+        case CC_LIST:
+            CanvasRunList(&Window1.draw1.Canvas, Window1.Bitmaps, cmd.List.cmds, cmd.List.count);
+            return 0;
+            break;
         case CC_LAST:
         default:
             break;
@@ -1999,6 +2325,36 @@ void CPWindow1::menu1_Tools_PinViewer_EvMenuActive(CControl* control) {
 #endif
 }
 
+void CPWindow1::menu1_Tools_Profiler_EvMenuActive(CControl* control) {
+    if (!Profiler.IsRunning()) {
+        if (Profiler.Start(PICSimLab.GetBoard())) {
+            Message_sz("Profiler not supported by this board!", 400, 200);
+            return;
+        }
+        if (!Profiler.GetSymbolCount()) {
+            Profiler.LoadSymbolsAuto(PICSimLab.GetFNAME());
+        }
+        menu1_Tools_Profiler.SetText("Stop Profiler");
+    } else {
+        Profiler.Stop();
+        menu1_Tools_Profiler.SetText("Start Profiler");
+
+        std::string base = PICSimLab.GetHomePath() + "/profile";
+        if (PICSimLab.GetFNAME().length() > 1) {
+            base = PICSimLab.GetFNAME().substr(0, PICSimLab.GetFNAME().find_last_of('.'));
+        }
+        if (Profiler.Dump((base + ".callgrind.out").c_str(), PROF_CALLGRIND) ||
+            Profiler.Dump((base + ".pprof.pb").c_str(), PROF_PPROF)) {
+            Message_sz("Error saving profiler files!", 400, 200);
+        } else {
+            Message_sz(lxString::FromUTF8(
+                           ("Profiler saved to:\n" + base + ".callgrind.out\n" + base + ".pprof.pb").c_str()),
+                       600, 240);
+        }
+        Profiler.Clear();
+    }
+}
+
 // emscripten interface
 
 extern "C" {
@@ -99,6 +99,7 @@ public:
     CItemMenu menu1_Tools_ArduinoBootloader;
     CItemMenu menu1_Tools_MPLABXDebuggerPlugin;
     CItemMenu menu1_Tools_PinViewer;
+    CItemMenu menu1_Tools_Profiler;
     CItemMenu menu1_Help_Contents;
     CItemMenu menu1_Help_Board;
     CItemMenu menu1_Help_Examples;
@@ -142,6 +143,7 @@ public:
     void menu1_Tools_ArduinoBootloader_EvMenuActive(CControl* control);
     void menu1_Tools_MPLABXDebuggerPlugin_EvMenuActive(CControl* control);
     void menu1_Tools_PinViewer_EvMenuActive(CControl* control);
+    void menu1_Tools_Profiler_EvMenuActive(CControl* control);
     void menu1_Help_Contents_EvMenuActive(CControl* control);
     void menu1_Help_Examples_EvMenuActive(CControl* control);
     void menu1_Help_Board_EvMenuActive(CControl* control);
@@ -182,6 +184,12 @@ public:
     static int OnSystemCmd(const PICSimLabSystemCmd cmd, const char* Arg, void* ReturnBuff);
 
     void Configure(void);
+
+    /**
+     * @brief  Draw board picture on draw1 at current scale, from the image cache when possible
+     */
+    void SetBoardImage(void);
+
     int GetNeedClkUpdate(void) { return need_clkupdate; };
     void SetNeedClkUpdate(const int ncu) { need_clkupdate = ncu; };
 
@@ -213,4 +221,11 @@ private:
 
 extern CPWindow1 Window1;
 
+void CanvasPutPixels(CCanvas* canvas, const CanvasCmd_t& cmd);
+void CanvasRunList(CCanvas* canvas, lxBitmap** bitmaps, const CanvasCmd_t* cmds, const int count);
+
+lxBitmap* GetCachedBitmap(CPWindow* win, const std::string& fname, const float scale, const int orientation);
+lxBitmap* LoadBitmapCached(CPWindow* win, const CanvasCmd_t& cmd);
+void ClearBitmapCache(void);
+
 #endif /*#CPWINDOW1*/
@@ -371,6 +371,16 @@ CPWindow1::CPWindow1(void) {
     menu1_Tools_PinViewer.SetSubMenu(NULL);
     menu1_Tools_PinViewer.EvMenuActive = EVMENUACTIVE & CPWindow1::menu1_Tools_PinViewer_EvMenuActive;
     menu1_Tools.CreateChild(&menu1_Tools_PinViewer);
+    // menu1_Tools_Profiler
+    menu1_Tools_Profiler.SetFOwner(this);
+    menu1_Tools_Profiler.SetClass(lxT("CItemMenu"));
+    menu1_Tools_Profiler.SetName(lxT("menu1_Tools_Profiler"));
+    menu1_Tools_Profiler.SetTag(0);
+    menu1_Tools_Profiler.SetText(lxT("Start Profiler"));
+    menu1_Tools_Profiler.SetEnable(1);
+    menu1_Tools_Profiler.SetSubMenu(NULL);
+    menu1_Tools_Profiler.EvMenuActive = EVMENUACTIVE & CPWindow1::menu1_Tools_Profiler_EvMenuActive;
+    menu1_Tools.CreateChild(&menu1_Tools_Profiler);
     // menu1_Help_Contents
     menu1_Help_Contents.SetFOwner(this);
     menu1_Help_Contents.SetClass(lxT("CItemMenu"));
@@ -35,10 +35,41 @@
 
 CPWindow4 Window4;
 
+#define NOISE_SIZE 1024  // power of 2
+
+// display noise table, added at render time to simulate a real scope trace
+static float noise[NOISE_SIZE];
+
+// colors of logic channels 3 to 8
+static const unsigned char lane_colors[OSC_MAX_CHANNELS - 2][3] = {
+    {255, 128, 0}, {0, 200, 255}, {255, 80, 255}, {120, 255, 120}, {255, 255, 255}, {160, 160, 255}};
+
+// min/max of each screen column in deep capture view
+static float deep_min[WMAX][OSC_MAX_CHANNELS];
+static float deep_max[WMAX][OSC_MAX_CHANNELS];
+static double deep_start;  // time of first column
+static double deep_spp;    // samples per column
+
 // Implementation
 
 void CPWindow4::DrawScreen(void) {
+    static unsigned int noise_phase = 0;
+    static int noise_init = 0;
     double xz = Oscilloscope.Getxz();
+    const int envelope = Oscilloscope.GetEnvelope();
+    const int deepview = GetDeepView();
+
+    if (!noise_init) {
+        for (int i = 0; i < NOISE_SIZE; i++) {
+            noise[i] = ((1.0 * rand() / RAND_MAX) - 0.5) * 0.1;
+        }
+        noise_init = 1;
+    }
+    noise_phase += 397;  // move noise between frames
+
+    if (deepview) {
+        UpdateDeepView();
+    }
 
     draw1.Canvas.Init();
     draw1.Canvas.SetFontSize(9);
@@ -84,11 +115,20 @@ void CPWindow4::DrawScreen(void) {
         draw1.Canvas.Polygon(1, pts, 3);
 
         draw1.Canvas.SetLineWidth(2);
-        for (int t = 0; t < (NPOINTS / 2) - 1; t++) {
-            draw1.Canvas.Line((t * xz + xz) - ((NPOINTS * (xz - 1.0)) / 4.0),
-                              gain[0] * Oscilloscope.GetChannel(0)[t] + nivel[0],
-                              ((t + 1) * xz + xz) - ((NPOINTS * (xz - 1.0)) / 4.0),
-                              gain[0] * Oscilloscope.GetChannel(0)[t + 1] + nivel[0]);
+        if (deepview) {
+            DrawDeepChannel(0, gain[0], nivel[0]);
+        } else {
+            const float* ch = Oscilloscope.GetChannel(0);
+            const unsigned int np = noise_phase;
+            for (int t = 0; t < (NPOINTS / 2) - 1; t++) {
+                draw1.Canvas.Line((t * xz + xz) - ((NPOINTS * (xz - 1.0)) / 4.0),
+                                  gain[0] * (ch[t] + noise[(np + t) & (NOISE_SIZE - 1)]) + nivel[0],
+                                  ((t + 1) * xz + xz) - ((NPOINTS * (xz - 1.0)) / 4.0),
+                                  gain[0] * (ch[t + 1] + noise[(np + t + 1) & (NOISE_SIZE - 1)]) + nivel[0]);
+            }
+            if (envelope) {
+                DrawEnvelope(0, gain[0], nivel[0], xz);
+            }
         }
     }
     draw1.Canvas.SetLineWidth(1);
@@ -110,15 +150,30 @@ void CPWindow4::DrawScreen(void) {
         draw1.Canvas.Polygon(1, pts, 3);
 
         draw1.Canvas.SetLineWidth(2);
-        for (int t = 0; t < (NPOINTS / 2) - 1; t++) {
-            draw1.Canvas.Line((t * xz + xz) - ((NPOINTS * (xz - 1.0)) / 4.0),
-                              gain[1] * Oscilloscope.GetChannel(1)[t] + nivel[1],
-                              ((t + 1) * xz + xz) - ((NPOINTS * (xz - 1.0)) / 4.0),
-                              gain[1] * Oscilloscope.GetChannel(1)[t + 1] + nivel[1]);
+        if (deepview) {
+            DrawDeepChannel(1, gain[1], nivel[1]);
+        } else {
+            const float* ch = Oscilloscope.GetChannel(1);
+            const unsigned int np = noise_phase + (NOISE_SIZE / 2);
+            for (int t = 0; t < (NPOINTS / 2) - 1; t++) {
+                draw1.Canvas.Line((t * xz + xz) - ((NPOINTS * (xz - 1.0)) / 4.0),
+                                  gain[1] * (ch[t] + noise[(np + t) & (NOISE_SIZE - 1)]) + nivel[1],
+                                  ((t + 1) * xz + xz) - ((NPOINTS * (xz - 1.0)) / 4.0),
+                                  gain[1] * (ch[t + 1] + noise[(np + t + 1) & (NOISE_SIZE - 1)]) + nivel[1]);
+            }
+            if (envelope) {
+                DrawEnvelope(1, gain[1], nivel[1], xz);
+            }
         }
     }
     draw1.Canvas.SetLineWidth(1);
 
+    DrawLogicLanes(xz, envelope, deepview);
+
+    if (deepview) {
+        DrawDeepNotes();
+    }
+
     // draw update cursor
     draw1.Canvas.SetFgColor(250, 250, 50);
     draw1.Canvas.Line(update_pos, 0, update_pos, HMAX);
@@ -269,6 +324,153 @@ void CPWindow4::DrawScreen(void) {
     draw1.Canvas.End();
 }
 
+// draw min/max of all samples of each point, pulses shorter than a point are visible as vertical lines
+void CPWindow4::DrawEnvelope(const int channel, const float gain, const float nivel, const double xz) {
+    const float* chmin = Oscilloscope.GetChannelMin(channel);
+    const float* chmax = Oscilloscope.GetChannelMax(channel);
+
+    for (int t = 0; t < (NPOINTS / 2); t++) {
+        if (chmax[t] > chmin[t]) {
+            const float x = (t * xz + xz) - ((NPOINTS * (xz - 1.0)) / 4.0);
+            draw1.Canvas.Line(x, gain * chmin[t] + nivel, x, gain * chmax[t] + nivel);
+        }
+    }
+}
+
+// logic channels 3 to 8 are drawn in lanes at bottom half of screen
+void CPWindow4::DrawLogicLanes(const double xz, const int envelope, const int deepview) {
+    const int lh = HMAX / (2 * (OSC_MAX_CHANNELS - 2));  // lane height
+    const float gain = (lh - 4) / Oscilloscope.GetVMax();
+    char text[10];
+
+    for (int c = 2; c < OSC_MAX_CHANNELS; c++) {
+        if (Oscilloscope.GetChannelPin(c) < 0) {
+            continue;
+        }
+        const int nivel = (HMAX / 2) + (c - 1) * lh - 2;  // lane base line
+
+        draw1.Canvas.SetFgColor(lane_colors[c - 2][0], lane_colors[c - 2][1], lane_colors[c - 2][2]);
+        snprintf(text, 10, "%i", c + 1);
+        draw1.Canvas.RotatedText(text, WMAX - 10, nivel - lh + 2, 0);
+
+        if (deepview) {
+            DrawDeepChannel(c, gain, nivel);
+            continue;
+        }
+
+        const float* ch = Oscilloscope.GetChannel(c);
+        for (int t = 0; t < (NPOINTS / 2) - 1; t++) {
+            draw1.Canvas.Line((t * xz + xz) - ((NPOINTS * (xz - 1.0)) / 4.0), gain * ch[t] + nivel,
+                              ((t + 1) * xz + xz) - ((NPOINTS * (xz - 1.0)) / 4.0), gain * ch[t + 1] + nivel);
+        }
+        if (envelope) {
+            DrawEnvelope(c, gain, nivel, xz);
+        }
+    }
+}
+
+// deep capture is shown when oscilloscope is stopped, time scale and offset are used to zoom and pan the capture
+int CPWindow4::GetDeepView(void) {
+    return !Oscilloscope.GetRun() && Oscilloscope.GetCapture()->GetChunks() && (Oscilloscope.GetDT() > 0);
+}
+
+// get min/max of each screen column from the capture pyramid, the cost does not depend of the zoom level
+void CPWindow4::UpdateDeepView(void) {
+    CScopeCapture* capture = Oscilloscope.GetCapture();
+    const double spp = Oscilloscope.GetRT() / Oscilloscope.GetDT();  // samples per pixel
+    const double end = capture->GetEndTime() + ((spind6.GetValue() * 1e-3) / Oscilloscope.GetDT());
+    const double start = end - (spp * WMAX);
+
+    deep_start = start;
+    deep_spp = spp;
+
+    for (int x = 0; x < WMAX; x++) {
+        const double ta = start + (x * spp);
+        const uint64_t t0 = (ta > 0) ? ta : 0;
+        uint64_t t1 = (ta + spp > 0) ? (ta + spp) : 0;
+        if (t1 <= t0) {
+            t1 = t0 + 1;
+        }
+        capture->GetMinMax(t0, t1, deep_min[x], deep_max[x]);
+    }
+}
+
+void CPWindow4::DrawDeepChannel(const int channel, const float gain, const float nivel) {
+    for (int x = 0; x < WMAX; x++) {
+        float lo = deep_min[x][channel];
+        float hi = deep_max[x][channel];
+
+        // join with previous column
+        if (x > 0) {
+            if (deep_max[x - 1][channel] < lo)
+                lo = deep_max[x - 1][channel];
+            if (deep_min[x - 1][channel] > hi)
+                hi = deep_min[x - 1][channel];
+        }
+
+        // samples are stored inverted in oscilloscope frames, but not in capture
+        if (lo == hi) {
+            draw1.Canvas.Line(x, nivel - gain * lo, x + 1, nivel - gain * lo);
+        } else {
+            draw1.Canvas.Line(x, nivel - gain * lo, x, nivel - gain * hi);
+        }
+    }
+}
+
+// decoded frames are drawn in one row for each decoder at top of screen
+void CPWindow4::DrawDeepNotes(void) {
+    CScopeDecoder* decoder = Oscilloscope.GetDecoder();
+    std::vector<cap_note_t> notes;
+    int lastx[DEC_MAX];
+
+    if (!decoder->GetCount()) {
+        return;
+    }
+
+    const uint64_t t0 = (deep_start > 0) ? deep_start : 0;
+    const uint64_t t1 = (deep_start + deep_spp * WMAX > 0) ? (deep_start + deep_spp * WMAX) : 0;
+    decoder->GetNotes(t0, t1, notes, 1000);
+
+    for (int d = 0; d < DEC_MAX; d++) {
+        lastx[d] = -1;
+    }
+
+    draw1.Canvas.SetFontWeight(lxFONTWEIGHT_NORMAL);
+    draw1.Canvas.SetFgColor(255, 255, 100);
+    for (unsigned int i = 0; i < notes.size(); i++) {
+        const int d = notes[i].decoder;
+        const int x0 = (notes[i].time - deep_start) / deep_spp;
+        const int x1 = (notes[i].end - deep_start) / deep_spp;
+        const int y = 2 + 14 * d;
+
+        // skip overlapping notes
+        if (x0 <= lastx[d]) {
+            continue;
+        }
+        draw1.Canvas.Line(x0, y + 12, (x1 > x0) ? x1 : x0 + 1, y + 12);
+        draw1.Canvas.RotatedText(notes[i].text, x0, y, 0);
+        lastx[d] = x0 + 6 * strlen(notes[i].text);
+    }
+    draw1.Canvas.SetFontWeight(lxFONTWEIGHT_BOLD);
+}
+
+void CPWindow4::SetDeepViewRange(void) {
+    CScopeCapture* capture = Oscilloscope.GetCapture();
+    const double len = (capture->GetEndTime() - capture->GetStartTime()) * Oscilloscope.GetDT() * 1e3;  // ms
+
+    spind6.SetMin(-len);
+    spind6.SetMax(0);
+}
+
+void CPWindow4::RedrawDeepView(void) {
+    if (GetDeepView()) {
+        DrawScreen();
+#ifndef _WIN_
+        Draw();
+#endif
+    }
+}
+
 void CPWindow4::button1_EvMouseButtonClick(CControl* control, unsigned int button, unsigned int x, unsigned int y,
                                            unsigned int state) {
 #ifndef __WXX11__
@@ -294,8 +496,12 @@ void CPWindow4::draw1_EvMouseButtonClick(CControl* control, unsigned int button,
 }
 
 void CPWindow4::spind5_EvOnChangeSpinDouble(CControl* control) {
-    spind6.SetMin(-5 * spind5.GetValue());
-    spind6.SetMax(5 * spind5.GetValue());
+    if (GetDeepView()) {
+        SetDeepViewRange();
+    } else {
+        spind6.SetMin(-5 * spind5.GetValue());
+        spind6.SetMax(5 * spind5.GetValue());
+    }
 
     float inc = spind5.GetValue() / 100.0;
 
@@ -310,6 +516,7 @@ void CPWindow4::spind5_EvOnChangeSpinDouble(CControl* control) {
     }
 
     Oscilloscope.SetTimeScaleAndOffset(spind5.GetValue(), spind6.GetValue());
+    RedrawDeepView();
 }
 
 void CPWindow4::spind6_EvOnChangeSpinDouble(CControl* control) {
@@ -326,6 +533,7 @@ void CPWindow4::spind6_EvOnChangeSpinDouble(CControl* control) {
     }
 
     Oscilloscope.SetTimeScaleAndOffset(spind5.GetValue(), spind6.GetValue());
+    RedrawDeepView();
 }
 
 void CPWindow4::togglebutton5_EvOnToggleButton(CControl* control) {
@@ -339,10 +547,8 @@ void CPWindow4::spind7_EvOnChangeSpinDouble(CControl* control) {
 void CPWindow4::timer1_EvOnTime(CControl* control) {
     static int count = 0;
 
-    update_pos = Oscilloscope.GetUpdate();
+    update_pos = Oscilloscope.FetchFrame();
     if (update_pos) {
-        Oscilloscope.SetUpdate(0);
-
         count++;
         if (count >= 5)  // Update at 2Hz
         {
@@ -459,19 +665,42 @@ void CPWindow4::togglebutton6_EvOnToggleButton(CControl* control) {
     combo1.SetEnable(Oscilloscope.GetRun());
     combo2.SetEnable(Oscilloscope.GetRun());
     combo3.SetEnable(Oscilloscope.GetRun());
+
+    if (GetDeepView()) {
+        spind5.SetEnable(1);
+        spind6.SetEnable(1);
+        SetDeepViewRange();
+        spind6.SetValue(0);
+        RedrawDeepView();
+    } else if (Oscilloscope.GetRun()) {
+        // restore offset range
+        spind5_EvOnChangeSpinDouble(control);
+    }
 }
 
 // save PNG
 
 void CPWindow4::button4_EvMouseButtonClick(CControl* control, unsigned int button, unsigned int x, unsigned int y,
                                            unsigned int state) {
+    if (Oscilloscope.GetCapture()->GetChunks()) {
+        filedialog1.SetFilter("PNG Files (*.png)|*.png|VCD Files (deep capture) (*.vcd)|*.vcd");
+    } else {
+        filedialog1.SetFilter("PNG Files (*.png)|*.png");
+    }
     filedialog1.SetType(lxFD_SAVE | lxFD_CHANGE_DIR);
     filedialog1.Run();
 }
 
 void CPWindow4::filedialog1_EvOnClose(int retId) {
     if (retId) {
-        draw1.WriteImgToFile(filedialog1.GetFileName());
+        std::string fname = (const char*)filedialog1.GetFileName().utf8_str();
+        if ((fname.length() > 4) && !fname.compare(fname.length() - 4, 4, ".vcd")) {
+            if (Oscilloscope.ExportCapture(fname.c_str())) {
+                PICSimLab.RegisterError("Error exporting oscilloscope capture: " + fname);
+            }
+        } else {
+            draw1.WriteImgToFile(filedialog1.GetFileName());
+        }
     }
 }
 
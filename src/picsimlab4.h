@@ -124,6 +124,14 @@ public:
                            void* ReturnBuff);
 
 private:
+    void DrawEnvelope(const int channel, const float gain, const float nivel, const double xz);
+    void DrawLogicLanes(const double xz, const int envelope, const int deepview);
+    int GetDeepView(void);
+    void UpdateDeepView(void);
+    void DrawDeepChannel(const int channel, const float gain, const float nivel);
+    void DrawDeepNotes(void);
+    void SetDeepViewRange(void);
+    void RedrawDeepView(void);
     CButton* ctrl;
     int update_pos;
 };
@@ -495,9 +495,25 @@ void CPWindow5::PartEvent(CControl* control) {
     }
 }
 
+// screen rectangle of part n, empty if it has no bitmap
+Rect_t CPWindow5::PartRect(const int n) {
+    part* p = SpareParts.GetPart(n);
+    Rect_t r = {(int)((p->GetX() + offsetx) * SpareParts.GetScale()),
+                (int)((p->GetY() + offsety) * SpareParts.GetScale()), 0, 0};
+    if ((p->GetBitmap() >= 0) && Bitmaps[p->GetBitmap()]) {
+        lxSize ps = Bitmaps[p->GetBitmap()]->GetSize();
+        r.width = ps.GetWidth();
+        r.height = ps.GetHeight();
+    }
+    return r;
+}
+
+static int RectIntersect(const Rect_t& a, const Rect_t& b) {
+    return (a.x < (b.x + b.width)) && (b.x < (a.x + a.width)) && (a.y < (b.y + b.height)) && (b.y < (a.y + a.height));
+}
+
 void CPWindow5::timer1_EvOnTime(CControl* control) {
     static int tc = 0;
-    int update = 0;
 
     if (need_resize == 1) {
         int w = GetClientWidth() - 10;
@@ -510,36 +526,82 @@ void CPWindow5::timer1_EvOnTime(CControl* control) {
 
     need_resize++;
 
-    for (int i = 0; i < SpareParts.GetCount(); i++) {
-        SpareParts.SetPartOnDraw(SpareParts.GetPart(i)->GetId());
-        SpareParts.GetPart(i)->Draw();
-        if (SpareParts.GetPart(i)->GetUpdate())
-            update++;
+    const int count = SpareParts.GetCount();
+    const Rect_t screen = {0, 0, (int)draw1.GetWidth(), (int)draw1.GetHeight()};
+
+    if ((int)scene.size() != count) {  // parts added or deleted
+        scene.resize(count);
+        update_all = 1;
+    }
+
+    // off screen parts are not drawn, their outputs keep the update flag until they are visible
+    SpareParts.CanvasCmdListBegin();
+    for (int i = 0; i < count; i++) {
+        if (RectIntersect(PartRect(i), screen)) {
+            SpareParts.SetPartOnDraw(SpareParts.GetPart(i)->GetId());
+            SpareParts.GetPart(i)->Draw();
+        }
     }
+    SpareParts.CanvasCmdListEnd();
 
     if (update_all) {
         SpareParts.UpdateAll();
-        update = 1;
     }
 
-    // printf ("part update %i\n", update);
+    // damage: old rectangles of moved parts (background) and rectangles of redrawn parts
+    damage.clear();
+    redraw.assign(count, 0);
+    for (int i = 0; i < count; i++) {
+        const Rect_t r = PartRect(i);
+        const int visible = RectIntersect(r, screen);
+        if (!update_all && ((r.x != scene[i].x) || (r.y != scene[i].y) || (r.width != scene[i].width) ||
+                            (r.height != scene[i].height))) {
+            if (RectIntersect(scene[i], screen)) {
+                damage.push_back(scene[i]);
+            }
+            redraw[i] = visible;
+        } else if (visible && SpareParts.GetPart(i)->GetUpdate()) {
+            redraw[i] = 1;
+        }
+        scene[i] = r;
+    }
+    const int background = damage.size();
+    for (int i = 0; i < count; i++) {
+        if (redraw[i]) {
+            damage.push_back(scene[i]);
+        }
+    }
+
+    // parts are opaque and drawn in order, so every part over a damaged area is redrawn
+    if (!update_all) {
+        for (size_t d = 0; d < damage.size(); d++) {
+            for (int i = 0; i < count; i++) {
+                if (!redraw[i] && RectIntersect(scene[i], damage[d]) && RectIntersect(scene[i], screen)) {
+                    redraw[i] = 1;
+                    damage.push_back(scene[i]);
+                }
+            }
+        }
+    }
 
-    if (update) {
+    if (damage.size() || update_all) {
         draw1.Canvas.Init(1.0, 1.0);
         draw1.Canvas.SetFontWeight(lxFONTWEIGHT_BOLD);
+        draw1.Canvas.SetFgColor(50, 50, 50);
+        draw1.Canvas.SetBgColor(50, 50, 50);
 
         if (update_all) {
-            draw1.Canvas.SetFgColor(50, 50, 50);
-            draw1.Canvas.SetBgColor(50, 50, 50);
             draw1.Canvas.Rectangle(1, 0, 0, draw1.GetWidth(), draw1.GetHeight());
             update_all = 0;
+        } else {
+            for (int d = 0; d < background; d++) {
+                draw1.Canvas.Rectangle(1, damage[d].x, damage[d].y, damage[d].width, damage[d].height);
+            }
         }
 
-        for (int i = 0; i < SpareParts.GetCount(); i++) {
-            if (SpareParts.GetPart(i)->GetUpdate()) {
-                draw1.Canvas.PutBitmap(Bitmaps[SpareParts.GetPart(i)->GetBitmap()],
-                                       (SpareParts.GetPart(i)->GetX() + offsetx) * SpareParts.GetScale(),
-                                       (SpareParts.GetPart(i)->GetY() + offsety) * SpareParts.GetScale());
+        for (int i = 0; i < count; i++) {
+            if (redraw[i]) {
+                draw1.Canvas.PutBitmap(Bitmaps[SpareParts.GetPart(i)->GetBitmap()], scene[i].x, scene[i].y);
             }
         }
 
@@ -593,7 +655,6 @@ void CPWindow5::draw1_EvMouseMove(CControl* control, unsigned int button, unsign
 
         SpareParts.GetPart(PartToMove)->SetX(x + mdx);
         SpareParts.GetPart(PartToMove)->SetY(y + mdy);
-        update_all = 1;
     } else {
         for (int i = 0; i < SpareParts.GetCount(); i++) {
             if (SpareParts.GetPart(i)->PointInside(x - offsetx, y - offsety)) {
@@ -1047,20 +1108,18 @@ int CPWindow5::OnCanvasCmd(const CanvasCmd_t cmd) {
             return 0;
         } break;
         case CC_LOADIMAGE: {
-            lxImage image(&Window5);
-            if (image.LoadFile(GetLocalFile(cmd.LoadImage.fname), cmd.LoadImage.orientation, cmd.LoadImage.scale,
-                               cmd.LoadImage.scale, cmd.LoadImage.usealpha)) {
-                // find enpty bitmap
-                int bid = -1;
-                for (int i = 0; i < (MAX_PARTS * 2); i++) {
-                    if (Window5.Bitmaps[i] == NULL) {
-                        bid = i;
-                        break;
-                    }
+            // find enpty bitmap
+            int bid = -1;
+            for (int i = 0; i < (MAX_PARTS * 2); i++) {
+                if (Window5.Bitmaps[i] == NULL) {
+                    bid = i;
+                    break;
                 }
-                if ((bid >= 0) && (bid < (MAX_PARTS * 2))) {
-                    Window5.Bitmaps[bid] = new lxBitmap(&image, &Window5);
-                    image.Destroy();
+            }
+
+            if ((bid >= 0) && (bid < (MAX_PARTS * 2))) {
+                Window5.Bitmaps[bid] = LoadBitmapCached(&Window5, cmd);
+                if (Window5.Bitmaps[bid]) {
                     return bid;
                 }
             }
@@ -1100,6 +1159,14 @@ int CPWindow5::OnCanvasCmd(const CanvasCmd_t cmd) {
         case CC_LINES:
             Window5.Canvas[partn].Lines((lxPoint*)cmd.Lines.points, cmd.Lines.npoints);
             break;
+        case CC_PUTPIXELS:
+            CanvasPutPixels(&Window5.Canvas[partn], cmd);
+            return 0;
+            break;
+        case CC_LIST:
+            CanvasRunList(&Window5.Canvas[partn], Window5.Bitmaps, cmd.List.cmds, cmd.List.count);
+            return 0;
+            break;
         case CC_LAST:
         default:
             break;
@@ -141,6 +141,10 @@ private:
     int mouse_scroll;
     int need_resize;
     int update_all;
+    Rect_t PartRect(const int n);
+    std::vector<Rect_t> scene;  // screen rectangle of each part at last flush
+    std::vector<Rect_t> damage;
+    std::vector<char> redraw;
 };
 
 extern CPWindow5 Window5;